@@ -0,0 +1,290 @@
+import datetime
+import logging
+import math
+import os
+import struct
+from typing import List, Union
+
+from backend.data.measurements import MeasurementArray
+
+logger = logging.getLogger(__name__)
+
+STORE_BLOCK_MAGIC = b"TSB1"
+STORE_KEY_SEPARATOR = "\x1f"
+STORE_BLOCK_WRITE = b"W"
+STORE_BLOCK_CULL = b"C"
+
+# Times in the store are GPS seconds since the GPS epoch, mongo dates are the same seconds counted from the posix epoch
+GPS_EPOCH = datetime.datetime(1980, 1, 6)
+
+
+class StoreBlockReader:
+    """
+    Bounds checked reader for the contents of a block, as written by the pea
+    """
+
+    def __init__(self, block: bytes) -> None:
+        self.block = block
+        self.pos = 0
+
+    def get(self, fmt: str):
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.block):
+            raise ValueError("Block is truncated")
+        (value,) = struct.unpack_from(fmt, self.block, self.pos)
+        self.pos += size
+        return value
+
+    def get_string(self) -> str:
+        size = self.get("<I")
+        if self.pos + size > len(self.block):
+            raise ValueError("Block is truncated")
+        value = self.block[self.pos : self.pos + size].decode("utf-8", errors="replace")
+        self.pos += size
+        return value
+
+
+def store_key_fields(key: str) -> dict:
+    """
+    Split the string a series is indexed by into its key fields
+    """
+    key_fields = {}
+    for field in key.split(STORE_KEY_SEPARATOR):
+        name, equals, value = field.partition("=")
+        if equals:
+            key_fields[name] = value
+    return key_fields
+
+
+def store_time(big_time: float) -> datetime.datetime:
+    return GPS_EPOCH + datetime.timedelta(seconds=big_time)
+
+
+def store_value(value):
+    """
+    Numbers are all stored as doubles, give back whole numbers as integers as mongo would for integer fields
+    """
+    if isinstance(value, float) and value.is_integer() and abs(value) < 2**31:
+        return int(value)
+    return value
+
+
+class LocalStore:
+    """
+    Reader for the file-backed time series store the pea writes when a mongo config section selects the local store backend.
+    It provides the same interface as MongoDB, with each store file in a directory taking the place of a database
+    """
+
+    def __init__(self, url: Union[str, None] = None, data_base: str = "", port: int = 0) -> None:
+        self.store_path: str = url or "."
+        self.store_db: str = data_base
+        self.mongo_content: dict = {}
+        self.list_collections: list = []
+        self.collections: dict = {}
+
+    def __enter__(self):
+        self.connect()
+        self.get_content()
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        pass
+
+    def store_filename(self) -> str:
+        if os.path.isdir(self.store_path):
+            return os.path.join(self.store_path, self.store_db)
+        return self.store_path
+
+    def connect(self) -> None:
+        if not os.path.exists(self.store_path):
+            raise ConnectionError(f"Local store not found at {self.store_path}")
+        if self.store_db:
+            self.read_blocks(self.store_filename())
+
+    def read_blocks(self, filename: str) -> None:
+        """
+        Load every complete block of a store file, applying writes and culls in order as the pea does
+        """
+        self.collections = {}
+        with open(filename, "rb") as store_file:
+            while True:
+                header = store_file.read(12)
+                if len(header) < 12 or header[:4] != STORE_BLOCK_MAGIC:
+                    # nothing more, or a block that is still being written
+                    break
+                (length,) = struct.unpack("<Q", header[4:])
+                block = store_file.read(length)
+                if len(block) < length:
+                    break
+                try:
+                    self.apply_block(block)
+                except ValueError:
+                    logger.warning(f"Corrupt block in time series store {filename}")
+
+    def apply_block(self, block: bytes) -> None:
+        reader = StoreBlockReader(block)
+        block_type = reader.get("<c")
+        collection = reader.get_string()
+        series_map = self.collections.setdefault(collection, {})
+
+        if block_type == STORE_BLOCK_CULL:
+            cull_time = reader.get("<d")
+            for key in list(series_map):
+                rows = series_map[key]["rows"]
+                for time in [time for time in rows if time < cull_time]:
+                    del rows[time]
+                if not rows:
+                    del series_map[key]
+            return
+
+        if block_type != STORE_BLOCK_WRITE:
+            return
+
+        num_rows = reader.get("<I")
+        key_list = [reader.get_string() for _ in range(num_rows)]
+        time_list = [reader.get("<d") for _ in range(num_rows)]
+        value_list = [{} for _ in range(num_rows)]
+
+        for _ in range(reader.get("<I")):
+            name = reader.get_string()
+            for values in value_list:
+                value = reader.get("<d")
+                if not math.isnan(value):
+                    values[name] = value
+
+        for _ in range(reader.get("<I")):
+            name = reader.get_string()
+            for values in value_list:
+                value = reader.get_string()
+                if value:
+                    values[name] = value
+
+        # values are set like a mongo $set, fields that aren't given keep any previous values
+        for key, time, values in zip(key_list, time_list, value_list):
+            series = series_map.setdefault(key, {"keyFields": store_key_fields(key), "rows": {}})
+            series["rows"].setdefault(time, {}).update(values)
+
+    def get_content(self) -> None:
+        """
+        Build the lists of what is available, which mongo keeps in its Content collection
+        """
+        content = {"Series": set(), "Site": set(), "Sat": set(), "State": set(), "Measurements": set()}
+        for collection in ["Measurements", "States"]:
+            for series in self.collections.get(collection, {}).values():
+                key_fields = series["keyFields"]
+                for name in ["Series", "Site", "Sat", "State"]:
+                    if name in key_fields:
+                        content[name].add(key_fields[name])
+                if collection == "Measurements":
+                    for values in series["rows"].values():
+                        content["Measurements"].update(name for name, value in values.items() if isinstance(value, float))
+
+        self.mongo_content = {name: sorted(values) for name, values in content.items()}
+        self.mongo_content["Has_measurements"] = "Measurements" in self.collections
+        # satellite geometry is only written to mongo
+        self.mongo_content["Geometry"] = ["Site", "Sat", "Epoch"]
+        self.mongo_content["states_fields"] = ["x", "dx", "P"]
+
+    def get_list_db(self) -> List[str]:
+        if os.path.isdir(self.store_path):
+            return sorted(
+                filename
+                for filename in os.listdir(self.store_path)
+                if not filename.endswith(".lock") and self.is_store(os.path.join(self.store_path, filename))
+            )
+        return [os.path.basename(self.store_path)]
+
+    @staticmethod
+    def is_store(filename: str) -> bool:
+        if not os.path.isfile(filename):
+            return False
+        with open(filename, "rb") as store_file:
+            return store_file.read(4) == STORE_BLOCK_MAGIC
+
+    def get_list_collections(self) -> None:
+        self.list_collections = list(self.collections)
+
+    @staticmethod
+    def get_field(time: float, key_fields: dict, values: dict, name: str):
+        """
+        Get a field of a row as mongo would return it, with arrays and vectors that the store expands into numbered fields put back together
+        """
+        if name == "Epoch":
+            return store_time(time)
+        if name in values:
+            return store_value(values[name])
+        if name in key_fields:
+            return key_fields[name]
+        array = []
+        while f"{name}{len(array)}" in values:
+            array.append(store_value(values[f"{name}{len(array)}"]))
+        if array:
+            return array
+        return float("nan")
+
+    def get_data(
+        self,
+        collection: str,
+        state: str,
+        site: List[str],
+        sat: List[str],
+        series: List[str],
+        keys,
+    ) -> list:
+        """
+        get_data getting data from the local store, grouped by site, sat and series as the mongo aggregation does.
+
+        :param str collection: Collection to pull data from
+        :param str state: State to plot (if collection is state)
+        :param List[str] site: List of site in the request
+        :param List[str] sat: List of sat in the request
+        :param List[str] series: List of series in the request
+        :param List[str] keys: List of keys to pull from the database
+        :raises ValueError: if no data is found
+        :return list: of the data
+        """
+        logger.debug("getting data")
+        rows = []
+        for store_series in self.collections.get(collection, {}).values():
+            key_fields = store_series["keyFields"]
+            if key_fields.get("Sat") not in sat or key_fields.get("Site") not in site or key_fields.get("Series") not in series:
+                continue
+            if state is not None and key_fields.get("State") not in state:
+                continue
+            for time, values in store_series["rows"].items():
+                rows.append((time, key_fields, values))
+        rows.sort(key=lambda row: row[0])
+
+        groups = {}
+        for time, key_fields, values in rows:
+            group_id = (key_fields.get("Site"), key_fields.get("Sat"), key_fields.get("Series"))
+            if group_id not in groups:
+                groups[group_id] = {"_id": {"site": group_id[0], "sat": group_id[1], "series": group_id[2]}, "t": []}
+                for key in keys:
+                    groups[group_id][key] = []
+            group = groups[group_id]
+            group["t"].append(store_time(time))
+            for key in keys:
+                group[key].append(self.get_field(time, key_fields, values, key))
+
+        if not groups:
+            raise ValueError("No data found")
+        return list(groups.values())
+
+    def get_data_to_measurement(
+        self,
+        collection: str,
+        state: str,
+        site: List[str],
+        sat: List[str],
+        series: List[str],
+        keys,
+    ) -> MeasurementArray:
+        data = self.get_data(collection, state, site, sat, series, keys)
+        array = MeasurementArray.from_mongolist(data)
+        array.sort()
+        return array
+
+    def get_config(self) -> Union[dict, None]:
+        # the config is only written to mongo
+        return None
@@ -1,8 +1,16 @@
 import logging
 from typing import List, Union
 
-from pymongo.mongo_client import MongoClient
-from pymongo.errors import ServerSelectionTimeoutError
+try:
+    from pymongo.mongo_client import MongoClient
+    from pymongo.errors import ServerSelectionTimeoutError
+except ImportError:
+    # pymongo is only needed for mongo databases, local stores are read without it
+    MongoClient = None
+
+    class ServerSelectionTimeoutError(ConnectionError):
+        pass
+
 from backend.data.measurements import MeasurementArray
 
 logger = logging.getLogger(__name__)
@@ -30,6 +38,8 @@ class MongoDB:
         self.mongo_client.close()
 
     def connect(self) -> None:
+        if MongoClient is None:
+            raise ConnectionError("pymongo is not installed, only local stores can be opened")
         try:
             self.mongo_client = MongoClient(host=self.mongo_url, port=self.mongo_port)
             logger.debug(self.mongo_client.list_database_names())
@@ -1,9 +1,7 @@
 from flask import render_template, request, session
 
-from backend.dbconnector.mongo import MongoDB
-
 from . import eda_bp
-from ..utilities import init_page, extra
+from ..utilities import init_page, extra, open_database
 
 
 @eda_bp.route("/config", methods=["GET", "POST"])
@@ -18,7 +16,9 @@ def config():
 def handle_post_request():
     form = request.form
     database = form.get("database")
-    with MongoDB(session["mongo_ip"], data_base=database, port=session["mongo_port"]) as client:
+    with open_database(database) as client:
         configuration = client.get_config()
-    configuration.pop('_id')
+    if configuration is None:
+        configuration = {}
+    configuration.pop('_id', None)
     return render_template("config.jinja", configuration=configuration, selection=form)
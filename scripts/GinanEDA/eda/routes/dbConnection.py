@@ -1,9 +1,8 @@
 from flask import  render_template, request, session
 from flask import current_app
 
-from pymongo.errors import ServerSelectionTimeoutError
-
-from backend.dbconnector.mongo import MongoDB
+from backend.dbconnector.mongo import MongoDB, ServerSelectionTimeoutError
+from backend.dbconnector.local_store import LocalStore
 from . import eda_bp
 
 
@@ -22,7 +21,8 @@ def connect():
         return handle_post_request()
     db_ip = getattr(session, "mongo_ip", "127.0.0.1")
     db_port = getattr(session, "mongo_port", "27017")
-    return render_template("connect.jinja", db_ip=db_ip, db_port=db_port)
+    store_path = session.get("store_path", "")
+    return render_template("connect.jinja", db_ip=db_ip, db_port=db_port, store_path=store_path)
 
 
 def handle_post_request():
@@ -39,6 +39,8 @@ def handle_post_request():
     db_port = getattr(session, "mongo_port", "27017")
     if "connect" in form_data:
         return handle_connect_request(form_data)
+    elif "open_store" in form_data:
+        return handle_open_store_request(form_data)
     elif "load" in form_data:
         return handle_load_request(form_data)
     else:
@@ -74,6 +76,31 @@ def handle_connect_request(form_data):
         return render_template("connect.jinja", db_ip=connect_db_ip, db_port=db_port, message=error_message)
 
 
+def handle_open_store_request(form_data):
+    """
+    Handle the 'open_store' request from the database connection form.
+
+    This function lists the local store files at the specified path, which is either a store file or a directory of them,
+    and renders the 'connect.html' template with them in place of the databases of a mongo server.
+
+    Args:
+        form_data: The form data containing the store path.
+
+    Returns:
+        The rendered template 'connect.html' with the retrieved data.
+    """
+    store_path = form_data.get("store_path", "")
+    current_app.logger.info(f"opening local store {store_path}")
+    try:
+        client = LocalStore(url=store_path)
+        client.connect()
+        databases = client.get_list_db()
+        return render_template("connect.jinja", store_path=store_path, backend="local_store", databases=databases)
+    except (ConnectionError, OSError):
+        error_message = f"Open failed: no local store at {store_path}"
+        return render_template("connect.jinja", store_path=store_path, message=error_message)
+
+
 def handle_load_request(form_data):
     """
     Handle the 'load' request from the database connection form.
@@ -89,9 +116,13 @@ def handle_load_request(form_data):
     """
     connect_db_ip = form_data.get("db_ip", "")
     db_name = form_data.getlist("dataset")
-    db_port = int(form_data.get("db_port", 27017))
+    db_port = int(form_data.get("db_port") or 27017)
+    backend = form_data.get("backend", "mongo")
+    store_path = form_data.get("store_path", "")
     current_app.logger.info(f"connection to {connect_db_ip}, {db_name}")
     message = []
+    session["db_backend"] = backend
+    session["store_path"] = store_path
     session["mongo_ip"] = connect_db_ip
     session["mongo_db"] = db_name
     session["mongo_port"] = db_port
@@ -102,7 +133,11 @@ def handle_load_request(form_data):
     geometry = []
     state = []
     for database  in db_name:
-        with MongoDB(connect_db_ip, port=db_port, data_base=database) as client:
+        if backend == "local_store":
+            client = LocalStore(store_path, data_base=database)
+        else:
+            client = MongoDB(connect_db_ip, port=db_port, data_base=database)
+        with client:
             databases = client.get_list_db()
             client.get_content()
             nsat = len(client.mongo_content["Sat"])
@@ -134,6 +169,8 @@ def handle_load_request(form_data):
         "connect.jinja",
         db_ip=connect_db_ip,
         db_port=db_port,
+        store_path=store_path,
+        backend=backend,
         databases=databases,
         message="<br>".join(message),
     )
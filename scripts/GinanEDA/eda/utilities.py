@@ -6,6 +6,7 @@ import plotly.io as pio
 
 from backend.data.measurements import MeasurementArray, Measurements
 from backend.dbconnector.mongo import MongoDB
+from backend.dbconnector.local_store import LocalStore
 
 extra = {}
 extra["plotType"] = ["Line", "Scatter", "QQ"]
@@ -15,6 +16,18 @@ extra["stateField"] = ["x", "dx", "P"]
 extra["preprocess"] = ["None", "Fit", "Detrend"]
 extra['degree'] = ["0", "1", "2"]
 
+def open_database(db):
+    """
+    Get a client for a database of the current session, which is either a mongo database or a local store file
+
+    :param db: Database name
+    :return: MongoDB or LocalStore client, to be used as a context manager
+    """
+    if session.get("db_backend") == "local_store":
+        return LocalStore(session["store_path"], data_base=db)
+    return MongoDB(session["mongo_ip"], data_base=db, port=session["mongo_port"])
+
+
 def init_page(template: str) -> str:
     """
     init Generate the empty page
@@ -75,7 +88,7 @@ def get_data(db, collection, state, site, sat, series, yaxis, data, reshape_on=N
     :param yaxis: Y axis name
     :return MeasurementArray: MeasurementArray object
     """
-    with MongoDB(session["mongo_ip"], data_base=db, port=session["mongo_port"]) as client:
+    with open_database(db) as client:
         try:
             for req in client.get_data(
                 collection,
@@ -153,7 +153,7 @@ int  enduserAmbigResl(Trace& trace, ObsList& obsList, KFState& kfState, Vector3d
 int  smoothdAmbigResl(KFState& kfState);																				/* Ambiguity resolution on smoothed KF*/
 
 bool ARsol_ready();
-KFState retrieve_last_ARcopy ();
+KFStateSnapshot retrieve_last_ARcopy ();
 GinAR_sat* GinAR_sat_metadata(SatSys sat);
 
 /* Output fuctions */
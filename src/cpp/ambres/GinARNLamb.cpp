@@ -136,9 +136,6 @@ int updat_ambigt(
 	
 	chk_arch( trace, kfState.time, opt );
 	
-	VectorXd KF_x =  kfState.x;
-	MatrixXd KF_P =  kfState.P;
-	
 	vector<int> 		AmbReadindx;
 	map <KFKey, int>	AmbList;
 	map <KFKey, int>	RecList;
@@ -513,7 +510,7 @@ int  apply_ambigt(
 			for (auto& [key,coef] : Zamb)
 			if (AmbList.find(key) == AmbList.end())
 			{
-				int indKF = kfState.kfIndexMap[key];
+				int indKF = kfState.getKFIndex(key);
 				AmbReadindx.push_back(indKF);
 				AmbList[key] = indH++;	
 			}
@@ -7,7 +7,7 @@
 
 #define SMP2RESET	20
 
-KFState ARcopy;
+KFStateSnapshot ARcopy = KFStateSnapshot(KFState());
 
 GinAR_opt defAR_WL;
 GinAR_opt defAR_NL;
@@ -665,7 +665,7 @@ int  networkAmbigResl(
 	if (AR_VERBO) 
 		kfState.outputStates(trace, "/AR");
 		
-	ARcopy = kfState;
+	ARcopy = KFStateSnapshot(kfState);
 	
 	return nfix;
 }
@@ -822,7 +822,7 @@ int smoothdAmbigResl(
 	if (AR_VERBO) 
 		kfState.outputStates(trace, "/AR");
 	
-	ARcopy = kfState;
+	ARcopy = KFStateSnapshot(kfState);
 	
 	return nfix;
 }
@@ -833,8 +833,8 @@ bool ARsol_ready()
 	return fixReady;
 }
 
-/** Retrieved the last ambiguity resolved Kalman filter state */
-KFState retrieve_last_ARcopy()
+/** Retrieved the last ambiguity resolved Kalman filter state, shared rather than copied */
+KFStateSnapshot retrieve_last_ARcopy()
 {
 	return 	ARcopy;
 }
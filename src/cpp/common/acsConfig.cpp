@@ -11,6 +11,7 @@
 
 using std::stringstream;
 using std::lock_guard;
+using std::make_unique;
 using std::unique_ptr;
 using std::multimap;
 using std::string;
@@ -1057,6 +1058,7 @@ void ACSConfig::info(
 	if (output_cost)						{	ss << "\tcost filename:                 " << cost_filename					<< "\n"; }
 	if (output_trop_sinex)					{	ss << "\ttrop sinex filename:           " << trop_sinex_filename			<< "\n"; }
 	if (output_gpx)							{	ss << "\tgpx filename:                  " << gpx_filename					<< "\n"; }
+	if (output_profile)						{	ss << "\tprofile filename:              " << profile_filename				<< "\n"; }
 	if (output_decoded_rtcm_json)			{	ss << "\tdecoded rtcm json filename:    " << decoded_rtcm_json_filename		<< "\n"; }
 	if (output_encoded_rtcm_json)			{	ss << "\tencoded rtcm json filename:    " << encoded_rtcm_json_filename		<< "\n"; }
 
@@ -1601,14 +1603,120 @@ void getFromYaml(
 	setInited(recOpts,	recOpts.laser_sigmas,		trySetFromYaml	(recOpts.laser_sigmas,		recNode, {"@ laser_sigmas"		},					"[floats] Standard deviation of SLR laser measurements"));
 }
 
-/** Set satellite options for a specific satellite using a hierarchy of sources
-*/
+/** Publish a snapshot of all options that have been resolved without suffixes, so that they may be looked up without locking.
+ * Snapshots are never modified once published, a new one is built only if options have been resolved since the last.
+ * Call this once per epoch, after the metadata of the satellites and receivers in use is known.
+ * The previous snapshot is kept for readers that may still be finishing a lookup in it, older snapshots are freed
+ */
+void ACSConfig::publishOptsSnapshot()
+{
+	lock_guard<mutex> guard(configMutex);
+	
+	if (resolvedOptsChanged == false)
+	{
+		return;
+	}
+	
+	auto newSnapshot_ptr = make_unique<OptionsSnapshot>(resolvedOpts);
+	
+	optsSnapshot_ptr.store(newSnapshot_ptr.get(), std::memory_order_release);
+	
+	prevOptsSnapshot	= std::move(optsSnapshot);
+	optsSnapshot		= std::move(newSnapshot_ptr);
+	
+	resolvedOptsChanged = false;
+}
+
+/** Discard all published options snapshots, before the options they point to are cleared
+ */
+void ACSConfig::clearOptsSnapshots()
+{
+	lock_guard<mutex> guard(configMutex);
+	
+	optsSnapshot_ptr.store(nullptr, std::memory_order_release);
+	
+	optsSnapshot		.reset();
+	prevOptsSnapshot	.reset();
+	resolvedOpts		= OptionsSnapshot();
+	resolvedOptsChanged	= false;
+}
+
+/** Get the options for a satellite.
+ * Options without suffixes are looked up in the published snapshot without locking,
+ * they are resolved (under lock) until they are included in a published snapshot, or after they have been reinitialised
+ */
 SatelliteOptions& ACSConfig::getSatOpts(
 	SatSys			Sat,		///< Satellite to search for options for
 	vector<string>	suffixes)	///< Optional suffix to get more specific versions
 {
+	if (suffixes.empty())
+	{
+		auto snapshot_ptr = optsSnapshot_ptr.load(std::memory_order_acquire);
+		if (snapshot_ptr)
+		{
+			auto it = snapshot_ptr->satOptsMap.find(Sat);
+			if	( it != snapshot_ptr->satOptsMap.end()
+				&&it->second->_initialised)
+			{
+				return *it->second;
+			}
+		}
+	}
+	
+	lock_guard<mutex> guard(configMutex);
+	
+	auto& satOpts = resolveSatOpts(Sat, suffixes);
+	
+	if (suffixes.empty())
+	{
+		resolvedOpts.satOptsMap[Sat]	= &satOpts;
+		resolvedOptsChanged				= true;
+	}
+	
+	return satOpts;
+}
+
+/** Get the options for a receiver.
+ * Options without suffixes are looked up in the published snapshot without locking,
+ * they are resolved (under lock) until they are included in a published snapshot, or after they have been reinitialised
+ */
+ReceiverOptions& ACSConfig::getRecOpts(
+	string			id,			///< Receiver to search for options for
+	vector<string>	suffixes)	///< Optional suffix to get more specific versions
+{
+	if (suffixes.empty())
+	{
+		auto snapshot_ptr = optsSnapshot_ptr.load(std::memory_order_acquire);
+		if (snapshot_ptr)
+		{
+			auto it = snapshot_ptr->recOptsMap.find(id);
+			if	( it != snapshot_ptr->recOptsMap.end()
+				&&it->second->_initialised)
+			{
+				return *it->second;
+			}
+		}
+	}
+	
 	lock_guard<mutex> guard(configMutex);
+	
+	auto& recOpts = resolveRecOpts(id, suffixes);
+	
+	if (suffixes.empty())
+	{
+		resolvedOpts.recOptsMap[id]	= &recOpts;
+		resolvedOptsChanged			= true;
+	}
+	
+	return recOpts;
+}
 
+/** Set satellite options for a specific satellite using a hierarchy of sources
+*/
+SatelliteOptions& ACSConfig::resolveSatOpts(
+	SatSys			Sat,		///< Satellite to search for options for
+	vector<string>	suffixes)	///< Optional suffix to get more specific versions
+{
 	string fullId = Sat.id();
 	for (auto& suffix : suffixes)
 	{
@@ -1710,6 +1818,9 @@ SatelliteOptions& ACSConfig::getSatOpts(
             {	auto vec = descriptorVec; vec.insert(vec.end(), {"@ pcv",			"@ enable"			});	setInited(aliasOpts,	aliasOpts.sat_pcv,							trySetFromYaml(aliasOpts.sat_pcv,							{yaml, ""}, vec, "(bool) Enable modelling of phase center variations"));			};
 			{	auto vec = descriptorVec; vec.insert(vec.end(), {"@ attitude",		"@ enable"			});	setInited(aliasOpts,	aliasOpts.sat_attitude.enable,				trySetFromYaml(aliasOpts.sat_attitude.enable,				{yaml, ""}, vec, "(bool) Enables non-nominal attitude types"));						};
 			{	auto vec = descriptorVec; vec.insert(vec.end(), {"@ attitude",		"@ sources"			});	setInited(aliasOpts,	aliasOpts.sat_attitude.sources, 			trySetEnumVec( aliasOpts.sat_attitude.sources, 				{yaml, ""}, vec, "List of sourecs to use for attitudes "));							};
+			{	auto vec = descriptorVec; vec.insert(vec.end(), {"@ integrator",	"@ tolerance"		});	setInited(aliasOpts,	aliasOpts.sat_integrator.tolerance,			trySetFromYaml(aliasOpts.sat_integrator.tolerance,			{yaml, ""}, vec, "(float) Maximum position error estimate (m) per step of the adaptive orbit integrator"));	};
+			{	auto vec = descriptorVec; vec.insert(vec.end(), {"@ integrator",	"@ min_step"		});	setInited(aliasOpts,	aliasOpts.sat_integrator.min_step,			trySetFromYaml(aliasOpts.sat_integrator.min_step,			{yaml, ""}, vec, "(float) Minimum step size (s) of the adaptive orbit integrator"));						};
+			{	auto vec = descriptorVec; vec.insert(vec.end(), {"@ integrator",	"@ max_step"		});	setInited(aliasOpts,	aliasOpts.sat_integrator.max_step,			trySetFromYaml(aliasOpts.sat_integrator.max_step,			{yaml, ""}, vec, "(float) Maximum step size (s) of the adaptive orbit integrator"));						};
 			
 			{	auto vec = descriptorVec; vec.push_back("@ antenna_boresight");		trySetFromYaml	(antenna_boresight,			{yaml, ""}, vec,	"[floats] Antenna boresight (Up) in satellite body-fixed frame");	}
 			{	auto vec = descriptorVec; vec.push_back("@ antenna_azimuth");		trySetFromYaml	(antenna_azimuth,			{yaml, ""}, vec,	"[floats] Antenna azimuth (North) in satellite body-fixed frame");	}
@@ -1726,12 +1837,10 @@ SatelliteOptions& ACSConfig::getSatOpts(
 
 /** Set receiver options for a specific receiver using a hierarchy of sources
 */
-ReceiverOptions& ACSConfig::getRecOpts(
+ReceiverOptions& ACSConfig::resolveRecOpts(
 	string			id,			///< Receiver to search for options for
 	vector<string>	suffixes)	///< Optional suffix to get more specific versions
 {
-	lock_guard<mutex> guard(configMutex);
-
 	string fullId = id;
 	for (auto& suffix : suffixes)
 	{
@@ -2157,6 +2266,7 @@ bool ACSConfig::parse(
 	commandOpts = newCommandOpts;
 
 	//clear old saved parameters
+	clearOptsSnapshots();
 	satOptsMap.clear();
 	recOptsMap.clear();
 	defaultOutputOptions();
@@ -2429,6 +2539,15 @@ bool ACSConfig::parse(
 				trySetFromYaml(ntrip_log_filename,		ntrip_log, {"@ filename"	});
 			}
 
+			{
+				auto profile = stringsToYamlObject(outputs, {"@ profile"}, "Profiling records the time spent in instrumented zones of the program, and counters of the work done");
+
+				trySetFromYaml(output_profile,				profile, {"0@ output"			}, "(bool) Enable recording and exporting of profiling data. May be switched while running");
+				trySetFromYaml(profile_directory,			profile, {"@ directory"			}, "(string) Directory to export profiling data");
+				trySetFromYaml(profile_filename,			profile, {"@ filename"			}, "(string) Chrome trace / perfetto json filename, viewable while running");
+				trySetFromYaml(profile_summary_filename,	profile, {"@ summary_filename"	}, "(string) Per-epoch csv summary of zone times and counters");
+			}
+
 			{
 				auto gpx = stringsToYamlObject(outputs, {"! gpx"}, "GPX files contain point data that may be easily viewed in GIS mapping software");
 
@@ -2713,6 +2832,7 @@ bool ACSConfig::parse(
 			trySetFromYaml	(use_tgd_bias,								general, {"@ use_tgd_bias"				}, "(bool) Use TGD/BGD bias from ephemeris, DO NOT turn on unless using Klobuchar/NeQuick Ionospheres");
 			trySetFromYaml	(common_sat_pco,							general, {"@ common_sat_pco"			}, "(bool) Use L1 satellite PCO values for all signals");
 			trySetFromYaml	(common_rec_pco,							general, {"@ common_rec_pco"			}, "(bool) Use L1 receiver PCO values for all signals");
+			trySetFromYaml	(sat_pos_cache_window,						general, {"@ sat_pos_cache_window"		}, "(float) Width of windows of transmission times (s) within which satellite positions and clocks are computed once and shared between stations, extrapolating with velocities and clock rates. Extrapolation errors grow with the square of the width, 0.02 keeps them well below a millimetre. 0 (default) to disable");
 			trySetFromYaml	(leap_seconds,								general, {"@ gpst_utc_leap_seconds"		}, "(int) Difference between gps time and utc in leap seconds");
 
 			trySetFromYaml	(process_meas[CODE],						general, {"1@ code_measurements",		"process"	}, "(bool) Process code measurements");
@@ -3047,6 +3167,8 @@ bool ACSConfig::parse(
 				trySetFromYaml(pppOpts.rts_smoothed_suffix,		rts,				{"suffix"					}, "(string) Suffix to be applied to smoothed versions of files");
 				trySetEnumOpt( pppOpts.rts_inverter, 			rts,				{"inverter" 				}, E_Inverter::_from_string_nocase, "Inverter to be used within the rts processor, which may provide different performance outcomes in terms of processing time and accuracy and stability.");
 				trySetFromYaml(pppOpts.output_intermediate_rts,	rts,				{"output_intermediates"		}, "(bool) Output best available smoothed states when performing fixed-lag rts (slow, use only when needed)");
+				trySetFromYaml(pppOpts.rts_in_memory,			rts,				{"in_memory"				}, "(bool) Keep the history for fixed-lag rts in memory rather than re-reading and rewriting the forward file each epoch");
+				trySetFromYaml(pppOpts.rts_compact_archive,		rts,				{"compact_archive"			}, "(bool) Write rts intermediate files as compact indexed archives, with keys stored once and only the upper triangle of covariance matrices");
 			}
 
 		}
@@ -3074,6 +3196,7 @@ bool ACSConfig::parse(
 			trySetFromYaml(orbitPropagation.degree_max,					orbit_propagation, {"@ degree_max"					}, "(int) Maximum degree of spherical harmonics model");
 			trySetFromYaml(orbitPropagation.itrf_pseudoobs,				orbit_propagation, {"@ itrf_pseudoobs"				}, "(bool) Pseudo observations are provided in ITRF frame rather than standard ECEF SP3 files");
 			trySetFromYaml(orbitPropagation.integrator_time_step,		orbit_propagation, {"@ integrator_time_step"		}, "(float) Timestep for the integrator, must be smaller than the processing time step, might be adjusted if the processing time step isn't a integer number of time steps");
+			trySetFromYaml(orbitPropagation.adaptive_integrator,		orbit_propagation, {"@ adaptive_integrator"			}, "(bool) Use an error controlled step size for the integrator, with tolerances and step limits from the satellite options. Predictions at intermediate times are interpolated rather than re-integrated");
 		}
 					
                                                       
@@ -3160,6 +3283,8 @@ bool ACSConfig::parse(
 			trySetFromYaml(localMongo.suffix,						mongo, {"@ suffix"					}, "(string) Suffix to append to database elements to make distinctions between runs for comparison");
 			trySetFromYaml(localMongo.database,						mongo, {"@ database"				}, "(string) ");
 			trySetFromYaml(localMongo.uri,							mongo, {"@ uri"						}, "(string) Location and port of the mongo database to connect to");
+			trySetEnumOpt(localMongo.backend,						mongo, {"@ backend"					}, E_Database::_from_string_nocase, "Database to use, mongo or a local file-backed store that requires no server");
+			trySetFromYaml(localMongo.store_filename,				mongo, {"@ store_filename"			}, "(string) File to hold the data when using the local store backend");
 			
 			trySetScaledFromYaml(localMongo.prediction_interval,			mongo, {"@ prediction_interval"			},	{"@ interval_units"	},	E_Period::_from_string_nocase);
 			trySetScaledFromYaml(localMongo.forward_prediction_duration,	mongo, {"@ forward_prediction_duration"	},	{"@ duration_units"	},	E_Period::_from_string_nocase);
@@ -3185,6 +3310,8 @@ bool ACSConfig::parse(
 			trySetFromYaml(remoteMongo.suffix,						mongo, {"@ suffix"						}, "(string) Suffix to append to database elements to make distinctions between runs for comparison");
 			trySetFromYaml(remoteMongo.database,					mongo, {"@ database"					}, "(string) ");
 			trySetFromYaml(remoteMongo.uri,							mongo, {"@ uri"							}, "(string) Location and port of the mongo database to connect to");
+			trySetEnumOpt(remoteMongo.backend,						mongo, {"@ backend"						}, E_Database::_from_string_nocase, "Database to use, mongo or a local file-backed store that requires no server");
+			trySetFromYaml(remoteMongo.store_filename,				mongo, {"@ store_filename"				}, "(string) File to hold the data when using the local store backend");
 		
 			trySetScaledFromYaml(remoteMongo.prediction_interval,			mongo, {"@ prediction_interval"			},	{"@ interval_units"	},	E_Period::_from_string_nocase);
 			trySetScaledFromYaml(remoteMongo.forward_prediction_duration,	mongo, {"@ forward_prediction_duration"	},	{"@ duration_units"	},	E_Period::_from_string_nocase);
@@ -3269,6 +3396,11 @@ bool ACSConfig::parse(
 	tryPatchPaths(root_output_directory,	rtcm_obs_directory,						rtcm_obs_filename);
 	tryPatchPaths(root_output_directory,	orbit_ics_directory,					orbit_ics_filename);
 	tryPatchPaths(root_output_directory,	ntrip_log_directory,					ntrip_log_filename);
+	tryPatchPaths(root_output_directory,	profile_directory,						profile_filename);
+	tryAddRootToPath(profile_directory,		profile_summary_filename);
+	replaceTags(profile_summary_filename);
+	tryAddRootToPath(root_output_directory,	localMongo.store_filename);
+	tryAddRootToPath(root_output_directory,	remoteMongo.store_filename);
 	tryPatchPaths(root_output_directory,	rinex_obs_directory,					rinex_obs_filename);
 	tryPatchPaths(root_output_directory,	rinex_nav_directory,					rinex_nav_filename);
 	tryPatchPaths(root_output_directory,	sp3_directory,							predicted_sp3_filename);
@@ -3311,10 +3443,12 @@ bool ACSConfig::parse(
 	
 	replaceTags(localMongo.suffix);
 	replaceTags(localMongo.database);
+	replaceTags(localMongo.store_filename);
 	
 	replaceTags(remoteMongo.suffix);
 	replaceTags(remoteMongo.database);
-	
+	replaceTags(remoteMongo.store_filename);
+
 	SatSys dummySat("G01");
 	getSatOpts(dummySat, {"L1W"});
 	getRecOpts("global");
@@ -9,6 +9,8 @@
 
 #include "eigenIncluder.hpp"
 
+#include <unordered_map>
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <limits>
@@ -19,6 +21,8 @@
 #include <map>
 #include <set>
 
+using std::unordered_map;
+using std::unique_ptr;
 using std::vector;
 using std::string;
 using std::tuple;
@@ -159,6 +163,11 @@ struct OutputOptions
 	string	ntrip_log_directory			= "./";
 	string  ntrip_log_filename			= "ntrip_log-<LOGTIME>.json";
 
+	bool	output_profile				= false;
+	string	profile_directory			= "./";
+	string	profile_filename			= "<CONFIG>-<LOGTIME>_profile.json";
+	string	profile_summary_filename	= "<CONFIG>-<LOGTIME>_profile.csv";
+
 	bool	output_gpx					= false;
 	string	gpx_directory	         	= "./";
 	string  gpx_filename				= "<STATION>-<LOGTIME>.gpx";
@@ -533,6 +542,8 @@ struct GlobalOptions
 	bool common_sat_pco	= false;
 	bool common_rec_pco	= false;
 	
+	double	sat_pos_cache_window	= 0;	///< Width of windows of transmission times that share satellite positions and clocks (s), 0 to disable
+	
 	
 	double clock_wrap_threshold = 0.05e-3;
 
@@ -590,6 +601,8 @@ struct FilterOptions
 	int			rts_lag					= -1;
 	string		rts_smoothed_suffix		= "_smoothed";
 	bool		output_intermediate_rts	= false;
+	bool		rts_in_memory			= false;
+	bool		rts_compact_archive		= false;
 	
 	E_Inverter	rts_inverter			= E_Inverter::LDLT;
 	E_Inverter	inverter				= E_Inverter::LDLT;
@@ -783,6 +796,13 @@ struct SatelliteOptions
 		double	undefined_sigma = 0;
 	} sat_phase_bias;
 	
+	struct
+	{
+		double	tolerance		= 1e-3;		///< Maximum position error estimate per step of the adaptive orbit integrator (m)
+		double	min_step		= 1;		///< Minimum step size of the adaptive orbit integrator (s)
+		double	max_step		= 900;		///< Maximum step size of the adaptive orbit integrator (s)
+	} sat_integrator;
+	
 	bool		sat_pco				= true;
 	bool		sat_pcv				= true;
 	
@@ -845,6 +865,9 @@ struct SatelliteOptions
 		if (isInited(rhs, rhs.sat_phase_bias.undefined_sigma))	{ sat_phase_bias.undefined_sigma= rhs.sat_phase_bias.undefined_sigma;	setInited(*this, sat_phase_bias.undefined_sigma	);	}
 		if (isInited(rhs, rhs.sat_pco						))	{ sat_pco						= rhs.sat_pco						;	setInited(*this, sat_pco						);	}
 		if (isInited(rhs, rhs.sat_pcv						))	{ sat_pcv						= rhs.sat_pcv						;	setInited(*this, sat_pcv						);	}
+		if (isInited(rhs, rhs.sat_integrator.tolerance		))	{ sat_integrator.tolerance		= rhs.sat_integrator.tolerance		;	setInited(*this, sat_integrator.tolerance		);	}
+		if (isInited(rhs, rhs.sat_integrator.min_step		))	{ sat_integrator.min_step		= rhs.sat_integrator.min_step		;	setInited(*this, sat_integrator.min_step		);	}
+		if (isInited(rhs, rhs.sat_integrator.max_step		))	{ sat_integrator.max_step		= rhs.sat_integrator.max_step		;	setInited(*this, sat_integrator.max_step		);	}
 		
 		return *this;
 	}
@@ -1025,6 +1048,8 @@ struct MongoOptions
 	bool	delete_history					= false;
 	bool	cull_history					= false;
 	bool	local							= false;
+	E_Database	backend						= E_Database::MONGO;
+	string	store_filename					= "<CONFIG>.store";
 	string	uri								= "mongodb://localhost:27017";
 	string	suffix							= "";
 	string	database						= "<CONFIG>";
@@ -1116,6 +1141,7 @@ struct OrbitPropagation
 	double 			sat_power						= 20;
 	double			srp_cr							= 1.25;
 	double 			integrator_time_step			= 60;
+	bool			adaptive_integrator				= false;
 	bool			itrf_pseudoobs					= true;
 };
 
@@ -1128,6 +1154,15 @@ struct YamlDefault
 	string	enumName;
 };
 
+/** Table of satellite and receiver options that have already been resolved.
+ * Published snapshots are immutable, so they may be read from any thread without locking
+ */
+struct OptionsSnapshot
+{
+	unordered_map<SatSys, SatelliteOptions*>	satOptsMap;		///< Resolved options for satellites, without suffixes
+	unordered_map<string, ReceiverOptions*>		recOptsMap;		///< Resolved options for receivers, without suffixes
+};
+
 /** General options object to be used throughout the software
 */
 struct ACSConfig : GlobalOptions, InputOptions, OutputOptions, DebugOptions
@@ -1165,6 +1200,18 @@ struct ACSConfig : GlobalOptions, InputOptions, OutputOptions, DebugOptions
 	SatelliteOptions&			getSatOpts				(SatSys	Sat,	vector<string> suffixes = {});
 	ReceiverOptions&			getRecOpts				(string	id,		vector<string> suffixes = {});
 
+	SatelliteOptions&			resolveSatOpts			(SatSys	Sat,	vector<string> suffixes = {});
+	ReceiverOptions&			resolveRecOpts			(string	id,		vector<string> suffixes = {});
+
+	void						publishOptsSnapshot		();
+	void						clearOptsSnapshots		();
+
+	std::atomic<const OptionsSnapshot*>		optsSnapshot_ptr	= nullptr;		///< Most recently published snapshot of resolved options
+	unique_ptr<OptionsSnapshot>				optsSnapshot;						///< Owner of the most recently published snapshot
+	unique_ptr<OptionsSnapshot>				prevOptsSnapshot;					///< Owner of the previous snapshot, kept for readers that may still be finishing a lookup in it
+	OptionsSnapshot							resolvedOpts;						///< All options resolved without suffixes since the last parse, guarded by configMutex
+	bool									resolvedOptsChanged	= false;		///< Options have been resolved since the snapshot was published
+
 	map<string,		SatelliteOptions>	satOptsMap;
 	map<string,		ReceiverOptions>	recOptsMap;
 
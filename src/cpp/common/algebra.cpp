@@ -1,6 +1,7 @@
 
 
 #include <utility>
+#include <sstream>
 
 using std::pair;
 
@@ -44,15 +45,100 @@ using std::pair;
 
 const KFKey KFState::oneKey = {.type = KF::ONE};
 
+thread_local KFStateUpdateBuffer* KFState::updateBuffer_ptr = nullptr;
+
+/** Apply the recorded modifications to a filter state.
+ * States that were provisionally reported as new to this buffer's owner may have been added by an earlier buffer in the meantime.
+ * The filter then initialises them with that earlier initial value, so the owner's measurements are relinearised about it
+*/
+void KFStateUpdateBuffer::apply(
+	KFState&	kfState)	///< Filter state to modify
+{
+	for (auto& update : updateList)
+	switch (update.type)
+	{
+		case KFStateUpdate::ADD_STATE:
+		{
+			bool isNew = kfState.addKFState(update.key, update.initialState);
+			
+			bool reportedNew = newKeys.erase(update.key);
+			if	( isNew			== true
+				||reportedNew	== false
+				||kfMeasEntryList_ptr == nullptr)
+			{
+				break;
+			}
+			
+			auto& transitions	= kfState.stateTransitionMap[update.key];
+			auto oneIt			= transitions.find(KFState::oneKey);
+			if (oneIt == transitions.end())
+			{
+				break;
+			}
+			
+			auto& [oneKey, oneTransition] = *oneIt;
+			
+			double dx	= oneTransition[0]
+						- update.initialState.x;
+			
+			if (dx == 0)
+			{
+				break;
+			}
+			
+			for (auto& kfMeasEntry : *kfMeasEntryList_ptr)
+			{
+				auto it = kfMeasEntry.designEntryMap.find(update.key);
+				if (it == kfMeasEntry.designEntryMap.end())
+				{
+					continue;
+				}
+				
+				auto& [key, coeff] = *it;
+				
+				kfMeasEntry.innov -= coeff * dx;
+			}
+			
+			break;
+		}
+		case KFStateUpdate::SET_TRANS:			{	kfState.setKFTrans			(update.key, update.source, update.value, update.initialState);								break;	}
+		case KFStateUpdate::SET_TRANS_RATE:		{	kfState.setKFTransRate		(update.key, update.source, update.value, update.sourceInitialState, update.initialState);	break;	}
+		case KFStateUpdate::ADD_NOISE:			{	kfState.addNoiseElement		(update.key, update.value);																	break;	}
+		case KFStateUpdate::SET_EXPONENTIAL:	{	kfState.setExponentialNoise	(update.key, update.exponential);															break;	}
+	}
+	
+	updateList	.clear();
+	newKeys		.clear();
+}
+
 struct KFStatistics
 {
 	double averageRatio	= 0;
 	double sumOfSquares	= 0;
 };
 
+/** Calculate the diagonal of H * P * H^T, touching only the non-zero elements of the (sparse) design matrix
+*/
+template<typename PTYPE>
+VectorXd sparseHPHtDiagonal(
+	const	RowSparseMatrix&	H,		///< Design matrix
+	const	PTYPE&				P)		///< Covariance matrix (or block)
+{
+	MatrixXd	HP			= H * P;
+	VectorXd	diagonal	= VectorXd::Zero(H.rows());
+	
+	for (int i = 0; i < H.outerSize(); i++)
+	for (RowSparseMatrix::InnerIterator it(H, i); it; ++it)
+	{
+		diagonal(i) += HP(i, it.col()) * it.value();
+	}
+	
+	return diagonal;
+}
+
 bool KFKey::operator ==(const KFKey& b) const
 {
-	if (str.compare(b.str)	!= 0)		return false;
+	if (str					!= b.str)	return false;
 	if (Sat					!= b.Sat)	return false;
 	if (type				!= b.type)	return false;
 	if (num					!= b.num)	return false;
@@ -61,10 +147,8 @@ bool KFKey::operator ==(const KFKey& b) const
 
 bool KFKey::operator <(const KFKey& b) const
 {
-	int strCompare = str.compare(b.str);
-
-	if (strCompare < 0)		return true;
-	if (strCompare > 0)		return false;
+	if (str.id < b.str.id)	return true;
+	if (str.id > b.str.id)	return false;
 
 	if (Sat < b.Sat)		return true;
 	if (Sat > b.Sat)		return false;
@@ -93,10 +177,18 @@ void KFState::initFilterEpoch()
 		}
 		
 		//remove initialisation elements for subsequent epochs
-		mapp.erase(oneKey);
+		if (mapp.erase(oneKey))
+		{
+			transitionCache.changedRows.insert(key1);
+		}
 	}
 	
-	stateTransitionMap	[oneKey][oneKey][0]	= 1;
+	auto& oneTransition = stateTransitionMap[oneKey][oneKey][0];
+	if (oneTransition != 1)
+	{
+		oneTransition = 1;
+		transitionCache.changedRows.insert(oneKey);
+	}
 // 	ZTransitionMap		[oneKey][oneKey]	= 1;
 }
 
@@ -106,12 +198,7 @@ int KFState::getKFIndex(
 	const	KFKey		key)		///< Key to search for in state
 const
 {
-	auto index = kfIndexMap.find(key);
-	if (index == kfIndexMap.end())
-	{
-		return -1;
-	}
-	return index->second;
+	return kfIndexMap.index(key);
 }
 
 /** Finds the position in the KF state vector of particular states.
@@ -120,12 +207,7 @@ int KFState::getNoiseIndex(
 	const	KFKey		key)		///< Key to search for in state
 const
 {
-	auto index = noiseIndexMap.find(key);
-	if (index == noiseIndexMap.end())
-	{
-		return -1;
-	}
-	return index->second;
+	return noiseIndexMap.index(key);
 }
 
 /** Returns the value and variance of a state within the kalman filter object
@@ -137,13 +219,12 @@ bool KFState::getKFValue(
 			double*		adjustment_ptr)	///< Optional adjustment output
 const
 {
-	auto a = kfIndexMap.find(key);
-	if (a == kfIndexMap.end())
+	int index = kfIndexMap.index(key);
+	if (index < 0)
 	{
 //		std::cout << std::endl << "Warning: State not found in filter: " << key << std::endl;
 		return false;
 	}
-	int index = a->second;
 	if (index >= x.size())
 	{
 		return false;
@@ -168,13 +249,13 @@ const
 bool KFState::getKFSigma(
 	const	KFKey		key,		///< Key to search for in state
 			double&		sigma)		///< Output value
+	const
 {
-	auto a = kfIndexMap.find(key);
-	if (a == kfIndexMap.end())
+	int index = kfIndexMap.index(key);
+	if (index < 0)
 	{
 		return false;
 	}
-	int index = a->second;
 	if (index >= x.size())
 	{
 		return false;
@@ -209,6 +290,9 @@ void KFState::setAccelerator(
 	
 	//t terms
 	stateTransitionMap[dotElement]	[dotDotElement][1] = value;
+	
+	transitionCache.changedRows.insert(element);
+	transitionCache.changedRows.insert(dotElement);
 }
 
 /** Adds dynamics to a filter state by inserting off-diagonal, non-time dependent elements to transition matrix
@@ -224,6 +308,8 @@ void KFState::setKFTrans(
 	auto& transition = stateTransitionMap[dest][source][0];
 	
 	transition += value;
+	
+	transitionCache.changedRows.insert(dest);
 }
 
 /** Adds dynamics to a filter state by inserting off-diagonal, time dependent elements to transition matrix
@@ -239,6 +325,8 @@ void KFState::setKFTransRate(
 	addKFState(integralKey,	initialIntegralState);
 
 	stateTransitionMap[integralKey][rateKey][1] = value;
+	
+	transitionCache.changedRows.insert(integralKey);
 }
 
 //todo aaron think about what happens when multiple states are removed at the same time - need to use the transition map contents as well as the z map contents?
@@ -258,6 +346,8 @@ void KFState::removeState(
 	gaussMarkovTauMap.		erase(kfKey);
 	gaussMarkovMuMap.		erase(kfKey);
 	exponentialNoiseMap.	erase(kfKey);
+	
+	transitionCache.changedRows.insert(kfKey);
 }
 
 /** Tries to add a state to the filter object.
@@ -273,8 +363,8 @@ bool KFState::addKFState(
 	{
 		//is an existing state, just update values
 		if (initialState.Q		!= 0)		{	procNoiseMap		[kfKey]	= initialState.Q;		}	
-		if (initialState.mu		!= 0)		{	gaussMarkovMuMap	[kfKey]	= initialState.mu;		}	
-		if (initialState.tau	!= 0)		{	gaussMarkovTauMap	[kfKey] = initialState.tau;		}
+		if (initialState.mu		!= 0)		{	auto& mu	= gaussMarkovMuMap	[kfKey];	if (mu	!= initialState.mu)		{	mu	= initialState.mu;	transitionCache.valid = false;	}	}
+		if (initialState.tau	!= 0)		{	auto& tau	= gaussMarkovTauMap	[kfKey];	if (tau	!= initialState.tau)	{	tau	= initialState.tau;	transitionCache.valid = false;	}	}
 
 		return false;
 	}
@@ -285,6 +375,7 @@ bool KFState::addKFState(
 // 	ZTransitionMap		[kfKey][kfKey]		= 1;
 	stateTransitionMap	[kfKey][kfKey]	[0]	= 1;
 	stateTransitionMap	[kfKey][oneKey]	[0]	= initialState.x;
+	transitionCache.changedRows.insert(kfKey);
 	initNoiseMap		[kfKey]				= initialState.P;
 	procNoiseMap		[kfKey]				= initialState.Q;
 	gaussMarkovTauMap	[kfKey]				= initialState.tau;
@@ -373,9 +464,66 @@ void KFState::noiseElementStateTransition()
 	int row = 0;
 	for (auto& [key, value] : noiseElementMap)
 	{
-		noiseIndexMap[key] = row;
+		noiseIndexMap.set(key, row);
 		row++;
 	}
+	
+	noiseIndexMap.reindex();
+}
+
+/** Compute F * P * F^T for a state transition matrix that is mostly identity/permutation rows.
+ * Rows of F that simply copy a single state are taken directly from P, only the remaining rows are multiplied out
+ */
+MatrixXd transitionCovariance(
+	const RowSparseMatrix&	F,		///< State transition matrix
+	const MatrixXd&			P)		///< Covariance matrix of the source states
+{
+	vector<int> sourceIndices(F.rows(), 0);
+	vector<int> mixedRows;
+
+	for (int row = 0; row < F.rows(); row++)
+	{
+		int		entries	= 0;
+		int		col		= 0;
+		double	value	= 0;
+
+		for (RowSparseMatrix::InnerIterator it(F, row); it; ++it)
+		{
+			entries++;
+			col		= it.col();
+			value	= it.value();
+		}
+
+		if	( entries	== 1
+			&&value		== 1)
+		{
+			sourceIndices[row] = col;
+		}
+		else
+		{
+			mixedRows.push_back(row);
+		}
+	}
+
+	MatrixXd newP = P(sourceIndices, sourceIndices);
+
+	if (mixedRows.empty())
+	{
+		return newP;
+	}
+
+	RowSparseMatrix	mixedF		= KFMeas::keepRows(F, mixedRows);
+	MatrixXd		mixedFPFt	= (mixedF * P) * F.transpose();
+
+	for (int i = 0; i < mixedRows.size(); i++)
+	{
+		int row = mixedRows[i];
+
+		newP.row(row) = mixedFPFt.row(i);
+		newP.col(row) = mixedFPFt.row(i).transpose();
+	}
+
+	return newP;
 }
 
 /** Add process noise and dynamics to filter object according to time gap.
@@ -405,93 +553,298 @@ void KFState::stateTransition(
 		return;
 	}
 
+	//reuse the existing index map if the layout of the states has not changed since the last transition
+	bool layoutUnchanged = (kfIndexMap.size() == stateTransitionMap.size());
+	if (layoutUnchanged)
+	{
+		int row = 0;
+		auto indexIt = kfIndexMap.begin();
+		for (auto& [newStateKey, newStateMap] : stateTransitionMap)
+		{
+			if	( indexIt->first	!= newStateKey
+				||indexIt->second	!= row)
+			{
+				layoutUnchanged = false;
+				break;
+			}
+			
+			indexIt++;
+			row++;
+		}
+	}
+	
+	KFIndexMap newKFIndexMap;
+	if (layoutUnchanged == false)
+	{
+		int row = 0;
+		for (auto& [newStateKey, newStateMap] : stateTransitionMap)
+		{
+			newKFIndexMap.set(newStateKey, row);
+			row++;
+		}
+		
+		newKFIndexMap.reindex();
+	}
+	
+	KFIndexMap& newIndexMap = layoutUnchanged ? kfIndexMap : newKFIndexMap;
+	
 	//Initialise and populate a state transition and Z transition matrix
 	SparseMatrix<double>	F_z		= SparseMatrix<double>	(newStateCount, x.rows());
-	SparseMatrix<double>	F		= SparseMatrix<double>	(newStateCount, x.rows());
 // 	MatrixXd			F		= MatrixXd::Zero(newStateCount, x.rows());
 	VectorXd			Z_plus	= VectorXd::Zero(newStateCount);
 	
-	//add transitions for any states (usually close to identity)
-	int row = 0;
-	map<KFKey, short int> newKFIndexMap;
+	auto& cache = transitionCache;
+	
+	//the cached terms refer to the columns of the states they were built against, find where those states are now
+	bool		cacheUsable = cache.valid;
+	vector<int>	colMap;
+	if (cacheUsable)
+	{
+		colMap.resize(cache.colKeyList.size());
+		
+		for (int i = 0; i < cache.colKeyList.size(); i++)
+		{
+			int col = getKFIndex(cache.colKeyList[i]);
+			
+			if (col >= x.rows())
+			{
+				col = -1;
+			}
+			
+			colMap[i] = col;
+		}
+	}
+	
+	bool structureChanged	=  cacheUsable		== false
+							|| cache.F.rows()	!= newStateCount
+							|| cache.F.cols()	!= x.rows();
+	
+	vector<KFKey>					keyList;
+	vector<vector<TransitionTerm>>	rowTermList(newStateCount);
+	keyList.reserve(newStateCount);
+	
+	//reuse the terms of rows that are still present and unmodified, only collecting the terms of new or modified rows (usually close to identity)
+	//both the cached and new rows are in key order, so they are matched up by walking along them together
+	int oldRow	= 0;
+	int row		= 0;
 	for (auto& [newStateKey, newStateMap] : stateTransitionMap)
 	{
-		newKFIndexMap[newStateKey] = row;
-
-		for (auto& [sourceStateKey, values] : newStateMap)
+		keyList.push_back(newStateKey);
+		
+		auto& termList = rowTermList[row];
+		
+		bool rebuild	=  cacheUsable	== false
+						|| cache.changedRows.count(newStateKey);
+		
+		if (rebuild == false)
 		{
-			int sourceIndex	= getKFIndex(sourceStateKey);
-
-			if	( (sourceIndex < 0)
-				||(sourceIndex >= F.cols()))
+			while	( oldRow < cache.keyList.size()
+					&&cache.keyList[oldRow] < newStateKey)
 			{
-				continue;
+				oldRow++;
 			}
 			
-			for (auto& [tExp, value] : values)
+			if	( oldRow < cache.keyList.size()
+				&&cache.keyList[oldRow] == newStateKey)
 			{
-				double tau = -1;
-				
-				auto gmIter = gaussMarkovTauMap.find(sourceStateKey);
-				if (gmIter != gaussMarkovTauMap.end())
+				if (oldRow != row)
 				{
-					auto& [dummy, sourceTau] = *gmIter;
-				
-					tau = sourceTau;
+					structureChanged = true;
 				}
-
-				double scalar = 1;
 				
-				if (tau < 0)
-				{
-					//Random Walk model (special case for First Order Gauss Markov model when tau == inf)
+				termList = std::move(cache.rowTermList[oldRow]);
 				
-					for (int i = 0; i < tExp; i++)
+				for (auto& term : termList)
+				{
+					int col = colMap[term.col];
+					if (col < 0)
 					{
-						scalar *= tgap / (i+1);
+						//source state has been removed
+						rebuild = true;
+						break;
 					}
 					
-		// 				F(row, sourceIndex) = value * scalar;
-					F.coeffRef(row, sourceIndex) += value * scalar;
-					
-					continue;
+					if (col != term.col)
+					{
+						term.col			= col;
+						structureChanged	= true;
+					}
 				}
-				
-				//First Order Gauss Markov model, Ref: Carpenter and Lee (2008) - A Stable Clock Error Model Using Coupled First- and Second-Order Gauss-Markov Processes - https://ntrs.nasa.gov/api/citations/20080044877/downloads/20080044877.pdf
+			}
+			else
+			{
+				rebuild = true;
+			}
+		}
+		
+		if (rebuild == false)
+		{
+			row++;
+			continue;
+		}
+		
+		termList.clear();
+		
+		for (auto& [sourceStateKey, values] : newStateMap)
+		{
+			int sourceIndex	= getKFIndex(sourceStateKey);
+
+			if	( (sourceIndex < 0)
+				||(sourceIndex >= x.rows()))
+			{
+				continue;
+			}
 			
-				double tempTerm = 1;
-				scalar = exp(-tgap/tau);
-				
-				for (int i = 0; i < tExp; i++)
-				{
-					scalar = tau * (tempTerm - scalar);	//recursive formula derived according to Ref: Carpenter and Lee (2008)
-					tempTerm *= tgap / (i+1);
-				}
-				
-				double transition = value * scalar;
-				
-		// 			F(row, sourceIndex) = transition;
-				F.coeffRef(row, sourceIndex) += transition;
-				
-				
-				//Add state transitions to ONE element, to allow for tiedown to average value mu
-				//derived from integrating and distributing terms for v = (v0 - mu) * exp(-t/tau) + mu;
-				//tempTerm calculated above appears to be same as required for these terms too, (at least for tExp = 0,1)
-				
+			TransitionTerm term;
+			term.col = sourceIndex;
+			
+			auto gmIter = gaussMarkovTauMap.find(sourceStateKey);
+			if (gmIter != gaussMarkovTauMap.end())
+			{
+				auto& [dummy, sourceTau] = *gmIter;
+			
+				term.tau = sourceTau;
+			}
+			
+			if (term.tau >= 0)
+			{
 				auto muIter = gaussMarkovMuMap.find(sourceStateKey);
 				if (muIter != gaussMarkovMuMap.end())
 				{
 					auto& [dummy2, mu] = *muIter;
 					
-		// 				F(row, 0) = mu * (tempTerm - transition);
-					F.coeffRef(row, 0) += mu * (tempTerm - transition);
+					term.mu		= mu;
+					term.hasMu	= true;
 				}
 			}
+			
+			for (auto& [tExp, value] : values)
+			{
+				term.tExp	= tExp;
+				term.value	= value;
+				
+				termList.push_back(term);
+			}
 		}
 		
+		structureChanged = true;
 		row++;
 	}
 	
+	cache.keyList		= std::move(keyList);
+	cache.rowTermList	= std::move(rowTermList);
+	cache.changedRows.clear();
+	
+	//the terms' columns now refer to the current states, record them so they can be mapped onto the states of the next transition
+	cache.colKeyList.assign(x.rows(), KFKey());
+	for (auto& [kfKey, index] : kfIndexMap)
+	{
+		if	( index >= 0
+			&&index < x.rows())
+		{
+			cache.colKeyList[index] = kfKey;
+		}
+	}
+	
+	if (structureChanged)
+	{
+		//lay out an entry for every column used by each row, and note where each term's values go
+		cache.F = RowSparseMatrix(newStateCount, x.rows());
+		
+		vector<vector<int>>	colListList(newStateCount);
+		Eigen::VectorXi		rowSizes(newStateCount);
+		
+		for (int row = 0; row < newStateCount; row++)
+		{
+			auto& colList = colListList[row];
+			
+			for (auto& term : cache.rowTermList[row])
+			{
+									colList.push_back(term.col);
+				if (term.hasMu)		colList.push_back(0);
+			}
+			
+			std::sort(colList.begin(), colList.end());
+			colList.erase(std::unique(colList.begin(), colList.end()), colList.end());
+			
+			rowSizes(row) = colList.size();
+		}
+		
+		cache.F.reserve(rowSizes);
+		
+		for (int row = 0; row < newStateCount; row++)
+		for (int col : colListList[row])
+		{
+			cache.F.insert(row, col) = 0;
+		}
+		
+		cache.F.makeCompressed();
+		
+		for (int row = 0; row < newStateCount; row++)
+		{
+			auto&	colList	= colListList[row];
+			int		start	= cache.F.outerIndexPtr()[row];
+			
+			for (auto& term : cache.rowTermList[row])
+			{
+									term.slot	= start + (std::lower_bound(colList.begin(), colList.end(), term.col)	- colList.begin());
+				if (term.hasMu)		term.muSlot	= start + (std::lower_bound(colList.begin(), colList.end(), 0)			- colList.begin());
+			}
+		}
+	}
+	
+	//evaluate all terms for this time gap
+	double* transitionValues = cache.F.valuePtr();
+	std::fill(transitionValues, transitionValues + cache.F.nonZeros(), 0);
+	
+	for (auto& termList	: cache.rowTermList)
+	for (auto& term		: termList)
+	{
+		double scalar = 1;
+		
+		if (term.tau < 0)
+		{
+			//Random Walk model (special case for First Order Gauss Markov model when tau == inf)
+		
+			for (int i = 0; i < term.tExp; i++)
+			{
+				scalar *= tgap / (i+1);
+			}
+			
+			transitionValues[term.slot] += term.value * scalar;
+			
+			continue;
+		}
+		
+		//First Order Gauss Markov model, Ref: Carpenter and Lee (2008) - A Stable Clock Error Model Using Coupled First- and Second-Order Gauss-Markov Processes - https://ntrs.nasa.gov/api/citations/20080044877/downloads/20080044877.pdf
+	
+		double tempTerm = 1;
+		scalar = exp(-tgap/term.tau);
+		
+		for (int i = 0; i < term.tExp; i++)
+		{
+			scalar = term.tau * (tempTerm - scalar);	//recursive formula derived according to Ref: Carpenter and Lee (2008)
+			tempTerm *= tgap / (i+1);
+		}
+		
+		double transition = term.value * scalar;
+		
+		transitionValues[term.slot] += transition;
+		
+		//Add state transitions to ONE element, to allow for tiedown to average value mu
+		//derived from integrating and distributing terms for v = (v0 - mu) * exp(-t/tau) + mu;
+		//tempTerm calculated above appears to be same as required for these terms too, (at least for tExp = 0,1)
+		
+		if (term.hasMu)
+		{
+			transitionValues[term.muSlot] += term.mu * (tempTerm - transition);
+		}
+	}
+	
+	cache.valid = true;
+	
+	const RowSparseMatrix& F = cache.F;
+	
 	noiseElementStateTransition();
 	
 // 	for (auto& [kfKey1, map] : ZTransitionMap)
@@ -525,15 +878,15 @@ void KFState::stateTransition(
 // 		Z_plus(row) = value;
 // 	}
 
-	//scale and add process noise
-	MatrixXd Q0 = MatrixXd::Zero(newStateCount, newStateCount);
+	//scale and add process noise, all contributions are on the diagonal so only keep that
+	VectorXd Q0 = VectorXd::Zero(newStateCount);
 	tgap = fabs(tgap);
 
 	//add noise as 'process noise' as the method of initialising a state's variance
 	for (auto& [kfKey, value]	: initNoiseMap)
 	{
-		auto iter = newKFIndexMap.find(kfKey);
-		if (iter == newKFIndexMap.end())
+		auto iter = newIndexMap.find(kfKey);
+		if (iter == newIndexMap.end())
 		{
 			std::cout << kfKey << " broke" << std::endl;
 			continue;
@@ -546,15 +899,15 @@ void KFState::stateTransition(
 			continue;
 		}
 
-		Q0(index, index) = value;
+		Q0(index) = value;
 	}
 
 	//add time dependent exponential process noise)
 	if	(tgap)
 	for (auto& [dest, exponential] : exponentialNoiseMap)
 	{
-		auto destIter = newKFIndexMap.find(dest);
-		if (destIter == newKFIndexMap.end())
+		auto destIter = newIndexMap.find(dest);
+		if (destIter == newIndexMap.end())
 		{
 			std::cout << dest << " broke" << std::endl;
 			continue;
@@ -576,7 +929,7 @@ void KFState::stateTransition(
 			continue;
 		}
 		
-		Q0(destIndex, destIndex) += expNoise * tgap;
+		Q0(destIndex) += expNoise * tgap;
 	}
 	
 	//shrink time dependent exponential process noise
@@ -610,8 +963,8 @@ void KFState::stateTransition(
 			}
 		}
 
-		auto destIter = newKFIndexMap.find(dest);
-		if (destIter == newKFIndexMap.end())
+		auto destIter = newIndexMap.find(dest);
+		if (destIter == newIndexMap.end())
 		{
 			std::cout << dest << " broke" << std::endl;
 			continue;
@@ -625,8 +978,8 @@ void KFState::stateTransition(
 			continue;
 		}
 
-		auto sourceIter = newKFIndexMap.find(source);
-		if (sourceIter == newKFIndexMap.end())
+		auto sourceIter = newIndexMap.find(source);
+		if (sourceIter == newIndexMap.end())
 		{
 			std::cout << dest << " broKe" << std::endl;
 			continue;
@@ -658,19 +1011,19 @@ void KFState::stateTransition(
 			{
 				//Random Walk model (special case for First Order Gauss Markov model when tau == inf)
 				
-				if		(tExp == 0)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 1	* tgap;}
-// 				else if	(tExp == 1)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 3	* tgap * tgap * tgap;	
+				if		(tExp == 0)	{	Q0(destIndex) += sourceProcessNoise / 1	* tgap;}
+// 				else if	(tExp == 1)	{	Q0(destIndex) += sourceProcessNoise / 3	* tgap * tgap * tgap;	
 		// 								Q0(sourceIndex, destIndex) += sourceProcessNoise / 2	* tgap * tgap;	
 		// 								Q0(destIndex, sourceIndex) += sourceProcessNoise / 2	* tgap * tgap; 
 // 									}
-// 				else if (tExp == 2)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 20	* tgap * tgap * tgap * tgap * tgap;}
+// 				else if (tExp == 2)	{	Q0(destIndex) += sourceProcessNoise / 20	* tgap * tgap * tgap * tgap * tgap;}
 			}
 			else
 			{
 				//First Order Gauss Markov model, Ref: Carpenter and Lee (2008) - A Stable Clock Error Model Using Coupled First- and Second-Order Gauss-Markov Processes - https://ntrs.nasa.gov/api/citations/20080044877/downloads/20080044877.pdf
 			
-				if		(tExp == 0)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 2	* tau * (1 - exp(-2*tgap/tau));		}
-				else if	(tExp == 1)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 2	* tau * tau * (	+ 2 * tgap 								//one tau from front tau3 distributed to prevent divide by zero
+				if		(tExp == 0)	{	Q0(destIndex) += sourceProcessNoise / 2	* tau * (1 - exp(-2*tgap/tau));		}
+				else if	(tExp == 1)	{	Q0(destIndex) += sourceProcessNoise / 2	* tau * tau * (	+ 2 * tgap 								//one tau from front tau3 distributed to prevent divide by zero
 																												- 4 * tau * (1 - exp(-1*tgap/tau)) 
 																												+ 1 * tau * (1 - exp(-2*tgap/tau)));	//correct formula re-derived according to Ref: Carpenter and Lee (2008)
 		// 								Q0(sourceIndex, destIndex) += sourceProcessNoise / 2	* tau * tau * (1-exp(-tgap/tau)) * (1-exp(-tgap/tau));
@@ -694,7 +1047,7 @@ void KFState::stateTransition(
 		transitionMatrixObject.cols = F.cols();
 
 		for (int k = 0; k < F.outerSize(); ++k)
-		for (Eigen::SparseMatrix<double>::InnerIterator it(F, k); it; ++it)
+		for (RowSparseMatrix::InnerIterator it(F, k); it; ++it)
 		{
 			double transition = it.value();
 			
@@ -741,7 +1094,8 @@ void KFState::stateTransition(
 	}
 	{
 // 		Instrument	instrument("PPPalgebra3");
-		P = (F		* P * F.transpose()		+ Q0	).eval();
+		P = (transitionCovariance(F, P)).eval();
+		P.diagonal() += Q0;
 	}
 // 	if (ZAdditionMap.empty() == false)
 // 	{
@@ -754,7 +1108,10 @@ void KFState::stateTransition(
 // 	std::cout << "Q0" << std::endl << Q0 << std::endl;
 
 	//replace the index map with the updated version that corresponds to the updated state
-	kfIndexMap = std::move(newKFIndexMap);
+	if (layoutUnchanged == false)
+	{
+		kfIndexMap = std::move(newKFIndexMap);
+	}
 	
 	initFilterEpoch();
 }
@@ -774,10 +1131,10 @@ void KFState::preFitSigmaCheck(
 	int				begH,			///< Index of first measurement to process
 	int				numH)			///< Number of measurements to process
 {
-	auto		v = kfMeas.V.segment(begH, numH);
-	auto		R = kfMeas.R.block(begH, begH, numH, numH);
-	auto		H = kfMeas.H.block(begH, begX, numH, numX);
-	auto		P = this-> P.block(begX, begX, numX, numX);
+	auto			v = kfMeas.V.segment(begH, numH);
+	auto			R = kfMeas.R.block(begH, begH, numH, numH);
+	RowSparseMatrix	H = kfMeas.H.block(begH, begX, numH, numX);
+	auto			P = this-> P.block(begX, begX, numX, numX);
 
 	ArrayXd		measRatios	= ArrayXd::Zero(numH);
 	ArrayXd		stateRatios	= ArrayXd::Zero(numX);
@@ -786,7 +1143,7 @@ void KFState::preFitSigmaCheck(
 	{
 		//use 'array' for component-wise calculations
 		auto		measVariations	= v.array().square();	//delta squared
-		auto		measVariances	= (R.diagonal() + (H * P * H.transpose()).diagonal()).array();
+		auto		measVariances	= (R.diagonal() + sparseHPHtDiagonal(H, P)).array();
 	
 		measRatios	= measVariations	/ measVariances;
 		measRatios	= measRatios.isFinite()	.select(measRatios,		0);
@@ -830,10 +1187,7 @@ void KFState::preFitSigmaCheck(
 	{
 		int chunkIndex = stateIndex + begX;
 		
-		auto it = kfIndexMap.begin();
-		std::advance(it, stateIndex);
-		
-		auto& [key, dummy] = *it;
+		KFKey key = kfIndexMap.key(chunkIndex);
 		
 		trace << std::endl << "LARGE STATE ERROR OF " << maxStateRatio	<< " AT " << chunkIndex << " : " << key;
 		
@@ -891,7 +1245,7 @@ void KFState::postFitSigmaChecks(
 	int				begH,			///< Index of first measurement to process
 	int				numH)			///< Number of measurements to process
 {
-	auto						H	= kfMeas.H.block(begH, begX, numH, numX);
+	RowSparseMatrix				H	= kfMeas.H.block(begH, begX, numH, numX);
 	kfMeas.VV.segment(begH, numH)	= kfMeas.V.segment(begH, numH) - H * dx.segment(begX, numX);
 
 	//use 'array' for component-wise calculations
@@ -930,10 +1284,7 @@ void KFState::postFitSigmaChecks(
 	{
 		int chunkIndex = stateIndex + begX;
 		
-		auto it = kfIndexMap.begin();
-		std::advance(it, stateIndex);
-		
-		auto& [key, dummy] = *it;
+		KFKey key = kfIndexMap.key(chunkIndex);
 		
 		trace << std::endl << "LARGE STATE ERROR OF " << maxStateRatio	<< " AT " << chunkIndex << " : " << key;
 		
@@ -992,8 +1343,8 @@ double KFState::measChiSquare(
 	int			begH,		///< Index of first measurement to process
 	int			numH)		///< Number of measurements to process
 {
-	auto		w = dx.segment(begX, numX);
-	auto		H = kfMeas.H.block(begH, begX, numH, numX);
+	auto			w = dx.segment(begX, numX);
+	RowSparseMatrix	H = kfMeas.H.block(begH, begX, numH, numX);
 	VectorXd	v = kfMeas.V.segment(begH, numH) - H * w;
 	auto		R = kfMeas.R.block(begH, begH, numH, numH);
 
@@ -1015,10 +1366,10 @@ double KFState::innovChiSquare(
 	int			begH,		///< Index of first measurement to process
 	int			numH)		///< Number of measurements to process
 {
-	auto		H = kfMeas.H.block(begH, begX, numH, numX);
-	auto		v = kfMeas.V.segment(begH, numH);
-	auto		R = kfMeas.R.block(begH, begH, numH, numH);
-	auto		P = this->P.block(begX, begX, numX, numX);
+	RowSparseMatrix	H = kfMeas.H.block(begH, begX, numH, numX);
+	auto			v = kfMeas.V.segment(begH, numH);
+	auto			R = kfMeas.R.block(begH, begH, numH, numH);
+	auto			P = this->P.block(begX, begX, numX, numX);
 	MatrixXd	Q = R + H * P * H.transpose();
 	
 	double		chiSq = v.transpose() * Q.inverse() * v;
@@ -1046,7 +1397,8 @@ int KFState::kFilter(
 	auto& R = kfMeas.R;
 	auto& v = kfMeas.V;
 
-	auto subH = H.block(begH, begX, numH, numX);
+	//extract the (sparse) chunk of the design matrix, products below only touch its non-zero elements
+	RowSparseMatrix subH = H.block(begH, begX, numH, numX);
 	
 	MatrixXd HP	= subH	* P.block(begX, begX, numX, numX);
 	MatrixXd Q	= HP	* subH.transpose();
@@ -1055,15 +1407,18 @@ int KFState::kFilter(
 	
 	MatrixXd K;
 
+	//chunks may be filtered concurrently, so fallbacks to other inverters only apply to this call
+	E_Inverter chunkInverter = inverter;
+	
 	bool repeat = true;
 	while (repeat)
 	{
-		switch (inverter)
+		switch (chunkInverter)
 		{
 			default:
 			{
-				tracepdeex(1, trace, "\nWarning: kalman filter inverter type %s not supported, reverting", inverter._to_string());
-				inverter = E_Inverter::LDLT;
+				tracepdeex(1, trace, "\nWarning: kalman filter inverter type %s not supported, reverting", chunkInverter._to_string());
+				chunkInverter = E_Inverter::LDLT;
 				continue;
 			}
 			case E_Inverter::LDLT:
@@ -1073,9 +1428,10 @@ int KFState::kFilter(
 				solver.compute(QQ);
 				if (solver.info() != Eigen::ComputationInfo::Success)
 				{
-					xp = x;
-					Pp = P;
-					dx = VectorXd::Zero(xp.rows());
+					//only reset this chunk's block, others may be updating theirs concurrently
+					xp.segment(begX, numX)				= x.segment(begX, numX);
+					Pp.block(begX, begX, numX, numX)	= P.block(begX, begX, numX, numX);
+					dx.segment(begX, numX)				= VectorXd::Zero(numX);
 
 					return 1;
 				}
@@ -1084,9 +1440,10 @@ int KFState::kFilter(
 				if (solver.info() != Eigen::ComputationInfo::Success)
 				{
 					tracepdeex(1, trace, "Warning: kalman filter error2\n");
-					xp = x;
-					Pp = P;
-					dx = VectorXd::Zero(xp.rows());
+					//only reset this chunk's block, others may be updating theirs concurrently
+					xp.segment(begX, numX)				= x.segment(begX, numX);
+					Pp.block(begX, begX, numX, numX)	= P.block(begX, begX, numX, numX);
+					dx.segment(begX, numX)				= VectorXd::Zero(numX);
 
 					return 1;
 				}
@@ -1102,14 +1459,14 @@ int KFState::kFilter(
 				solver.compute(QQ);
 				if (solver.info() != Eigen::ComputationInfo::Success)
 				{
-					inverter = E_Inverter::LDLT;
+					chunkInverter = E_Inverter::LDLT;
 					continue;
 				}
 
 				auto Kt = solver.solve(HP);
 				if (solver.info() != Eigen::ComputationInfo::Success)
 				{
-					inverter = E_Inverter::LDLT;
+					chunkInverter = E_Inverter::LDLT;
 					continue;
 				}
 
@@ -1120,7 +1477,7 @@ int KFState::kFilter(
 			case E_Inverter::INV:
 			{
 				MatrixXd Qinv = Q.inverse();
-				K = P * H.transpose() * Qinv;
+				K = HP.transpose() * Qinv;
 
 				break;
 			}
@@ -1143,8 +1500,8 @@ int KFState::kFilter(
 	
 	if (acsConfig.joseph_stabilisation)
 	{
-		MatrixXd IKH = MatrixXd::Identity(P.rows(), P.cols()) - K * H;
-		Pp = IKH * P * IKH.transpose() + K * R * K.transpose();
+		MatrixXd IKH = MatrixXd::Identity(numX, numX) - K * subH;
+		Pp.block(begX, begX, numX, numX) = IKH * P.block(begX, begX, numX, numX) * IKH.transpose() + K * R.block(begH, begH, numH, numH) * K.transpose();
 	}
 	else
 	{
@@ -1250,8 +1607,11 @@ KFMeas KFState::combineKFMeasList(
 	kfMeas.Y	.resize(numMeas);
 
 	kfMeas.R		= MatrixXd::Zero(numMeas, numMeas);
-	kfMeas.H		= MatrixXd::Zero(numMeas, x.rows());
-	kfMeas.H_star	= MatrixXd::Zero(numMeas, noiseIndexMap.size());
+	kfMeas.H		= RowSparseMatrix(numMeas, x.rows());
+	kfMeas.H_star	= RowSparseMatrix(numMeas, noiseIndexMap.size());
+	
+	vector<Triplet<double>> designTripletList;
+	vector<Triplet<double>> noiseTripletList;
 
 	kfMeas.obsKeys			.resize(numMeas);
 	kfMeas.metaDataMaps		.resize(numMeas);
@@ -1272,7 +1632,7 @@ KFMeas KFState::combineKFMeasList(
 				std::cout << "Code error: Trying to create measurement for undefined key, check stateTransition() is called first: " << kfKey << std::endl;
 				return KFMeas();
 			}
-			kfMeas.H(meas, index) = value;
+			designTripletList.push_back({meas, index, value});
 		}
 
 		for (auto& [kfKey, value] : entry.noiseEntryMap)
@@ -1283,7 +1643,7 @@ KFMeas KFState::combineKFMeasList(
 				std::cout << "Code error: Trying to create measurement for undefined key, check stateTransition() or noiseElementStateTransition() is called first: " << kfKey << std::endl;
 				return KFMeas();
 			}
-			kfMeas.H_star(meas, index) = value;
+			noiseTripletList.push_back({meas, index, value});
 		}
 
 		kfMeas.obsKeys			[meas] = std::move(entry.obsKey);
@@ -1292,6 +1652,9 @@ KFMeas KFState::combineKFMeasList(
 		meas++;
 	}
 	
+	kfMeas.H		.setFromTriplets(designTripletList	.begin(),	designTripletList	.end());
+	kfMeas.H_star	.setFromTriplets(noiseTripletList	.begin(),	noiseTripletList	.end());
+	
 	if (noiseMatrix_ptr)
 	{
 		kfMeas.R = *noiseMatrix_ptr;
@@ -1383,6 +1746,9 @@ void KFState::filterKalman(
 	vector<FilterChunk>*	filterChunkList_ptr)	///< Optional ist of chunks for parallel processing of sub filters
 {
 	Instrument	instrument(__FUNCTION__);
+	
+	Instrument::count("states",			x.rows());
+	Instrument::count("measurements",	kfMeas.H.rows());
 		
 	if (kfMeas.time != GTime::noTime())
 	{
@@ -1431,30 +1797,69 @@ void KFState::filterKalman(
 	{
 		if (filterChunk.numX < 0)	filterChunk.numX = x.rows();
 		if (filterChunk.numH < 0)	filterChunk.numH = kfMeas.H.rows();
+	}
+	
+	//chunks are independent blocks of the state and measurements, so their checks and updates may be processed concurrently.
+	//each chunk writes its trace to a buffer which is flushed in order afterwards.
+	//reject callbacks may modify the filter and measurements that all chunks read, so the chunks are iterated in rounds,
+	//with the callbacks for each round applied serially once all chunks have finished it
+	int							numChunks	= filterChunkList.size();
+	vector<std::ostringstream>	chunkTraceList		(numChunks);
+	vector<KFStatistics>		preStatisticsList	(numChunks);
+	vector<KFStatistics>		postStatisticsList	(numChunks);
+	
+	vector<int> activeList;
+	if	(  sigma_check
+		|| w_test)
+	for (int c = 0; c < numChunks; c++)
+	{
+		activeList.push_back(c);
+	}
+	
+	for (int i = 0; i < max_prefit_remv && activeList.empty() == false; i++)
+	{
+		int numActive = activeList.size();
+		vector<KFKey>	badStateList		(numActive);
+		vector<int>		badMeasIndexList	(numActive, -1);
 		
-		KFStatistics statistics;
-		for (int i = 0; i < max_prefit_remv; i++)
-		{
-			auto& chunkTrace = *filterChunk.trace_ptr;
-
-			if	(  sigma_check	== false
-				&& w_test		== false)	
-			{
-				continue;
-			}
+#		ifdef ENABLE_PARALLELISATION
+#		ifndef ENABLE_UNIT_TESTS
+			Eigen::setNbThreads(1);
+#			pragma omp parallel for schedule(dynamic) if (numActive > 1)
+#		endif
+#		endif
+		for (int a = 0; a < numActive; a++)
+		{
+			int c = activeList[a];
+			auto& filterChunk = filterChunkList[c];
 			
-			KFKey	badState;
-			int		badMeasIndex = -1;
-
-			preFitSigmaCheck(chunkTrace, kfMeas, badState, badMeasIndex, statistics, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
+			preFitSigmaCheck(chunkTraceList[c], kfMeas, badStateList[a], badMeasIndexList[a], preStatisticsList[c], filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
+		}
+		Eigen::setNbThreads(0);
+		
+		vector<int> nextActiveList;
+		for (int a = 0; a < numActive; a++)
+		{
+			int		c				= activeList		[a];
+			auto&	chunkTrace		= chunkTraceList	[c];
+			auto&	badState		= badStateList		[a];
+			auto&	badMeasIndex	= badMeasIndexList	[a];
 			
 			if (badState.type)		{	chunkTrace << std::endl << "Prefit check failed state test";		bool keepGoing = doStateRejectCallbacks	(chunkTrace, kfMeas, badState);			/*continue;*/	}	//always fallthrough
-			if (badMeasIndex >= 0)	{	chunkTrace << std::endl << "Prefit check failed measurement test";	bool keepGoing = doMeasRejectCallbacks	(chunkTrace, kfMeas, badMeasIndex);		continue;		}	//retry next iteration	
-			else					{	chunkTrace << std::endl << "Prefit check passed";																									break;			}
+			if (badMeasIndex >= 0)	{	chunkTrace << std::endl << "Prefit check failed measurement test";	bool keepGoing = doMeasRejectCallbacks	(chunkTrace, kfMeas, badMeasIndex);		nextActiveList.push_back(c);	}	//retry next iteration	
+			else					{	chunkTrace << std::endl << "Prefit check passed";																												}
 		}
-
-		testStatistics.sumOfSquaresPre	+= statistics.sumOfSquares;
-		testStatistics.averageRatioPre	+= statistics.averageRatio / filterChunkList.size();
+		
+		activeList = nextActiveList;
+	}
+	
+	for (int c = 0; c < numChunks; c++)
+	{
+		*filterChunkList[c].trace_ptr << chunkTraceList[c].str();
+		chunkTraceList[c].str("");
+		
+		testStatistics.sumOfSquaresPre	+= preStatisticsList[c].sumOfSquares;
+		testStatistics.averageRatioPre	+= preStatisticsList[c].averageRatio / numChunks;
 	}
 
 	if	(  sigma_check 
@@ -1467,34 +1872,69 @@ void KFState::filterKalman(
 	VectorXd xp = x;
 			 dx = VectorXd::Zero(x.rows());
 	
-	for (auto& filterChunk : filterChunkList)
+	bool filterFailed = false;
+	
+	activeList.clear();
+	for (int c = 0; c < numChunks; c++)
 	{
-		KFStatistics statistics;
-		for (int i = 0; i < max_filter_iter; i++)
-		{
-			auto& chunkTrace = *filterChunk.trace_ptr;
+		activeList.push_back(c);
+	}
+	
+	for (int i = 0; i < max_filter_iter && activeList.empty() == false; i++)
+	{
+		int numActive = activeList.size();
+		vector<char>	passList			(numActive, true);
+		vector<KFKey>	badStateList		(numActive);
+		vector<int>		badMeasIndexList	(numActive, -1);
+		
+#		ifdef ENABLE_PARALLELISATION
+#		ifndef ENABLE_UNIT_TESTS
+			Eigen::setNbThreads(1);
+#			pragma omp parallel for schedule(dynamic) if (numActive > 1)
+#		endif
+#		endif
+		for (int a = 0; a < numActive; a++)
+		{
+			int c = activeList[a];
+			auto& filterChunk	= filterChunkList	[c];
+			auto& chunkTrace	= chunkTraceList	[c];
 			
-			bool pass = kFilter(chunkTrace, kfMeas, xp, Pp, dx, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
-
-			if (pass == false)
+			passList[a] = kFilter(chunkTrace, kfMeas, xp, Pp, dx, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
+			
+			if	(  passList[a]	== false
+				|| sigma_check	== false)
 			{
-				chunkTrace << "FILTER FAILED" << std::endl;
-				return;
+				continue;
 			}
 			
 // 			chunkTrace << "\nFrom " << filterChunk.begH << " for " << filterChunk.numH;
 // 			chunkTrace << "\nStat " << filterChunk.begX << " for " << filterChunk.numX;
 	// 		outputStates(chunkTrace, " Debug");
 	
+			postFitSigmaChecks(chunkTrace, kfMeas, dx, i, badStateList[a], badMeasIndexList[a], postStatisticsList[c], filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
+		}
+		Eigen::setNbThreads(0);
+		
+		vector<int> nextActiveList;
+		for (int a = 0; a < numActive; a++)
+		{
+			int		c				= activeList		[a];
+			auto&	chunkTrace		= chunkTraceList	[c];
+			auto&	badState		= badStateList		[a];
+			auto&	badMeasIndex	= badMeasIndexList	[a];
+			
+			if (passList[a] == false)
+			{
+				chunkTrace << "FILTER FAILED" << std::endl;
+				filterFailed = true;
+				continue;
+			}
+			
 			if (sigma_check == false)	
 			{
-				break;
+				continue;
 			}
 
-			KFKey	badState;
-			int		badMeasIndex = -1;
-			
-			postFitSigmaChecks(chunkTrace, kfMeas, dx, i, badState, badMeasIndex, statistics, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
 			bool stopIterating = false;
 			if (badState.type)		{	chunkTrace << std::endl << "Postfit check failed state test";		bool keepGoing = doStateRejectCallbacks	(chunkTrace, kfMeas, badState);			/*continue;*/	}	//always fallthrough
 			if (badMeasIndex >= 0)	{	chunkTrace << std::endl << "Postfit check failed measurement test";	bool keepGoing = doMeasRejectCallbacks	(chunkTrace, kfMeas, badMeasIndex);		stopIterating = false;		}	//retry next iteration	
@@ -1505,10 +1945,34 @@ void KFState::filterKalman(
 			{
 				statisticsMap["Filter iterations " + std::to_string(i+1)]++;
 				
-				break;
+				continue;
 			}
-		}
 			
+			nextActiveList.push_back(c);
+		}
+		
+		if (filterFailed)
+		{
+			break;
+		}
+		
+		activeList = nextActiveList;
+	}
+	
+	for (int c = 0; c < numChunks; c++)
+	{
+		*filterChunkList[c].trace_ptr << chunkTraceList[c].str();
+	}
+	
+	if (filterFailed)
+	{
+		return;
+	}
+	
+	for (int c = 0; c < numChunks; c++)
+	{
+		auto& filterChunk = filterChunkList[c];
+		
 		if	(outputMongoMeasurements)
 		{
 			mongoMeasResiduals	(kfMeas.time, kfMeas, suffix, filterChunk.begH, filterChunk.numH);
@@ -1519,8 +1983,8 @@ void KFState::filterKalman(
 			storeResiduals		(kfMeas.time, kfMeas.obsKeys, kfMeas.V, kfMeas.VV, kfMeas.R, suffix, filterChunk.begH, filterChunk.numH);
 		}
 
-		testStatistics.sumOfSquaresPost	+= statistics.sumOfSquares;
-		testStatistics.averageRatioPost	+= statistics.averageRatio / filterChunkList.size();
+		testStatistics.sumOfSquaresPost	+= postStatisticsList[c].sumOfSquares;
+		testStatistics.averageRatioPost	+= postStatisticsList[c].averageRatio / numChunks;
 	}
 
 	if (sigma_check)	
@@ -1690,8 +2154,11 @@ void KFState::leastSquareInitStates(
 		}
 	}
 
+	//least squares initialisation is infrequent and works on column subsets, use a dense copy of the design matrix
+	MatrixXd measH = kfMeas.H;
+	
 	//get the subset of the measurement matrix that applies to the uninitialised states
-	auto subsetA = kfMeas.H(all, newStateIndicies);
+	auto subsetA = measH(all, newStateIndicies);
 
 	//find the subset of measurements that are required for the initialisation
 	auto usedMeas = subsetA.rowwise().any();
@@ -1712,9 +2179,11 @@ void KFState::leastSquareInitStates(
 		leastSquareMeasIndicies.push_back(meas);
 
 		//remember make a pseudo measurement of anything it references that is already set
-		for (int state = 0; state < kfMeas.H.cols(); state++)
+		for (RowSparseMatrix::InnerIterator it(kfMeas.H, meas); it; ++it)
 		{
-			if	( (kfMeas.H(meas, state)	!= 0)
+			int state = it.col();
+			
+			if	( (it.value()				!= 0)
 				&&(P(state,state)			!= 0))
 			{
 				pseudoMeasStates[state] = true;
@@ -1727,29 +2196,30 @@ void KFState::leastSquareInitStates(
 	//Create new measurement objects with larger size, (using all states for now)
 	KFMeas	leastSquareMeas;
 
+	MatrixXd leastSquareH = MatrixXd::Zero(newMeasCount, measH.cols());
+	
 	leastSquareMeas.Y = VectorXd::Zero(newMeasCount);
 	leastSquareMeas.R = MatrixXd::Zero(newMeasCount, newMeasCount);
-	leastSquareMeas.H = MatrixXd::Zero(newMeasCount, kfMeas.H.cols());
 
 	int measCount = leastSquareMeasIndicies.size();
 
 	//copy in the required measurements from the old set
 	leastSquareMeas.Y.head			(measCount)				= kfMeas.Y(leastSquareMeasIndicies);
 	leastSquareMeas.R.topLeftCorner	(measCount, measCount)	= kfMeas.R(leastSquareMeasIndicies, leastSquareMeasIndicies);
-	leastSquareMeas.H.topRows		(measCount)				= kfMeas.H(leastSquareMeasIndicies, all);
+	leastSquareH.topRows			(measCount)				= measH(leastSquareMeasIndicies, all);
 
 	//append any new pseudo measurements to the end
 	for (auto& [state, boool] : pseudoMeasStates)
 	{
 		leastSquareMeas.Y(measCount)				= x(state);
 		leastSquareMeas.R(measCount, measCount)		= P(state, state);
-		leastSquareMeas.H(measCount, state)			= 1;
+		leastSquareH(measCount, state)				= 1;
 		measCount++;
 	}
 
 	//find the subset of states required for these measurements
 	vector<int> usedCols;
-	auto usedStates = leastSquareMeas.H.colwise().any();
+	auto usedStates = leastSquareH.colwise().any();
 	for (int i = 0; i < usedStates.cols(); i++)
 	{
 		if (usedStates(i) != 0)
@@ -1762,7 +2232,7 @@ void KFState::leastSquareInitStates(
 	KFMeas	leastSquareMeasSubs;
 	leastSquareMeasSubs.Y = leastSquareMeas.Y;
 	leastSquareMeasSubs.R = leastSquareMeas.R;
-	leastSquareMeasSubs.H = leastSquareMeas.H(all, usedCols);
+	leastSquareMeasSubs.H = MatrixXd(leastSquareH(all, usedCols)).sparseView();
 
 	//invert measurement noise matrix to get a weight matrix
 	leastSquareMeasSubs.W = (1 / leastSquareMeasSubs.R.diagonal().array()).matrix();
@@ -1892,8 +2362,11 @@ void KFState::leastSquareInitStatesA(
 		}
 	}
 
+	//least squares initialisation is infrequent and works on column subsets, use a dense copy of the design matrix
+	MatrixXd measH = kfMeas.H;
+	
 	//get the subset of the measurement matrix that applies to the uninitialised states
-	auto subsetA = kfMeas.H(all, newStateIndicies);
+	auto subsetA = measH(all, newStateIndicies);
 
 	//find the subset of measurements that are required for the initialisation
 	auto usedMeas = subsetA.rowwise().any();
@@ -1921,7 +2394,7 @@ void KFState::leastSquareInitStatesA(
 	leastSquareMeas.V	= kfMeas.V(leastSquareMeasIndicies);
 	leastSquareMeas.VV	= leastSquareMeas.V;
 	leastSquareMeas.R	= kfMeas.R(leastSquareMeasIndicies, leastSquareMeasIndicies);
-	leastSquareMeas.H	= kfMeas.H(leastSquareMeasIndicies, all);
+	leastSquareMeas.H	= KFMeas::keepRows(kfMeas.H, leastSquareMeasIndicies);
 
 	//invert measurement noise matrix to get a weight matrix
 	leastSquareMeas.W = (1 / leastSquareMeas.R.diagonal().array()).matrix();
@@ -2068,8 +2541,10 @@ const
 			indices[mapIndex] = stateIndex;
 		}
 		
-		subState.kfIndexMap[kfKey] = mapIndex;
+		subState.kfIndexMap.set(kfKey, mapIndex);
 	}
+	
+	subState.kfIndexMap.reindex();
 
 	subState.time	= time;
 	subState.x		= x	(indices);
@@ -2078,6 +2553,7 @@ const
 	subState.P		= P	(indices, indices);
 
 	subState.stateTransitionMap	.clear();
+	subState.transitionCache		= TransitionCache();
 // 	subState.ZTransitionMap		.clear();
 	
 	for (auto& [keyA, stmMap] : stateTransitionMap)
@@ -2128,6 +2604,7 @@ void KFState::outputStates(
 		string		suffix,	///< Suffix to append to state block info tag in trace files
 		int			begX,	///< Index of first state element to process
 		int			numX)   ///< Number of state elements to process
+	const
 {
 	Instrument	instrument(__FUNCTION__);
 		
@@ -2328,7 +2805,7 @@ void KFState::outputMeasurements(
 		
 		for (int j = 1; j < meas.H.cols(); j++)
 		{
-			double a = meas.H(i,j);
+			double a = meas.H.coeff(i,j);
 			
 			if (fabs(a) > 0.001)		tracepdeex(2, trace, "%6.2f ", a);
 			else						tracepdeex(2, trace, "%6.2s ", "");		
@@ -2426,17 +2903,19 @@ KFState mergeFilters(
 	int i = 0;
 	for (auto& [key, value] : stateValueMap)
 	{
-		mergedKFState.kfIndexMap[key]	= i;
+		mergedKFState.kfIndexMap.set(key, i);
 		mergedKFState.x(i)				= value;
 
 		i++;
 	}
+	
+	mergedKFState.kfIndexMap.reindex();
 
 	for (auto& [key1, map2]		: stateCovarMap)
 	for (auto& [key2, value]	: map2)
 	{
-		int index1 = mergedKFState.kfIndexMap[key1];
-		int index2 = mergedKFState.kfIndexMap[key2];
+		int index1 = mergedKFState.kfIndexMap.index(key1);
+		int index2 = mergedKFState.kfIndexMap.index(key2);
 
 		mergedKFState.P(index1, index2) = value;
 	}
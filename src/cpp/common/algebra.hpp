@@ -4,17 +4,23 @@
 #include "eigenIncluder.hpp"
 #include <boost/algorithm/string.hpp>
 
+#include <unordered_set>
+#include <unordered_map>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <limits>
+#include <memory>
 #include <math.h>  
 #include <mutex>  
 #include <tuple>
 #include <map>
 
 using boost::algorithm::to_lower;
+using std::unordered_set;
+using std::unordered_map;
 using std::lock_guard;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 using std::mutex;
@@ -23,6 +29,7 @@ using std::hash;
 using std::pair;
 using std::map;
 
+#include "internedString.hpp"
 #include "satSys.hpp"
 #include "gTime.hpp"
 #include "trace.hpp"
@@ -35,15 +42,17 @@ struct Station;
 * These have parameters to separate states of different 'type', for different 'Sat's, with different receiver id 'str's and may have a different 'num' (eg xyz->0,1,2)
 *
 * Keys should be used rather than indices for accessing kalman filter state parameters.
+*
+* Strings within keys are interned to integer ids, so keys are trivially copyable and are compared, ordered, and hashed by those ids without touching the string contents.
 */
 struct KFKey
 {
-	short int	type	= 0;			///< Key type (From enum)
-	SatSys		Sat		= {};			///< Satellite
-	string		str		= "";			///< String (receiver ID)
-	short int 	num		= 0;			///< Subkey number (eg xyz => 0,1,2)
-	string		comment	= "";			///< Optional comment
-	Station*	rec_ptr	= 0;			///< Pointer to station object for dereferencing
+	short int		type	= 0;			///< Key type (From enum)
+	SatSys			Sat		= {};			///< Satellite
+	InternedString	str		= {};			///< String (receiver ID)
+	short int 		num		= 0;			///< Subkey number (eg xyz => 0,1,2)
+	InternedString	comment	= {};			///< Optional comment
+	Station*		rec_ptr	= 0;			///< Pointer to station object for dereferencing
 	
 	bool operator ==	(const KFKey& b) const;
 	bool operator <		(const KFKey& b) const;
@@ -108,15 +117,223 @@ namespace std
 		{
 			//create hashes of all parts and XOR them to get a complete hash
 
-			size_t hashval	= hash<string>	{}(key.str)		<< 0
-							^ hash<size_t>	{}(key.Sat) 	<< 1
-							^ hash<int>		{}(key.type) 	<< 2
-							^ hash<short>   {}(key.num) 	<< 3;
+			size_t hashval	= hash<InternedString>	{}(key.str)		<< 0
+							^ hash<size_t>			{}(key.Sat) 	<< 1
+							^ hash<int>				{}(key.type) 	<< 2
+							^ hash<short>			{}(key.num) 	<< 3;
 			return hashval;
 		}
 	};
 }
 
+/** Map from keys to indices of parameters in a state (or noise) vector.
+* Holds an ordered map, along with a contiguous list of keys ordered by index, and a hashed index for constant time lookups.
+* These are rebuilt by reindex() once the map has been populated (eg once per epoch in stateTransition()).
+* The map may only be modified through the members below, which keep the list and hash current or invalidate them,
+* while invalidated, lookups revert to the tree until the next reindex().
+*/
+struct KFIndexMap
+{
+private:
+	map<KFKey, int>				indexMap;				///< Ordered map from keys to indices
+	vector<KFKey>				keyList;				///< Keys ordered by their index
+	unordered_map<KFKey, int>	hashIndexMap;			///< Hashed copy of the map for fast lookups
+	bool						indexed		= false;	///< Flag that the above are consistent with the map
+	
+public:
+	using const_iterator	= map<KFKey, int>::const_iterator;
+	using iterator			= const_iterator;
+	using value_type		= map<KFKey, int>::value_type;
+	
+	KFIndexMap()
+	{
+		
+	}
+	
+	KFIndexMap(
+		const map<KFKey, int>& kfIndexMap)
+	:	indexMap	(kfIndexMap)
+	{
+		
+	}
+	
+	KFIndexMap& operator=(
+		const map<KFKey, int>& kfIndexMap)
+	{
+		indexMap = kfIndexMap;
+		invalidate();
+		
+		return *this;
+	}
+	
+	KFIndexMap(const KFIndexMap&)				= default;
+	KFIndexMap(KFIndexMap&&)					= default;
+	KFIndexMap& operator=(const KFIndexMap&)	= default;
+	KFIndexMap& operator=(KFIndexMap&&)			= default;
+	
+	const_iterator	begin()	const	{	return indexMap.begin();	}
+	const_iterator	end()	const	{	return indexMap.end();		}
+	size_t			size()	const	{	return indexMap.size();		}
+	bool			empty()	const	{	return indexMap.empty();	}
+	
+	const_iterator find(
+		const KFKey& kfKey)
+	const
+	{
+		return indexMap.find(kfKey);
+	}
+	
+	size_t count(
+		const KFKey& kfKey)
+	const
+	{
+		return indexMap.count(kfKey);
+	}
+	
+	/** Rebuild the contiguous key list and hashed index from the map contents
+	*/
+	void reindex()
+	{
+		invalidate();
+		
+		keyList		.resize(size());
+		hashIndexMap.reserve(size());
+		
+		for (auto& [kfKey, index] : indexMap)
+		{
+			if	( index < 0
+				||index >= keyList.size())
+			{
+				//not a contiguous set of indices, cant use the list
+				invalidate();
+				return;
+			}
+			
+			keyList[index]		= kfKey;
+			hashIndexMap[kfKey]	= index;
+		}
+		
+		indexed = true;
+	}
+	
+	/** Returns the index of a key, or -1 if not present
+	*/
+	int index(
+		const KFKey& kfKey)
+	const
+	{
+		if (indexed)
+		{
+			auto it = hashIndexMap.find(kfKey);
+			if (it == hashIndexMap.end())
+			{
+				return -1;
+			}
+			return it->second;
+		}
+		
+		auto it = indexMap.find(kfKey);
+		if (it == indexMap.end())
+		{
+			return -1;
+		}
+		return it->second;
+	}
+	
+	/** Returns the key that corresponds to an index
+	*/
+	KFKey key(
+		int index)
+	const
+	{
+		if (indexed)
+		{
+			return keyList[index];
+		}
+		
+		for (auto& [kfKey, kfIndex] : indexMap)
+		{
+			if (kfIndex == index)
+			{
+				return kfKey;
+			}
+		}
+		
+		return KFKey();
+	}
+	
+	/** Set the index of a key, adding it if not present.
+	* Keys appended with the next index keep the list and hash current, anything else invalidates them
+	*/
+	void set(
+		const KFKey&	kfKey,
+		int				index)
+	{
+		auto [it, added] = indexMap.insert({kfKey, index});
+		
+		if (indexed == false)
+		{
+			it->second = index;
+			return;
+		}
+		
+		if	( added
+			&&index == keyList.size())
+		{
+			keyList.push_back(kfKey);
+			hashIndexMap[kfKey] = index;
+			return;
+		}
+		
+		if	( added		== false
+			&&it->second	== index)
+		{
+			return;
+		}
+		
+		it->second = index;
+		invalidate();
+	}
+	
+	void clear()
+	{
+		indexMap.clear();
+		invalidate();
+	}
+	
+	size_t erase(
+		const KFKey& kfKey)
+	{
+		size_t erased = indexMap.erase(kfKey);
+		
+		if (erased)
+		{
+			invalidate();
+		}
+		
+		return erased;
+	}
+	
+	template<class ARCHIVE>
+	void serialize(ARCHIVE& ar, const unsigned int& version)
+	{
+		ar & indexMap;
+		
+		if (ARCHIVE::is_loading::value)
+		{
+			reindex();
+		}
+	}
+	
+private:
+	void invalidate()
+	{
+		indexed = false;
+		keyList		.clear();
+		hashIndexMap.clear();
+	}
+};
+
 struct FilterChunk
 {
 	Trace*	trace_ptr = nullptr;
@@ -136,22 +353,45 @@ struct SubState
 };
 
 /** Object to hold measurements, design matrices, and residuals for multiple observations
+*
+* Design matrices are stored row-compressed, as each measurement only references a handful of states,
+* and the number of states may be much larger than the number of measurements.
 */
 struct KFMeas
 {
-	GTime		time = GTime::noTime();		///< Epoch these measurements were recorded
-	VectorXd	Y;							///< Value of the observations (for linear systems)
-	VectorXd	V;							///< Prefit Residual of the observations (for non-linear systems)
-	VectorXd	VV;							///< Postfit Residual of the observations (for non-linear systems)
-	MatrixXd	R;							///< Measurement noise for these observations
-	VectorXd	W;							///< Weight (inverse of noise) used in least squares
-	MatrixXd	H;							///< Design matrix between measurements and state
-	MatrixXd	H_star;						///< Design matrix between measurements and noise states
+	GTime			time = GTime::noTime();		///< Epoch these measurements were recorded
+	VectorXd		Y;							///< Value of the observations (for linear systems)
+	VectorXd		V;							///< Prefit Residual of the observations (for non-linear systems)
+	VectorXd		VV;							///< Postfit Residual of the observations (for non-linear systems)
+	MatrixXd		R;							///< Measurement noise for these observations
+	VectorXd		W;							///< Weight (inverse of noise) used in least squares
+	RowSparseMatrix	H;							///< Design matrix between measurements and state
+	RowSparseMatrix	H_star;						///< Design matrix between measurements and noise states
 
 	vector<KFKey>												obsKeys;					///< Optional labels for reporting when measurements are removed etc.
 	vector<map<string, void*>>									metaDataMaps;
 	vector<vector<tuple<E_Component, double, string, double>>>	componentLists;	
 	
+	/** Return a copy of a row-compressed matrix with only the specified rows retained
+	*/
+	static RowSparseMatrix keepRows(
+		const	RowSparseMatrix&	mat,
+		const	vector<int>&		keepIndices)
+	{
+		vector<Triplet<double>> tripletList;
+		
+		for (int i = 0; i < keepIndices.size(); i++)
+		for (RowSparseMatrix::InnerIterator it(mat, keepIndices[i]); it; ++it)
+		{
+			tripletList.push_back({i, (int) it.col(), it.value()});
+		}
+		
+		RowSparseMatrix newMat(keepIndices.size(), mat.cols());
+		newMat.setFromTriplets(tripletList.begin(), tripletList.end());
+		
+		return newMat;
+	}
+	
 	void removeMeas(int index)
 	{
 		vector<int> keepIndices;
@@ -170,8 +410,8 @@ struct KFMeas
 		V		= ( V		(keepIndices)				).eval();
 		VV		= ( VV		(keepIndices)				).eval();
 		R		= ( R		(keepIndices, keepIndices)	).eval();
-		H		= ( H		(keepIndices, all)			).eval();
-		H_star	= ( H_star	(keepIndices, all)			).eval();
+		H		= keepRows(H,		keepIndices);
+		H_star	= keepRows(H_star,	keepIndices);
 	}
 	
 	template<class ARCHIVE>
@@ -191,13 +431,13 @@ struct KFMeas
 			ar & time;
 			ar & VV;
 			
-			for (int i = 0; i < rows; i++)
-			for (int j = 0; j < cols; j++)
+			for (int i = 0; i < H.outerSize(); i++)
+			for (RowSparseMatrix::InnerIterator it(H, i); it; ++it)
 			{
-				double value = H(i,j);
+				double value = it.value();
 				if (value)
 				{
-					H2[{i,j}] = value;
+					H2[{it.row(), it.col()}] = value;
 				}
 			}
 			
@@ -213,14 +453,19 @@ struct KFMeas
 			ar & VV;
 			ar & H2;
 			
-			H = MatrixXd::Zero(rows,cols);
 			R = MatrixXd::Zero(rows,rows);
 			V = VectorXd::Zero(rows);
 			
+			vector<Triplet<double>> tripletList;
+			tripletList.reserve(H2.size());
+			
 			for (auto & [index, value] : H2)
 			{
-				H(index.first, index.second) = value;
+				tripletList.push_back({index.first, index.second, value});
 			}
+			
+			H = RowSparseMatrix(rows, cols);
+			H.setFromTriplets(tripletList.begin(), tripletList.end());
 		}
 	}
 };
@@ -260,6 +505,34 @@ struct Exponential
 	double tau		= 0;
 };
 
+/** Term of a row of the state transition matrix, with what is needed to evaluate it for a new time gap
+*/
+struct TransitionTerm
+{
+	int		col		= 0;		///< Index of the source state
+	int		tExp	= 0;		///< Exponent of the time gap
+	double	value	= 0;		///< Coefficient of the term
+	double	tau		= -1;		///< Gauss markov time constant of the source, negative for random walks
+	double	mu		= 0;		///< Gauss markov mean of the source
+	bool	hasMu	= false;	///< Term also ties the state down to its mean through the ONE element
+	int		slot	= 0;		///< Position of the value in the cached matrix
+	int		muSlot	= 0;		///< Position of the tiedown value in the cached matrix
+};
+
+/** Structure of the most recent state transition matrix.
+* Rows are rebuilt from the transition maps only if they are new, have been modified, or have lost a source state.
+* The terms of all other rows are moved to their new rows and columns by key when states are added or removed, and re-evaluated for the new time gap
+*/
+struct TransitionCache
+{
+	bool							valid		= false;	///< Cached terms may be reused
+	vector<KFKey>					keyList;				///< Keys of the rows the terms were collected for
+	vector<KFKey>					colKeyList;				///< Keys of the source states that the columns of the terms refer to
+	vector<vector<TransitionTerm>>	rowTermList;			///< Terms making up each row
+	RowSparseMatrix					F;						///< Transition matrix, with an entry for every term
+	unordered_set<KFKey>			changedRows;			///< Rows whose transitions have been modified since the cache was built
+};
+
 /** Kalman filter object.
 *
 * Contains most persistant parameters and values of state. Includes state vector, covariance, and process noise.
@@ -275,8 +548,8 @@ struct KFState_
 	MatrixXd	P;										///< State Covariance
 	VectorXd	dx;										///< Last filter update
 
-	map<KFKey, short int>								kfIndexMap;			///< Map from key to indexes of parameters in the state vector
-	map<KFKey, short int>								noiseIndexMap;		///< Map from key to indexes of parameters in the noise vector
+	KFIndexMap											kfIndexMap;			///< Map from key to indexes of parameters in the state vector
+	KFIndexMap											noiseIndexMap;		///< Map from key to indexes of parameters in the noise vector
 
 	map<KFKey, map<KFKey, map<int, double>>>			stateTransitionMap;
 	map<KFKey, double>									gaussMarkovTauMap;
@@ -285,6 +558,7 @@ struct KFState_
 	map<KFKey, double>									initNoiseMap;
 	map<KFKey, double>									noiseElementMap;
 	map<KFKey, Exponential>								exponentialNoiseMap;
+	TransitionCache										transitionCache;
 
 	vector<StateRejectCallback> 						stateRejectCallbacks;
 	vector<MeasRejectCallback> 							measRejectCallbacks;
@@ -326,12 +600,50 @@ struct KFState_
 };
 
 
+/** Modification to a filter state that has been recorded in an update buffer
+*/
+struct KFStateUpdate
+{
+	enum E_Update
+	{
+		ADD_STATE,
+		SET_TRANS,
+		SET_TRANS_RATE,
+		ADD_NOISE,
+		SET_EXPONENTIAL
+	};
+	
+	E_Update		type;
+	KFKey			key;						///< State being modified
+	KFKey			source;						///< Source of the transition, or rate state
+	double			value		= 0;			///< Transition coefficient, or noise variance
+	InitialState	initialState;				///< Initial conditions of the modified state
+	InitialState	sourceInitialState;			///< Initial conditions of the rate state
+	Exponential		exponential;
+};
+
+/** Modifications to a filter state that are requested through const references while measurements are built in parallel.
+* They are recorded here rather than locking the state, and applied afterwards in a consistent order.
+*/
+struct KFStateUpdateBuffer
+{
+	const KFState*			kfState_ptr			= nullptr;	///< Filter state that modifications are recorded for
+	KFMeasEntryList*		kfMeasEntryList_ptr	= nullptr;	///< Measurements built while this buffer was installed
+	vector<KFStateUpdate>	updateList;						///< Recorded modifications, in the order they were requested
+	unordered_set<KFKey>	newKeys;						///< States that were reported as new to the owner of this buffer
+
+	void apply(
+		KFState&	kfState);
+};
+
 struct KFState : KFState_
 {
 	mutex kfStateMutex;
 	
 	static const KFKey oneKey;
 	
+	static thread_local KFStateUpdateBuffer* updateBuffer_ptr;		///< Buffer for the current thread to record modifications in, if any
+	
 	KFState(
 		const KFState &kfState) 
 	:	KFState_		(kfState),	
@@ -341,6 +653,15 @@ struct KFState : KFState_
 		rts_basename.clear();
 	}
 	
+	KFState(
+		KFState&& kfState)
+	:	KFState_		(std::move(kfState)),
+		kfStateMutex	()
+	{
+		//dont use same rts file unless explicitly copied
+		rts_basename.clear();
+	}
+	
 	KFState()
 	{
 		//initialise all filter state objects with a ONE element for later use.
@@ -349,7 +670,8 @@ struct KFState : KFState_
 		P			= MatrixXd	::Zero(1,1);
 		dx			= VectorXd	::Zero(1);
 
-		kfIndexMap[oneKey]	= 0;
+		kfIndexMap.set(oneKey, 0);
+		kfIndexMap.reindex();
 		
 		initFilterEpoch();
 	}
@@ -397,7 +719,8 @@ struct KFState : KFState_
 
 	bool	getKFSigma(
 		const	KFKey		key,
-				double&		sigma);
+				double&		sigma)
+	const;
 
 	bool	setKFNoise(
 		const	KFKey		key,
@@ -521,7 +844,8 @@ struct KFState : KFState_
 		Trace&			trace,
 		string			suffix	= "",
 		int				begX	=  0,
-		int				numX 	= -1);
+		int				numX 	= -1)
+	const;
 	
 	void outputConditionNumber(
 		Trace&		trace);
@@ -583,11 +907,37 @@ struct KFState : KFState_
 		KFState&			kfState)					
 	const;
 
+	/** Returns the buffer that modifications to this state should be recorded in by the current thread, if any
+	*/
+	KFStateUpdateBuffer* deferredUpdates()
+	const
+	{
+		if	( updateBuffer_ptr
+			&&updateBuffer_ptr->kfState_ptr == this)
+		{
+			return updateBuffer_ptr;
+		}
+		
+		return nullptr;
+	}
+	
 	void setExponentialNoise(
 		const	KFKey			kfKey,
 		const	Exponential		exponential)
 	const
 	{
+		auto buffer_ptr = deferredUpdates();
+		if (buffer_ptr)
+		{
+			KFStateUpdate update;
+			update.type			= KFStateUpdate::SET_EXPONENTIAL;
+			update.key			= kfKey;
+			update.exponential	= exponential;
+			
+			buffer_ptr->updateList.push_back(std::move(update));
+			return;
+		}
+		
 		auto& kfState = *const_cast<KFState*>(this);	lock_guard<mutex> guard(kfState.kfStateMutex);			kfState.setExponentialNoise	(kfKey, exponential);	
 	}
 
@@ -596,16 +946,30 @@ struct KFState : KFState_
 		const	double			variance)			
 	const
 	{
+		auto buffer_ptr = deferredUpdates();
+		if (buffer_ptr)
+		{
+			KFStateUpdate update;
+			update.type			= KFStateUpdate::ADD_NOISE;
+			update.key			= kfKey;
+			update.value		= variance;
+			
+			buffer_ptr->updateList.push_back(std::move(update));
+			return;
+		}
+		
 		auto& kfState = *const_cast<KFState*>(this);	lock_guard<mutex> guard(kfState.kfStateMutex);			kfState.addNoiseElement	(kfKey, variance);	
 	}
 	
+	/** Adds a noise element for a measurement, the coefficient belongs to the measurement so only the variance is needed by the state
+	*/
 	void addNoiseEntry(
 		const	KFKey			kfKey,		
 		const	double			value,		
 		const	double			variance)			
 	const
 	{
-		auto& kfState = *const_cast<KFState*>(this);	lock_guard<mutex> guard(kfState.kfStateMutex);			kfState.addNoiseEntry	(kfKey, value, variance);	
+		addNoiseElement(kfKey, variance);
 	}	
 	
 	bool 	addKFState(
@@ -613,6 +977,26 @@ struct KFState : KFState_
 		const	InitialState	initialState = {})	
 	const
 	{
+		auto buffer_ptr = deferredUpdates();
+		if (buffer_ptr)
+		{
+			KFStateUpdate update;
+			update.type			= KFStateUpdate::ADD_STATE;
+			update.key			= kfKey;
+			update.initialState	= initialState;
+			
+			buffer_ptr->updateList.push_back(std::move(update));
+			
+			if (stateTransitionMap.find(kfKey) != stateTransitionMap.end())
+			{
+				return false;
+			}
+			
+			//provisionally new, may be resolved otherwise when the buffer is applied
+			auto [dummy, isNew] = buffer_ptr->newKeys.insert(kfKey);
+			return isNew;
+		}
+		
 		auto& kfState = *const_cast<KFState*>(this);	lock_guard<mutex> guard(kfState.kfStateMutex);	return	kfState.addKFState		(kfKey, initialState);	
 	}	
 	
@@ -623,6 +1007,20 @@ struct KFState : KFState_
 		const	InitialState	initialState = {})	
 	const
 	{	
+		auto buffer_ptr = deferredUpdates();
+		if (buffer_ptr)
+		{
+			KFStateUpdate update;
+			update.type			= KFStateUpdate::SET_TRANS;
+			update.key			= dest;
+			update.source		= source;
+			update.value		= value;
+			update.initialState	= initialState;
+			
+			buffer_ptr->updateList.push_back(std::move(update));
+			return;
+		}
+		
 		auto& kfState = *const_cast<KFState*>(this);	lock_guard<mutex> guard(kfState.kfStateMutex);			kfState.setKFTrans		(dest, source, value, initialState);
 	}	
 	
@@ -634,10 +1032,101 @@ struct KFState : KFState_
 		const	InitialState	initialIntegralState	= {})	
 	const
 	{		
+		auto buffer_ptr = deferredUpdates();
+		if (buffer_ptr)
+		{
+			KFStateUpdate update;
+			update.type					= KFStateUpdate::SET_TRANS_RATE;
+			update.key					= integral;
+			update.source				= rate;
+			update.value				= value;
+			update.initialState			= initialIntegralState;
+			update.sourceInitialState	= initialRateState;
+			
+			buffer_ptr->updateList.push_back(std::move(update));
+			return;
+		}
+		
 		auto& kfState = *const_cast<KFState*>(this);	lock_guard<mutex> guard(kfState.kfStateMutex);	kfState.setKFTransRate	(integral, rate, value, initialRateState, initialIntegralState);
 	}
 };
 
+/** Immutable, reference counted snapshot of a filter state.
+* Copies of a snapshot share the same state, so that consumers which only read it (outputs, ambiguity resolution inputs) don't each take a deep copy.
+* A consumer that needs to modify the state calls edit(), which only duplicates it while it is shared with another snapshot or borrowed from a live filter.
+* Copy-on-write is of the whole state, the covariance and key tables are not shared between copies as separate blocks.
+* The consumers that edit (ambiguity resolution, minimum constraints, smoothing actions) modify the states and covariance anyway,
+* so copying them separately would save little over copying the whole state.
+*/
+struct KFStateSnapshot
+{
+	shared_ptr<KFState>	kfState_ptr;		///< Shared state, empty use count if borrowed
+	
+	KFStateSnapshot()
+	{
+		
+	}
+	
+	/** Take a snapshot of a filter by copying it once
+	*/
+	explicit KFStateSnapshot(
+		const KFState&	kfState)
+	:	kfState_ptr	(std::make_shared<KFState>(kfState))
+	{
+		
+	}
+	
+	/** Take a snapshot of a filter that is no longer needed, without copying it
+	*/
+	explicit KFStateSnapshot(
+		KFState&&		kfState)
+	:	kfState_ptr	(std::make_shared<KFState>(std::move(kfState)))
+	{
+		
+	}
+	
+	/** Refer to a live filter without copying it.
+	* The filter must outlive the snapshot, and not be modified while it is in use
+	*/
+	static KFStateSnapshot borrow(
+		KFState&		kfState)
+	{
+		KFStateSnapshot snapshot;
+		snapshot.kfState_ptr = shared_ptr<KFState>(shared_ptr<KFState>(), &kfState);
+		
+		return snapshot;
+	}
+	
+	bool empty()	const	{	return kfState_ptr == nullptr;	}
+	
+	const KFState& operator*()	const	{	return *kfState_ptr;	}
+	const KFState* operator->()	const	{	return  kfState_ptr.get();	}
+	
+	/** Read the shared state, use edit() to modify it
+	*/
+	const KFState& view()
+	const
+	{
+		return *kfState_ptr;
+	}
+	
+	/** Get a modifiable state, copying all of it first (including the covariance and key tables) if it is shared or borrowed
+	*/
+	KFState& edit()
+	{
+		if (kfState_ptr == nullptr)
+		{
+			kfState_ptr = std::make_shared<KFState>();
+		}
+		else if (kfState_ptr.use_count() != 1)
+		{
+			kfState_ptr = std::make_shared<KFState>(*kfState_ptr);
+		}
+		
+		return *kfState_ptr;
+	}
+};
+
 /** Object to hold an individual measurement.
 * Includes the measurement itself, (or its innovation) and design matrix entries
 * Adding design matrix entries for states that do not yet exist will create and add new states to the measurement's kalman filter object.
@@ -1,8 +1,16 @@
 
+#include <shared_mutex>
+#include <mutex>
 #include <iostream>
 #include <fstream>
+#include <cstring>
 #include <map>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
 using std::map;
 
 #include "eigenIncluder.hpp"
@@ -19,10 +27,610 @@ using std::map;
 #include <boost/serialization/binary_object.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/string.hpp>
+#include <boost/serialization/array.hpp>
+
+#define FILTER_ARCHIVE_MAGIC	"GINANKFA"
+#define FILTER_ARCHIVE_VERSION	1
 
 map<short int, string> idStringMap;
 map<string, short int> stringIdMap;
 
+map<string, SerialRecordBuffer>	serialRecordBufferMap;
+std::shared_mutex				serialRecordBufferMutex;
+
+/** Returns the in-memory record buffer registered for an archive file, or nullptr if objects go directly to the file
+*/
+SerialRecordBuffer* getSerialRecordBuffer(
+	string		filename)		///< Path to archive file
+{
+	std::shared_lock lock(serialRecordBufferMutex);
+	
+	auto it = serialRecordBufferMap.find(filename);
+	if (it == serialRecordBufferMap.end())
+	{
+		return nullptr;
+	}
+	
+	auto& [dummy, buffer] = *it;
+	
+	return &buffer;
+}
+
+/** Keep objects destined for an archive file in memory
+*/
+void enableSerialRecordBuffer(
+	string		filename,		///< Path to archive file
+	bool		spillToFile)	///< Also append objects to the archive file
+{
+	std::unique_lock lock(serialRecordBufferMutex);
+	
+	serialRecordBufferMap[filename].spillToFile = spillToFile;
+}
+
+/** Discard the in-memory record buffer for an archive file
+*/
+void removeSerialRecordBuffer(
+	string		filename)		///< Path to archive file
+{
+	std::unique_lock lock(serialRecordBufferMutex);
+	
+	serialRecordBufferMap.erase(filename);
+}
+
+map<string, FilterArchiveWriter>	filterArchiveWriterMap;
+std::shared_mutex					filterArchiveWriterMutex;
+
+map<string, FilterArchiveReader>	filterArchiveReaderMap;
+std::mutex							filterArchiveReaderMutex;
+
+/** Close the reader of an archive file, it will be reopened when next requested
+*/
+void dropFilterArchiveReader(
+	string		filename)		///< Path to archive file
+{
+	std::lock_guard<std::mutex> lock(filterArchiveReaderMutex);
+	
+	filterArchiveReaderMap.erase(filename);
+}
+
+/** Write objects destined for an archive file as a compact indexed archive
+*/
+void enableFilterArchive(
+	string		filename)		///< Path to archive file
+{
+	{
+		std::unique_lock lock(filterArchiveWriterMutex);
+		
+		filterArchiveWriterMap[filename] = FilterArchiveWriter();
+	}
+	
+	dropFilterArchiveReader(filename);
+}
+
+/** Stop writing compact archives for a file
+*/
+void removeFilterArchive(
+	string		filename)		///< Path to archive file
+{
+	{
+		std::unique_lock lock(filterArchiveWriterMutex);
+		
+		filterArchiveWriterMap.erase(filename);
+	}
+	
+	dropFilterArchiveReader(filename);
+}
+
+/** Close the open streams and reader of a compact archive.
+ * Must be called whenever the archive file is truncated, removed, or replaced, the next write will then start a new archive or continue the replacement
+*/
+void resetFilterArchive(
+	string		filename)		///< Path to archive file
+{
+	{
+		std::unique_lock lock(filterArchiveWriterMutex);
+		
+		auto it = filterArchiveWriterMap.find(filename);
+		if (it != filterArchiveWriterMap.end())
+		{
+			auto& [dummy, archive] = *it;
+			
+			archive.dataStream	.close();
+			archive.indexStream	.close();
+		}
+	}
+	
+	dropFilterArchiveReader(filename);
+}
+
+/** Returns the writer for a compact archive file, or nullptr if the file is a plain archive.
+ * The archive's streams are opened on first use - if the archive file is missing or empty a new archive is started, with a fresh header, index, and key table
+*/
+FilterArchiveWriter* getFilterArchiveWriter(
+	string		filename)		///< Path to archive file
+{
+	FilterArchiveWriter* archive_ptr;
+	{
+		std::shared_lock lock(filterArchiveWriterMutex);
+		
+		auto it = filterArchiveWriterMap.find(filename);
+		if (it == filterArchiveWriterMap.end())
+		{
+			return nullptr;
+		}
+		
+		archive_ptr = &it->second;
+	}
+	
+	auto& archive = *archive_ptr;
+	
+	if (archive.dataStream.is_open())
+	{
+		return archive_ptr;
+	}
+	
+	struct stat fileStat;
+	if	( stat(filename.c_str(), &fileStat) == 0
+		&&fileStat.st_size > 0)
+	{
+		//continue the existing archive
+		archive.dataStream	.open(filename,					std::ofstream::binary | std::ofstream::out | std::ofstream::app);
+		archive.indexStream	.open(filename + INDEX_SUFFIX,	std::ofstream::binary | std::ofstream::out | std::ofstream::app);
+		archive.dataSize	= fileStat.st_size;
+	}
+	else
+	{
+		archive.keyIdMap.clear();
+		
+		archive.dataStream	.open(filename,					std::ofstream::binary | std::ofstream::out | std::ofstream::trunc);
+		archive.indexStream	.open(filename + INDEX_SUFFIX,	std::ofstream::binary | std::ofstream::out | std::ofstream::trunc);
+		archive.dataSize	= 0;
+		
+		if (archive.dataStream)
+		{
+			int version = FILTER_ARCHIVE_VERSION;
+			archive.dataStream.write(FILTER_ARCHIVE_MAGIC,		strlen(FILTER_ARCHIVE_MAGIC));
+			archive.dataStream.write((char*) &version,			sizeof(version));
+			archive.dataSize = strlen(FILTER_ARCHIVE_MAGIC) + sizeof(version);
+		}
+	}
+	
+	if	( !archive.dataStream
+		||!archive.indexStream)
+	{
+		std::cout << std::endl << "Error opening algebra archive '" << filename <<  "' for writing";
+		
+		archive.dataStream	.close();
+		archive.indexStream	.close();
+	}
+	
+	return archive_ptr;
+}
+
+/** Returns the up to date reader for a compact archive file, or nullptr if the file is not a readable compact archive.
+ * Anything buffered by the archive's writer is flushed first, so all records written so far are visible to the reader
+*/
+FilterArchiveReader* getFilterArchiveReader(
+	string		filename)		///< Path to archive file
+{
+	{
+		std::shared_lock lock(filterArchiveWriterMutex);
+		
+		auto it = filterArchiveWriterMap.find(filename);
+		if (it == filterArchiveWriterMap.end())
+		{
+			return nullptr;
+		}
+		
+		auto& [dummy, archive] = *it;
+		
+		if (archive.dataStream.is_open())
+		{
+			archive.dataStream	.flush();
+			archive.indexStream	.flush();
+		}
+	}
+	
+	std::lock_guard<std::mutex> lock(filterArchiveReaderMutex);
+	
+	auto [it, isNew] = filterArchiveReaderMap.try_emplace(filename, filename);
+	
+	auto& [dummy, reader] = *it;
+	
+	if (isNew == false)
+	{
+		reader.update();
+	}
+	
+	if (reader.valid() == false)
+	{
+		filterArchiveReaderMap.erase(it);
+		return nullptr;
+	}
+	
+	return &reader;
+}
+
+/** Append a serialised record to a compact archive, and add it to the archive's index
+*/
+void writeFilterArchiveRecord(
+	FilterArchiveWriter&	archive,	///< Archive being written to
+	E_SerialObject			type,		///< Type of object in the record
+	const string&			record)		///< Serialised object
+{
+	if	( archive.dataStream	.is_open() == false
+		||archive.indexStream	.is_open() == false)
+	{
+		return;
+	}
+	
+	FilterArchiveIndexEntry entry;
+	entry.offset	= archive.dataSize;
+	entry.length	= record.size();
+	entry.type		= type;
+	entry.version	= FILTER_ARCHIVE_VERSION;
+	
+	archive.dataStream	.write(record.data(),		record.size());
+	archive.indexStream	.write((char*) &entry,		sizeof(entry));
+	
+	archive.dataSize += record.size();
+}
+
+/** Drop records from the beginning of a compact archive.
+ * Keys from expired key table records are kept in a single key table at the start of the archive, so that ids referenced by retained states are unchanged.
+ * The archive is only rewritten once the expired records outweigh the retained ones, so that each record is copied a bounded number of times
+*/
+void trimFilterArchive(
+	string		filename,		///< Path to archive file
+	long int	firstRecord)	///< Index of the first record to retain
+{
+	FilterArchiveReader* reader_ptr = getFilterArchiveReader(filename);
+	if	( reader_ptr == nullptr
+		||firstRecord <= 0
+		||firstRecord >= reader_ptr->index.size())
+	{
+		return;
+	}
+	
+	auto& reader = *reader_ptr;
+	
+	long int headerSize	= strlen(FILTER_ARCHIVE_MAGIC) + sizeof(int);
+	long int keepBegin	= reader.index[firstRecord]	.offset;
+	long int keepEnd	= reader.index.back()		.offset
+						+ reader.index.back()		.length;
+	
+	if (keepBegin - headerSize < keepEnd - keepBegin)
+	{
+		return;
+	}
+	
+	string tempFile			= filename					+ "_temp";
+	string tempIndexFile	= filename + INDEX_SUFFIX	+ "_temp";
+	{
+		std::ofstream dataStream	(tempFile,		std::ofstream::binary | std::ofstream::out | std::ofstream::trunc);
+		std::ofstream indexStream	(tempIndexFile,	std::ofstream::binary | std::ofstream::out | std::ofstream::trunc);
+		
+		if	( !dataStream
+			||!indexStream)
+		{
+			std::cout << std::endl << "Error opening algebra archive '" << tempFile <<  "' for writing";
+			return;
+		}
+		
+		int version = FILTER_ARCHIVE_VERSION;
+		dataStream.write(FILTER_ARCHIVE_MAGIC,		strlen(FILTER_ARCHIVE_MAGIC));
+		dataStream.write((char*) &version,			sizeof(version));
+		
+		long int offset = headerSize;
+		
+		auto writeRecord = [&](
+			int			type,
+			const char*	record,
+			long int	length)
+		{
+			FilterArchiveIndexEntry entry;
+			entry.offset	= offset;
+			entry.length	= length;
+			entry.type		= type;
+			entry.version	= FILTER_ARCHIVE_VERSION;
+			
+			dataStream	.write(record,				length);
+			indexStream	.write((char*) &entry,		sizeof(entry));
+			
+			offset += length;
+		};
+		
+		std::ostringstream keyStream(std::ios::binary);
+		{
+			binary_oarchive serial(keyStream, 1);	//no header
+			
+			int firstId = 0;
+			serial & firstId;
+			serial & reader.keyTable;
+		}
+		
+		string keyRecord = keyStream.str();
+		writeRecord(E_SerialObject::KEY_TABLE, keyRecord.data(), keyRecord.size());
+		
+		for (long int i = firstRecord; i < reader.index.size(); i++)
+		{
+			auto& entry = reader.index[i];
+			
+			if (entry.type == E_SerialObject::KEY_TABLE)
+			{
+				continue;
+			}
+			
+			writeRecord(entry.type, reader.data + entry.offset, entry.length);
+		}
+	}
+	
+	//closes the reader, dont use it after this point
+	resetFilterArchive(filename);
+	
+	std::rename(tempFile		.c_str(), filename					.c_str());
+	std::rename(tempIndexFile	.c_str(), (filename + INDEX_SUFFIX)	.c_str());
+}
+
+/** Serialise a filter state for a compact archive.
+ * Keys are replaced by ids into the archive's key table (writing any new keys first), and only the upper triangle of the covariance is stored
+*/
+string encodeFilterArchiveState(
+	FilterArchiveWriter&	archive,	///< Archive being written to
+	KFState&				kfState)	///< Filter state to serialise
+{
+	int numX = kfState.x.rows();
+	
+	vector<int>		keyIds(numX, -1);
+	vector<KFKey>	newKeys;
+	int				firstNewId = archive.keyIdMap.size();
+	
+	for (auto& [key, index] : kfState.kfIndexMap)
+	{
+		if	( index < 0
+			||index >= numX)
+		{
+			continue;
+		}
+		
+		auto [it, isNew] = archive.keyIdMap.insert({key, (int) archive.keyIdMap.size()});
+		if (isNew)
+		{
+			newKeys.push_back(key);
+		}
+		
+		keyIds[index] = it->second;
+	}
+	
+	if (newKeys.empty() == false)
+	{
+		std::ostringstream keyStream(std::ios::binary);
+		{
+			binary_oarchive serial(keyStream, 1);	//no header
+			
+			serial & firstNewId;
+			serial & newKeys;
+		}
+		
+		writeFilterArchiveRecord(archive, E_SerialObject::KEY_TABLE, keyStream.str());
+	}
+	
+	int numDx = kfState.dx.rows();
+	
+	vector<double> upperP;
+	upperP.reserve(numX * (numX + 1) / 2);
+	
+	for (int j = 0; j < numX;	j++)
+	for (int i = 0; i <= j;		i++)
+	{
+		upperP.push_back(kfState.P(i, j));
+	}
+	
+	std::ostringstream recordStream(std::ios::binary);
+	{
+		binary_oarchive serial(recordStream, 1);	//no header
+		
+		serial & kfState.time;
+		serial & numX;
+		serial & numDx;
+		serial & boost::serialization::make_array(keyIds		.data(), keyIds.size());
+		serial & boost::serialization::make_array(kfState.x		.data(), numX);
+		serial & boost::serialization::make_array(kfState.dx	.data(), numDx);
+		serial & boost::serialization::make_array(upperP		.data(), upperP.size());
+	}
+	
+	return recordStream.str();
+}
+
+/** Open a compact archive and its index for reading.
+ * If the file is not a compact archive the reader is left invalid
+*/
+FilterArchiveReader::FilterArchiveReader(
+	string		filename)		///< Path to archive file
+:	filename	{filename}
+{
+	fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return;
+	}
+	
+	update();
+}
+
+/** Map any growth of the archive file, and read the index entries and keys of records that have been appended since the last update
+*/
+void FilterArchiveReader::update()
+{
+	struct stat fileStat;
+	if	( fd < 0
+		||fstat(fd, &fileStat) != 0)
+	{
+		return;
+	}
+	
+	size_t fileSize = fileStat.st_size;
+	
+	if (fileSize > dataSize)
+	{
+		void* map_ptr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map_ptr == MAP_FAILED)
+		{
+			return;
+		}
+		
+		if (data)
+		{
+			munmap((void*) data, dataSize);
+		}
+		
+		data		= (const char*) map_ptr;
+		dataSize	= fileSize;
+	}
+	
+	if (data == nullptr)
+	{
+		return;
+	}
+	
+	if (indexStream.is_open() == false)
+	{
+		int		version;
+		size_t	headerSize = strlen(FILTER_ARCHIVE_MAGIC) + sizeof(version);
+		
+		if (dataSize >= headerSize)
+		{
+			memcpy(&version, data + strlen(FILTER_ARCHIVE_MAGIC), sizeof(version));
+		}
+		
+		if	( dataSize < headerSize
+			||memcmp(data, FILTER_ARCHIVE_MAGIC, strlen(FILTER_ARCHIVE_MAGIC)) != 0
+			||version > FILTER_ARCHIVE_VERSION)
+		{
+			munmap((void*) data, dataSize);
+			data		= nullptr;
+			dataSize	= 0;
+			return;
+		}
+		
+		indexStream.open(filename + INDEX_SUFFIX, std::ifstream::binary);
+	}
+	
+	indexStream.clear();
+	indexStream.seekg(indexPos, indexStream.beg);
+	
+	FilterArchiveIndexEntry entry;
+	while (indexStream.read((char*) &entry, sizeof(entry)))
+	{
+		if (entry.offset + entry.length > dataSize)
+		{
+			//record was not completely written, look again next update
+			break;
+		}
+		
+		indexPos += sizeof(entry);
+		
+		index.push_back(entry);
+		
+		if (entry.type != E_SerialObject::KEY_TABLE)
+		{
+			continue;
+		}
+		
+		//collect all keys that states may refer to
+		MemoryStreamBuf	recordBuf(data + entry.offset, entry.length);
+		std::istream	recordStream(&recordBuf);
+		binary_iarchive serial(recordStream, 1); //no header
+		
+		int				firstId;
+		vector<KFKey>	newKeys;
+		serial & firstId;
+		serial & newKeys;
+		
+		if (keyTable.size() < firstId + newKeys.size())
+		{
+			keyTable.resize(firstId + newKeys.size());
+		}
+		
+		for (int i = 0; i < newKeys.size(); i++)
+		{
+			keyTable[firstId + i] = newKeys[i];
+		}
+	}
+}
+
+FilterArchiveReader::~FilterArchiveReader()
+{
+	if (data)
+	{
+		munmap((void*) data, dataSize);
+	}
+	
+	if (fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+/** Deserialise a filter state from a compact archive record, directly from the mapped file
+*/
+bool FilterArchiveReader::getState(
+	const FilterArchiveIndexEntry&	entry,		///< Index entry of the record to read
+	KFState&						kfState)	///< The pre-declared state to set the value of
+const
+{
+	MemoryStreamBuf	recordBuf(data + entry.offset, entry.length);
+	std::istream	recordStream(&recordBuf);
+	binary_iarchive serial(recordStream, 1); //no header
+	
+	int numX;
+	int numDx;
+	serial & kfState.time;
+	serial & numX;
+	serial & numDx;
+	
+	vector<int>		keyIds(numX);
+	vector<double>	upperP(numX * (numX + 1) / 2);
+	kfState.x	= VectorXd(numX);
+	kfState.dx	= VectorXd(numDx);
+	
+	serial & boost::serialization::make_array(keyIds		.data(), keyIds.size());
+	serial & boost::serialization::make_array(kfState.x		.data(), numX);
+	serial & boost::serialization::make_array(kfState.dx	.data(), numDx);
+	serial & boost::serialization::make_array(upperP		.data(), upperP.size());
+	
+	kfState.P = MatrixXd(numX, numX);
+	
+	int k = 0;
+	for (int j = 0; j < numX;	j++)
+	for (int i = 0; i <= j;		i++)
+	{
+		kfState.P(i, j) = upperP[k];
+		kfState.P(j, i) = upperP[k];
+		k++;
+	}
+	
+	kfState.kfIndexMap.clear();
+	
+	for (int i = 0; i < numX; i++)
+	{
+		int id = keyIds[i];
+		
+		if	( id < 0
+			||id >= keyTable.size())
+		{
+			std::cout << std::endl << "Error: Unknown key in algebra archive";
+			return false;
+		}
+		
+		kfState.kfIndexMap.set(keyTable[id], i);
+	}
+	
+	kfState.kfIndexMap.reindex();
+	
+	return true;
+}
+
 /** Returns the type of object that is located at the specified position in a file
 */
 E_SerialObject getFilterTypeFromFile(
@@ -158,7 +766,7 @@ void inputPersistanceStates(
 
 		//fix up the station pointers
 		{
-			map<KFKey, short int> newKFIndexMap;
+			KFIndexMap newKFIndexMap;
 
 			for (auto& [kfKey, index] : destKFState.kfIndexMap)
 			{
@@ -170,9 +778,11 @@ void inputPersistanceStates(
 					newKey.rec_ptr = &stationMap[receiverId];
 				}
 
-				newKFIndexMap[newKey] = index;
+				newKFIndexMap.set(newKey, index);
 			}
-			destKFState.kfIndexMap = newKFIndexMap;
+			newKFIndexMap.reindex();
+			
+			destKFState.kfIndexMap = std::move(newKFIndexMap);
 		}
 	}
 
@@ -209,7 +819,7 @@ void tryPrepareFilterPointers(
 	
 	auto& stationMap = *stationMap_ptr;
 	
-	map<KFKey, short> replacementKFIndexMap;
+	KFIndexMap replacementKFIndexMap;
 	for (auto& [key, index] : kfState.kfIndexMap)
 	{
 		KFKey kfKey = key;
@@ -225,8 +835,10 @@ void tryPrepareFilterPointers(
 			}
 		}
 		
-		replacementKFIndexMap[kfKey] = index;
+		replacementKFIndexMap.set(kfKey, index);
 	}
 	
-	kfState.kfIndexMap = replacementKFIndexMap;
+	replacementKFIndexMap.reindex();
+	
+	kfState.kfIndexMap = std::move(replacementKFIndexMap);
 }
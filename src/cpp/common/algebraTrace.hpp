@@ -1,14 +1,19 @@
 
 #pragma once
 
+#include <type_traits>
 #include <iostream>
+#include <fstream>
 #include <utility>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <deque>
 #include <map>
 
 using std::vector;
 using std::string;
+using std::deque;
 using std::pair;
 using std::map;
 
@@ -35,7 +40,8 @@ BETTER_ENUM(E_SerialObject,		int,
 			NAVIGATION_DATA,
 			STRING,
 			MEASUREMENT,
-			METADATA
+			METADATA,
+			KEY_TABLE
 )
 
 struct TransitionMatrixObject
@@ -53,6 +59,125 @@ struct TransitionMatrixObject
 	}
 };
 
+/** In-memory history of serialised filter objects.
+ * When registered for an archive filename, objects are kept here instead of being read back from the file,
+ * which allows fixed-lag smoothing without reopening and rewriting the archive every epoch
+*/
+struct SerialRecordBuffer
+{
+	deque<pair<int, string>>	records;				///< Type and serialised data of each object, oldest first
+	bool						spillToFile	= false;	///< Also append objects to the archive file
+};
+
+SerialRecordBuffer* getSerialRecordBuffer(
+	string		filename);
+
+void enableSerialRecordBuffer(
+	string		filename,
+	bool		spillToFile);
+
+void removeSerialRecordBuffer(
+	string		filename);
+
+/** Entry in the index of a compact filter archive.
+ * Entries are appended to a sidecar file as records are written, so that any record can be located without walking the archive
+*/
+struct FilterArchiveIndexEntry
+{
+	long int	offset	= 0;	///< Position of the record's data in the archive file
+	long int	length	= 0;	///< Number of bytes in the record
+	int			type	= 0;	///< Type of object in the record (E_SerialObject)
+	int			version	= 0;	///< Archive version used to write the record
+};
+
+/** State of a compact filter archive that is being written.
+ * Keys are written to KEY_TABLE records once, filter states then refer to them by id.
+ * The archive and index streams are kept open between records
+*/
+struct FilterArchiveWriter
+{
+	unordered_map<KFKey, int>	keyIdMap;		///< Ids of keys that have already been written to the archive
+	std::ofstream				dataStream;		///< Open stream to the archive file
+	std::ofstream				indexStream;	///< Open stream to the archive's index file
+	long int					dataSize = 0;	///< Number of bytes in the archive file
+};
+
+/** Memory mapped reader for compact filter archives.
+ * Readers are kept open between epochs, only records that have been appended since the last update are indexed
+*/
+struct FilterArchiveReader
+{
+	string							filename;				///< Path to archive file
+	int								fd			= -1;		///< Open descriptor of the archive file
+	const char*						data		= nullptr;	///< Mapped contents of the archive file
+	size_t							dataSize	= 0;		///< Size of the mapped archive
+	std::ifstream					indexStream;			///< Open stream to the archive's index file
+	long int						indexPos	= 0;		///< Number of bytes of the index file that have been read
+	vector<FilterArchiveIndexEntry>	index;					///< Locations of records in the archive
+	vector<KFKey>					keyTable;				///< Keys referenced by filter states, by id
+
+	FilterArchiveReader(
+		string		filename);
+
+	~FilterArchiveReader();
+
+	FilterArchiveReader(const FilterArchiveReader&)				= delete;
+	FilterArchiveReader& operator=(const FilterArchiveReader&)	= delete;
+
+	bool valid() const
+	{
+		return data != nullptr;
+	}
+
+	void update();
+
+	bool getState(
+		const FilterArchiveIndexEntry&	entry,
+		KFState&						kfState)
+	const;
+};
+
+FilterArchiveWriter* getFilterArchiveWriter(
+	string		filename);
+
+FilterArchiveReader* getFilterArchiveReader(
+	string		filename);
+
+void enableFilterArchive(
+	string		filename);
+
+void removeFilterArchive(
+	string		filename);
+
+void resetFilterArchive(
+	string		filename);
+
+void trimFilterArchive(
+	string		filename,
+	long int	firstRecord);
+
+string encodeFilterArchiveState(
+	FilterArchiveWriter&	archive,
+	KFState&				kfState);
+
+void writeFilterArchiveRecord(
+	FilterArchiveWriter&	archive,
+	E_SerialObject			type,
+	const string&			record);
+
+/** Read-only stream buffer over existing memory, so archives can be deserialised in place
+*/
+struct MemoryStreamBuf : std::streambuf
+{
+	MemoryStreamBuf(
+		const char*	data,
+		size_t		size)
+	{
+		char* begin = const_cast<char*>(data);
+		setg(begin, begin, begin + size);
+	}
+};
+
 extern map<short int, string> idStringMap;
 extern map<string, short int> stringIdMap;
 	
@@ -64,6 +189,7 @@ using boost::archive::binary_iarchive;
 /** Output filter state to a file for later reading.
  * Uses a binary archive which requires all of the relevant class members to have serialization functions written.
  * Output format is TypeId, ObjectData, NumBytes - this allows seeking backward from the end of the file to the beginning of each object.
+ * Files registered with enableFilterArchive() are instead written as compact archives with a separate index of records.
 */
 template<class TYPE>
 void spitFilterToFile(
@@ -71,6 +197,49 @@ void spitFilterToFile(
 	E_SerialObject	type,		///< Type of object
 	string			filename)	///< Path to file to output to
 {
+	SerialRecordBuffer* buffer_ptr = getSerialRecordBuffer(filename);
+	if (buffer_ptr)
+	{
+		std::ostringstream recordStream(std::ios::binary);
+		{
+			binary_oarchive serial(recordStream, 1);	//no header
+			
+			serial & object;
+		}
+		
+		buffer_ptr->records.push_back({(int) type, recordStream.str()});
+		
+		if (buffer_ptr->spillToFile == false)
+		{
+			return;
+		}
+	}
+	
+	FilterArchiveWriter* archive_ptr = getFilterArchiveWriter(filename);
+	if (archive_ptr)
+	{
+		string record;
+		if constexpr (std::is_same<TYPE, KFState>::value)
+		{
+			record = encodeFilterArchiveState(*archive_ptr, object);
+		}
+		else
+		{
+			std::ostringstream recordStream(std::ios::binary);
+			{
+				binary_oarchive serial(recordStream, 1);	//no header
+				
+				serial & object;
+			}
+			
+			record = recordStream.str();
+		}
+		
+		writeFilterArchiveRecord(*archive_ptr, type, record);
+		
+		return;
+	}
+	
 	std::fstream fileStream(filename, std::ifstream::binary | std::ifstream::out | std::ifstream::app);
 
 	if (!fileStream)
@@ -143,6 +312,65 @@ bool getFilterObjectFromFile(
 	return true;
 }
 
+/* Retrieve an object from an in-memory record
+*/
+template<class TYPE>
+bool getFilterObjectFromRecord(
+	E_SerialObject				expectedType,	///< The expected type of object
+	TYPE&						object,			///< The pre-declared object to set the value of
+	const pair<int, string>&	record)			///< The record to read from
+{
+	auto& [typeInt, data] = record;
+	
+	E_SerialObject type = E_SerialObject::_from_integral(typeInt);
+	if (type != expectedType)
+	{
+		std::cout << std::endl << "Error: Unexpected algebra record object type";
+		return false;
+	}
+	
+	std::istringstream recordStream(data, std::ios::binary);
+	binary_iarchive serial(recordStream, 1); //no header
+	
+	serial & object;
+	
+	return true;
+}
+
+/* Retrieve an object from a compact filter archive
+*/
+template<class TYPE>
+bool getFilterObjectFromArchive(
+	E_SerialObject			expectedType,	///< The expected type of object
+	TYPE&					object,			///< The pre-declared object to set the value of
+	long int				recordIndex,	///< Index of the record in the archive
+	FilterArchiveReader&	archive)		///< The archive to read from
+{
+	auto& entry = archive.index[recordIndex];
+	
+	E_SerialObject type = E_SerialObject::_from_integral(entry.type);
+	if (type != expectedType)
+	{
+		std::cout << std::endl << "Error: Unexpected algebra archive object type";
+		return false;
+	}
+	
+	if constexpr (std::is_same<TYPE, KFState>::value)
+	{
+		return archive.getState(entry, object);
+	}
+	else
+	{
+		MemoryStreamBuf	recordBuf(archive.data + entry.offset, entry.length);
+		std::istream	recordStream(&recordBuf);
+		binary_iarchive serial(recordStream, 1); //no header
+		
+		serial & object;
+		
+		return true;
+	}
+}
+
 E_SerialObject getFilterTypeFromFile(
 	long int&	startPos,
 	string		filename);
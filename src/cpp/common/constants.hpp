@@ -211,6 +211,7 @@ using std::map;
 #define SMOOTHED_SUFFIX		"_smoothed"
 #define FORWARD_SUFFIX		"_forward"
 #define BACKWARD_SUFFIX		"_backward"
+#define INDEX_SUFFIX		"_index"
 
 extern map<E_Sys, map<E_ObsCode, E_FType>> code2Freq;
 extern map<E_FType, double> genericWavelength;
@@ -209,7 +209,7 @@ void outputMeas(
 	{
 		tracepdeex(2, trace, "*\t%19s\t%15.4f\t%15.9f", time.to_string(0).c_str(), meas.Y(i), meas.R(i, i));
 
-		for (int j = 0; j < meas.H.cols(); j++)		tracepdeex(2, trace, "\t%15.5f", meas.H(i, j));
+		for (int j = 0; j < meas.H.cols(); j++)		tracepdeex(2, trace, "\t%15.5f", meas.H.coeff(i, j));
 		tracepdeex(2, trace, "\n");
 	}
 	trace << "-MEAS" << std::endl;
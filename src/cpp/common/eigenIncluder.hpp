@@ -48,6 +48,10 @@ using Eigen::placeholders::all;
 
 typedef Eigen::Array<bool,Eigen::Dynamic,1> ArrayXb;
 
+/** Row-compressed sparse matrix, used where each row only references a few columns (eg design matrices)
+*/
+typedef SparseMatrix<double, Eigen::RowMajor> RowSparseMatrix;
+
 template <typename Type, int Size>
 using Vector = Matrix<Type, Size, 1>;
 
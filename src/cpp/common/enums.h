@@ -304,6 +304,10 @@ BETTER_ENUM(E_Inverter, int,
 			FULLPIVLU,		FIRST_UNSUPPORTED = FULLPIVLU,
 			FULLPIVHQR)
 
+BETTER_ENUM(E_Database, int,
+			MONGO,
+			LOCAL_STORE)
+
 BETTER_ENUM(E_ObsDesc, int,
 	C,					// Code / Pseudorange
 	L,					// Phase
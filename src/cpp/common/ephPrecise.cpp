@@ -1,12 +1,17 @@
 
 // #pragma GCC optimize ("O0")
 
+#include <shared_mutex>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <array>
+#include <mutex>
 #include <map>
 #include <ctype.h>
 
+using std::shared_ptr;
 using std::string;
 using std::array;
 using std::map;
@@ -156,7 +161,92 @@ double interpolate(const double *x, double *y, int n)
 	return y[0];
 }
 
-/** satellite position by precise ephemeris
+/** Contiguous, time ordered copy of the precise ephemeris samples for a satellite, for fast interpolation
+*/
+struct PephSeries
+{
+	long int			pephMapVersion	= -1;	///< Version of the ephemeris map that these samples were taken from
+	vector<GTime>		timeList;				///< Times of samples
+	vector<Vector3d>	posList;				///< Positions of samples
+	vector<double>		posStdList;				///< Position standard deviations of samples
+	vector<int>			outageCountList;		///< Number of samples without positions before and including each sample
+};
+
+/** Interpolation window currently in use for a satellite, with barycentric weights for its sample times
+*/
+struct PephWindow
+{
+	shared_ptr<const PephSeries>	series_ptr;				///< Series that the window was taken from
+	int								nearIndex	= -1;		///< Index of the first sample at or after the last request time
+	int								beginIndex	= -1;		///< Index of the first sample in the window
+	GTime							refTime;				///< Reference time for the window's sample offsets
+	double							t[NMAX+1];				///< Times of samples, relative to the reference time
+	double							w[NMAX+1];				///< Barycentric weights of samples
+};
+
+map<SatSys, shared_ptr<const PephSeries>>	pephSeriesMap;
+std::shared_mutex							pephSeriesMutex;
+
+/** Get the contiguous ephemeris samples for a satellite, (re)building them if the ephemeris map has changed.
+* All modifications to the ephemeris map increment its version, so existing samples are found without searching the map by satellite id
+*/
+shared_ptr<const PephSeries> getPephSeries(
+	SatSys		Sat,
+	Navigation&	nav)
+{
+	{
+		std::shared_lock lock(pephSeriesMutex);
+		
+		auto series_it = pephSeriesMap.find(Sat);
+		if	( series_it != pephSeriesMap.end()
+			&&series_it->second->pephMapVersion == nav.pephMapVersion)
+		{
+			return series_it->second;
+		}
+	}
+	
+	auto it = nav.pephMap.find(Sat.id());
+	if (it == nav.pephMap.end())
+	{
+		return nullptr;
+	}
+	
+	auto& [id, pephMap] = *it;
+	
+	auto series_ptr = std::make_shared<PephSeries>();
+	auto& series = *series_ptr;
+	
+	series.pephMapVersion	= nav.pephMapVersion;
+	
+	series.timeList			.reserve(pephMap.size());
+	series.posList			.reserve(pephMap.size());
+	series.posStdList		.reserve(pephMap.size());
+	series.outageCountList	.reserve(pephMap.size());
+	
+	int outageCount = 0;
+	for (auto& [time, peph] : pephMap)
+	{
+		if (peph.pos.isZero())
+		{
+			outageCount++;
+		}
+		
+		series.timeList			.push_back(time);
+		series.posList			.push_back(peph.pos);
+		series.posStdList		.push_back(peph.posStd.norm());
+		series.outageCountList	.push_back(outageCount);
+	}
+	
+	std::unique_lock lock(pephSeriesMutex);
+	
+	pephSeriesMap[Sat] = series_ptr;
+	
+	return series_ptr;
+}
+
+/** satellite position by precise ephemeris.
+* Samples are kept in contiguous arrays per satellite, and the interpolation window and its barycentric weights are cached between calls,
+* so that repeated requests near the same time only require a single pass over the window.
  */
 bool pephpos(
 	Trace&		trace,
@@ -168,6 +258,8 @@ bool pephpos(
 {
 //     trace(4,"%s : time=%s sat=%s\n",__FUNCTION__, time.to_string(3).c_str(),Sat.id().c_str());
 
+	thread_local map<SatSys, PephWindow> windowMap;
+	
 	rSat = Vector3d::Zero();
 
 	if (nav.pephMap.empty())
@@ -177,20 +269,39 @@ bool pephpos(
 		return false;
 	}
 	
-	auto it = nav.pephMap.find(Sat.id());
-	if (it == nav.pephMap.end())
+	auto& window = windowMap[Sat];
+	
+	//reuse the series of this thread's window while the ephemerides are unchanged, without looking it up again
+	shared_ptr<const PephSeries> series_ptr;
+	if	( window.series_ptr
+		&&window.series_ptr->pephMapVersion == nav.pephMapVersion)
+	{
+		series_ptr = window.series_ptr;
+	}
+	else
+	{
+		series_ptr = getPephSeries(Sat, nav);
+	}
+	
+	if (series_ptr == nullptr)
 	{
 		BOOST_LOG_TRIVIAL(warning) << "Warning: Looking for precise position, but no precise ephemerides found for " << Sat.id();
 		
 		return false;
 	}
 	
-	auto& [id, pephMap] = *it;
+	auto& series = *series_ptr;
+	
+	int size = series.timeList.size();
+	if (size == 0)
+	{
+		return false;
+	}
 
-	auto firstTime	= pephMap.begin()	->first;
-	auto lastTime	= pephMap.rbegin()	->first;
+	auto firstTime	= series.timeList.front();
+	auto lastTime	= series.timeList.back();
 	
-	if	( (pephMap.size()	< NMAX + 1)
+	if	( (size	< NMAX + 1)
 		||(time	< firstTime	- MAXDTE)
 		||(time	> lastTime	+ MAXDTE))
 	{
@@ -201,70 +312,110 @@ bool pephpos(
 				   lastTime	.to_string(0)	.c_str());
 		return false;
 	}
-
-// 	//search for the ephemeris in the map
-
-	auto peph_it = pephMap.lower_bound(time);
-	if (peph_it == pephMap.end())
+	
+	if (window.series_ptr != series_ptr)
 	{
-		peph_it--;
+		window				= PephWindow();
+		window.series_ptr	= series_ptr;
 	}
 
-	auto middle0 = peph_it;
-
-	//go forward a few steps to make sure we're far from the end of the map.
-	for (int i = 0; i < NMAX/2; i++)
+	//find the first sample at or after the requested time, (or the last sample) - reusing the previous search if it is still valid
+	int nearIndex = window.nearIndex;
+	
+	if	( nearIndex < 0
+		||(nearIndex < size - 1	&& series.timeList[nearIndex]		< time)
+		||(nearIndex > 0		&& series.timeList[nearIndex - 1]	>= time))
 	{
-		peph_it++;
-		if (peph_it == pephMap.end())
+		nearIndex = std::lower_bound(series.timeList.begin(), series.timeList.end(), time) - series.timeList.begin();
+		
+		if (nearIndex == size)
 		{
-			break;
+			nearIndex--;
 		}
+		
+		window.nearIndex = nearIndex;
 	}
-
-	//go backward a few steps to make sure we're far from the beginning of the map
-	for (int i = 0; i <= NMAX; i++)
+	
+	//centre the window on the sample, keeping it within the series
+	int beginIndex = std::min(nearIndex + NMAX/2, size) - (NMAX + 1);
+	if (beginIndex < 0)
 	{
-		peph_it--;
-		if (peph_it == pephMap.begin())
+		beginIndex = 0;
+	}
+	int endIndex = beginIndex + NMAX;
+	
+	//check all ephemerides in the window have values.
+	int outageCount = series.outageCountList[endIndex];
+	if (beginIndex > 0)
+	{
+		outageCount -= series.outageCountList[beginIndex - 1];
+	}
+	
+	if (outageCount > 0)
+	{
+//             trace(3,"prec ephem outage %s sat=%s\n",time.to_string().c_str(), Sat.id().c_str());
+		return false;
+	}
+	
+	if (window.beginIndex != beginIndex)
+	{
+		//new window, recompute the barycentric weights for its sample times
+		window.beginIndex	= beginIndex;
+		window.refTime		= series.timeList[beginIndex + NMAX/2];
+		
+		for (int i = 0; i <= NMAX; i++)
 		{
-			break;
+			window.t[i] = (series.timeList[beginIndex + i] - window.refTime).to_double();
+		}
+		
+		for (int i = 0; i <= NMAX; i++)
+		{
+			double denom = 1;
+			for (int j = 0; j <= NMAX; j++)
+			{
+				if (j != i)
+				{
+					denom *= window.t[i] - window.t[j];
+				}
+			}
+			
+			window.w[i] = 1 / denom;
 		}
 	}
-
-	auto begin = peph_it;
-
-	vector<double>		t(NMAX+1);
-	vector<Vector3d>	p(NMAX+1);
-	double c[2];
-	double s[3];
 	
-	//get interpolation parameters and check all ephemerides have values.
-	peph_it = begin;
-	for (int i = 0; i <= NMAX; i++, peph_it++)
+	double dt = (time - window.refTime).to_double();
+	
+	//barycentric lagrange interpolation
+	Vector3d	numer = Vector3d::Zero();
+	double		denom = 0;
+	for (int i = 0; i <= NMAX; i++)
 	{
-		Peph& peph = peph_it->second;
-		if (peph.pos.isZero())
+		double diff = dt - window.t[i];
+		if (diff == 0)
 		{
-//             trace(3,"prec ephem outage %s sat=%s\n",time.to_string().c_str(), Sat.id().c_str());
-			return false;
+			numer = series.posList[beginIndex + i];
+			denom = 1;
+			break;
 		}
-
-		auto& pos = peph.pos;
 		
-		t[i] = (peph.time - time).to_double();
-		p[i] = pos;
+		double weight = window.w[i] / diff;
+		
+		numer += weight * series.posList[beginIndex + i];
+		denom += weight;
 	}
-
-	rSat = interpolate(t, p);
+	
+	rSat = numer / denom;
 	
 	if (vare)
 	{
-		double std = middle0->second.posStd.norm();	
+		double std = series.posStdList[nearIndex];
 
+		double t0		= window.t[0]		- dt;
+		double tNmax	= window.t[NMAX]	- dt;
+		
 		/* extrapolation error for orbit */
-		if      (t[0   ] > 0) std += EXTERR_EPH * SQR(t[0   ]) / 2;		//todo aaron, needs straigtening as below?
-		else if (t[NMAX] < 0) std += EXTERR_EPH * SQR(t[NMAX]) / 2;
+		if      (t0		> 0) std += EXTERR_EPH * SQR(t0		) / 2;		//todo aaron, needs straigtening as below?
+		else if (tNmax	< 0) std += EXTERR_EPH * SQR(tNmax	) / 2;
 
 		*vare = SQR(std);
 	}
@@ -573,7 +724,7 @@ bool satPosPrecise(
 	Vector3d rSat2 = Vector3d::Zero();
 	
 	bool pass	=	pephpos(trace, time,		Sat, nav, rSat,		&ephVar)
-				&&	pephpos(trace, time + tt,	Sat, nav, rSat2);
+				&&	pephpos(trace, time + tt,	Sat, nav, rSat2);		//both times will share the cached interpolation window
 					
 	if 	(pass == false)
 	{
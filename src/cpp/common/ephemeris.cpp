@@ -1,6 +1,12 @@
 
 // #pragma GCC optimize ("O0")
 
+#include <shared_mutex>
+#include <mutex>
+#include <map>
+
+using std::map;
+
 #include "eigenIncluder.hpp"
 #include "corrections.hpp"
 #include "coordinates.hpp"
@@ -256,21 +262,14 @@ void adjustRelativity(
 	satPos.satClk -= scalar * relativity1(satPos.rSat, satPos.satVel);	
 }
 
-/** satellite positions and clocks.
-* satellite position and clock are values at signal transmission time.
-* satellite clock does not include code bias correction (tgd or bgd).
-* any pseudorange and broadcast ephemeris are always needed to get signal transmission time.
+/** Nominal signal transmission time of an observation, from its pseudorange.
+* Flags the observation as failed if it is excluded or has no pseudorange
 */
-bool satPosClk(
+bool transmissionTime(
 	Trace&				trace,				///< Trace to output to
 	GTime				teph,				///< time to select ephemeris (gpst)
-	GObs&				obs,				///< observations to complete with satellite positions
-	Navigation&			nav,				///< Navigation data
-	vector<E_Source>	posSources,			///< Source of ephemeris data
-	vector<E_Source>	clkSources,			///< Source of ephemeris data
-	const KFState*		kfState_ptr,		///< Optional pointer to a kalman filter to take values from
-	E_OffsetType		offsetType,			///< Point of satellite to output position of
-	E_Relativity		applyRelativity)	///< Option to apply relativistic correction to clock
+	GObs&				obs,				///< observation to find the transmission time of
+	GTime&				time)				///< Transmission time by satellite clock
 {
 	if (obs.exclude)
 	{
@@ -304,11 +303,35 @@ bool satPosClk(
 	obs.tof = pr / CLIGHT;
 	
 	// transmission time by satellite clock
-	GTime time = obs.time;
+	time = obs.time;
 	
 	time -= obs.tof;
 	
-	bool pass;
+	return true;
+}
+
+/** satellite positions and clocks.
+* satellite position and clock are values at signal transmission time.
+* satellite clock does not include code bias correction (tgd or bgd).
+* any pseudorange and broadcast ephemeris are always needed to get signal transmission time.
+*/
+bool satPosClk(
+	Trace&				trace,				///< Trace to output to
+	GTime				teph,				///< time to select ephemeris (gpst)
+	GObs&				obs,				///< observations to complete with satellite positions
+	Navigation&			nav,				///< Navigation data
+	vector<E_Source>	posSources,			///< Source of ephemeris data
+	vector<E_Source>	clkSources,			///< Source of ephemeris data
+	const KFState*		kfState_ptr,		///< Optional pointer to a kalman filter to take values from
+	E_OffsetType		offsetType,			///< Point of satellite to output position of
+	E_Relativity		applyRelativity)	///< Option to apply relativistic correction to clock
+{
+	GTime time;
+	bool pass = transmissionTime(trace, teph, obs, time);
+	if (pass == false)
+	{
+		return false;
+	}
 	
 	pass = satclk(trace, time, teph, obs, clkSources,				nav,	kfState_ptr);
 	
@@ -320,7 +343,7 @@ bool satPosClk(
 		return false;
 	}
 
-	tracepdeex(5, trace, "\neph time %s %s pr=%.5f, satClk= %.5f", obs.Sat.id().c_str(), time.to_string(3).c_str(), pr / CLIGHT, obs.satClk);
+	tracepdeex(5, trace, "\neph time %s %s pr=%.5f, satClk= %.5f", obs.Sat.id().c_str(), time.to_string(3).c_str(), obs.tof, obs.satClk);
 	
 	time -= obs.satClk;	// Eugene: what if using ssr?
 	
@@ -354,3 +377,227 @@ bool satPosClk(
 	
 	return true;
 }
+
+/** Key for satellite positions and clocks that may be shared between observations
+*/
+struct SatPosClkKey
+{
+	SatSys				Sat;
+	GTime				teph;
+	long int			window;
+	vector<E_Source>	posSources;
+	vector<E_Source>	clkSources;
+	const KFState*		kfState_ptr;
+	E_OffsetType		offsetType;
+	
+	bool operator <(const SatPosClkKey& b) const
+	{
+		if (Sat			< b.Sat)			return true;
+		if (Sat			!= b.Sat)			return false;
+		if (teph		< b.teph)			return true;
+		if (teph		!= b.teph)			return false;
+		if (window		< b.window)			return true;
+		if (window		!= b.window)		return false;
+		if (posSources	< b.posSources)		return true;
+		if (posSources	!= b.posSources)	return false;
+		if (clkSources	< b.clkSources)		return true;
+		if (clkSources	!= b.clkSources)	return false;
+		if (kfState_ptr	< b.kfState_ptr)	return true;
+		if (kfState_ptr	!= b.kfState_ptr)	return false;
+		
+		return offsetType < b.offsetType;
+	}
+};
+
+/** Satellite position and clock computed at the centre of a window of transmission times
+*/
+struct SatPosClkEntry
+{
+	GTime		time;						///< Clock evaluation time at the centre of the window
+	bool		clkPass			= false;
+	bool		posPass			= false;
+	SatNav*		satNav_ptr		= nullptr;
+	E_Source	posSource		= E_Source::NONE;
+	E_Source	clkSource		= E_Source::NONE;
+	VectorEcef	rSat;
+	VectorEcef	satVel;
+	VectorEci	rSatEciDt;
+	VectorEci	vSatEciDt;
+	VectorEci	rSatEci0;
+	VectorEci	vSatEci0;
+	double		posVar			= 0;
+	double		satClk			= 0;
+	double		satClkVel		= 0;
+	double		satClkVar		= 0;
+	int			iodeClk			= -1;
+	int			iodePos			= -1;
+	bool		ephPosValid		= false;
+	bool		ephClkValid		= false;
+};
+
+map<SatPosClkKey, SatPosClkEntry>	satPosClkCache;
+std::shared_mutex					satPosClkCacheMutex;
+
+/** Discard all satellite positions and clocks that have been shared between observations
+*/
+void clearSatPosClkCache()
+{
+	std::unique_lock lock(satPosClkCacheMutex);
+	
+	satPosClkCache.clear();
+}
+
+/** Satellite positions and clocks, shared between stations.
+* Observations of the same satellite from different stations have transmission times that differ by the light time to each station.
+* Times are grouped into windows of acsConfig.sat_pos_cache_window seconds, the position and clock are computed once at the centre of each window,
+* and are then extrapolated to each observation's own transmission time using the satellite's velocity and clock rate.
+* Falls back to satPosClk() when the cache is disabled or the source does not provide a velocity.
+*/
+bool satPosClkCached(
+	Trace&				trace,				///< Trace to output to
+	GTime				teph,				///< time to select ephemeris (gpst)
+	GObs&				obs,				///< observations to complete with satellite positions
+	Navigation&			nav,				///< Navigation data
+	vector<E_Source>	posSources,			///< Source of ephemeris data
+	vector<E_Source>	clkSources,			///< Source of ephemeris data
+	const KFState*		kfState_ptr,		///< Optional pointer to a kalman filter to take values from
+	E_OffsetType		offsetType,			///< Point of satellite to output position of
+	E_Relativity		applyRelativity)	///< Option to apply relativistic correction to clock
+{
+	double windowWidth = acsConfig.sat_pos_cache_window;
+	
+	if (windowWidth <= 0)
+	{
+		return satPosClk(trace, teph, obs, nav, posSources, clkSources, kfState_ptr, offsetType, applyRelativity);
+	}
+	
+	GTime time;
+	bool pass = transmissionTime(trace, teph, obs, time);
+	if (pass == false)
+	{
+		return false;
+	}
+	
+	SatPosClkKey key;
+	key.Sat			= obs.Sat;
+	key.teph		= teph;
+	key.window		= floor((time - teph).to_double() / windowWidth);
+	key.posSources	= posSources;
+	key.clkSources	= clkSources;
+	key.kfState_ptr	= kfState_ptr;
+	key.offsetType	= offsetType;
+	
+	SatPosClkEntry entry;
+	bool found = false;
+	{
+		std::shared_lock lock(satPosClkCacheMutex);
+		
+		auto it = satPosClkCache.find(key);
+		if (it != satPosClkCache.end())
+		{
+			entry = it->second;
+			found = true;
+		}
+	}
+	
+	if (found == false)
+	{
+		//compute at the centre of the window so that the result doesnt depend on which observation got here first
+		SatPos satPos;
+		satPos.Sat			= obs.Sat;
+		satPos.satNav_ptr	= obs.satNav_ptr;
+		satPos.satStat_ptr	= obs.satStat_ptr;
+		
+		entry.time		= teph + (key.window + 0.5) * windowWidth;
+		entry.clkPass	= satclk(trace, entry.time, teph, satPos, clkSources,								nav,	kfState_ptr);
+		
+		if (entry.clkPass)
+		{
+			entry.posPass	= satpos(trace, entry.time - satPos.satClk, teph, satPos, posSources, offsetType,	nav,	kfState_ptr);
+		}
+		
+		entry.satNav_ptr	= satPos.satNav_ptr;
+		entry.posSource		= satPos.posSource;
+		entry.clkSource		= satPos.clkSource;
+		entry.rSat			= satPos.rSat;
+		entry.satVel		= satPos.satVel;
+		entry.rSatEciDt		= satPos.rSatEciDt;
+		entry.vSatEciDt		= satPos.vSatEciDt;
+		entry.rSatEci0		= satPos.rSatEci0;
+		entry.vSatEci0		= satPos.vSatEci0;
+		entry.posVar		= satPos.posVar;
+		entry.satClk		= satPos.satClk;
+		entry.satClkVel		= satPos.satClkVel;
+		entry.satClkVar		= satPos.satClkVar;
+		entry.iodeClk		= satPos.iodeClk;
+		entry.iodePos		= satPos.iodePos;
+		entry.ephPosValid	= satPos.ephPosValid;
+		entry.ephClkValid	= satPos.ephClkValid;
+		
+		std::unique_lock lock(satPosClkCacheMutex);
+		
+		satPosClkCache[key] = entry;
+	}
+	
+	if	( entry.posPass
+		&&entry.satVel.isZero())
+	{
+		//cant extrapolate without a velocity
+		return satPosClk(trace, teph, obs, nav, posSources, clkSources, kfState_ptr, offsetType, applyRelativity);
+	}
+	
+	obs.ephClkValid = entry.ephClkValid;
+	obs.ephPosValid = entry.ephPosValid;
+	
+	if (entry.clkPass == false)
+	{
+		obs.failureNoSatClock = true;
+		
+		tracepdeex(2, trace, "\nno satellite clock %s sat=%s", time.to_string(3).c_str(), obs.Sat.id().c_str());
+		return false;
+	}
+	
+	if (entry.posPass == false)
+	{
+		obs.failureNoSatPos = true;
+		
+		tracepdeex(3, trace, "\n%s failed (no ephemeris?) %s sat=%s", __FUNCTION__, time.to_string(3).c_str(), obs.Sat.id().c_str());
+		return false;
+	}
+	
+	//extrapolate from the centre of the window to this observation's transmission time
+	double dtClk = (time - entry.time).to_double();
+	
+	obs.satClk		= entry.satClk + entry.satClkVel * dtClk;
+	
+	double dtPos = dtClk - (obs.satClk - entry.satClk);
+	
+	obs.satNav_ptr	= entry.satNav_ptr;
+	obs.posSource	= entry.posSource;
+	obs.clkSource	= entry.clkSource;
+	obs.rSat		= entry.rSat		+ entry.satVel		* dtPos;
+	obs.satVel		= entry.satVel;
+	obs.rSatEciDt	= entry.rSatEciDt	+ entry.vSatEciDt	* dtPos;
+	obs.vSatEciDt	= entry.vSatEciDt;
+	obs.rSatEci0	= entry.rSatEci0;
+	obs.vSatEci0	= entry.vSatEci0;
+	obs.posVar		= entry.posVar;
+	obs.satClkVel	= entry.satClkVel;
+	obs.satClkVar	= entry.satClkVar;
+	obs.iodeClk		= entry.iodeClk;
+	obs.iodePos		= entry.iodePos;
+	
+	adjustRelativity(obs, applyRelativity);
+	
+	tracepdeex(4, trace, "\n%s sat=%s rs=%13.3f %13.3f %13.3f dtSat=%12.3f varPos=%7.3f varClk=%7.3f (shared)",
+			obs.time.to_string(6).c_str(),
+			obs.Sat.id().c_str(),
+			obs.rSat[0],
+			obs.rSat[1],
+			obs.rSat[2],
+			obs.satClk * 1E9,
+			obs.posVar,
+			obs.satClkVar);
+	
+	return true;
+}
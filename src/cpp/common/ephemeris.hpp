@@ -423,6 +423,19 @@ bool satPosClk(
 	E_OffsetType		offsetType		= E_OffsetType::COM,
 	E_Relativity		applyRelativity	= E_Relativity::ON);
 
+bool satPosClkCached(
+	Trace&				trace,
+	GTime				teph,
+	GObs&				obs,
+	Navigation&			nav,
+	vector<E_Source>	posSources,
+	vector<E_Source>	clkSources,
+	const KFState*		kfState_ptr		= nullptr,
+	E_OffsetType		offsetType		= E_OffsetType::COM,
+	E_Relativity		applyRelativity	= E_Relativity::ON);
+
+void clearSatPosClkCache();
+
 void readSp3ToNav(
 	string&		file, 
 	Navigation*	nav, 
@@ -10,10 +10,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/log/trivial.hpp>
 
-#include <bsoncxx/builder/basic/document.hpp>
-#include <bsoncxx/json.hpp>
-
-using bsoncxx::builder::basic::kvp;
+#include "trace.hpp"
 
 
 namespace sinks = boost::log::sinks;
@@ -22,6 +19,44 @@ namespace sinks = boost::log::sinks;
 
 string FileLog::path_log;
 
+/** Escape a string for use as a json value
+ */
+string jsonEscape(
+	const string&	str)
+{
+	string out;
+	out.reserve(str.size());
+	
+	for (unsigned char c : str)
+	{
+		switch (c)
+		{
+			case '"':	out += "\\\"";	break;
+			case '\\':	out += "\\\\";	break;
+			case '\b':	out += "\\b";		break;
+			case '\f':	out += "\\f";		break;
+			case '\n':	out += "\\n";		break;
+			case '\r':	out += "\\r";		break;
+			case '\t':	out += "\\t";		break;
+			default:
+			{
+				if (c < 0x20)
+				{
+					char buff[8];
+					snprintf(buff, sizeof(buff), "\\u%04x", c);
+					out += buff;
+				}
+				else
+				{
+					out += c;
+				}
+			}
+		}
+	}
+	
+	return out;
+}
+
 void FileLog::consume(
 	boost::log::record_view																	const&	rec,
 	sinks::basic_formatted_sink_backend<char, sinks::synchronized_feeding>::string_type		const&	log_string)
@@ -44,20 +79,15 @@ void FileLog::consume(
 		case boost::log::trivial::fatal:			logLevel = 0;			break;
 	}
 
-	std::ofstream logStream(FileLog::path_log, std::ofstream::app);
-
-	if (!logStream)
-		return;
-	
 	GTime time = timeGet();
 	
-	bsoncxx::builder::basic::document doc = {};
-	doc.append(kvp("label", 		"message"));
-	doc.append(kvp("Time", 			time.to_string()));
-	doc.append(kvp("level", 		logLevel));
-	doc.append(kvp("str", 			mess));
+	string line;
+	line += "{ \"label\" : \"message\"";
+	line += ", \"Time\" : \"" + jsonEscape(time.to_string()) + "\"";
+	line += ", \"level\" : " + std::to_string(logLevel);
+	line += ", \"str\" : \"" + jsonEscape(mess) + "\" }\n";
 	
-	logStream << bsoncxx::to_json(doc) << std::endl;
+	submitTraceRecord(FileLog::path_log, line);
 }
 
 
@@ -3,38 +3,380 @@
 
 
 #include "instrument.hpp"
+#include "trace.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <chrono>
+#include <memory>
+#include <vector>
+#include <mutex>
+
+using std::vector;
 
 map<string, size_t>		Instrument::timeMap;
 map<string, size_t>		Instrument::callMap;
 
+std::atomic<bool>		Instrument::enabled = false;
+string					Instrument::profileFilename;
+string					Instrument::summaryFilename;
+
 
-Instrument::Instrument(string desc, bool print)
+/** Completed zone recorded by the profiler
+ */
+struct ProfileZone
+{
+	const char*	name;
+	long int	start;			///< Time the zone was entered (ns)
+	long int	duration;		///< Time spent in the zone (ns)
+	int			depth;			///< Number of enclosing zones in the same thread
+};
+
+/** Counter accumulated by the profiler between epoch markers
+ */
+struct ProfileCounter
+{
+	const char*	name;
+	double		value;
+};
+
+/** Profiler records of a single thread.
+ * Only the owning thread adds records, the lock is uncontended except while the records are collected at an epoch marker
+ */
+struct ProfileThread
+{
+	std::atomic_flag		lock = ATOMIC_FLAG_INIT;
+	int						tid;
+	int						depth = 0;
+	vector<ProfileZone>		zoneList;
+	vector<ProfileCounter>	counterList;
+
+	void acquire()
+	{
+		while (lock.test_and_set(std::memory_order_acquire))
+		{
+
+		}
+	}
+
+	void release()
+	{
+		lock.clear(std::memory_order_release);
+	}
+};
+
+std::mutex								profileThreadMutex;
+vector<std::shared_ptr<ProfileThread>>	profileThreadList;
+
+/** Get the profiler records of the current thread, registering them on first use
+ */
+ProfileThread& profileThread()
+{
+	thread_local ProfileThread* profileThread_ptr = nullptr;
+
+	if (profileThread_ptr == nullptr)
+	{
+		auto newThread_ptr = std::make_shared<ProfileThread>();
+
+		std::lock_guard<std::mutex> guard(profileThreadMutex);
+
+		newThread_ptr->tid = profileThreadList.size();
+
+		//records are owned by the list so that they outlive their thread and are still exported
+		profileThreadList.push_back(newThread_ptr);
+
+		profileThread_ptr = newThread_ptr.get();
+	}
+
+	return *profileThread_ptr;
+}
+
+auto profileZero = std::chrono::steady_clock::now();
+
+/** Nanoseconds since the program started
+ */
+inline long int profileNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profileZero).count();
+}
+
+
+Instrument::Instrument(const char* desc, bool print)
 {
-#ifdef	ENABLE_UNIT_TESTS
-	this->print	= print;
-	start		= std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
 	description	= desc;
+	this->print	= print;
+
+	if (enabled.load(std::memory_order_relaxed))
+	{
+		active = true;
+
+		thread_ptr = &profileThread();
+		thread_ptr->depth++;
+	}
+
+#ifndef	ENABLE_UNIT_TESTS
+	if (active == false)
+		return;
 #endif
+
+	start = profileNow();
 }
 
 
-/** Pop a level from the stack for runtime tests
+/** Pop a level from the stack for runtime tests, and record the zone if profiling
 	*/
 Instrument::~Instrument()
 {
+#ifndef	ENABLE_UNIT_TESTS
+	if (active == false)
+		return;
+#endif
+
+	long int stop = profileNow();
+
+	if (active)
+	{
+		auto& thread = *thread_ptr;
+
+		thread.depth--;
+
+		ProfileZone zone;
+		zone.name		= description;
+		zone.start		= start;
+		zone.duration	= stop - start;
+		zone.depth		= thread.depth;
+
+		thread.acquire();
+		thread.zoneList.push_back(zone);
+		thread.release();
+	}
+
 #ifdef	ENABLE_UNIT_TESTS
-	size_t stop = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-	
-	timeMap[description] += stop - start;
+	size_t micros = (stop - start) / 1000;
+
+	timeMap[description] += micros;
 	callMap[description] += 1;
 	if (print)
-		printf("\n%40s took %15ld us", description.c_str(), stop - start);
+		printf("\n%40s took %15ld us", description, micros);
 #endif
 }
 
+/** Accumulate a value into a named counter (states, measurements, bytes written...) for the current epoch
+ */
+void Instrument::count(
+	const char*	name,		///< Name of the counter
+	double		value)		///< Value to add
+{
+	if (enabled.load(std::memory_order_relaxed) == false)
+	{
+		return;
+	}
+
+	auto& thread = profileThread();
+
+	thread.acquire();
+	{
+		bool found = false;
+		for (auto& counter : thread.counterList)
+		{
+			//names may be equal strings at different addresses, eg the same literal in different translation units
+			if	(  counter.name == name
+				|| strcmp(counter.name, name) == 0)
+			{
+				counter.value += value;
+				found = true;
+				break;
+			}
+		}
+
+		if (found == false)
+		{
+			thread.counterList.push_back({name, value});
+		}
+	}
+	thread.release();
+}
+
+/** Totals of a zone over an epoch
+ */
+struct ProfileSummary
+{
+	long int	calls		= 0;
+	long int	total		= 0;
+	long int	self		= 0;
+	long int	max			= 0;
+};
+
+/** Mark the end of an epoch, collecting the records of all threads and exporting them to the profile outputs.
+ * The chrome trace is written as an unterminated json array so that it may be appended to and viewed while the program is running
+ */
+void Instrument::epochMark(
+	int				epoch,		///< Number of the epoch that has completed
+	const string&	label)		///< Time of the epoch, for the summary
+{
+	long int now = profileNow();
+
+	vector<std::pair<int, vector<ProfileZone>>>	threadZoneList;
+	map<string, double>							counterMap;
+	{
+		std::lock_guard<std::mutex> guard(profileThreadMutex);
+
+		for (auto& thread_ptr : profileThreadList)
+		{
+			auto& thread = *thread_ptr;
+
+			//swap in buffers of the same size, so that recording doesn't need to grow them again next epoch
+			vector<ProfileZone>		zoneList;
+			vector<ProfileCounter>	counterList;
+
+			zoneList	.reserve(thread.zoneList	.capacity());
+			counterList	.reserve(thread.counterList	.capacity());
+
+			thread.acquire();
+			{
+				zoneList	.swap(thread.zoneList);
+				counterList	.swap(thread.counterList);
+			}
+			thread.release();
+
+			for (auto& counter : counterList)
+			{
+				counterMap[counter.name] += counter.value;
+			}
+
+			if (zoneList.empty() == false)
+			{
+				threadZoneList.push_back({thread.tid, std::move(zoneList)});
+			}
+		}
+	}
+
+	//records are always collected, so that they don't accumulate while there is nowhere to export them
+	if	(  profileFilename.empty()
+		&& summaryFilename.empty())
+	{
+		return;
+	}
+
+	static string lastProfileFilename;
+	static string lastSummaryFilename;
+
+	string	json;
+	string	csv;
+	char	buff[1024];
+
+	if (profileFilename != lastProfileFilename)
+	{
+		lastProfileFilename = profileFilename;
+
+		json += "[\n";
+	}
+
+	if (summaryFilename != lastSummaryFilename)
+	{
+		lastSummaryFilename = summaryFilename;
+
+		csv += "epoch,time,type,name,calls,total_ms,self_ms,max_ms,value\n";
+	}
+
+	map<string, ProfileSummary> summaryMap;
+
+	for (auto& [tid, zoneList] : threadZoneList)
+	{
+		//zones are recorded as they exit, put parents back in front of their children to rebuild the hierarchy
+		std::sort(zoneList.begin(), zoneList.end(), [](ProfileZone& a, ProfileZone& b)
+		{
+			if (a.start != b.start)		return a.start < b.start;
+			else						return a.depth < b.depth;
+		});
+
+		vector<ProfileSummary*>	parentList;
+		vector<string>			pathList;
+
+		for (auto& zone : zoneList)
+		{
+			snprintf(buff, sizeof(buff), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+					zone.name,
+					tid,
+					zone.start		/ 1e3,
+					zone.duration	/ 1e3);
+
+			json += buff;
+
+			//zones whose parents were exported with a previous epoch start a new branch
+			int depth = std::min(zone.depth, (int) pathList.size());
+
+			parentList	.resize(depth);
+			pathList	.resize(depth);
+
+			string path;
+			if (depth > 0)		path = pathList.back() + "/" + zone.name;
+			else				path = zone.name;
+
+			auto& summary = summaryMap[path];
+
+			summary.calls++;
+			summary.total	+= zone.duration;
+			summary.self	+= zone.duration;
+			summary.max		= std::max(summary.max, zone.duration);
+
+			if (depth > 0)
+			{
+				parentList.back()->self -= zone.duration;
+			}
+
+			parentList	.push_back(&summary);
+			pathList	.push_back(path);
+		}
+	}
+
+	snprintf(buff, sizeof(buff), "{\"name\":\"Epoch %d\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{\"time\":\"%s\"}},\n",
+			epoch,
+			now / 1e3,
+			label.c_str());
+
+	json += buff;
+
+	for (auto& [name, value] : counterMap)
+	{
+		snprintf(buff, sizeof(buff), "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%.17g}},\n",
+				name.c_str(),
+				now / 1e3,
+				value);
+
+		json += buff;
+	}
+
+	for (auto& [path, summary] : summaryMap)
+	{
+		snprintf(buff, sizeof(buff), "%d,%s,zone,%s,%ld,%.6f,%.6f,%.6f,\n",
+				epoch,
+				label.c_str(),
+				path.c_str(),
+				summary.calls,
+				summary.total	/ 1e6,
+				summary.self	/ 1e6,
+				summary.max		/ 1e6);
+
+		csv += buff;
+	}
+
+	for (auto& [name, value] : counterMap)
+	{
+		snprintf(buff, sizeof(buff), "%d,%s,counter,%s,,,,,%.17g\n",
+				epoch,
+				label.c_str(),
+				name.c_str(),
+				value);
+
+		csv += buff;
+	}
+
+	submitTraceRecord(profileFilename, json);
+	submitTraceRecord(summaryFilename, csv);
+}
+
 
 /** Print the status of completed (passed/failed) and remaining tests
 	*/
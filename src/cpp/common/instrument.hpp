@@ -2,28 +2,49 @@
 #pragma once
 
 #include <string>
+#include <atomic>
 #include <map>
 
 using std::string;
 using std::map;
 
+struct ProfileThread;
 
+/** Scoped timing zone, and interface to the runtime profiler.
+ * When the profiler is enabled each zone is recorded with nanosecond timestamps into a buffer belonging to its thread,
+ * and the buffers are collected at each epoch marker to be exported as chrome trace events and a per-epoch summary.
+ * Zone names and counter names must remain valid for the life of the program, (string literals or __FUNCTION__)
+ */
 struct Instrument
 {
 	static map<string, size_t>		timeMap;
 	static map<string, size_t>		callMap;
 	
+	static std::atomic<bool>		enabled;			///< Record zones and counters, switched at runtime from the config
+	static string					profileFilename;	///< Chrome trace / perfetto json output
+	static string					summaryFilename;	///< Per-epoch csv summary output
+
 	bool print = false;
+	bool active = false;				///< This zone is being recorded by the profiler
+
+	long int		start;
+	const char*		description;
+	ProfileThread*	thread_ptr = nullptr;	///< Records of the thread the zone was entered in
 
-	size_t	start;
-	string	description;
-	
 	Instrument(
-		string	desc, 
-		bool	print = false);
+		const char*	desc,
+		bool		print = false);
 
 	~Instrument();
 
+	static void count(
+		const char*	name,
+		double		value);
+
+	static void epochMark(
+		int				epoch,
+		const string&	label);
+
 	static void printStatus();
 };
 
@@ -0,0 +1,49 @@
+
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+#include "internedString.hpp"
+
+using std::unordered_map;
+using std::shared_mutex;
+using std::shared_lock;
+using std::unique_lock;
+
+/** Point this handle to the canonical copy of a string, adding it to the string table with the next id if required.
+*/
+void InternedString::intern(
+	const string&	str)		///< String to find in the table
+{
+	if (str.empty())
+	{
+		str_ptr	= &emptyString();
+		id		= 0;
+		
+		return;
+	}
+	
+	//elements are never removed from the table, so pointers to them remain valid
+	static unordered_map<string, unsigned int>	stringTable;
+	static shared_mutex							stringTableMutex;
+	
+	{
+		shared_lock<shared_mutex> guard(stringTableMutex);
+		
+		auto it = stringTable.find(str);
+		if (it != stringTable.end())
+		{
+			str_ptr	= &it->first;
+			id		= it->second;
+			
+			return;
+		}
+	}
+	
+	unique_lock<shared_mutex> guard(stringTableMutex);
+	
+	auto [it, inserted] = stringTable.insert({str, stringTable.size() + 1});
+	
+	str_ptr	= &it->first;
+	id		= it->second;
+}
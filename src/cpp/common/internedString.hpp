@@ -0,0 +1,113 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <string>
+
+using std::ostream;
+using std::string;
+
+/** Handle to a string that is stored once in a global string table.
+* Each string is also given a small integer id when it is first interned, and copying, hashing, testing for equality, and ordering
+* operate on the id alone, without touching the characters.
+* Containers sorted by these are therefore ordered by the time each string was first seen rather than alphabetically.
+*
+* Handles are implicitly convertible to/from std::string so they may be used in place of strings in most situations,
+* strings are only formatted when they are required for output.
+*/
+struct InternedString
+{
+	const string*	str_ptr = &emptyString();		///< Pointer to the canonical copy of the string in the string table
+	unsigned int	id		= 0;					///< Integer handle of the string, in the order strings were first interned (0 for the empty string)
+
+	InternedString()
+	{
+		
+	}
+
+	InternedString(
+		const string&	str)
+	{
+		intern(str);
+	}
+
+	InternedString(
+		const char*		str)
+	{
+		intern(str);
+	}
+
+	void intern(
+		const string&	str);
+
+	static const string&	emptyString()
+	{
+		static const string empty;
+		
+		return empty;
+	}
+
+	operator const string&()	const	{	return *str_ptr;					}
+	const string&	get()		const	{	return *str_ptr;					}
+	const char*		c_str()		const	{	return str_ptr->c_str();			}
+	bool			empty()		const	{	return str_ptr->empty();			}
+	size_t			size()		const	{	return str_ptr->size();				}
+	size_t			length()	const	{	return str_ptr->length();			}
+	
+	string			substr(
+		size_t	pos,
+		size_t	len = string::npos)
+	const
+	{
+		return str_ptr->substr(pos, len);
+	}
+
+	bool operator ==	(const InternedString&	b)	const	{	return id		== b.id;		}
+	bool operator ==	(const string&			b)	const	{	return *str_ptr	== b;			}
+	bool operator ==	(const char*			b)	const	{	return *str_ptr	== b;			}
+	bool operator <		(const InternedString&	b)	const	{	return id		<  b.id;		}
+	bool operator >		(const InternedString&	b)	const	{	return id		>  b.id;		}
+
+	friend ostream& operator<<(ostream& os, const InternedString& str)
+	{
+		os << *str.str_ptr;
+		
+		return os;
+	}
+
+	template<class ARCHIVE>
+	void serialize(ARCHIVE& ar, const unsigned int& version)
+	{
+		string str;
+		
+		if (ARCHIVE::is_saving::value)
+		{
+			str = *str_ptr;
+			ar & str;
+		}
+		else
+		{
+			ar & str;
+			intern(str);
+		}
+	}
+};
+
+inline string operator+(const InternedString&	a, const InternedString&	b)	{	return a.get()	+ b.get();	}
+inline string operator+(const InternedString&	a, const string&			b)	{	return a.get()	+ b;		}
+inline string operator+(const string&			a, const InternedString&	b)	{	return a		+ b.get();	}
+inline string operator+(const InternedString&	a, const char*				b)	{	return a.get()	+ b;		}
+inline string operator+(const char*				a, const InternedString&	b)	{	return a		+ b.get();	}
+inline string operator+(const InternedString&	a, char						b)	{	return a.get()	+ b;		}
+
+namespace std
+{
+	template<> struct hash<InternedString>
+	{
+		size_t operator()(InternedString const& str) const
+		{
+			//the ids are unique for each string, so hash them directly
+			return hash<unsigned int>{}(str.id);
+		}
+	};
+}
@@ -21,6 +21,9 @@ namespace sinks = boost::log::sinks;
 Mongo*	localMongo_ptr	= nullptr;
 Mongo*	remoteMongo_ptr	= nullptr;
 
+TimeSeriesStore*	localStore_ptr	= nullptr;
+TimeSeriesStore*	remoteStore_ptr	= nullptr;
+
 
 mongocxx::instance Mongo::instance;	//single static instance of the driver
 
@@ -46,6 +49,18 @@ void mongoooo()
 			continue;
 		}
 		
+		if (config.backend == +E_Database::LOCAL_STORE)
+		{
+			auto& store_ptr = (config_ptr == &acsConfig.localMongo) ? localStore_ptr : remoteStore_ptr;
+
+			if (store_ptr == nullptr)
+			{
+				store_ptr = openTimeSeriesStore(config.store_filename, config.delete_history);
+			}
+
+			continue;
+		}
+
 		try
 		{
 			mongo_ptr = new Mongo(config.uri);
@@ -29,23 +29,13 @@ using std::deque;
 using std::map;
 
 
+#include "timeSeriesStore.hpp"
 #include "networkEstimator.hpp"
 #include "observations.hpp"
 #include "station.hpp"
 #include "algebra.hpp"
 
 
-struct DBEntry
-{
-	map<string, tuple<string,			bool>>		stringMap;
-	map<string, tuple<GTime,			bool>>		timeMap;
-	map<string, tuple<double,			bool>>		doubleMap;
-	map<string, tuple<int,				bool>>		intMap;	
-	map<string, tuple<Vector3d,			bool>>		vectorMap;	
-	map<string, tuple<vector<double>,	bool>>		doubleArrayMap;	
-	map<string, tuple<deque<bool>,		bool>>		boolArrayMap;	
-};
-
 using bsoncxx::builder::stream::close_array;
 using bsoncxx::builder::stream::close_document;
 using bsoncxx::builder::stream::document;
@@ -134,6 +124,9 @@ document entryToDocument(
 extern Mongo*	localMongo_ptr;
 extern Mongo*	remoteMongo_ptr;
 
+extern TimeSeriesStore*	localStore_ptr;
+extern TimeSeriesStore*	remoteStore_ptr;
+
 
 #define MONGO_NOT_INITIALISED_MESSAGE BOOST_LOG_TRIVIAL(warning)	<< "Mongo actions requested but mongo is not available - check it is enabled and connected correctly"
 
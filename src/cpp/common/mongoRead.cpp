@@ -71,6 +71,27 @@ GTime mongoReadLastClock()		//todo aaron delete me
 {
 	GTime outTime;
 	
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		if (remoteStore_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return outTime;
+		}
+		
+		//clocks are stored as a series per satellite, take the latest of them
+		for (auto& row : remoteStore_ptr->findLatest(SSR_DB, {{SSR_DATA, SSR_CLOCK}}))
+		{
+			if	(  outTime == GTime::noTime()
+				|| row.time > outTime)
+			{
+				outTime = row.time;
+			}
+		}
+		
+		return outTime;
+	}
+	
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
@@ -106,6 +127,136 @@ GTime mongoReadLastClock()		//todo aaron delete me
 	return outTime;
 }
 
+/** Select the orbits and clocks of a satellite that straddle the reference time, and note any change in broadcast iode
+*/
+void addOrbClkStraddle(
+	GTime				referenceTime,		///< reference time (t0) of SSR correction
+	SatSys				Sat,				///< satellite the values are for
+	deque<EphValues>&	ephVec,				///< orbit values around the reference time, in time order
+	deque<ClkValues>&	clkVec,				///< clock values around the reference time, in time order
+	SsrOutMap&			ssrOutMap,			///< map to add the selected values to
+	bool&				changeIod)			///< set if the broadcast iode of the satellite has changed
+{
+	//try to find a set of things that straddle the reference time, with the same iode
+	//do for both broadcast and precise values
+	SSROut ssrOut;
+	ssrOut.ephInput = getStraddle<SSREphInput>(referenceTime, ephVec);
+	ssrOut.clkInput = getStraddle<SSRClkInput>(referenceTime, clkVec);
+	
+	if	(ssrOut.ephInput.valid == false)
+	{
+		tracepdeex(3, std::cout, "Could not retrieve valid ephemeris for %s\n", Sat.id().c_str()); 
+		return;
+	}
+	if	( ssrOut.clkInput.valid == false)
+	{
+		tracepdeex(3, std::cout, "Could not retrieve valid clock     for %s\n", Sat.id().c_str()); 
+		return;
+	}
+
+	ssrOutMap[Sat] = ssrOut;
+	
+	if (ssrOut.ephInput.vals[0].iode != lastBrdcIode[Sat])
+	{
+		changeIod = true;
+		lastBrdcIode[Sat] = ssrOut.ephInput.vals[0].iode;
+	}
+}
+
+/** Increment the ssr iod after any change in broadcast iode
+*/
+void updateSsrIod(
+	bool	changeIod)
+{
+	if (changeIod)
+	{
+		currentSSRIod++;
+		
+		if (currentSSRIod > 15)
+			currentSSRIod = 0;
+	}
+}
+
+/** Read orbits and clocks from the local time series store
+*/
+SsrOutMap storeReadOrbClk(
+	TimeSeriesStore&	store,				///< store to read from
+	GTime				referenceTime,		///< reference time (t0) of SSR correction
+	E_Sys				targetSys)			///< target system
+{
+	SsrOutMap ssrOutMap;
+	
+	bool changeIod = false;
+	auto sats = getSysSats(targetSys);
+	for (auto Sat : sats) 
+	{
+		deque<EphValues> ephVec;
+		deque<ClkValues> clkVec;
+		
+		//try to get up to two entries from either side of the desired time
+		for (string	data		: {SSR_EPHEMERIS, SSR_CLOCK})
+		for (bool	less		: {false, true})
+		{
+			vector<StoreRow> rowList;
+			if (less)	rowList = store.find(SSR_DB, {{SSR_SAT, Sat.id()}, {SSR_DATA, data}}, GTime::noTime(),	referenceTime,		2,	true);
+			else		rowList = store.find(SSR_DB, {{SSR_SAT, Sat.id()}, {SSR_DATA, data}}, referenceTime,	GTime::noTime(),	3,	false);
+			
+			int count = 0;
+			for (auto& row : rowList)
+			{
+				if	(  less == false
+					&& row.time == referenceTime)
+				{
+					//range is inclusive, the reference time is already taken by the lesser side
+					continue;
+				}
+				
+				if (count++ >= 2)
+					break;
+				
+				if (data == SSR_EPHEMERIS)
+				{
+					EphValues ephValues;
+					ephValues.time = row.time;
+					
+					for (int i = 0; i < 3; i++)
+					{
+						ephValues.brdcPos(i) = row.getDouble(SSR_POS SSR_BRDC + std::to_string(i));
+						ephValues.precPos(i) = row.getDouble(SSR_POS SSR_PREC + std::to_string(i));
+						ephValues.brdcVel(i) = row.getDouble(SSR_VEL SSR_BRDC + std::to_string(i));
+						ephValues.precVel(i) = row.getDouble(SSR_VEL SSR_PREC + std::to_string(i));
+					}
+					
+					ephValues.ephVar	= row.getDouble	(SSR_VAR);
+					ephValues.iode		= row.getInt	(SSR_IODE);
+					
+					if (less)	ephVec	.push_front	(ephValues);
+					else		ephVec	.push_back	(ephValues);
+				}
+				
+				if (data == SSR_CLOCK)
+				{
+					ClkValues clkValues;
+					clkValues.time = row.time;
+					
+					clkValues.brdcClk 	= row.getDouble	(SSR_CLOCK SSR_BRDC);
+					clkValues.precClk 	= row.getDouble	(SSR_CLOCK SSR_PREC);
+					clkValues.iode		= row.getInt	(SSR_IODE);
+					
+					if (less)	clkVec	.push_front	(clkValues);
+					else		clkVec	.push_back	(clkValues);
+				}
+			}
+		}
+		
+		addOrbClkStraddle(referenceTime, Sat, ephVec, clkVec, ssrOutMap, changeIod);
+	}
+	
+	updateSsrIod(changeIod);
+	
+	return ssrOutMap;
+}
+
 /** Read orbits and clocks from Mongo DB
 */
 SsrOutMap mongoReadOrbClk(
@@ -116,6 +267,21 @@ SsrOutMap mongoReadOrbClk(
 {
 	SsrOutMap ssrOutMap;
 	
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		if (remoteStore_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return ssrOutMap;
+		}
+		
+		ssrOutMap = storeReadOrbClk(*remoteStore_ptr, referenceTime, targetSys);
+		
+		masterIod = currentSSRIod;
+		
+		return ssrOutMap;
+	}
+	
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
@@ -238,39 +404,10 @@ SsrOutMap mongoReadOrbClk(
 // 		std::cout << Sat.id() << "Final eprecs:" << " iode: " << a.iode <<  " "<< a.time.to_string(0) << std::endl;
 // 	}
 		
-		//try to find a set of things that straddle the reference time, with the same iode
-		//do for both broadcast and precise values
-		SSROut ssrOut;
-		ssrOut.ephInput = getStraddle<SSREphInput>(referenceTime, ephVec);
-		ssrOut.clkInput = getStraddle<SSRClkInput>(referenceTime, clkVec);
-		
-		if	(ssrOut.ephInput.valid == false)
-		{
-			tracepdeex(3, std::cout, "Could not retrieve valid ephemeris for %s\n", Sat.id().c_str()); 
-			continue;
-		}
-		if	( ssrOut.clkInput.valid == false)
-		{
-			tracepdeex(3, std::cout, "Could not retrieve valid clock     for %s\n", Sat.id().c_str()); 
-			continue;
-		}
-
-		ssrOutMap[Sat] = ssrOut;
-		
-		if (ssrOut.ephInput.vals[0].iode != lastBrdcIode[Sat])
-		{
-			changeIod = true;
-			lastBrdcIode[Sat] = ssrOut.ephInput.vals[0].iode;
-		}
+		addOrbClkStraddle(referenceTime, Sat, ephVec, clkVec, ssrOutMap, changeIod);
 	}
 
-	if (changeIod)
-	{
-		currentSSRIod++;
-		
-		if (currentSSRIod > 15)
-			currentSSRIod = 0;
-	}
+	updateSsrIod(changeIod);
 	
 	masterIod = currentSSRIod;
 
@@ -312,6 +449,53 @@ SsrPBMap mongoReadPhaseBias(
 {
 	SsrPBMap ssrPBMap;
 	
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		if (remoteStore_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return ssrPBMap;
+		}
+		
+		//the latest entry of each series is the latest of each satellite and code
+		for (auto& row : remoteStore_ptr->findLatest(SSR_DB, {{SSR_DATA, SSR_PHAS_BIAS}}))
+		{
+			SatSys Sat(row.getString(SSR_SAT).c_str());
+			
+			if (Sat.sys != targetSys)
+				continue;
+			
+			if (!row.time.bigTime)
+				continue;
+			
+			SSRPhasBias& ssrPhasBias	= ssrPBMap[Sat];
+			ssrPhasBias.ssrMeta			= ssrMeta;
+			ssrPhasBias.iod				= masterIod;
+			
+			ssrPhasBias.t0							= row.time;
+			ssrPhasBias.ssrPhase.dispBiasConistInd	= row.getInt	("dispBiasConistInd");
+			ssrPhasBias.ssrPhase.MWConistInd		= row.getInt	("MWConistInd");
+			ssrPhasBias.ssrPhase.yawAngle			= row.getDouble	("yawAngle");
+			ssrPhasBias.ssrPhase.yawRate			= row.getDouble	("yawRate");
+			
+			SSRPhaseCh ssrPhaseCh;
+			ssrPhaseCh.signalIntInd 				= row.getInt	("signalIntInd");
+			ssrPhaseCh.signalWLIntInd 				= row.getInt	("signalWLIntInd");
+			ssrPhaseCh.signalDisconCnt 				= row.getInt	("signalDisconCnt");
+			
+			E_ObsCode obsCode						= E_ObsCode::_from_string(row.getString(SSR_OBSCODE).c_str());
+			
+			BiasVar biasVar;
+			biasVar.bias							= row.getDouble	(SSR_BIAS);
+			biasVar.var								= row.getDouble	(SSR_VAR);
+			
+			ssrPhasBias.obsCodeBiasMap	[obsCode]	= biasVar;
+			ssrPhasBias.ssrPhaseChs		[obsCode]	= ssrPhaseCh;
+		}
+		
+		return ssrPBMap;
+	}
+	
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
@@ -395,6 +579,42 @@ SsrCBMap mongoReadCodeBias(
 {
 	SsrCBMap ssrCBMap;
 	
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		if (remoteStore_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return ssrCBMap;
+		}
+		
+		//the latest entry of each series is the latest of each satellite and code
+		for (auto& row : remoteStore_ptr->findLatest(SSR_DB, {{SSR_DATA, SSR_CODE_BIAS}}))
+		{
+			SatSys Sat(row.getString(SSR_SAT).c_str());
+			
+			if (Sat.sys != targetSys)
+				continue;
+			
+			if (!row.time.bigTime)
+				continue;
+			
+			SSRCodeBias& ssrCodeBias	= ssrCBMap[Sat];
+			ssrCodeBias.ssrMeta			= ssrMeta;
+			ssrCodeBias.iod				= masterIod;
+			ssrCodeBias.t0				= row.time;
+			
+			E_ObsCode obsCode 	= E_ObsCode::_from_string(row.getString(SSR_OBSCODE).c_str());
+			
+			BiasVar biasVar;
+			biasVar.bias 		= row.getDouble(SSR_BIAS);
+			biasVar.var 		= row.getDouble(SSR_VAR);
+			
+			ssrCodeBias.obsCodeBiasMap[obsCode] = biasVar;
+		}
+		
+		return ssrCBMap;
+	}
+	
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
@@ -469,6 +689,100 @@ Eph	mongoReadEphemeris(
 	Eph				eph;
 	E_NavMsgType	type;
 
+	switch (rtcmMessCode)
+	{
+		case +RtcmMessageType:: GPS_EPHEMERIS:		// fallthrough
+		case +RtcmMessageType:: QZS_EPHEMERIS:		type	= E_NavMsgType::LNAV;	break;
+		case +RtcmMessageType:: BDS_EPHEMERIS:		type	= E_NavMsgType::D1;		break;
+		case +RtcmMessageType:: GAL_FNAV_EPHEMERIS:	type	= E_NavMsgType::FNAV;	break;
+		case +RtcmMessageType:: GAL_INAV_EPHEMERIS:	type	= E_NavMsgType::INAV;	break;
+		default:
+			BOOST_LOG_TRIVIAL(error) << "Error, attempting to upload incorrect message type.\n";
+			return eph;
+	}
+	
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		if (remoteStore_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return eph;
+		}
+		
+		//ephemerides of a satellite and type are a single series, its latest row is the newest toe
+		for (auto& row : remoteStore_ptr->findLatest("Ephemeris", {{"Sat", Sat.id()}, {"Type", type._to_string()}}))
+		{
+			eph.Sat		= Sat;
+			eph.type	= type;
+			
+			eph.toe		= row.time;
+			eph.toc		= row.getTime	("TocGPST");
+			
+			eph.weekRollOver	= row.getInt	("WeekDecoded");
+			eph.week			= row.getInt	("WeekAdjusted");
+			eph.toes			= row.getDouble	("ToeSecOfWeek");
+			eph.tocs			= row.getDouble	("TocSecOfWeek");
+			
+			eph.aode	= row.getInt	("AODE");
+			eph.aodc	= row.getInt	("AODC");
+			eph.iode	= row.getInt	("IODE");
+			eph.iodc	= row.getInt	("IODC");
+			
+			eph.f0		= row.getDouble	("f0");
+			eph.f1		= row.getDouble	("f1");
+			eph.f2		= row.getDouble	("f2");
+			
+			eph.sqrtA	= row.getDouble	("SqrtA");
+			eph.A		= row.getDouble	("A");
+			eph.e		= row.getDouble	("e");
+			eph.i0		= row.getDouble	("i0");
+			eph.idot	= row.getDouble	("iDot");
+			eph.omg		= row.getDouble	("omg");
+			eph.OMG0	= row.getDouble	("OMG0");
+			eph.OMGd	= row.getDouble	("OMGDot");
+			eph.M0		= row.getDouble	("M0");
+			eph.deln	= row.getDouble	("DeltaN");
+			eph.crc		= row.getDouble	("Crc");
+			eph.crs		= row.getDouble	("Crs");
+			eph.cic		= row.getDouble	("Cic");
+			eph.cis		= row.getDouble	("Cis");
+			eph.cuc		= row.getDouble	("Cuc");
+			eph.cus		= row.getDouble	("Cus");
+			
+			eph.tgd[0]	= row.getDouble	("TGD0");
+			eph.tgd[1]	= row.getDouble	("TGD1");
+			eph.sva		= row.getInt	("URAIndex");
+			eph.svh		= (E_Svh) row.getInt("SVHealth");
+			
+			if	( eph.Sat.sys == +E_Sys::GPS
+				||eph.Sat.sys == +E_Sys::QZS)
+			{
+				eph.ura[0]	= row.getDouble	("URA");
+				eph.code	= row.getInt	("CodeOnL2");
+				eph.flag	= row.getInt	("L2PDataFlag");
+				eph.fitFlag	= row.getInt	("FitFlag");
+				eph.fit		= row.getDouble	("FitInterval");
+			}
+			else if (eph.Sat.sys == +E_Sys::GAL)
+			{
+				eph.ura[0]	= row.getDouble	("SISA");
+				eph.e5a_hs	= row.getInt	("E5aHealth");
+				eph.e5a_dvs	= row.getInt	("E5aDataValidity");
+				eph.e5b_hs	= row.getInt	("E5bHealth");
+				eph.e5b_dvs	= row.getInt	("E5bDataValidity");
+				eph.e1_hs	= row.getInt	("E1Health");
+				eph.e1_dvs	= row.getInt	("E1DataValidity");
+				eph.code	= row.getInt	("DataSource");
+			}
+			else if (eph.Sat.sys == +E_Sys::BDS)
+			{
+				eph.ura[0]	= row.getDouble	("URA");
+			}
+		}
+		
+		return eph;
+	}
+	
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
@@ -485,18 +799,6 @@ Eph	mongoReadEphemeris(
 
 	b_date btime{std::chrono::system_clock::from_time_t((time_t)((PTime)targetTime).bigTime)};
 
-	switch (rtcmMessCode)
-	{
-		case +RtcmMessageType:: GPS_EPHEMERIS:		// fallthrough
-		case +RtcmMessageType:: QZS_EPHEMERIS:		type	= E_NavMsgType::LNAV;	break;
-		case +RtcmMessageType:: BDS_EPHEMERIS:		type	= E_NavMsgType::D1;		break;
-		case +RtcmMessageType:: GAL_FNAV_EPHEMERIS:	type	= E_NavMsgType::FNAV;	break;
-		case +RtcmMessageType:: GAL_INAV_EPHEMERIS:	type	= E_NavMsgType::INAV;	break;
-		default:
-			BOOST_LOG_TRIVIAL(error) << "Error, attempting to upload incorrect message type.\n";
-			return eph;
-	}
-	
 	// Find the latest document according to t0_time.
 	auto docSys		= document{}	<< "Sat"		<< Sat.id()
 									<< "Type"		<< type._to_string()
@@ -601,6 +903,66 @@ Geph mongoReadGloEphemeris(
 {
 	Geph geph;
 	
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		if (remoteStore_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return geph;
+		}
+		
+		//take the newest toe across the types the satellite has been broadcast with
+		bool found = false;
+		for (auto& row : remoteStore_ptr->findLatest("Ephemeris", {{"Sat", Sat.id()}}))
+		{
+			if	(  found
+				&& row.time <= geph.toe)
+			{
+				continue;
+			}
+			
+			found = true;
+			
+			geph.Sat		= Sat;
+			geph.type		= E_NavMsgType::FDMA;
+			
+			geph.toe		= row.time;
+			geph.tof		= row.getTime	("TofGPST");
+			
+			geph.tb			= row.getInt	("ToeSecOfDay");
+			geph.tk_hour	= row.getInt	("TofHour");
+			geph.tk_min		= row.getInt	("TofMin");
+			geph.tk_sec		= row.getDouble	("TofSec");
+			
+			geph.iode		= row.getInt	("IODE");
+			
+			geph.taun		= row.getDouble	("TauN");
+			geph.gammaN		= row.getDouble	("GammaN");
+			geph.dtaun		= row.getDouble	("DeltaTauN");
+			
+			geph.pos[0]		= row.getDouble	("PosX");
+			geph.pos[1]		= row.getDouble	("PosY");
+			geph.pos[2]		= row.getDouble	("PosZ");
+			geph.vel[0]		= row.getDouble	("VelX");
+			geph.vel[1]		= row.getDouble	("VelY");
+			geph.vel[2]		= row.getDouble	("VelZ");
+			geph.acc[0]		= row.getDouble	("AccX");
+			geph.acc[1]		= row.getDouble	("AccY");
+			geph.acc[2]		= row.getDouble	("AccZ");
+			
+			geph.frq		= row.getInt	("FrquencyNumber");
+			geph.svh		= (E_Svh) row.getInt("SVHealth");
+			geph.age		= row.getInt	("Age");
+			
+			geph.glonassM	= row.getInt	("GLONASSM");
+			geph.NT			= row.getInt	("NumberOfDayIn4Year");
+			geph.moreData	= row.getInt	("AdditionalData");
+			geph.N4			= row.getInt	("4YearIntervalNumber");
+		}
+		
+		return geph;
+	}
+	
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
@@ -687,6 +1049,73 @@ SSRAtm mongoReadIGSIonosphere(
 {
 	SSRAtm ssrAtm;
 	
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		if (remoteStore_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return ssrAtm;
+		}
+		
+		ssrAtm.ssrMeta = ssrMeta;
+		
+		auto& store = *remoteStore_ptr;
+		
+		SSRAtmGlobal atmGlob;
+		
+		//latest metadata from before the requested time
+		for (auto& row : store.find(SSR_DB, {{SSR_DATA, IGS_ION_META}}, GTime::noTime(), time, 2, true))
+		{
+			if (row.time == time)
+				continue;
+			
+			atmGlob.time			= row.time;
+			atmGlob.numberLayers	= row.getInt	(IGS_ION_NLAY);
+			atmGlob.vtecQuality		= row.getDouble	(IGS_ION_QLTY);
+			for (int i = 0; i < atmGlob.numberLayers; i++)
+			{
+				string hghStr = "Height_" + std::to_string(i);
+				atmGlob.layers[i].height = row.getDouble(hghStr);
+			}
+			
+			break;
+		}
+		
+		auto rowList = store.find(SSR_DB, {{SSR_DATA, IGS_ION_ENTRY}}, atmGlob.time, atmGlob.time);
+		
+		//keep the basis functions in the order they were written
+		std::sort(rowList.begin(), rowList.end(), [](const StoreRow& a, const StoreRow& b)
+		{
+			return a.getInt(SSR_ION_IND) < b.getInt(SSR_ION_IND);
+		});
+		
+		map<int,int> maxBasis;
+		for (auto& row : rowList)
+		{
+			SphComp	sphComp;
+			sphComp.layer			= row.getInt	(IGS_ION_HGT);
+			sphComp.degree			= row.getInt	(IGS_ION_DEG);
+			sphComp.order			= row.getInt	(IGS_ION_ORD);
+			sphComp.trigType		= E_TrigType::_from_integral(row.getInt(IGS_ION_PAR));
+			sphComp.value			= row.getDouble	(IGS_ION_VAL);
+			sphComp.variance		= 0;
+			
+			SSRVTEClayer& laydata	= atmGlob.layers[sphComp.layer];
+			
+			laydata.sphHarmonic[maxBasis[sphComp.layer]] = sphComp;
+			maxBasis[sphComp.layer]++;
+			
+			if (laydata.maxDegree	< sphComp.degree)			laydata.maxDegree	= sphComp.degree;
+			if (laydata.maxOrder	< sphComp.order)			laydata.maxOrder	= sphComp.order;
+		}
+		
+		atmGlob.iod = masterIod;
+		
+		ssrAtm.atmosGlobalMap[atmGlob.time] = atmGlob;
+		
+		return ssrAtm;
+	}
+	
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
@@ -783,6 +1212,43 @@ map<SatSys, map<GTime, Vector6d>> mongoReadOrbits(
 {
 	map<SatSys, map<GTime, Vector6d>> predictedPosMap;
 	
+	auto& config = remote ? acsConfig.remoteMongo : acsConfig.localMongo;
+	
+	if (config.backend == +E_Database::LOCAL_STORE)
+	{
+		TimeSeriesStore* store_ptr;
+		
+		if (remote)	store_ptr = remoteStore_ptr;
+		else		store_ptr = localStore_ptr;
+		
+		if (store_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return predictedPosMap;
+		}
+		
+		map<string, string> keyFilter = {{REMOTE_DATA, REMOTE_ORBIT}};
+		if (Sat.prn)
+			keyFilter[REMOTE_SAT] = Sat.id();
+		
+		for (auto& row : store_ptr->find(REMOTE_DATA_DB, keyFilter, time, time))
+		{
+			Vector6d inertialState = Vector6d::Zero();
+			
+			for (int i = 0; i < 3; i++)
+			{
+				inertialState(i + 0) = row.getDouble(REMOTE_POS + std::to_string(i));
+				inertialState(i + 3) = row.getDouble(REMOTE_VEL + std::to_string(i));
+			}
+			
+			SatSys rowSat(row.getString(REMOTE_SAT).c_str());
+			
+			predictedPosMap[rowSat][row.time] = inertialState;
+		}
+		
+		return predictedPosMap;
+	}
+	
 	Mongo* mongo_ptr;
 	
 	if (remote)	mongo_ptr = remoteMongo_ptr;
@@ -853,6 +1319,40 @@ map<string, map<GTime, tuple<double, double>>> mongoReadClocks(
 {
 	map<string, map<GTime, tuple<double, double>>> predictedClkMap;
 	
+	auto& config = remote ? acsConfig.remoteMongo : acsConfig.localMongo;
+	
+	if (config.backend == +E_Database::LOCAL_STORE)
+	{
+		TimeSeriesStore* store_ptr;
+		
+		if (remote)	store_ptr = remoteStore_ptr;
+		else		store_ptr = localStore_ptr;
+		
+		if (store_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return predictedClkMap;
+		}
+		
+		map<string, string> keyFilter = {{REMOTE_DATA, REMOTE_CLOCK}};
+		if (str.empty() == false)
+			keyFilter[REMOTE_SAT] = str;
+		
+		for (auto& row : store_ptr->find(REMOTE_DATA_DB, keyFilter, time, time))
+		{
+			tuple<double, double> clocks;
+			
+			auto& [clock, drift] = clocks;
+			
+			clock = row.getDouble(REMOTE_CLK);
+			drift = row.getDouble(REMOTE_CLK_DRIFT);
+			
+			predictedClkMap[row.getString(REMOTE_STR)][row.time] = clocks;
+		}
+		
+		return predictedClkMap;
+	}
+	
 	Mongo* mongo_ptr;
 	
 	if (remote)	mongo_ptr = remoteMongo_ptr;
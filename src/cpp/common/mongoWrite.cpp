@@ -258,6 +258,138 @@ void mongoMeasSatStat(
 
 
 
+/** Append the key fields, or the value fields, of an entry to a document
+ */
+void appendEntryFields(
+	document&	doc,
+	DBEntry&	entry,
+	bool		type)
+{
+	for (auto&[k,v]:entry.stringMap)		{auto& [e,b] = v; if (type == b)							doc << k << e;}
+	for (auto&[k,v]:entry.intMap)			{auto& [e,b] = v; if (type == b)							doc << k << e;}
+	for (auto&[k,v]:entry.doubleMap)		{auto& [e,b] = v; if (type == b)							doc << k << e;}
+	for (auto&[k,v]:entry.timeMap)			{auto& [e,b] = v; if (type == b)							doc << k << bDate(e);}
+	for (auto&[k,v]:entry.vectorMap)		{auto& [e,b] = v; if (type == b) for (int i=0;i<3;i++)		doc << k + std::to_string(i) << e[i];}
+	for (auto&[k,v]:entry.doubleArrayMap)	{auto& [e,b] = v; if (type == b) { auto builder = doc << k << open_array; for (auto& a : e) builder << a; builder << close_array; }}
+	for (auto&[k,v]:entry.intArrayMap)		{auto& [e,b] = v; if (type == b) { auto builder = doc << k << open_array; for (auto& a : e) builder << a; builder << close_array; }}
+	for (auto&[k,v]:entry.boolArrayMap)		{auto& [e,b] = v; if (type == b) { auto builder = doc << k << open_array; for (auto& a : e) builder << a; builder << close_array; }}
+}
+
+document entryToDocument(
+	DBEntry&	entry,
+	bool		type)
+{
+	// builder::document builds an empty BSON document
+	document doc = {};
+	
+	appendEntryFields(doc, entry, type);
+	
+	return doc;
+}
+
+
+/** Write documents to a collection of the database selected by a config, returns false if that database is not available.
+ * Documents are inserted into mongo as they are, with the values of the named key fields, and optionally the names of the value fields,
+ * added to the Content collection that lists what is available. The local store upserts them by their key fields
+ */
+bool writeEntries(
+	Mongo*					mongo_ptr,			///< Mongo database, used when the config selects the mongo backend
+	TimeSeriesStore*		store_ptr,			///< Local store, used when the config selects the local store backend
+	MongoOptions&			config,				///< Options of the database
+	const string&			collection,			///< Collection to write to
+	vector<DBEntry>&		dbEntryList,		///< Documents to write
+	const vector<string>&	indexFields,		///< Key fields whose values are listed in the Content collection
+	const string&			valueIndex = "")	///< Name to list the names of value fields under in the Content collection, if any
+{
+	if (config.backend == +E_Database::LOCAL_STORE)
+	{
+		if (store_ptr == nullptr)
+		{
+			return false;
+		}
+		
+		store_ptr->write(collection, dbEntryList);
+		
+		return true;
+	}
+	
+	if (mongo_ptr == nullptr)
+	{
+		return false;
+	}
+	
+	if (dbEntryList.empty())
+	{
+		return true;
+	}
+	
+	Mongo& mongo = *mongo_ptr;
+
+	auto 						c		= mongo.pool.acquire();
+	mongocxx::client&			client	= *c;
+	mongocxx::database			db		= client[config.database];
+
+	mongocxx::options::bulk_write bulk_opts;
+	bulk_opts.ordered(false);
+	
+	auto bulk = db[collection].create_bulk_write(bulk_opts);
+	
+	map<string, map<string, bool>> indexMap;
+	
+	for (auto& entry : dbEntryList)
+	{
+		document doc = {};
+		appendEntryFields(doc, entry, true);
+		appendEntryFields(doc, entry, false);
+		
+		bsoncxx::document::value doc_val = doc << finalize;
+		
+		bulk.append(mongocxx::model::insert_one(doc_val.view()));
+		
+		for (auto& field : indexFields)
+		{
+			auto it = entry.stringMap.find(field);
+			if (it != entry.stringMap.end())
+			{
+				auto& [value, isKey] = it->second;
+				indexMap[field][value] = true;
+			}
+		}
+		
+		if (valueIndex.empty() == false)
+		for (auto& [name, value] : entry.doubleMap)
+		{
+			auto& [num, isKey] = value;
+			if (isKey == false)
+				indexMap[valueIndex][name] = true;
+		}
+	}
+	
+	bulk.execute();
+	
+	mongocxx::options::update	options;
+	options.upsert(true);
+	
+	for (auto& [name, index] : indexMap)
+	{
+		auto eachDoc = document{};
+		
+		auto arrayDoc = eachDoc << "$each" << open_array;
+		for (auto &[indexName, unused]: index)
+		{
+			arrayDoc << indexName;
+		}
+		arrayDoc << close_array;
+		
+		auto findDoc	= document{}									<< "type"	<< name							<< finalize;
+		auto updateDoc	= document{} << "$addToSet" << open_document	<< "Values" << eachDoc << close_document	<< finalize;
+		
+		db["Content"].update_one(findDoc.view(), updateDoc.view(), options);
+	}
+	
+	return true;
+}
+
 void mongoMeasResiduals(
 	GTime				time,
 	KFMeas&				kfMeas,
@@ -267,9 +399,15 @@ void mongoMeasResiduals(
 {
 	Instrument instrument(__FUNCTION__);
 	
+	if (num < 0)
+	{
+		num = kfMeas.obsKeys.size();
+	}
+	
 	for (auto mongo_ptr_ptr : {&localMongo_ptr, &remoteMongo_ptr})
 	{
 		auto& mongo_ptr = *mongo_ptr_ptr;
+		auto& store_ptr = (mongo_ptr_ptr == &localMongo_ptr) ? localStore_ptr : remoteStore_ptr;
 		
 		MongoOptions*	config_ptr;
 		if (mongo_ptr_ptr == &localMongo_ptr)		config_ptr = &acsConfig.localMongo;
@@ -281,158 +419,82 @@ void mongoMeasResiduals(
 		{
 			continue;
 		}
-	
-		if (mongo_ptr == nullptr)
-		{
-			MONGO_NOT_INITIALISED_MESSAGE;
-			
-			config.output_measurements = false;
-			
-			continue;
-		}
-			
-		Mongo& mongo = *mongo_ptr;
-
-		auto 						c		= mongo.pool.acquire();
-		mongocxx::client&			client	= *c;
-		mongocxx::database			db		= client[config.database];
-
-		
-		string collectionName = "Measurements";
 		
-		mongocxx::collection		coll	= db[collectionName];
-
-		mongocxx::options::bulk_write bulk_opts;
-		bulk_opts.ordered(false);
-
-		auto bulk = coll.create_bulk_write(bulk_opts);
-
-		bool update = false;
-
-		if (num < 0)
-		{
-			num = kfMeas.obsKeys.size();
-		}
-
-		map<tuple<string, string>, vector<int>> lookup;
-		
-		map<string, bool> indexSeries;
-		map<string, bool> indexLabel;
-		map<string, bool> indexSite;
-		map<string, bool> indexSat;
+		map<tuple<string, string>, DBEntry> entryMap;
 
 		for (int i = beg; i < beg + num; i++)
 		{
 			KFKey& obsKey = kfMeas.obsKeys[i];
-			
+
+			auto& entry = entryMap[make_tuple(obsKey.str, obsKey.Sat.id())];
+
+			entry.timeMap	["Epoch"]	= {time,					true};
+			entry.stringMap	["Site"]	= {obsKey.str,				true};
+			entry.stringMap	["Sat"]		= {obsKey.Sat.id(),			true};
+			entry.stringMap	["Series"]	= {config.suffix + suffix,	true};
+
 			string commentString = "";
 			if (obsKey.comment.empty() == false)
 				commentString = obsKey.comment + "-";
-			
+
 			string name = commentString + std::to_string(obsKey.num);
-			
-			lookup[make_tuple(obsKey.str, obsKey.Sat.id())].push_back(i);
-		}
 
-		for (auto& [description, index] : lookup)
-		{
-			bsoncxx::builder::stream::document doc{};
-			auto& [site, sat] = description;
-			doc		<< "Epoch"		<< bDate(time)
-					<< "Site"		<< site
-					<< "Sat"		<< sat
-					<< "Series"		<< config.suffix + suffix;
-					
-			indexSeries	[config.suffix + suffix]	= true;
-			indexSite	[site]						= true;
-			indexSat	[sat]						= true;
-			
-			for (int& i : index)
+			entry.doubleMap[name + "-Prefit"]		= {kfMeas.V		(i),	false};
+			entry.doubleMap[name + "-Postfit"]		= {kfMeas.VV	(i),	false};
+			entry.doubleMap[name + "-Variance"]		= {kfMeas.R		(i,i),	false};
+
+			if	( config.output_components == false
+				||kfMeas.componentLists.empty())
 			{
-				KFKey& obsKey = kfMeas.obsKeys[i];
-			
-				string commentString = "";
-				if (obsKey.comment.empty() == false)
-					commentString = obsKey.comment + "-";
-				
-				string name = commentString + std::to_string(obsKey.num);
-				
-				doc << name + "-Prefit"		<<	kfMeas.V	(i)	
-					<< name + "-Postfit"	<<	kfMeas.VV	(i)	
-					<< name + "-Variance"	<<	kfMeas.R	(i,i);
-					
-				indexLabel[name + "-Prefit"]	= true;
-				indexLabel[name + "-Postfit"]	= true;
-				indexLabel[name + "-Variance"]	= true;
-				
-				if	( config.output_components == false
-					||kfMeas.componentLists.empty())
-				{
-					continue;
-				}
-				
-				auto& componentList = kfMeas.componentLists[i];
-				
-				for (auto& component : componentList)
-				{
-					auto& [comp, value, desc, var] = component;
-				
-					string label = name + " " + KF::_from_integral_unchecked(obsKey.type)._to_string() + " " + comp._to_string();
-					
-					doc << label << value;
-					
-					indexLabel[label] = true;
-				}
+				continue;
+			}
+
+			for (auto& [comp, value, desc, var] : kfMeas.componentLists[i])
+			{
+				string label = name + " " + KF::_from_integral_unchecked(obsKey.type)._to_string() + " " + comp._to_string();
+
+				entry.doubleMap[label] = {value, false};
 			}
-			
-			bsoncxx::document::value doc_val = doc << finalize;
-			
-			bulk.append(mongocxx::model::insert_one(doc_val.view()));
-			
-			update = true;
 		}
 
-		if (update)
+		vector<DBEntry> dbEntryList;
+		for (auto& [description, entry] : entryMap)
 		{
-			bulk.execute();
+			dbEntryList.push_back(std::move(entry));
+		}
 
-			auto addIndices = [&](string name, map<string, bool> index)
-			{
-				mongocxx::options::update	options;
-				options.upsert(true);
-				
-				auto eachDoc = document{};
-				
-				auto arrayDoc = eachDoc << "$each" << open_array;
-				for (auto &[indexName, unused]: index)
-				{
-					arrayDoc << indexName;
-				}
-				arrayDoc << close_array;
-				
-				auto findDoc	= document{}									<< "type"	<< name							<< finalize;
-				auto updateDoc	= document{} << "$addToSet" << open_document	<< "Values" << eachDoc << close_document	<< finalize;
-				
-				db["Content"].update_one(findDoc.view(), updateDoc.view(), options);
-			};
+		bool written = writeEntries(mongo_ptr, store_ptr, config, "Measurements", dbEntryList, {"Series", "Site", "Sat"}, "Measurements");
+		if (written == false)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
 			
-			addIndices("Measurements",	indexLabel);
-			addIndices("Series",		indexSeries);
-			addIndices("Site",			indexSite);
-			addIndices("Sat",			indexSat);
+			config.output_measurements = false;
 		}
 	}
 }
 
 void mongoStates(
-	KFState&			kfState,
+	const KFState&		kfState,
 	string				suffix)
 {
 	Instrument instrument(__FUNCTION__);
 	
+	map<tuple<string, string, string>, vector<pair<int, int>>> lookup;
+
+	for (auto& [key, index] : kfState.kfIndexMap)
+	{
+		if (key.type == KF::ONE)
+		{
+			continue;
+		}
+
+		lookup[make_tuple(key.str, key.Sat.id(), KF::_from_integral_unchecked(key.type)._to_string())].push_back(make_pair(index, key.num));
+	}
+	
 	for (auto mongo_ptr_ptr : {&localMongo_ptr, &remoteMongo_ptr})
 	{
 		auto& mongo_ptr = *mongo_ptr_ptr;
+		auto& store_ptr = (mongo_ptr_ptr == &localMongo_ptr) ? localStore_ptr : remoteStore_ptr;
 		
 		MongoOptions*	config_ptr;
 		if (mongo_ptr_ptr == &localMongo_ptr)		config_ptr = &acsConfig.localMongo;
@@ -445,104 +507,46 @@ void mongoStates(
 			continue;
 		}
 		
-		if (mongo_ptr == nullptr)
-		{
-			MONGO_NOT_INITIALISED_MESSAGE;
-			
-			config.output_states = false;
-			
-			return;
-		}
-		
-		Instrument instrument(__FUNCTION__);
-		
-		Mongo& mongo = *mongo_ptr;
+		vector<DBEntry> dbEntryList;
 
-		auto 						c		= mongo.pool.acquire();
-		mongocxx::client&			client	= *c;
-		mongocxx::database			db		= client[config.database];
+		for (auto& [description, index] : lookup)
+		{
+			auto& [site, sat, state] = description;
 
-		mongocxx::options::update	options;
-		options.upsert(true);
-		
-		mongocxx::options::bulk_write bulk_opts;
-		bulk_opts.ordered(false);
-		
-		auto bulk = db["States"].create_bulk_write(bulk_opts);
+			DBEntry entry;
+			entry.timeMap	["Epoch"]	= {kfState.time,			true};
+			entry.stringMap	["Site"]	= {site,					true};
+			entry.stringMap	["Sat"]		= {sat,						true};
+			entry.stringMap	["State"]	= {state,					true};
+			entry.stringMap	["Series"]	= {config.suffix + suffix,	true};
 
-		map<tuple<string, string, string>, vector<pair<int, int>>> lookup;
-		map<string, bool> indexSeries;
-		map<string, bool> indexState;
-		map<string, bool> indexSite;
-		map<string, bool> indexSat;
+			vector<double>	x;
+			vector<double>	dx;
+			vector<double>	P;
+			vector<int>		Num;
 
-		for (auto& [key, index] : kfState.kfIndexMap)
-		{
-			if (key.type == KF::ONE)
+			for (auto& [i, num] : index)
 			{
-				continue;
+				x	.push_back(kfState.x	(i));
+				dx	.push_back(kfState.dx	(i));
+				P	.push_back(kfState.P	(i,i));
+				Num	.push_back(num);
 			}
-			
-			lookup[make_tuple(key.str, key.Sat.id(), KF::_from_integral_unchecked(key.type)._to_string())].push_back(make_pair(index, key.num));
-		}
 
-		vector<bsoncxx::document::value> documents;
+			entry.doubleArrayMap["x"]	= {x,	false};
+			entry.doubleArrayMap["dx"]	= {dx,	false};
+			entry.doubleArrayMap["P"]	= {P,	false};
+			entry.intArrayMap	["Num"]	= {Num,	false};
 
-		bool update = false;
-		
-		for (auto &[description, index] : lookup)
-		{
-			auto &[site, sat, state] = description;
-
-			bsoncxx::builder::stream::document doc{};
-			doc		<< "Epoch"		<< bDate(kfState.time)
-					<< "Site"		<< site
-					<< "Sat"		<< sat
-					<< "State"		<< state
-					<< "Series"		<< config.suffix + suffix;
-
-			indexSeries	[config.suffix + suffix]	= true;
-			indexState	[state]						= true;
-			indexSat	[sat]						= true;
-			indexSite	[site]						= true;
-
-			auto	array_builder = doc << "x"		<< open_array;	for (auto &[i, num]: index)		array_builder << kfState.x	(i);	array_builder << close_array;
-					array_builder = doc << "dx"		<< open_array;	for (auto &[i, num]: index)		array_builder << kfState.dx	(i);	array_builder << close_array;
-					array_builder = doc << "P"		<< open_array;	for (auto &[i, num]: index)		array_builder << kfState.P	(i,i);	array_builder << close_array;
-					array_builder = doc << "Num"	<< open_array;	for (auto &[i, num]: index)		array_builder << num;				array_builder << close_array;
-			
-			bsoncxx::document::value doc_val = doc << finalize;
-			
-			bulk.append(mongocxx::model::insert_one(doc_val.view()));	
-			
-			update = true;
+			dbEntryList.push_back(std::move(entry));
 		}
-		
-		if (update)
-		{
-			bulk.execute();
 
-			auto addIndices = [&](string name, map<string, bool> index)
-			{
-				auto eachDoc = document{};
-				
-				auto arrayDoc = eachDoc << "$each" << open_array;
-				for (auto &[indexStr, unused]: index)
-				{
-					arrayDoc << indexStr;
-				}
-				arrayDoc << close_array;
-				
-				auto findDoc	= document{}									<< "type"	<< name							<< finalize;
-				auto updateDoc	= document{} << "$addToSet" << open_document	<< "Values" << eachDoc << close_document	<< finalize;
-				
-				db["Content"].update_one(findDoc.view(), updateDoc.view(), options);
-			};
+		bool written = writeEntries(mongo_ptr, store_ptr, config, "States", dbEntryList, {"Series", "State", "Site", "Sat"});
+		if (written == false)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
 			
-			addIndices("Series",indexSeries);
-			addIndices("State",	indexState);
-			addIndices("Site",	indexSite);
-			addIndices("Sat",	indexSat);
+			config.output_states = false;
 		}
 	}
 }
@@ -566,6 +570,24 @@ void mongoCull(
 			continue;
 		}
 		
+		if (config.backend == +E_Database::LOCAL_STORE)
+		{
+			auto& store_ptr = (mongo_ptr_ptr == &localMongo_ptr) ? localStore_ptr : remoteStore_ptr;
+
+			if (store_ptr == nullptr)
+			{
+				MONGO_NOT_INITIALISED_MESSAGE;
+				return;
+			}
+
+			for (auto collection: {SSR_DB, REMOTE_DATA_DB})
+			{
+				store_ptr->cull(collection, time - config.min_cull_age);
+			}
+
+			continue;
+		}
+
 		if (mongo_ptr == nullptr)
 		{
 			MONGO_NOT_INITIALISED_MESSAGE;
@@ -598,30 +620,29 @@ void mongoCull(
 	}
 }
 
-document entryToDocument(
-	DBEntry&	entry,
-	bool		type)
-{
-	// builder::document builds an empty BSON document
-	document doc = {};
-	
-	for (auto&[k,v]:entry.stringMap)		{auto& [e,b] = v; if (type == b)							doc << k << e;}
-	for (auto&[k,v]:entry.intMap)			{auto& [e,b] = v; if (type == b)							doc << k << e;}
-	for (auto&[k,v]:entry.doubleMap)		{auto& [e,b] = v; if (type == b)							doc << k << e;}
-	for (auto&[k,v]:entry.timeMap)			{auto& [e,b] = v; if (type == b)							doc << k << b_date{std::chrono::system_clock::from_time_t((time_t)((PTime)e).bigTime)};}
-	for (auto&[k,v]:entry.vectorMap)		{auto& [e,b] = v; if (type == b) for (int i=0;i<3;i++)		doc << k + std::to_string(i) << e[i];}
-	for (auto&[k,v]:entry.doubleArrayMap)	{auto& [e,b] = v; if (type == b) { auto builder = doc << k << open_array; for (auto& a : e) builder << a; builder << close_array; }}
-	for (auto&[k,v]:entry.boolArrayMap)		{auto& [e,b] = v; if (type == b) { auto builder = doc << k << open_array; for (auto& a : e) builder << a; builder << close_array; }}
-	
-	return doc;
-}
-
-
 void mongoOutput(
 	vector<DBEntry>&	dbEntryList,
 	MongoOptions&		config,
 	string				collection)
 {	
+	if (config.backend == +E_Database::LOCAL_STORE)
+	{
+		TimeSeriesStore* store_ptr;
+
+		if (&config == &acsConfig.localMongo)		store_ptr = localStore_ptr;
+		else										store_ptr = remoteStore_ptr;
+
+		if (store_ptr == nullptr)
+		{
+			MONGO_NOT_INITIALISED_MESSAGE;
+			return;
+		}
+
+		store_ptr->write(collection, dbEntryList);
+
+		return;
+	}
+
 	Mongo* mongo_ptr;
 	
 	if (config.local)		mongo_ptr = localMongo_ptr;
@@ -679,7 +700,7 @@ void mongoOutput(
 */
 void	prepareSsrStates(
 	Trace&				trace,			///< Trace to output to
-	KFState&			kfState,		///< Filter object to extract state elements from
+	const KFState&		kfState,		///< Filter object to extract state elements from
 	GTime 				time)			///< Time of current epoch
 {
 	if	( acsConfig.localMongo.	output_ssr_precursors == false
@@ -1093,11 +1114,139 @@ void	outputMongoPredictions(
 	mongoOutput(dbEntryList, config, REMOTE_DATA_DB);
 }
 
+/** Collect the fields of a GPS/GAL/BDS/QZS ephemeris for the local store, named as in mongo and keyed by satellite, type and toe
+*/
+DBEntry brdcEphEntry(
+	Eph&		eph)	///< Ephemeris to collect the fields of
+{
+	DBEntry entry;
+	entry.stringMap	["Sat"]				= {eph.Sat.id(),			true};
+	entry.stringMap	["Type"]			= {eph.type._to_string(),	true};
+	entry.timeMap	["ToeGPST"]			= {eph.toe,					true};
+	entry.timeMap	["TocGPST"]			= {eph.toc,					false};
+
+	entry.intMap	["WeekDecoded"]		= {eph.weekRollOver,		false};
+	entry.intMap	["WeekAdjusted"]	= {eph.week,				false};
+	entry.doubleMap	["ToeSecOfWeek"]	= {eph.toes,				false};
+	entry.doubleMap	["TocSecOfWeek"]	= {eph.tocs,				false};
+
+	entry.intMap	["AODE"]			= {eph.aode,				false};
+	entry.intMap	["AODC"]			= {eph.aodc,				false};
+	entry.intMap	["IODE"]			= {eph.iode,				false};
+	entry.intMap	["IODC"]			= {eph.iodc,				false};
+
+	entry.doubleMap	["f0"]				= {eph.f0,					false};
+	entry.doubleMap	["f1"]				= {eph.f1,					false};
+	entry.doubleMap	["f2"]				= {eph.f2,					false};
+
+	entry.doubleMap	["SqrtA"]			= {eph.sqrtA,				false};
+	entry.doubleMap	["A"]				= {eph.A,					false};
+	entry.doubleMap	["e"]				= {eph.e,					false};
+	entry.doubleMap	["i0"]				= {eph.i0,					false};
+	entry.doubleMap	["iDot"]			= {eph.idot,				false};
+	entry.doubleMap	["omg"]				= {eph.omg,					false};
+	entry.doubleMap	["OMG0"]			= {eph.OMG0,				false};
+	entry.doubleMap	["OMGDot"]			= {eph.OMGd,				false};
+	entry.doubleMap	["M0"]				= {eph.M0,					false};
+	entry.doubleMap	["DeltaN"]			= {eph.deln,				false};
+	entry.doubleMap	["Crc"]				= {eph.crc,					false};
+	entry.doubleMap	["Crs"]				= {eph.crs,					false};
+	entry.doubleMap	["Cic"]				= {eph.cic,					false};
+	entry.doubleMap	["Cis"]				= {eph.cis,					false};
+	entry.doubleMap	["Cuc"]				= {eph.cuc,					false};
+	entry.doubleMap	["Cus"]				= {eph.cus,					false};
+
+	entry.doubleMap	["TGD0"]			= {eph.tgd[0],				false};
+	entry.doubleMap	["TGD1"]			= {eph.tgd[1],				false};
+	entry.intMap	["URAIndex"]		= {eph.sva,					false};
+	entry.intMap	["SVHealth"]		= {(int) eph.svh,			false};
+
+	if	( eph.Sat.sys == +E_Sys::GPS
+		||eph.Sat.sys == +E_Sys::QZS)
+	{
+		entry.doubleMap	["URA"]				= {eph.ura[0],		false};
+		entry.intMap	["CodeOnL2"]		= {eph.code,		false};
+		entry.intMap	["L2PDataFlag"]		= {eph.flag,		false};
+		entry.intMap	["FitFlag"]			= {eph.fitFlag,		false};
+		entry.doubleMap	["FitInterval"]		= {eph.fit,			false};
+	}
+	else if (eph.Sat.sys == +E_Sys::GAL)
+	{
+		entry.doubleMap	["SISA"]			= {eph.ura[0],		false};
+		entry.intMap	["E5aHealth"]		= {eph.e5a_hs,		false};
+		entry.intMap	["E5aDataValidity"]	= {eph.e5a_dvs,		false};
+		entry.intMap	["E5bHealth"]		= {eph.e5b_hs,		false};
+		entry.intMap	["E5bDataValidity"]	= {eph.e5b_dvs,		false};
+		entry.intMap	["E1Health"]		= {eph.e1_hs,		false};
+		entry.intMap	["E1DataValidity"]	= {eph.e1_dvs,		false};
+		entry.intMap	["DataSource"]		= {eph.code,		false};
+	}
+	else if (eph.Sat.sys == +E_Sys::BDS)
+	{
+		entry.doubleMap	["URA"]				= {eph.ura[0],		false};
+	}
+
+	return entry;
+}
+
+/** Collect the fields of a GLO ephemeris for the local store, named as in mongo and keyed by satellite, type and toe
+*/
+DBEntry brdcEphEntry(
+	Geph&		geph)	///< Ephemeris to collect the fields of
+{
+	DBEntry entry;
+	entry.stringMap	["Sat"]					= {geph.Sat.id(),			true};
+	entry.stringMap	["Type"]				= {geph.type._to_string(),	true};
+	entry.timeMap	["ToeGPST"]				= {geph.toe,				true};
+	entry.timeMap	["TofGPST"]				= {geph.tof,				false};
+
+	entry.intMap	["ToeSecOfDay"]			= {geph.tb,					false};
+	entry.intMap	["TofHour"]				= {geph.tk_hour,			false};
+	entry.intMap	["TofMin"]				= {geph.tk_min,				false};
+	entry.doubleMap	["TofSec"]				= {geph.tk_sec,				false};
+
+	entry.intMap	["IODE"]				= {geph.iode,				false};
+
+	entry.doubleMap	["TauN"]				= {geph.taun,				false};
+	entry.doubleMap	["GammaN"]				= {geph.gammaN,				false};
+	entry.doubleMap	["DeltaTauN"]			= {geph.dtaun,				false};
+
+	entry.doubleMap	["PosX"]				= {geph.pos[0],				false};
+	entry.doubleMap	["PosY"]				= {geph.pos[1],				false};
+	entry.doubleMap	["PosZ"]				= {geph.pos[2],				false};
+	entry.doubleMap	["VelX"]				= {geph.vel[0],				false};
+	entry.doubleMap	["VelY"]				= {geph.vel[1],				false};
+	entry.doubleMap	["VelZ"]				= {geph.vel[2],				false};
+	entry.doubleMap	["AccX"]				= {geph.acc[0],				false};
+	entry.doubleMap	["AccY"]				= {geph.acc[1],				false};
+	entry.doubleMap	["AccZ"]				= {geph.acc[2],				false};
+
+	entry.intMap	["FrquencyNumber"]		= {geph.frq,				false};
+	entry.intMap	["SVHealth"]			= {(int) geph.svh,			false};
+	entry.intMap	["Age"]					= {geph.age,				false};
+
+	entry.intMap	["GLONASSM"]			= {geph.glonassM,			false};
+	entry.intMap	["NumberOfDayIn4Year"]	= {geph.NT,					false};
+	entry.intMap	["AdditionalData"]		= {geph.moreData,			false};
+	entry.intMap	["4YearIntervalNumber"]	= {geph.N4,					false};
+
+	return entry;
+}
+
 /** Write GPS/GAL/BDS/QZS ephemeris to Mongo DB
 */
 void	mongoBrdcEph(
 	Eph&		eph)	///< GPS/GAL/BDS/QZS ephemeris to write
 {
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		vector<DBEntry> dbEntryList = {brdcEphEntry(eph)};
+
+		mongoOutput(dbEntryList, acsConfig.remoteMongo, "Ephemeris");
+
+		return;
+	}
+
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
@@ -1163,6 +1312,15 @@ void	mongoBrdcEph(
 void	mongoBrdcEph(
 	Geph&		geph)	///< GLO ephemeris to write
 {
+	if (acsConfig.remoteMongo.backend == +E_Database::LOCAL_STORE)
+	{
+		vector<DBEntry> dbEntryList = {brdcEphEntry(geph)};
+
+		mongoOutput(dbEntryList, acsConfig.remoteMongo, "Ephemeris");
+
+		return;
+	}
+
 	auto& mongo_ptr = remoteMongo_ptr;
 	
 	if (mongo_ptr == nullptr)
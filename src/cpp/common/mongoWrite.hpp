@@ -36,7 +36,7 @@ void mongoOutputConfig(
 	string& config);
 
 void mongoStates(
-	KFState&			kfState,
+	const KFState&		kfState,
 	string				suffix = "");
 
 void mongoMeasSatStat(
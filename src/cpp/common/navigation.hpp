@@ -63,6 +63,7 @@ struct SatNav
 	BrdcEph*			eph_ptr			= nullptr;
 	
 	MatrixXd			satPartialMat;				///< Partial derivative matrices for orbits
+	GTime				satPartialTime	= {};		///< Time that the partial derivative matrices were computed for
 
 	AttStatus			attStatus		= {};		///< Persistent data for attitude model
 	
@@ -82,6 +83,8 @@ struct Navigation
 	map<string,							map<GTime, Pclk>> 														pclkMap;	///< precise clock
 	map<string,							map<GTime, Att>>													 	attMapMap;	///< attitudes
 	
+	long int	pephMapVersion	= 0;	///< Incremented when precise ephemerides are modified, to invalidate interpolation caches
+	
 	map<string,												map<GTime, AzElMapData<Vector3d>,	std::greater<GTime>>>	dragMap;
 	map<string,												map<GTime, AzElMapData<Vector3d>,	std::greater<GTime>>>	reflectorMap;
 	map<string, 	map<E_Sys,			map<E_FType, 		map<GTime, PhaseCenterOffset,		std::greater<GTime>>>>>	pcoMap;
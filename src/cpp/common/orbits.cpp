@@ -4,7 +4,9 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>    
+#include <sstream>
 #include <chrono>
+#include <mutex>
 #include <string>
 #include <ctime>
 #include <cmath>
@@ -492,6 +494,67 @@ int orbPartials(
 	return 1;
 }
 
+/** Update the orbit partials of all estimated satellites for an epoch.
+* The partials are shared by all stations, so they are computed once for each time, (in parallel across satellites).
+* Must be called before stations are processed, not from within the parallel station loops that read the partials
+*/
+void updateOrbitPartials(
+	Trace&		trace,		///< Trace to output to
+	GTime		time)		///< Time to compute partials for
+{
+	static mutex orbitPartialsMutex;
+	
+	lock_guard<mutex> guard(orbitPartialsMutex);
+	
+	vector<pair<SatSys, SatNav*>> updateList;
+	
+	for (auto& [Sat, satNav] : nav.satNavMap)
+	{
+		if (acsConfig.process_sys[Sat.sys] == false)
+		{
+			continue;
+		}
+		
+		if (satNav.satPartialTime == time)
+		{
+			continue;
+		}
+		
+		auto& satOpts = acsConfig.getSatOpts(Sat);
+		
+		InitialState init = initialStateFromConfig(satOpts.orb);
+		
+		if (init.estimate == false)
+		{
+			continue;
+		}
+		
+		updateList.push_back({Sat, &satNav});
+	}
+	
+	vector<std::ostringstream> traceList(updateList.size());
+	
+#	ifdef ENABLE_PARALLELISATION
+#	ifndef ENABLE_UNIT_TESTS
+		Eigen::setNbThreads(1);
+#		pragma omp parallel for
+#	endif
+#	endif
+	for (int i = 0; i < updateList.size(); i++)
+	{
+		auto& [Sat, satNav_ptr] = updateList[i];
+		
+		orbPartials(traceList[i], time, Sat, satNav_ptr->satPartialMat);
+		
+		satNav_ptr->satPartialTime = time;
+	}
+	Eigen::setNbThreads(0);
+	
+	for (auto& satTrace : traceList)
+	{
+		trace << satTrace.str();
+	}
+}
 
 
 
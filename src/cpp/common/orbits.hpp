@@ -47,6 +47,10 @@ int orbPartials(
 	SatSys		Sat,
 	MatrixXd&	interpPartials);
 
+void updateOrbitPartials(
+	Trace&		trace,
+	GTime		time);
+
 int readorbit(
 	string		file);
 
@@ -76,7 +76,7 @@ void outputRinexClocksBody(
 void getKalmanSatClks(
 	ClockList&			clkValList,
 	map<E_Sys, bool>&	outSys,
-	KFState&			kfState)
+	const KFState&		kfState)
 {
 	for (auto& [key,index] : kfState.kfIndexMap)
 	{
@@ -104,8 +104,8 @@ void getKalmanSatClks(
 
 void getKalmanRecClks(
 	ClockList&	clkValList,
-	ClockEntry&	referenceRec,
-	KFState& 	kfState)
+	ClockEntry&		referenceRec,
+	const KFState&	kfState)
 {
 	SatSys firstSys;
 	for (auto& [key, index] : kfState.kfIndexMap)
@@ -371,7 +371,7 @@ void outputClocksSet(
 	vector<E_Source>	clkDataSatSrcs,
 	GTime&				time,
 	map<E_Sys, bool>&	outSys,
-	KFState&			kfState,
+	const KFState&		kfState,
 	StationMap*			stationMap_ptr)
 {
 	ClockList  clkValList;
@@ -457,7 +457,7 @@ void outputClocks(
 	vector<E_Source>	clkDataRecSrcs,
 	vector<E_Source>	clkDataSatSrcs,
 	GTime&				time,
-	KFState&			kfState,
+	const KFState&		kfState,
 	StationMap*			stationMap_ptr)
 {
 	auto filenameSysMap = getSysOutputFilenames(filename, time);
@@ -22,5 +22,5 @@ void outputClocks(
 	vector<E_Source>	clkDataRecSrcs,
 	vector<E_Source>	clkDataSatSrcs,
 	GTime&				time,
-	KFState&			kfState,
+	const KFState&		kfState,
 	StationMap*			stationMap_ptr = nullptr);
@@ -1596,11 +1596,22 @@ unsigned int getbitu(
 	int						pos,	///< bit position from start of data (bits)
 	int						len)	///< bit length (bits) (len<=32)
 {
-	unsigned int bits = 0;
-	for (int i = pos; i < pos+len; i++)
-		bits = (bits<<1) + ((buff[i/8]>>(7-i%8))&1u);
+	if (len <= 0)
+		return 0;
+	
+	//gather only the bytes spanned by the field into a 64 bit word, then shift it into place
+	const unsigned char* byte_ptr = buff + pos / 8;
+	
+	int startBit = pos % 8;
+	int numBytes = (startBit + len + 7) / 8;
+	
+	uint64_t word = 0;
+	for (int i = 0; i < numBytes; i++)
+		word = (word << 8) | byte_ptr[i];
+	
+	word >>= numBytes * 8 - startBit - len;
 	
-	return bits;
+	return (unsigned int) (word & ((1ull << len) - 1));
 }
 
 /** extract unsigned bits from RTCM messages
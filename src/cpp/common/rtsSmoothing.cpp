@@ -20,12 +20,14 @@ using std::map;
 #include "acsConfig.hpp"
 #include "testUtils.hpp"
 #include "constants.hpp"
+#include "instrument.hpp"
 #include "ionoModel.hpp"
 #include "sp3Write.cpp"
 #include "metaData.hpp"
 #include "algebra.hpp"
 #include "sinex.hpp"
 #include "cost.hpp"
+#include "trace.hpp"
 #include "ppp.hpp"
 #include "gpx.hpp"
 
@@ -53,7 +55,7 @@ void postRTSActions(
 	}
 	
 	{
-		std::ofstream ofs(kfState.metaDataMap[TRACE_FILENAME_STR + SMOOTHED_SUFFIX], std::ofstream::out | std::ofstream::app);
+		TraceStream ofs(kfState.metaDataMap[TRACE_FILENAME_STR + SMOOTHED_SUFFIX]);
 		kfState.outputStates(ofs, "/RTS");
 	}
 	
@@ -71,10 +73,13 @@ void postRTSActions(
 		&&( acsConfig.clocks_receiver_sources.front()	== +E_Source::KALMAN
 		  ||acsConfig.clocks_satellite_sources.front()	== +E_Source::KALMAN))
 	{
-		auto kfState2 = kfState;	//todo aaron, delete this after fixing something else, tryPrepareFilterPointers damages the state
-		tryPrepareFilterPointers(kfState2, stationMap_ptr);
+		//tryPrepareFilterPointers only replaces the key table, keep a copy of that to restore rather than copying the whole state
+		KFIndexMap kfIndexMap = kfState.kfIndexMap;
+		tryPrepareFilterPointers(kfState, stationMap_ptr);
 
-		outputClocks			(kfState.metaDataMap[CLK_FILENAME_STR			+ SMOOTHED_SUFFIX], acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, kfState2.time, kfState2, stationMap_ptr);
+		outputClocks			(kfState.metaDataMap[CLK_FILENAME_STR			+ SMOOTHED_SUFFIX], acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, kfState.time, kfState, stationMap_ptr);
+		
+		kfState.kfIndexMap = std::move(kfIndexMap);
 	}
 	
 	if (acsConfig.output_orbex)
@@ -127,6 +132,67 @@ void postRTSActions(
 // 	pppoutstat(ofs, archiveKF, true);
 }
 
+/** Walks backwards through the objects of a filter archive.
+ * Objects may be kept in an in-memory record buffer, a compact indexed archive, or a plain archive file.
+ * For buffers and compact archives the position is the index of the record, otherwise it is the offset in the file.
+*/
+struct ReverseArchiveReader
+{
+	string					filename;
+	SerialRecordBuffer*		buffer_ptr;
+	FilterArchiveReader*	archive_ptr	= nullptr;
+	long int				startPos	= -1;
+	
+	ReverseArchiveReader(
+		string	filename)
+	:	filename	{filename},
+		buffer_ptr	{getSerialRecordBuffer(filename)}
+	{
+		if (buffer_ptr == nullptr)
+		{
+			archive_ptr = getFilterArchiveReader(filename);
+		}
+		
+		if		(buffer_ptr)	startPos = buffer_ptr->records.size();
+		else if	(archive_ptr)	startPos = archive_ptr->index.size();
+	}
+	
+	E_SerialObject getType()
+	{
+		if	( buffer_ptr	== nullptr
+			&&archive_ptr	== nullptr)
+		{
+			return getFilterTypeFromFile(startPos, filename);
+		}
+		
+		while (startPos > 0)
+		{
+			startPos--;
+			
+			int type;
+			if (buffer_ptr)		type = buffer_ptr->records	[startPos].first;
+			else				type = archive_ptr->index	[startPos].type;
+			
+			if (type != E_SerialObject::KEY_TABLE)
+			{
+				return E_SerialObject::_from_integral(type);
+			}
+		}
+		
+		return E_SerialObject::NONE;
+	}
+	
+	template<class TYPE>
+	bool getObject(
+		E_SerialObject	type,
+		TYPE&			object)
+	{
+		if		(buffer_ptr)		return getFilterObjectFromRecord	(type, object, buffer_ptr->records[startPos]);
+		else if	(archive_ptr)		return getFilterObjectFromArchive	(type, object, startPos, *archive_ptr);
+		else						return getFilterObjectFromFile		(type, object, startPos, filename);
+	}
+};
+
 /** Output filter states from a reversed binary trace file
 */
 void RTS_Output(
@@ -135,7 +201,7 @@ void RTS_Output(
 {
 	string reversedStatesFilename = kfState.rts_basename + BACKWARD_SUFFIX;
 	
-	long int startPos = -1;
+	ReverseArchiveReader reader(reversedStatesFilename);
 	
 	BOOST_LOG_TRIVIAL(info) 
 	<< "Outputting RTS products...";
@@ -144,10 +210,10 @@ void RTS_Output(
 	
 	while (1)
 	{
-		E_SerialObject type = getFilterTypeFromFile(startPos, reversedStatesFilename);
+		E_SerialObject type = reader.getType();
 
 		BOOST_LOG_TRIVIAL(debug) 
-		<< "Outputting " << type._to_string() << " from file position " << startPos << std::endl;
+		<< "Outputting " << type._to_string() << " from file position " << reader.startPos << std::endl;
 		
 		switch (type)
 		{
@@ -159,7 +225,7 @@ void RTS_Output(
 			
 			case E_SerialObject::METADATA:
 			{
-				bool pass = getFilterObjectFromFile(type, metaDataMap, startPos, reversedStatesFilename);
+				bool pass = reader.getObject(type, metaDataMap);
 				if (pass == false)
 				{
 					BOOST_LOG_TRIVIAL(error) << "BAD RTS OUTPUT read";
@@ -172,7 +238,7 @@ void RTS_Output(
 			case E_SerialObject::MEASUREMENT:
 			{
 				KFMeas archiveMeas;
-				bool pass = getFilterObjectFromFile(type, archiveMeas, startPos, reversedStatesFilename);
+				bool pass = reader.getObject(type, archiveMeas);
 				if (pass == false)
 				{
 					BOOST_LOG_TRIVIAL(error) << "BAD RTS OUTPUT read";
@@ -180,13 +246,14 @@ void RTS_Output(
 				}
 				
 				string filename = kfState.metaDataMap[TRACE_FILENAME_STR + SMOOTHED_SUFFIX];
-				std::ofstream ofs(filename, std::ofstream::out | std::ofstream::app);
-				if (!ofs)
+				if (filename.empty())
 				{
 					BOOST_LOG_TRIVIAL(error) << "BAD RTS Write to " << filename;
 					break;
 				}
 				
+				TraceStream ofs(filename);
+				
 				if (acsConfig.output_residuals)
 				{
 					outputResiduals(ofs, archiveMeas, -1, "/RTS", 0, archiveMeas.obsKeys.size());
@@ -200,7 +267,7 @@ void RTS_Output(
 			case E_SerialObject::FILTER_SMOOTHED:
 			{
 				KFState archiveKF;
-				bool pass = getFilterObjectFromFile(type, archiveKF, startPos, reversedStatesFilename);
+				bool pass = reader.getObject(type, archiveKF);
 				
 				if (pass == false)
 				{
@@ -212,14 +279,18 @@ void RTS_Output(
 				
 				if (acsConfig.ambrOpts.mode != +E_ARmode::OFF)
 				{
-					std::ofstream rtsTrace(archiveKF.metaDataMap[TRACE_FILENAME_STR + SMOOTHED_SUFFIX], std::ofstream::out | std::ofstream::app);
-					PPP_AR(rtsTrace,archiveKF);
+					TraceStream rtsTrace(archiveKF.metaDataMap[TRACE_FILENAME_STR + SMOOTHED_SUFFIX]);
+					
+					//the archived state isnt used again, move it into the snapshot rather than copying it
+					KFStateSnapshot archiveSnapshot(std::move(archiveKF));
+					PPP_AR(rtsTrace, archiveSnapshot);
 					
-					KFState ARRTScopy;
+					//postRTSActions temporarily replaces the key table, so it needs its own copy if the state is shared
+					KFStateSnapshot ARRTScopy;
 					if (copyFixedKF(ARRTScopy))
-						postRTSActions(true, ARRTScopy, stationMap_ptr);
+						postRTSActions(true, ARRTScopy		.edit(), stationMap_ptr);
 					else
-						postRTSActions(true, archiveKF, stationMap_ptr);
+						postRTSActions(true, archiveSnapshot	.edit(), stationMap_ptr);
 				}
 				else
 				{
@@ -230,11 +301,11 @@ void RTS_Output(
 			}
 		}
 
-		if (startPos == 0)
+		if (reader.startPos == 0)
 		{
 			return;
 		}
-		if (startPos < 0)
+		if (reader.startPos < 0)
 		{
 			BOOST_LOG_TRIVIAL(error) 
 			<< "Oopsie " << std::endl;
@@ -249,6 +320,8 @@ KFState RTS_Process(
 	bool		write,
 	StationMap*	stationMap_ptr)
 {
+	Instrument	instrument(__FUNCTION__);
+	
 	if (kfState.rts_lag == 0)
 	{
 		return KFState();
@@ -272,15 +345,18 @@ KFState RTS_Process(
 
 	if (write)
 	{
+		resetFilterArchive(outputFile);
+		
 		std::ofstream ofs(outputFile,	std::ofstream::out | std::ofstream::trunc);
 	}
 
-	long int startPos = -1;
 	double lag = 0;
 	
+	ReverseArchiveReader reader(inputFile);
+	
 	while (lag != kfState.rts_lag)
 	{
-		E_SerialObject type = getFilterTypeFromFile(startPos, inputFile);
+		E_SerialObject type = reader.getType();
 
 		BOOST_LOG_TRIVIAL(debug) << "Found " << type._to_string() << std::endl;
 		
@@ -298,7 +374,7 @@ KFState RTS_Process(
 			}
 			case E_SerialObject::METADATA:
 			{
-				bool pass = getFilterObjectFromFile(type, smoothedKF.metaDataMap, startPos, inputFile);
+				bool pass = reader.getObject(type, smoothedKF.metaDataMap);
 				if (pass == false)
 				{
 					BOOST_LOG_TRIVIAL(debug) << "CREASS" << std::endl;
@@ -314,7 +390,7 @@ KFState RTS_Process(
 			}
 			case E_SerialObject::MEASUREMENT:
 			{
-				bool pass = getFilterObjectFromFile(type, measurements, startPos, inputFile);
+				bool pass = reader.getObject(type, measurements);
 				if (pass == false)
 				{
 					return KFState();
@@ -325,7 +401,7 @@ KFState RTS_Process(
 			case E_SerialObject::TRANSITION_MATRIX:
 			{
 				TransitionMatrixObject transistionMatrixObject;
-				bool pass = getFilterObjectFromFile(type, transistionMatrixObject, startPos, inputFile);
+				bool pass = reader.getObject(type, transistionMatrixObject);
 				if (pass == false)
 				{
 					return KFState();
@@ -347,7 +423,7 @@ KFState RTS_Process(
 			}
 			case E_SerialObject::FILTER_MINUS:
 			{
-				bool pass = getFilterObjectFromFile(type, kalmanMinus, startPos, inputFile);
+				bool pass = reader.getObject(type, kalmanMinus);
 				if (pass == false)
 				{
 					return KFState();
@@ -365,7 +441,7 @@ KFState RTS_Process(
 			case E_SerialObject::FILTER_PLUS:
 			{
 				KFState kalmanPlus;
-				bool pass = getFilterObjectFromFile(type, kalmanPlus, startPos, inputFile);
+				bool pass = reader.getObject(type, kalmanPlus);
 				if (pass == false)
 				{
 					return KFState();
@@ -543,7 +619,7 @@ KFState RTS_Process(
 			}
 		}
 
-		if (startPos == 0)
+		if (reader.startPos == 0)
 		{
 			break;
 		}
@@ -554,7 +630,21 @@ KFState RTS_Process(
 		RTS_Output(kfState, stationMap_ptr);
 	}
 
-	if (lag == kfState.rts_lag)
+	if	( lag == kfState.rts_lag
+		&&reader.buffer_ptr)
+	{
+		//drop the records that are older than the lag window
+		auto& records = reader.buffer_ptr->records;
+		
+		records.erase(records.begin(), records.begin() + reader.startPos);
+	}
+	else if ( lag == kfState.rts_lag
+			&&reader.archive_ptr)
+	{
+		//drop the records that are older than the lag window
+		trimFilterArchive(inputFile, reader.startPos);
+	}
+	else if (lag == kfState.rts_lag)
 	{
 		//delete the beginning of the history file
 		string tempFile	= kfState.rts_basename + FORWARD_SUFFIX + "_temp";
@@ -565,12 +655,12 @@ KFState RTS_Process(
 			inputStream.seekg(0,	inputStream.end);
 			long int lengthPos = inputStream.tellg();
 
-			vector<char>	fileContents(lengthPos - startPos);
+			vector<char>	fileContents(lengthPos - reader.startPos);
 
-			inputStream.seekg(startPos,	inputStream.beg);
+			inputStream.seekg(reader.startPos,	inputStream.beg);
 
-			inputStream.read(&fileContents[0], lengthPos - startPos);
-			tempStream.write(&fileContents[0], lengthPos - startPos);
+			inputStream.read(&fileContents[0], lengthPos - reader.startPos);
+			tempStream.write(&fileContents[0], lengthPos - reader.startPos);
 		}
 
 		std::remove(inputFile.c_str());
@@ -589,6 +679,12 @@ KFState RTS_Process(
 		<< "Removing RTS file: " << outputFile;
 		
 		std::remove(outputFile.c_str());
+		
+		std::remove((inputFile	+ INDEX_SUFFIX).c_str());
+		std::remove((outputFile	+ INDEX_SUFFIX).c_str());
+		
+		resetFilterArchive(inputFile);
+		resetFilterArchive(outputFile);
 	}
 
 	if (lag == kfState.rts_lag)
@@ -4,6 +4,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <unordered_map>
+#include <algorithm>
 #include <cstring>
 #include <map>
 #include <sys/utsname.h>
@@ -68,7 +70,7 @@ void trimCut(
 /** seconds diff bewteen left and right
  * If left < right the value is negative
  */
-long int time_compare(UYds& left, UYds& right)			//todo aaron, delete this
+long int time_compare(const UYds& left, const UYds& right)			//todo aaron, delete this
 {
 	long int leftfull	= (left[0]	* 365 + left[1])	* 86400 + left[2];
 	long int rightfull	= (right[0] * 365 + right[1])	* 86400 + right[2];
@@ -422,18 +424,151 @@ bool compare(Sinex_solmatrix_t& one, 	Sinex_solmatrix_t& two)
 	return false;
 }
 
+/** Accumulate the hash of a value into a seed
+ */
+template<typename TYPE>
+void hashCombine(
+	size_t&			seed,
+	const TYPE&		value)
+{
+	seed ^= std::hash<TYPE>{}(value) + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+}
+
+void hashCombine(
+	size_t&			seed,
+	const UYds&		yds)
+{
+	for (auto& value : yds)
+	{
+		hashCombine(seed, value);
+	}
+}
+
+/** Hashes of the identities used by compare() to find duplicate records.
+ * Only fields that compare() tests for equality are hashed, so that duplicates always share a hash
+ */
+size_t dedupeHash(string& entry)
+{
+	return std::hash<string>{}(entry);
+}
+
+size_t dedupeHash(Sinex_input_history_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.code);
+	hashCombine(seed, entry.fmt);
+	hashCombine(seed, entry.create_time);
+	hashCombine(seed, entry.start);
+	hashCombine(seed, entry.stop[0]);
+	hashCombine(seed, entry.stop[2]);
+	hashCombine(seed, entry.obs_tech);
+	hashCombine(seed, entry.num_estimates);
+	hashCombine(seed, entry.constraint);
+	hashCombine(seed, entry.contents);
+	hashCombine(seed, entry.data_agency);
+	hashCombine(seed, entry.create_agency);
+	return seed;
+}
+
+size_t dedupeHash(Sinex_input_file_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.yds);
+	hashCombine(seed, entry.agency);
+	hashCombine(seed, entry.file);
+	hashCombine(seed, entry.description);
+	return seed;
+}
+
+size_t dedupeHash(Sinex_ack_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.agency);
+	hashCombine(seed, entry.description);
+	return seed;
+}
+
+size_t dedupeHash(Sinex_nutcode_t&		entry)	{	return std::hash<string>{}(entry.nutcode);		}
+size_t dedupeHash(Sinex_precode_t&		entry)	{	return std::hash<string>{}(entry.precesscode);	}
+size_t dedupeHash(Sinex_source_id_t&	entry)	{	return std::hash<string>{}(entry.source);		}
+size_t dedupeHash(Sinex_solstatistic_t&	entry)	{	return std::hash<string>{}(entry.name);			}
+
+size_t dedupeHash(Sinex_satid_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.svn);
+	hashCombine(seed, entry.prn);
+	hashCombine(seed, entry.timeSinceLaunch);
+	hashCombine(seed, entry.timeUntilDecom);
+	return seed;
+}
+
+size_t dedupeHash(Sinex_satprn_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.svn);
+	hashCombine(seed, entry.prn);
+	hashCombine(seed, entry.start);
+	return seed;
+}
+
+size_t dedupeHash(Sinex_satfreqchn_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.svn);
+	hashCombine(seed, entry.start);
+	hashCombine(seed, entry.stop);
+	return seed;
+}
+
+size_t dedupeHash(Sinex_satcom_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.svn);
+	hashCombine(seed, entry.start);
+	hashCombine(seed, entry.stop);
+	return seed;
+}
+
+size_t dedupeHash(Sinex_satecc_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.svn);
+	hashCombine(seed, entry.type);
+	return seed;
+}
+
+size_t dedupeHash(Sinex_satpc_t& entry)
+{
+	size_t seed = 0;
+	hashCombine(seed, entry.svn);
+	hashCombine(seed, entry.freq);
+	hashCombine(seed, entry.freq2);
+	return seed;
+}
+
+/** Remove duplicate records, keeping the first of each in their original order.
+ * Records are indexed by the hash of their identity, so that each is only compared against the few kept records that share its hash
+ */
 template<typename TYPE>
-void dedupe(list<TYPE>& source)
+void dedupe(vector<TYPE>& source)
 {
-	list<TYPE> copy;
+	std::unordered_multimap<size_t, int> keptMap;
+	keptMap.reserve(source.size());
 
-	for (auto it = source.begin(); it != source.end();   )
+	int kept = 0;
+	for (int i = 0; i < source.size(); i++)
 	{
+		auto& entry = source[i];
+
+		size_t hash = dedupeHash(entry);
+
 		bool found = false;
 
-		for (auto it2 = copy.begin(); it2 != copy.end(); it2++)
+		auto [begin, end] = keptMap.equal_range(hash);
+		for (auto it = begin; it != end; it++)
 		{
-			if (compare(*it, *it2))
+			if (compare(entry, source[it->second]))
 			{
 				found = true;
 				break;
@@ -442,45 +577,44 @@ void dedupe(list<TYPE>& source)
 
 		if (found)
 		{
-			it = source.erase(it);
+			continue;
 		}
-		else
+
+		if (kept != i)
 		{
-			copy.push_back(*it);
-			it++;
+			source[kept] = std::move(entry);
 		}
+
+		keptMap.insert({hash, kept});
+		kept++;
 	}
+
+	source.resize(kept);
 }
 
+/** Remove consecutive duplicate records from a sorted block
+ */
 template<typename TYPE>
-void dedupeB(list<TYPE>& source)
+void dedupeB(vector<TYPE>& source)
 {
-	TYPE previous;
-	bool first = true;
-
-	for (auto it = source.begin(); it != source.end();   )
+	int kept = 0;
+	for (int i = 0; i < source.size(); i++)
 	{
-		bool found = false;
-
-		if (!first)
+		if	(  kept > 0
+			&& compare(source[i], source[kept - 1]))
 		{
-			if (compare(*it, previous))
-			{
-				found = true;
-			}
+			continue;
 		}
 
-		if (found)
-		{
-			it = source.erase(it);
-		}
-		else
+		if (kept != i)
 		{
-			previous = *it;
-			it++;
-			first = false;
+			source[kept] = std::move(source[i]);
 		}
+
+		kept++;
 	}
+
+	source.resize(kept);
 }
 
 // each of the lists is parsed for duplicates. When a dup is found it is erased. At the end of each loop the _copy list should contain the same stuff
@@ -514,26 +648,15 @@ void dedupe_sinex()
 	dedupeB(theSinex.list_solepochs);
 	dedupeB(theSinex.list_normal_eqns);
 
-	for (matrix_type	t = ESTIMATE;		t < MAX_MATRIX_TYPE;	t = static_cast<matrix_type>	(static_cast<int>(t) + 1))
-	for (matrix_value	v = CORRELATION;	v < MAX_MATRIX_VALUE;	v = static_cast<matrix_value>	(static_cast<int>(v) + 1))
-	{
-		if (theSinex.matrix_map[t][v].empty())
-			continue;
-
-		dedupeB(theSinex.matrix_map[t][v]);
-	}
+	//matrix blocks are stored packed, where duplicated elements simply overwrite each other
 
 	return;
 }
 
 // TODO; What if we are reading a second file. What wins?
-int read_snx_header(std::ifstream& in)
+int read_snx_header(string& s)
 {
-	string s;
-
-	std::getline(in, s);
-
-	if (in.eof())
+	if (s.size() < 5)
 	{
 		BOOST_LOG_TRIVIAL(error) << "Error: empty file" << endl;
 		return 1;
@@ -1275,7 +1398,7 @@ void write_snx_antennas(ofstream& out)
 }
 
 // compare by antenna type and serial number.
-bool compare_gps_pc(Sinex_gps_phase_center_t& left, Sinex_gps_phase_center_t& right)
+bool compare_gps_pc(const Sinex_gps_phase_center_t& left, const Sinex_gps_phase_center_t& right)
 {
 	int comp = left.antname.compare(right.antname);
 
@@ -1381,7 +1504,7 @@ void write_snx_gps_pcs(ofstream& out, list<SinexRecData>* pstns)
 }
 
 // compare by antenna type and serial number. return true0 if left < right
-bool compare_gal_pc(Sinex_gal_phase_center_t& left, Sinex_gal_phase_center_t& right)
+bool compare_gal_pc(const Sinex_gal_phase_center_t& left, const Sinex_gal_phase_center_t& right)
 {
 	int comp = left.antname.compare(right.antname);
 
@@ -1630,7 +1753,7 @@ void write_snx_site_eccs(ofstream& out)
 	}
 }
 
-bool compare_site_epochs(Sinex_solepoch_t& left, Sinex_solepoch_t& right)
+bool compare_site_epochs(const Sinex_solepoch_t& left, const Sinex_solepoch_t& right)
 {
 	int comp = left.sitecode.compare(right.sitecode);
 	int i = 0;
@@ -1833,7 +1956,13 @@ void parse_snx_solutionEstimates(string& s)
 
 		if (theSinex.primary)		theSinex.map_estimates_primary	[sst.sitecode][sst.type][sst.refepoch] = sst;
 		else						theSinex.map_estimates			[sst.sitecode][sst.type][sst.refepoch] = sst;
-		
+
+		//matrices refer to parameters by their index in this file, give each parameter a single index across all files
+		string paramId = s.substr(7, 32);
+
+		auto [it, inserted] = theSinex.paramIndexMap.insert({paramId, (int) theSinex.paramIndexMap.size() + 1});
+
+		theSinex.fileParamIndexMap[sst.index] = it->second;
 	}
 }
 
@@ -2146,45 +2275,248 @@ int compare_matrix_entries(Sinex_solmatrix_t& left, Sinex_solmatrix_t& right)
 	return (comp < 0);
 }
 
-matrix_type		mat_type;
-matrix_value	mat_value;
+/** Read an integer from a fixed format line in place, returns false if there is none before the end of the line
+ */
+bool snxReadInt(
+	const char*&	pos,	///< Position to read from, advanced past the value
+	const char*		eol,	///< End of the line
+	int&			value)	///< Value output
+{
+	char* next;
+	long int result = strtol(pos, &next, 10);
+
+	if	(  next == pos
+		|| next >  eol)
+	{
+		return false;
+	}
 
-void parse_snx_matrix(string& s)//, matrix_type type, matrix_value value)
+	value	= result;
+	pos		= next;
+	return true;
+}
+
+/** Read a floating point value from a fixed format line in place, returns false if there is none before the end of the line
+ */
+bool snxReadDouble(
+	const char*&	pos,	///< Position to read from, advanced past the value
+	const char*		eol,	///< End of the line
+	double&			value)	///< Value output
+{
+	char* next;
+	double result = strtod(pos, &next);
+
+	if	(  next == pos
+		|| next >  eol)
+	{
+		return false;
+	}
+
+	value	= result;
+	pos		= next;
+	return true;
+}
+
+/** Parse a line of a SOLUTION/MATRIX block without copying it, returns false if it contains no values
+ */
+bool parseSnxMatrixLine(
+	const char*				pos,	///< Start of the line
+	const char*				eol,	///< End of the line
+	Sinex_solmatrix_t&		smt)	///< Matrix entries output
+{
+	smt.numvals = 0;
+
+	bool pass	=  snxReadInt(pos, eol, smt.row)
+				&& snxReadInt(pos, eol, smt.col);
+
+	if (pass == false)
+	{
+		return false;
+	}
+
+	while	(  smt.numvals < 3
+			&& snxReadDouble(pos, eol, smt.value[smt.numvals]))
+	{
+		smt.numvals++;
+	}
+
+	return smt.numvals > 0;
+}
+
+/** Set an element of the matrix, and its symmetric counterpart
+ */
+void SinexMatrix::set(
+	int		row,	///< Row of the element (from 1)
+	int		col,	///< Column of the element (from 1)
+	double	value)	///< Value to set
 {
-// 	//todo aaron, this is only half complete, the maxrow/col arent used but should be with multiple input matrices.
-	int		maxrow = 0;
-	int		maxcol = 0;
-	Sinex_solmatrix_t smt;
+	if (row < col)
+	{
+		std::swap(row, col);
+	}
 
-	int readcount = sscanf(s.c_str(), " %5d %5d %21lf %21lf %21lf",
-						&smt.row,
-						&smt.col,
-						&smt.value[0],
-						&smt.value[1],
-						&smt.value[2]);
+	if (row > dim)
+	{
+		//packed lower triangles share their layout regardless of size, so existing elements stay in place
+		dim = row;
+		packed.resize((long int) dim * (dim + 1) / 2, 0);
+	}
 
-	if (readcount > 2)
+	packed[(long int) (row - 1) * row / 2 + (col - 1)] = value;
+}
+
+/** Get an element of the matrix, elements that were never set are zero
+ */
+double SinexMatrix::operator()(
+	int		row,	///< Row of the element (from 1)
+	int		col)	///< Column of the element (from 1)
+	const
+{
+	if (row < col)
 	{
-		if (smt.row < smt.col)
+		std::swap(row, col);
+	}
+
+	if	(  row > dim
+		|| col < 1)
+	{
+		return 0;
+	}
+
+	return packed[(long int) (row - 1) * row / 2 + (col - 1)];
+}
+
+/** Expand the matrix to a full dense symmetric matrix, with parameter n of the file at row and column n - 1
+ */
+MatrixXd SinexMatrix::toDense()
+	const
+{
+	MatrixXd dense = MatrixXd::Zero(dim, dim);
+
+	long int k = 0;
+	for (int i = 0; i < dim; i++)
+	for (int j = 0; j <= i; j++, k++)
+	{
+		dense(i, j) = packed[k];
+		dense(j, i) = packed[k];
+	}
+
+	return dense;
+}
+
+/** Parse the body of a SOLUTION/MATRIX block without copying its lines.
+ * Lines are located serially and then parsed in parallel.
+ * Returns the position of the block's closing line
+ */
+const char* parseSnxMatrixBlock(
+	const char*					pos,		///< Start of the first line of the block body
+	const char*					end,		///< End of the file buffer
+	vector<Sinex_solmatrix_t>&	entryList)	///< Matrix entries output, with row and column as indices of this file's parameters
+{
+	vector<const char*> lineList;
+	vector<const char*> eolList;
+
+	while (pos < end)
+	{
+		if (*pos == '-')
 		{
-			//xor swap
-			smt.row ^= smt.col;
-			smt.col ^= smt.row;
-			smt.row ^= smt.col;
+			break;
+		}
+
+		auto eol = (const char*) memchr(pos, '\n', end - pos);
+		if (eol == nullptr)
+		{
+			eol = end;
 		}
-		
-		int covars = readcount - 2;
-		
-		for (int i = readcount - 2; i < 3; i++)
-			smt.value[i] = -1;
 
-		smt.numvals = readcount - 2;
+		if (*pos == ' ')
+		{
+			lineList.push_back(pos);
+			eolList	.push_back(eol);
+		}
 
-		if (smt.row > maxrow)		maxrow = smt.row;
-		if (smt.col > maxcol)		maxcol = smt.col;
+		pos = eol + 1;
+	}
 
-		theSinex.matrix_map[mat_type][mat_value].push_back(smt);
+	vector<Sinex_solmatrix_t>	lineEntryList(lineList.size());
+	vector<char>				passList(lineList.size());
+
+#	ifdef ENABLE_PARALLELISATION
+#	ifndef ENABLE_UNIT_TESTS
+#		pragma omp parallel for
+#	endif
+#	endif
+	for (int i = 0; i < lineList.size(); i++)
+	{
+		passList[i] = parseSnxMatrixLine(lineList[i], eolList[i], lineEntryList[i]);
 	}
+
+	for (int i = 0; i < lineEntryList.size(); i++)
+	{
+		if (passList[i])
+		{
+			entryList.push_back(lineEntryList[i]);
+		}
+	}
+
+	return std::min(pos, end);
+}
+
+/** Scatter the entries of a matrix block into its packed matrix.
+ * The matrix keeps the file's own parameter numbering, along with the index across all files of each parameter, so that files with different parameter sets may be combined by their users.
+ * Returns the number of elements whose parameters are not in the file's SOLUTION/ESTIMATE block, which are skipped
+ */
+int scatterSnxMatrix(
+	const vector<Sinex_solmatrix_t>&	entryList,		///< Entries of the block, indexed by the file's parameters
+	const map<int, int>&				indexMap,		///< Index across all files of each of the file's parameters
+	SinexMatrix&						matrix)			///< Matrix to fill
+{
+	//size the matrix once, rather than for each new parameter - packed lower triangles share their layout regardless of size
+	int maxRow = matrix.dim;
+	if (indexMap.empty() == false)
+	{
+		maxRow = std::max(maxRow, indexMap.rbegin()->first);
+	}
+
+	matrix.dim = maxRow;
+	matrix.packed			.resize((long int) maxRow * (maxRow + 1) / 2,	0);
+	matrix.paramIndexList	.resize(maxRow,									0);
+
+	for (auto& [index, paramIndex] : indexMap)
+	{
+		if (index >= 1)
+		{
+			matrix.paramIndexList[index - 1] = paramIndex;
+		}
+	}
+
+	auto hasEstimate = [&](int index)
+	{
+		return	( index >= 1
+				&&index <= matrix.dim
+				&&matrix.paramIndexList[index - 1] != 0);
+	};
+
+	int missing = 0;
+
+	for (auto& smt : entryList)
+	{
+		for (int k = 0; k < smt.numvals; k++)
+		{
+			int col = smt.col + k;
+
+			if	(  hasEstimate(smt.row)	== false
+				|| hasEstimate(col)		== false)
+			{
+				missing++;
+				continue;
+			}
+
+			matrix.set(smt.row, col, smt.value[k]);
+		}
+	}
+
+	return missing;
 }
 
 void parseSinexEstimates(
@@ -2394,7 +2726,7 @@ void write_snx_sourceids(ofstream& out)
 	}
 }
 
-bool compare_satids(Sinex_satid_t& left, Sinex_satid_t& right)
+bool compare_satids(const Sinex_satid_t& left, const Sinex_satid_t& right)
 {
 	char	constleft	= left.svn[0];
 	char    constright	= right.svn[0];
@@ -2504,7 +2836,7 @@ void write_snx_satidents(ofstream& out)
 }
 
 // NB this DOES not compare by PRN!!
-bool compare_satprns(Sinex_satprn_t& left, Sinex_satprn_t& right)
+bool compare_satprns(const Sinex_satprn_t& left, const Sinex_satprn_t& right)
 {
 	char	constleft	= left.svn[0];
 	char    constright	= right.svn[0];
@@ -2570,7 +2902,7 @@ void write_snx_satprns(ofstream& out)
 	}
 }
 
-bool compare_freq_channels(Sinex_satfreqchn_t& left, Sinex_satfreqchn_t& right)
+bool compare_freq_channels(const Sinex_satfreqchn_t& left, const Sinex_satfreqchn_t& right)
 {
 	// start by comparing SVN...
 	char	constleft	= left	.svn[0];
@@ -2709,7 +3041,7 @@ void write_snx_satmass(ofstream& out)
 	}
 }
 
-bool compare_satcom(Sinex_satcom_t& left, Sinex_satcom_t& right)
+bool compare_satcom(const Sinex_satcom_t& left, const Sinex_satcom_t& right)
 {
 	// start by comparing SVN...
 	char	constleft		= left.svn[0];
@@ -2783,7 +3115,7 @@ void write_snx_satcom(ofstream& out)
 	}
 }
 
-bool compare_satecc(Sinex_satecc_t& left, Sinex_satecc_t& right)
+bool compare_satecc(const Sinex_satecc_t& left, const Sinex_satecc_t& right)
 {
 	// start by comparing SVN...
 	char	constleft	= left.svn[0];
@@ -2918,7 +3250,7 @@ void write_snx_satpower(ofstream& out)
 	}
 }
 
-bool compare_satpc(Sinex_satpc_t& left, Sinex_satpc_t& right)
+bool compare_satpc(const Sinex_satpc_t& left, const Sinex_satpc_t& right)
 {
 	// start by comparing SVN...
 	char	constleft	= left.svn[0];
@@ -3064,24 +3396,134 @@ void nullFunction(string& s)
 	
 }
 
+/** Read the whole of a file into memory, returns false if it cannot be opened or read completely
+ */
+bool loadSinexFile(
+	const string&	filepath,	///< Path of the file to load
+	string&			buffer)		///< Contents of the file output
+{
+	buffer.clear();
+
+	ifstream filestream(filepath, std::ios::binary);
+	if (!filestream)
+	{
+		return false;
+	}
+
+	filestream.seekg(0, std::ios::end);
+	long int size = filestream.tellg();
+	filestream.seekg(0, std::ios::beg);
+
+	if	(  size < 0
+		|| !filestream)
+	{
+		return false;
+	}
+
+	buffer.resize(size);
+	filestream.read(&buffer[0], buffer.size());
+
+	if (filestream.gcount() != size)
+	{
+		buffer.clear();
+
+		return false;
+	}
+
+	return true;
+}
+
+/** Load sinex files into memory concurrently, so that they may then be read in order by readSinex().
+ * All of the files are held in memory at once, so callers with many files should load them a few at a time
+ */
+vector<string> loadSinexFiles(
+	const vector<string>&	filepaths,		///< Paths of the files to load
+	vector<char>&			loadedList)		///< Output of whether each file was read completely
+{
+	vector<string> bufferList(filepaths.size());
+
+	loadedList.assign(filepaths.size(), false);
+
+#	ifdef ENABLE_PARALLELISATION
+#	ifndef ENABLE_UNIT_TESTS
+#		pragma omp parallel for
+#	endif
+#	endif
+	for (int i = 0; i < filepaths.size(); i++)
+	{
+		loadedList[i] = loadSinexFile(filepaths[i], bufferList[i]);
+	}
+
+	return bufferList;
+}
+
+/** Read a sinex file, from a buffer already loaded by loadSinexFiles() if given.
+ * Lines are scanned from the in-memory buffer and passed to the parse_snx_* function of their block,
+ * except for SOLUTION/MATRIX blocks, which are tokenised in place and go straight into their packed matrices
+ */
 int readSinex(
-	string filepath, 
-	bool primary)
+	string	filepath,
+	bool	primary,
+	string*	buffer_ptr)
 {
 	theSinex.primary = primary;
+
+	theSinex.fileParamIndexMap.clear();
 	
 // 	BOOST_LOG_TRIVIAL(info)
 // 	<< "reading " << filepath << std::endl;
 
-	ifstream filestream(filepath);
-	if (!filestream)
+	string fileBuffer;
+	if (buffer_ptr == nullptr)
 	{
-		BOOST_LOG_TRIVIAL(error)
-		<< "Error opening sinex file" << filepath << endl;
-		return 1;
+		bool pass = loadSinexFile(filepath, fileBuffer);
+		if (pass == false)
+		{
+			BOOST_LOG_TRIVIAL(error)
+			<< "Error reading sinex file " << filepath << endl;
+			return 1;
+		}
+
+		buffer_ptr = &fileBuffer;
 	}
 
-	int failure = read_snx_header(filestream);
+	const char* pos = buffer_ptr->data();
+	const char* end = buffer_ptr->data() + buffer_ptr->size();
+
+	//lines are copied into the same string each time, so that it is only allocated once
+	string line;
+
+	//matrix blocks are kept until the whole file is read, as they can only be scattered once the parameters they refer to are known
+	vector<std::pair<SinexMatrix*, vector<Sinex_solmatrix_t>>> fileMatrixList;
+
+	auto getLine = [&]() -> bool
+	{
+		if (pos >= end)
+		{
+			return false;
+		}
+
+		auto eol = (const char*) memchr(pos, '\n', end - pos);
+		if (eol == nullptr)
+		{
+			eol = end;
+		}
+
+		line.assign(pos, eol);
+		if	(  line.empty() == false
+			&& line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		pos = eol + 1;
+
+		return true;
+	};
+
+	getLine();
+
+	int failure = read_snx_header(line);
 	if (failure)
 	{
 		BOOST_LOG_TRIVIAL(error)
@@ -3094,14 +3536,12 @@ int readSinex(
 	
 	string			closure = "";
 	
-	while (filestream)
+	while (true)
 	{
-		string line;
-		
-		getline(filestream, line);
+		bool found = getLine();
 
 		// test below empty line (ie continue if something on the line)
-		if	(!filestream)
+		if	(found == false)
 		{
 			// error - did not find closure line. Report and clean up.
 			BOOST_LOG_TRIVIAL(error)
@@ -3162,9 +3602,6 @@ int readSinex(
 			else if	(line == "+SOLUTION/ESTIMATE"				)	{ parseFunction = parse_snx_solutionEstimates;		}
 			else if	(line == "+SOLUTION/APRIORI"				)	{ parseFunction = parse_snx_apriori;				}
 			else if	(line == "+SOLUTION/NORMAL_EQUATION_VECTOR"	)	{ parseFunction = parse_snx_normals;				}
-			else if	(line == "+SOLUTION/MATRIX_ESTIMATE"		)	{ parseFunction = parse_snx_matrix;					}
-			else if	(line == "+SOLUTION/MATRIX_APRIORI"			)	{ parseFunction = parse_snx_matrix;					}
-			else if	(line == "+SOLUTION/NORMAL_EQUATION_MATRIX"	)	{ parseFunction = parse_snx_matrix;					}
 			else if	(line == "+SOLUTION/DATA_HANDLING"			)	{ parseFunction = parse_snx_dataHandling;			}
 			else if	(line == "+SATELLITE/IDENTIFIER"			)	{ parseFunction = parse_snx_satelliteIdentifiers;	}
 			else if	(line == "+SATELLITE/PRN"					)	{ parseFunction = parse_snx_satprns;				}
@@ -3177,6 +3614,44 @@ int readSinex(
 			else if	(line == "+SATELLITE/ID"					)	{ parseFunction = parse_snx_satelliteIds;			}
 			else if	(line == "+SATELLITE/YAW_BIAS_RATE"			)	{ parseFunction = parseSinexSatYawRates;			}
 			else if	(line == "+SATELLITE/ATTITUDE_MODE"			)	{ parseFunction = parseSinexSatAttMode;				}
+			else if	( line == "+SOLUTION/MATRIX_ESTIMATE"
+					||line == "+SOLUTION/MATRIX_APRIORI"
+					||line == "+SOLUTION/NORMAL_EQUATION_MATRIX")
+			{
+				//matrices have millions of lines, they skip the line by line parsing and go straight into their packed storage
+				matrix_type		type	= ESTIMATE;
+				matrix_value	value	= INFORMATION;
+
+				if		(line == "+SOLUTION/MATRIX_APRIORI")			type = APRIORI;
+				else if	(line == "+SOLUTION/NORMAL_EQUATION_MATRIX")	type = NORMAL_EQN;
+
+				//header continues with the triangle given, and the type of values, eg "+SOLUTION/MATRIX_ESTIMATE L COVA"
+				char	triangle	= 'L';
+				string	valueType	= "INFO";
+				if (closure.size() > line.size() + 1)		triangle	= closure[line.size() + 1];
+				if (closure.size() > line.size() + 3)		valueType	= closure.substr(line.size() + 3, 4);
+
+				if		(valueType == "CORR")	value = CORRELATION;
+				else if	(valueType == "COVA")	value = COVARIANCE;
+				else if	(valueType == "INFO")	value = INFORMATION;
+
+				//each file has its own matrix, replacing any from a previous read of the same file, but combining repeated blocks within it
+				auto& matrix = theSinex.matrix_map[type][value][filepath];
+
+				bool repeated = std::any_of(fileMatrixList.begin(), fileMatrixList.end(), [&](auto& fileMatrix) { return fileMatrix.first == &matrix; });
+				if (repeated == false)
+				{
+					matrix = SinexMatrix();
+				}
+
+				matrix.triangle = triangle;
+
+				fileMatrixList.push_back({&matrix, {}});
+
+				pos = parseSnxMatrixBlock(pos, end, fileMatrixList.back().second);
+
+				parseFunction = nullFunction;
+			}
 			else
 			{
 				BOOST_LOG_TRIVIAL(error)
@@ -3269,19 +3744,31 @@ int readSinex(
 			break;
 	}
 
-	theSinex.list_satpcs.		sort(compare_satpc);
-	theSinex.list_sateccs.		sort(compare_satecc);
-	theSinex.list_solepochs.	sort(compare_site_epochs);
-	theSinex.list_sitedata.		sort(compare_sitedata);
-	theSinex.list_gps_pcs.		sort(compare_gps_pc);
-	theSinex.list_satids.		sort(compare_satids);
-	theSinex.list_satfreqchns.	sort(compare_freq_channels);
-	theSinex.list_satprns.		sort(compare_satprns);
-	theSinex.list_satcoms.		sort(compare_satcom);
-	theSinex.list_gal_pcs.		sort(compare_gal_pc);
+	std::stable_sort(theSinex.list_satpcs		.begin(),	theSinex.list_satpcs		.end(),	compare_satpc);
+	std::stable_sort(theSinex.list_sateccs		.begin(),	theSinex.list_sateccs		.end(),	compare_satecc);
+	std::stable_sort(theSinex.list_solepochs	.begin(),	theSinex.list_solepochs		.end(),	compare_site_epochs);
+	std::stable_sort(theSinex.list_sitedata		.begin(),	theSinex.list_sitedata		.end(),	compare_sitedata);
+	std::stable_sort(theSinex.list_gps_pcs		.begin(),	theSinex.list_gps_pcs		.end(),	compare_gps_pc);
+	std::stable_sort(theSinex.list_satids		.begin(),	theSinex.list_satids		.end(),	compare_satids);
+	std::stable_sort(theSinex.list_satfreqchns	.begin(),	theSinex.list_satfreqchns	.end(),	compare_freq_channels);
+	std::stable_sort(theSinex.list_satprns		.begin(),	theSinex.list_satprns		.end(),	compare_satprns);
+	std::stable_sort(theSinex.list_satcoms		.begin(),	theSinex.list_satcoms		.end(),	compare_satcom);
+	std::stable_sort(theSinex.list_gal_pcs		.begin(),	theSinex.list_gal_pcs		.end(),	compare_gal_pc);
 	
+	for (auto& [matrix_ptr, entryList] : fileMatrixList)
+	{
+		int missing = scatterSnxMatrix(entryList, theSinex.fileParamIndexMap, *matrix_ptr);
+		if (missing)
+		{
+			BOOST_LOG_TRIVIAL(warning)
+			<< "Warning: " << missing << " matrix elements in " << filepath << " refer to parameters without estimates, skipping them";
+		}
+	}
+
 // 	theSinex.matrix_map[type][value].sort(compare_matrix_entries);
 	dedupe_sinex();
+	
+	indexSinexSatellites();
 
 	return failure;
 }
@@ -3718,39 +4205,97 @@ GetSnxResult getStnSnx(
 	return result;
 }
 
+/** Build the time indexes of the satellite blocks, must be called whenever the blocks are modified
+ */
+void indexSinexSatellites()
+{
+	auto& index = theSinex.satIndex;
+
+	index = SinexSatIndex();
+
+	//where entries share a start time, prn assignments keep the first and other blocks keep the last, as when they were searched in order
+	for (auto& entry : theSinex.list_satprns)		index.prnMap	[entry.prn].emplace(entry.start, &entry);
+	for (auto& entry : theSinex.list_satfreqchns)	index.freqChnMap[entry.svn][entry.start] = &entry;
+	for (auto& entry : theSinex.list_satcoms)		index.comMap	[entry.svn][entry.start] = &entry;
+
+	for (auto& [svn, massMap]	: theSinex.map_satmasses)	for (auto& [start, entry] : massMap)		index.massMap	[svn][start] = &entry;
+	for (auto& [svn, powerMap]	: theSinex.map_satpowers)	for (auto& [start, entry] : powerMap)		index.powerMap	[svn][start] = &entry;
+
+	for (auto& entry : theSinex.list_sateccs)
+	{
+		switch (entry.type)
+		{
+			case 'P':	{	index.eccMap[entry.svn][E_EccType::P_ANT] = &entry;		break;		}
+			case 'L':	{	index.eccMap[entry.svn][E_EccType::L_LRA] = &entry;		break;		}
+			default:
+			{
+				BOOST_LOG_TRIVIAL(error) << "Unknown satellite eccentricity type";
+				break;
+			}
+		}
+	}
+}
+
+/** Find the entry of a time-indexed block that is in effect at a time, or nullptr if there is none
+ */
+template<typename TYPE>
+TYPE* findSnxSatInterval(
+	map<string, map<GTime, TYPE*, std::greater<GTime>>>&	intervalMap,	///< Index of block entries by id, then start time
+	const string&											id,				///< Id (PRN or SVN) of the satellite
+	GTime													time)			///< Time the entry must be in effect
+{
+	auto it = intervalMap.find(id);
+	if (it == intervalMap.end())
+	{
+		return nullptr;
+	}
+
+	auto& [dummy, timeMap] = *it;
+
+	auto it2 = timeMap.lower_bound(time);
+	if (it2 == timeMap.end())
+	{
+		return nullptr;
+	}
+
+	auto& [start, entry_ptr] = *it2;
+
+	//a zero stop time means the entry is still in effect
+	GTime stopTime = entry_ptr->stop;
+
+	if	( entry_ptr->stop[0] != 0
+		&&(time - stopTime).to_double() > 0)
+	{
+		return nullptr;
+	}
+
+	return entry_ptr;
+}
+
 GetSnxResult getSatSnx(
 	string			prn,
 	GTime			time, 
 	SinexSatSnx&	satSnx)
 {
-	bool found = false;
-
 	GetSnxResult result;
 
 	satSnx = SinexSatSnx();
 	satSnx.start = time;
 
-	// search satprns for prn and svn (not time dependent)
-	for (auto& satPrn : theSinex.list_satprns)
-	{
-		GTime startTime	= satPrn.start;
-		GTime stopTime	= satPrn.stop;
+	auto& index = theSinex.satIndex;
 
-		if 	(  satPrn.prn == prn
-			&&	(time - startTime)	.to_double()	>= 0
-			&&(	(time - stopTime)	.to_double()	<= 0
-			  ||satPrn.stop[0] == 0))
-		{
-			satSnx.prn	= prn;
-			satSnx.svn	= satPrn.svn;
-			//todo: start and stop time
-			found = true;
-			break;
-		}
+	// prn and svn
+	auto satPrn_ptr = findSnxSatInterval(index.prnMap, prn, time);
+	if (satPrn_ptr)
+	{
+		satSnx.prn	= prn;
+		satSnx.svn	= satPrn_ptr->svn;
+		//todo: start and stop time
 	}
-
-	if (!found)
+	else
+	{
 		result.failurePRN = true;
+	}
 
 	// sat identifiers
 	auto itr = theSinex.satIdentityMap.find(satSnx.svn);
@@ -3770,50 +4315,33 @@ GetSnxResult getSatSnx(
 	//todo: add other sections for satellite in theSinex
 
 	// sat com
-	found = false;
-	for (auto& satCom : theSinex.list_satcoms)
+	auto satCom_ptr = findSnxSatInterval(index.comMap, satSnx.svn, time);
+	if (satCom_ptr)
 	{
-		GTime startTime	= satCom.start;
-		GTime stopTime	= satCom.stop;
-
-		if 	(  satCom.svn == satSnx.svn
-			&& 	(time - startTime)	.to_double()	>= 0
-			&&(	(time - stopTime)	.to_double()	<= 0
-			  ||satCom.stop[0] == 0))
-		{
-			for (int i = 0; i < 3; i++)
-				satSnx.com[i] = satCom.com[i];
-			//todo: start and stop time
-			found = true;
-		}
+		for (int i = 0; i < 3; i++)
+			satSnx.com[i] = satCom_ptr->com[i];
+		//todo: start and stop time
+	}
+	else
+	{
+		result.failureCOM = true;
 	}
-
-	if (!found)
-		result.failureCOM = true;;
-
-	found = false;
 
 	// sat eccentricities
-	for (auto& satEcc : theSinex.list_sateccs)
+	auto eccIt = index.eccMap.find(satSnx.svn);
+	if (eccIt != index.eccMap.end())
 	{
-		if (satEcc.svn == satSnx.svn)
+		auto& [dummy, eccMap] = *eccIt;
+
+		for (auto& [eccType, satEcc_ptr] : eccMap)
 		{
-			E_EccType eccType;
-			switch (satEcc.type)
-			{
-				case 'P':	{	found = true;	satSnx.ecc_ptrs[E_EccType::P_ANT] = &satEcc;	break;		}
-				case 'L':	{	found = true;	satSnx.ecc_ptrs[E_EccType::L_LRA] = &satEcc;	break;		}
-				default:
-				{
-					BOOST_LOG_TRIVIAL(error) << "Unknown satellite eccentricity type";
-					break;
-				}
-			}
+			satSnx.ecc_ptrs[eccType] = satEcc_ptr;
 		}
 	}
-
-	if (!found)
+	else
+	{
 		result.failureEccentricity = true;
+	}
 
 	//todo: add other sections for satellite in theSinex
 
@@ -3933,8 +4461,15 @@ bool getSnxSatMaxYawRate(
 	GTime&	time, 
 	double&	maxYawRate)
 {
-	auto itr = theSinex.satYawRateMap[svn].lower_bound(time);
-	if (itr == theSinex.satYawRateMap[svn].end())
+	//find rather than [] so that lookups from parallel threads never modify the map
+	auto svnItr = theSinex.satYawRateMap.find(svn);
+	if (svnItr == theSinex.satYawRateMap.end())
+		return false;
+
+	auto& [dummySvn, yawRateMap] = *svnItr;
+
+	auto itr = yawRateMap.lower_bound(time);
+	if (itr == yawRateMap.end())
 		return false;
 
 	auto& [dummy, entry] = *itr;
@@ -3964,8 +4499,14 @@ bool getSnxSatAttMode(
 	GTime&	time, 
 	string&	attMode)
 {
-	auto itr = theSinex.satAttModeMap[svn].lower_bound(time);
-	if (itr == theSinex.satAttModeMap[svn].end())
+	auto svnItr = theSinex.satAttModeMap.find(svn);
+	if (svnItr == theSinex.satAttModeMap.end())
+		return false;
+
+	auto& [dummySvn, attModeMap] = *svnItr;
+
+	auto itr = attModeMap.lower_bound(time);
+	if (itr == attModeMap.end())
 		return false;
 
 	auto& [dummy, entry] = *itr;
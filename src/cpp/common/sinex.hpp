@@ -4,10 +4,12 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
 #include <list>
 #include <map>
 
 using std::string;
+using std::vector;
 using std::list;
 using std::map;
 
@@ -348,6 +350,30 @@ struct Sinex_solmatrix_t
 	double value[3]; // each d21.14 cols col, col+1, col+2 of the row
 };
 
+/** Symmetric matrix of a SOLUTION/MATRIX block, stored as its packed lower triangle.
+ * Elements that are not given in the block are zero
+ */
+struct SinexMatrix
+{
+	char			triangle	= 'L';		///< Triangle the matrix was given in, (L)ower or (U)pper
+	int				dim			= 0;		///< Number of rows and columns, parameters are numbered from 1 as in the file's SOLUTION/ESTIMATE block
+	vector<double>	packed;					///< Lower triangle by rows, element (row, col) is at (row - 1) * row / 2 + col - 1
+	vector<int>		paramIndexList;			///< Index in Sinex::paramIndexMap of each of the file's parameters, 0 for those without estimates
+
+	void set(
+		int		row,
+		int		col,
+		double	value);
+
+	double operator()(
+		int		row,
+		int		col)
+	const;
+
+	MatrixXd toDense()
+	const;
+};
+
 
 //=============================================================================
 /*
@@ -595,6 +621,19 @@ struct SinexTropSol
 	vector<TropSolutionEntry> solutions; //map not used b/c may have multiple STDDEV entries
 };
 
+/** Time-indexed views of the satellite blocks of a sinex, rebuilt whenever a sinex file is read.
+ * Intervals are keyed by their start in descending order, so the entry in effect at a time is the lower bound of that time
+ */
+struct SinexSatIndex
+{
+	map<string, map<GTime, Sinex_satprn_t*,		std::greater<GTime>>>	prnMap;			///< PRN assignments by PRN
+	map<string, map<GTime, Sinex_satfreqchn_t*,	std::greater<GTime>>>	freqChnMap;		///< Frequency channels by SVN
+	map<string, map<GTime, Sinex_satcom_t*,		std::greater<GTime>>>	comMap;			///< Centre of mass offsets by SVN
+	map<string, map<GTime, Sinex_satmass_t*,	std::greater<GTime>>>	massMap;		///< Masses by SVN
+	map<string, map<GTime, Sinex_satpower_t*,	std::greater<GTime>>>	powerMap;		///< Transmit powers by SVN
+	map<string, map<E_EccType, Sinex_satecc_t*>>						eccMap;			///< Eccentricities by SVN and type
+};
+
 struct Sinex
 {
 	/* header block */
@@ -615,50 +654,53 @@ struct Sinex
 
 	
 	map<string, list<string>>			blockComments;
-	list<string>						refstrings;
-	list<Sinex_input_history_t>       	inputHistory;
-	list<Sinex_input_file_t>          	inputFiles;
-	list<Sinex_ack_t>                 	acknowledgements;
+	vector<string>						refstrings;
+	vector<Sinex_input_history_t>       	inputHistory;
+	vector<Sinex_input_file_t>          	inputFiles;
+	vector<Sinex_ack_t>                 	acknowledgements;
 
 	/* site stuff */
 	map<string, Sinex_siteid_t>		map_siteids;
-	list<Sinex_sitedata_t>            	list_sitedata;
+	vector<Sinex_sitedata_t>            	list_sitedata;
 	map<string, map<GTime, Sinex_receiver_t,	std::greater<GTime>>>	map_receivers;
 	map<string, map<GTime, Sinex_antenna_t,		std::greater<GTime>>>	map_antennas;
 	map<string, map<GTime, Sinex_site_ecc_t,	std::greater<GTime>>>	map_eccentricities;
-	list<Sinex_gps_phase_center_t>    	list_gps_pcs;
-	list<Sinex_gal_phase_center_t>    	list_gal_pcs;
+	vector<Sinex_gps_phase_center_t>    	list_gps_pcs;
+	vector<Sinex_gal_phase_center_t>    	list_gal_pcs;
 
 	/* solution stuff - tied to sites */
 	bool								epochs_have_bias;      
-	list<Sinex_solepoch_t>				list_solepochs;
-	list<Sinex_solstatistic_t>			list_statistics;
+	vector<Sinex_solepoch_t>				list_solepochs;
+	vector<Sinex_solstatistic_t>			list_statistics;
 	map<string, map<string, map<GTime, Sinex_solestimate_t, std::greater<GTime>>>>	map_estimates_primary;
 	map<string, map<string, map<GTime, Sinex_solestimate_t, std::greater<GTime>>>>	map_estimates;
 	map<int, Sinex_solapriori_t>			apriori_map;
-	list<Sinex_solneq_t>				list_normal_eqns;
-	map<matrix_value,list<Sinex_solmatrix_t>>  matrix_map[MAX_MATRIX_TYPE];
+	vector<Sinex_solneq_t>				list_normal_eqns;
+	map<matrix_value, map<string, SinexMatrix>>	matrix_map[MAX_MATRIX_TYPE];	///< Matrices by type and file, kept per file so that their sizes do not compound across files
+	map<string, int>					paramIndexMap;		///< Index of each parameter, by its type, site, point, solution and epoch columns, across all files
+	map<int, int>						fileParamIndexMap;	///< Index across all files of each parameter index of the file being read
 	map<string,	map<char, map<GTime, Sinex_datahandling_t, std::greater<GTime>>>>	map_data_handling;
 
 	/* satellite stuff */
-	list<Sinex_satpc_t>				list_satpcs;
-	list<Sinex_satid_t>				list_satids;
+	vector<Sinex_satpc_t>				list_satpcs;
+	vector<Sinex_satid_t>				list_satids;
 	map<string, SinexSatIdentity>	satIdentityMap;
 	
 	map<string, map<GTime, Sinex_satmass_t>>	map_satmasses;
 	map<string, map<GTime, Sinex_satpower_t>>	map_satpowers;
 	
-	list<Sinex_satprn_t>			list_satprns;
-	list<Sinex_satfreqchn_t>		list_satfreqchns;
-	list<Sinex_satcom_t>			list_satcoms;
-	list<Sinex_satecc_t>			list_sateccs;
+	vector<Sinex_satprn_t>			list_satprns;
+	vector<Sinex_satfreqchn_t>		list_satfreqchns;
+	vector<Sinex_satcom_t>			list_satcoms;
+	vector<Sinex_satecc_t>			list_sateccs;
 	map<string, map<GTime, SinexSatYawRate,		std::greater<GTime>>>	satYawRateMap;
 	map<string, map<GTime, SinexSatAttMode,		std::greater<GTime>>>	satAttModeMap;
+	SinexSatIndex					satIndex;
 
 	/* VLBI - ignored for now */
-	list<Sinex_source_id_t>		list_source_ids;
-	list<Sinex_nutcode_t>		list_nutcodes;
-	list<Sinex_precode_t>		list_precessions;
+	vector<Sinex_source_id_t>		list_source_ids;
+	vector<Sinex_nutcode_t>		list_nutcodes;
+	vector<Sinex_precode_t>		list_precessions;
 
 	// constructor
 	Sinex(bool t = false) 
@@ -716,9 +758,14 @@ struct SinexSatSnx /* satellite meta data */
 void nearestYear(
 	double&	year);
 
+vector<string> loadSinexFiles(
+	const vector<string>&	filepaths,
+	vector<char>&			loadedList);
+
 int readSinex(
 	string	filepath,
-	bool	primary);
+	bool	primary,
+	string*	buffer_ptr = nullptr);
 
 bool  writeSinex(
 	string					filepath,
@@ -748,7 +795,7 @@ GetSnxResult getStnSnx	(string rec,	GTime time, SinexRecData&	snx);
 GetSnxResult getSatSnx	(string prn,	GTime time, SinexSatSnx&	snx);
 
 void	getRecBias	(string station,	UYds yds, map<char, double>& stn_bias);
-long int time_compare(UYds& left, UYds& right);
+long int time_compare(const UYds& left, const UYds& right);
 void sinex_add_statistic(const string& what, const int		value);
 void sinex_add_statistic(const string& what, const double	value);
 int sinex_check_add_ga_reference(string solType, string peaVer, bool isTrop);
@@ -806,6 +853,8 @@ bool getSnxSatAttMode(
 	GTime&	time, 
 	string&	attMode);
 
+void indexSinexSatellites();
+
 extern Sinex theSinex; // the one and only sinex object.
 
 void getStationsFromSinex(
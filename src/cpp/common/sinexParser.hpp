@@ -171,13 +171,13 @@ struct SinexParser : Parser, ObsLister
 			
 			int index = 0;
 			
-			obs.obsState.kfIndexMap[KFState::oneKey] = index;
+			obs.obsState.kfIndexMap.set(KFState::oneKey, index);
 			
 			index++;
 			
 			for (auto& [key, tuplet] : someMap)
 			{
-				obs.obsState.kfIndexMap[key]					= index;
+				obs.obsState.kfIndexMap.set(key, index);
 				obs.obsState.stateTransitionMap[key][key][0]	= 1;
 				
 				index++;
@@ -189,7 +189,7 @@ struct SinexParser : Parser, ObsLister
 			
 			for (auto& [keyA, tuplet] : someMap)
 			{
-				auto indexA = obs.obsState.kfIndexMap[keyA];
+				auto indexA = obs.obsState.kfIndexMap.index(keyA);
 				
 				auto& [value, covMap] = tuplet;
 				
@@ -197,7 +197,9 @@ struct SinexParser : Parser, ObsLister
 				
 				for (auto& [keyB, cov] : covMap)
 				{
-					auto indexB = obs.obsState.kfIndexMap[keyB];
+					auto indexB = obs.obsState.kfIndexMap.index(keyB);
+					if (indexB < 0)
+						continue;
 					
 					obs.obsState.P(indexA, indexB) = cov;
 				}
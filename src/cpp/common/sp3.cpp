@@ -349,6 +349,8 @@ void readSp3ToNav(
 		}
 		pephList.clear();
 	}
+	
+	nav->pephMapVersion++;
 }
 
 
@@ -370,4 +372,6 @@ void orb2sp3(
 
 		nav.pephMap[Sat.id()][time] = peph;
 	}
+	
+	nav.pephMapVersion++;
 }
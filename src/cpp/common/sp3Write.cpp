@@ -318,7 +318,7 @@ void writeSysSetSp3(
 	Sp3FileData&		outFileDat,
 	vector<E_Source>	sp3OrbitSrcs,	
 	vector<E_Source>	sp3ClockSrcs,	
-	KFState*			kfState_ptr,
+	const KFState*		kfState_ptr,
 	bool				predicted)
 {
 	map<int, Sp3Entry> entryList;
@@ -381,7 +381,7 @@ void outputSp3(
 	GTime				time,
 	vector<E_Source>	sp3OrbitSrcs,
 	vector<E_Source>	sp3ClockSrcs,
-	KFState*			kfState_ptr,
+	const KFState*		kfState_ptr,
 	bool				predicted)
 {
 	time = time.floorTime(1);
@@ -18,7 +18,7 @@ void outputSp3(
 	GTime				time,
 	vector<E_Source>	sp3OrbitSrcs,
 	vector<E_Source>	sp3ClockSrcs,
-	KFState*			kfState_ptr	= nullptr,
+	const KFState*		kfState_ptr	= nullptr,
 	bool				predicted	= false);
 
 void outputMongoOrbits();
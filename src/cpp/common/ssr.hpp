@@ -318,7 +318,7 @@ double ephVarToUra(double ephVar);
 
 void prepareSsrStates(
 	Trace&				trace,
-	KFState&			kfState,
+	const KFState&		kfState,
 	GTime				time);
 
 void writeSsrOutToFile(
@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <cstring>
+
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 
@@ -9,99 +11,138 @@
 #include "streamObs.hpp"
 
 
-#define CLEAN_UP_AND_RETURN_ON_FAILURE	\
-										\
-	if (inputStream.fail())				\
-	{									\
-		inputStream.clear();			\
-		inputStream.seekg(pos);			\
-		return;							\
-	}					
-
+#define RTCM_CHUNK_SIZE		0x10000		///< Number of bytes read from the input stream at a time, must hold the largest frame (1029 bytes)
 
 
 struct RtcmParser : Parser, RtcmDecoder
 {
-	void parse(
-		std::istream& inputStream)
+	vector<unsigned char>	chunk;			///< Contiguous block of input data that frames are scanned from
+	vector<unsigned char>	frameData;		///< Reused copy of the current frame, for recording
+	vector<unsigned char>	messageData;	///< Reused copy of the current message, without the frame header
+
+	/** Scan a contiguous block of data for frames and decode them.
+	 * Returns the number of bytes consumed, which stops short of any incomplete frame at the end of the block,
+	 * or of the frame that requested parsing to pause
+	 */
+	int scanFrames(
+		const unsigned char*	buff,		///< Start of block
+		int						size,		///< Number of bytes in block
+		bool&					stop)		///< Flag that parsing should return to the caller
 	{
-// 		std::cout << "Parsing rtcm" << std::endl;
-		
-		while (inputStream)
+		int i = 0;
+		while (i < size)
 		{
-			int byteCnt = 0;
-			int pos;
-			while (true)
+			// Skip to the start of the frame - marked by preamble character 0xD3
+			auto preamble_ptr = (const unsigned char*) memchr(buff + i, RTCM_PREAMBLE, size - i);
+			
+			int start = size;
+			if (preamble_ptr)
+				start = preamble_ptr - buff;
+			
+			for (; i < start; i++)
 			{
-				// Skip to the start of the frame - marked by preamble character 0xD3
-				pos = inputStream.tellg();
-
-				unsigned char c;
-				inputStream.read((char*)&c, 1);																			CLEAN_UP_AND_RETURN_ON_FAILURE;
-				
-				if (inputStream)
-				{
-					if (c == RTCM_PREAMBLE)
-					{
-						break;
-					}
-				}
-				else
-				{
-					printf(".");
-					return;
-				}
-				
-				nonFrameByteFound(c);
+				nonFrameByteFound(buff[i]);
+			}
+			
+			if (i >= size)
+			{
+				return size;
+			}
+			
+			// Message length is 10 bits starting at bit 6 of the two bytes after the preamble
+			if (size - i < 3)
+			{
+				return i;
+			}
+			
+			int messageLength	= getbitu(buff + i + 1, 6, 10);
+			int dataFrameLength	= messageLength + 3;
+			
+			if (size - i < dataFrameLength + 3)
+			{
+				return i;
 			}
-			CLEAN_UP_AND_RETURN_ON_FAILURE;
 			
 			preambleFound();
 			
-			// Read the frame length - 2 bytes big endian only want 10 bits
-			char buf[2];									inputStream.read((char*)buf,				2);				CLEAN_UP_AND_RETURN_ON_FAILURE;
+			const unsigned char* frame = buff + i;
 			
-			// Message length is 10 bits starting at bit 6
-			auto messageLength		= getbitu((uint8_t*)buf, 6,	10);
-			auto dataFrameLength	= messageLength + 3;
-
-			// Read the frame data (include the header)
-			vector<unsigned char> data(dataFrameLength);	inputStream.read((char*)data.data() + 3,	messageLength);	CLEAN_UP_AND_RETURN_ON_FAILURE;
-
-			// Read the frame CRC
-			unsigned int crcRead = 0;						inputStream.read((char*)&crcRead,			3);				CLEAN_UP_AND_RETURN_ON_FAILURE;
-
-			data[0] = RTCM_PREAMBLE;
-			data[1] = buf[0];
-			data[2] = buf[1];
-			unsigned int crcCalc = crc24q(data.data(), data.size());
-
-			if	( (((char*)&crcCalc)[0] != ((char*)&crcRead)[2])
-				||(((char*)&crcCalc)[1] != ((char*)&crcRead)[1])
-				||(((char*)&crcCalc)[2] != ((char*)&crcRead)[0]))
+			// Check the frame CRC, which follows the frame data (including the header)
+			unsigned int crcRead	= 0;
+			memcpy(&crcRead, frame + dataFrameLength, 3);
+			
+			unsigned int crcFrame	= getbitu(frame + dataFrameLength, 0, 24);
+			unsigned int crcCalc	= crc24q(frame, dataFrameLength);
+			
+			if (crcCalc != crcFrame)
 			{
 				checksumFailure(rtcmMountpoint);
 				
-// 				printHex(std::cout, data);
-				
-				inputStream.seekg(pos + 1);
+				i++;
 				
 				continue;
 			}
 			
 			checksumSuccess(crcRead);
-
-			recordFrame(data, crcRead);
+			
+			if (rtcm_filename.empty() == false)
+			{
+				frameData.assign(frame, frame + dataFrameLength);
+				
+				recordFrame(frameData, crcRead);
+			}
 			
 			//remove the header to get to the meat of the message
-			auto& message = data;
-			message.erase(message.begin(), message.begin()+3);
+			messageData.assign(frame + 3, frame + dataFrameLength);
+			
+			auto rtcmReturnType = decode(messageData);
+			
+			if (rtcmReturnType == E_ReturnType::WAIT)			{	stop = true;	return i;									}
+			
+			i += dataFrameLength + 3;
+			
+			if (rtcmReturnType == E_ReturnType::GOT_OBS)		{	stop = true;	return i;									}
+		}
+		
+		return i;
+	}
+	
+	/** Parse frames from the input stream.
+	 * Data is read in large blocks and scanned in memory, the stream is then repositioned to just after the last consumed byte
+	 */
+	void parse(
+		std::istream& inputStream)
+	{
+// 		std::cout << "Parsing rtcm" << std::endl;
+		
+		chunk.resize(RTCM_CHUNK_SIZE);
+		
+		while (inputStream)
+		{
+			long int pos = inputStream.tellg();
+			if (pos < 0)
+			{
+				return;
+			}
+			
+			inputStream.read((char*)chunk.data(), chunk.size());
+			
+			int		chunkSize	= inputStream.gcount();
+			bool	endOfData	= (chunkSize < chunk.size());
 			
-			auto rtcmReturnType = decode(message);
+			inputStream.clear();
 			
-			if (rtcmReturnType == E_ReturnType::GOT_OBS)		{								return;		}
-			if (rtcmReturnType == E_ReturnType::WAIT)			{	inputStream.seekg(pos);		return;		}
+			bool	stop		= false;
+			int		consumed	= scanFrames(chunk.data(), chunkSize, stop);
 			
+			inputStream.seekg(pos + consumed);
+			
+			if	(  stop
+				|| endOfData
+				|| consumed == 0)
+			{
+				return;
+			}
 		}
 	}
 	
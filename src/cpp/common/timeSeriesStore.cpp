@@ -0,0 +1,1013 @@
+
+// #pragma GCC optimize ("O0")
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <limits>
+#include <cmath>
+
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/log/trivial.hpp>
+
+#include "timeSeriesStore.hpp"
+
+
+#define STORE_BLOCK_MAGIC		"TSB1"		///< Marker at the start of every block in a store file
+#define STORE_KEY_SEPARATOR		'\x1f'		///< Separator between the fields of a series key
+
+#define STORE_BLOCK_WRITE		'W'
+#define STORE_BLOCK_CULL		'C'
+
+const double storeNaN = std::numeric_limits<double>::quiet_NaN();
+
+
+/** Row of data to be encoded into a block
+ */
+struct StoreBlockRow
+{
+	string					key;
+	GTime					time;
+	map<string, double>		doubleMap;
+	map<string, string>		stringMap;
+};
+
+/** Exclusive lock on a store file, held while writing so that writers in other processes can't interleave their blocks.
+ * The lock is taken on a separate lock file, as the store file itself is replaced when it is compacted
+ */
+struct StoreFileLock
+{
+	int fd = -1;
+
+	StoreFileLock(
+		const string&	filename)
+	{
+		fd = open((filename + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+		{
+			BOOST_LOG_TRIVIAL(warning)
+			<< "Warning: Could not open lock file for time series store " << filename << ", writes from other processes may interleave";
+
+			return;
+		}
+
+		flock(fd, LOCK_EX);
+	}
+
+	~StoreFileLock()
+	{
+		if (fd < 0)
+			return;
+
+		flock(fd, LOCK_UN);
+		close(fd);
+	}
+};
+
+/** Join the key fields of a series into the string it is indexed by
+ */
+string storeKey(
+	const map<string, string>&	keyFields)
+{
+	string key;
+	for (auto& [name, value] : keyFields)
+	{
+		if (key.empty() == false)
+			key += STORE_KEY_SEPARATOR;
+
+		key += name + "=" + value;
+	}
+
+	return key;
+}
+
+/** Split the string a series is indexed by back into its key fields
+ */
+map<string, string> storeKeyFields(
+	const string&	key)
+{
+	map<string, string> keyFields;
+
+	size_t start = 0;
+	while (start < key.size())
+	{
+		size_t stop = key.find(STORE_KEY_SEPARATOR, start);
+		if (stop == string::npos)
+			stop = key.size();
+
+		string	field	= key.substr(start, stop - start);
+		size_t	equals	= field.find('=');
+
+		if (equals != string::npos)
+		{
+			keyFields[field.substr(0, equals)] = field.substr(equals + 1);
+		}
+
+		start = stop + 1;
+	}
+
+	return keyFields;
+}
+
+void putU32(
+	string&		buffer,
+	uint32_t	value)
+{
+	buffer.append((char*) &value, sizeof(value));
+}
+
+void putDouble(
+	string&		buffer,
+	double		value)
+{
+	buffer.append((char*) &value, sizeof(value));
+}
+
+void putString(
+	string&			buffer,
+	const string&	value)
+{
+	putU32(buffer, value.size());
+	buffer.append(value);
+}
+
+/** Bounds checked reader for the contents of a block
+ */
+struct StoreBlockReader
+{
+	const string&	block;
+	size_t			pos		= 0;
+	bool			pass	= true;
+
+	StoreBlockReader(
+		const string&	block)
+	:	block	(block)
+	{
+
+	}
+
+	template<typename TYPE>
+	TYPE get()
+	{
+		TYPE value = 0;
+
+		if (pos + sizeof(TYPE) > block.size())
+		{
+			pass = false;
+			return value;
+		}
+
+		memcpy(&value, &block[pos], sizeof(TYPE));
+		pos += sizeof(TYPE);
+
+		return value;
+	}
+
+	string getString()
+	{
+		uint32_t size = get<uint32_t>();
+
+		if (pos + size > block.size())
+		{
+			pass = false;
+			return "";
+		}
+
+		string value = block.substr(pos, size);
+		pos += size;
+
+		return value;
+	}
+};
+
+/** Encode rows of a collection into a block, with each field stored as a column
+ */
+string encodeWriteBlock(
+	const string&					collection,
+	const vector<StoreBlockRow>&	rowList)
+{
+	map<string, bool> doubleNames;
+	map<string, bool> stringNames;
+
+	for (auto& row : rowList)
+	{
+		for (auto& [name, value] : row.doubleMap)		doubleNames[name] = true;
+		for (auto& [name, value] : row.stringMap)		stringNames[name] = true;
+	}
+
+	string block;
+	block += STORE_BLOCK_WRITE;
+	putString(block, collection);
+
+	putU32(block, rowList.size());
+	for (auto& row : rowList)		putString(block, row.key);
+	for (auto& row : rowList)		putDouble(block, row.time.bigTime);
+
+	putU32(block, doubleNames.size());
+	for (auto& [name, unused] : doubleNames)
+	{
+		putString(block, name);
+
+		for (auto& row : rowList)
+		{
+			auto it = row.doubleMap.find(name);
+			if (it == row.doubleMap.end())		putDouble(block, storeNaN);
+			else								putDouble(block, it->second);
+		}
+	}
+
+	putU32(block, stringNames.size());
+	for (auto& [name, unused] : stringNames)
+	{
+		putString(block, name);
+
+		for (auto& row : rowList)
+		{
+			auto it = row.stringMap.find(name);
+			if (it == row.stringMap.end())		putString(block, "");
+			else								putString(block, it->second);
+		}
+	}
+
+	return block;
+}
+
+/** Get a numeric field of a row, or the default value if it is not set
+ */
+double StoreRow::getDouble(
+	const string&	name,
+	double			defaultValue)
+const
+{
+	auto it = doubleMap.find(name);
+	if (it == doubleMap.end())
+		return defaultValue;
+
+	return it->second;
+}
+
+/** Get an integer field of a row, or the default value if it is not set
+ */
+int StoreRow::getInt(
+	const string&	name,
+	int				defaultValue)
+const
+{
+	return std::round(getDouble(name, defaultValue));
+}
+
+/** Get a text field of a row, empty if it is not set
+ */
+string StoreRow::getString(
+	const string&	name)
+const
+{
+	auto it = stringMap.find(name);
+	if (it == stringMap.end())
+		return "";
+
+	return it->second;
+}
+
+/** Get a time field of a row, which are stored numerically
+ */
+GTime StoreRow::getTime(
+	const string&	name)
+const
+{
+	GTime time;
+	time.bigTime = getDouble(name);
+
+	return time;
+}
+
+/** Get the row of a series at a time, adding an empty row if there is none
+ */
+int StoreSeries::row(
+	GTime	time)
+{
+	auto it = timeIndexMap.find(time);
+	if (it != timeIndexMap.end())
+	{
+		return it->second;
+	}
+
+	int newRow = timeList.size();
+
+	timeList.push_back(time);
+	timeIndexMap[time] = newRow;
+
+	for (auto& [name, column] : doubleColumns)		column.push_back(storeNaN);
+	for (auto& [name, column] : stringColumns)		column.push_back("");
+
+	return newRow;
+}
+
+/** Collect the fields of a row of a series, along with the key fields of the series
+ */
+StoreRow StoreSeries::getRow(
+	int		row)
+const
+{
+	StoreRow storeRow;
+	storeRow.time		= timeList[row];
+	storeRow.stringMap	= keyFields;
+
+	for (auto& [name, column] : doubleColumns)
+	{
+		if (std::isnan(column[row]) == false)
+			storeRow.doubleMap[name] = column[row];
+	}
+
+	for (auto& [name, column] : stringColumns)
+	{
+		if (column[row].empty() == false)
+			storeRow.stringMap[name] = column[row];
+	}
+
+	return storeRow;
+}
+
+TimeSeriesStore::TimeSeriesStore(
+	string	filename,
+	bool	deleteHistory)
+:	filename	(filename)
+{
+	if (deleteHistory)
+	{
+		std::remove(filename.c_str());
+	}
+
+	std::lock_guard<std::mutex> guard(storeMutex);
+
+	readBlocks();
+
+	BOOST_LOG_TRIVIAL(info)
+	<< "Time series store opened at " << filename << " with " << numRows << " rows";
+}
+
+/** Add or update the values of a row in memory
+ */
+void TimeSeriesStore::insert(
+	const string&				collection,
+	const map<string, string>&	keyFields,
+	GTime						time,
+	const map<string, double>&	doubleMap,
+	const map<string, string>&	stringMap)
+{
+	auto& series = collectionMap[collection][storeKey(keyFields)];
+
+	if (series.timeList.empty())
+	{
+		series.keyFields = keyFields;
+	}
+
+	int numSeriesRows = series.timeList.size();
+
+	int row = series.row(time);
+
+	if (row == numSeriesRows)
+	{
+		numRows++;
+	}
+
+	//values are set like a mongo $set, fields that aren't given keep any previous values
+	for (auto& [name, value] : doubleMap)
+	{
+		auto& column = series.doubleColumns[name];
+		column.resize(series.timeList.size(), storeNaN);
+		column[row] = value;
+	}
+
+	for (auto& [name, value] : stringMap)
+	{
+		auto& column = series.stringColumns[name];
+		column.resize(series.timeList.size(), "");
+		column[row] = value;
+	}
+}
+
+/** Apply a block read from file to the data in memory
+ */
+void TimeSeriesStore::applyBlock(
+	const string&	block)
+{
+	StoreBlockReader reader(block);
+
+	char	type		= reader.get<char>();
+	string	collection	= reader.getString();
+
+	if (type == STORE_BLOCK_CULL)
+	{
+		GTime time;
+		time.bigTime = reader.get<double>();
+
+		if (reader.pass)
+			removeBefore(collection, time);
+
+		return;
+	}
+
+	if (type != STORE_BLOCK_WRITE)
+	{
+		return;
+	}
+
+	int numBlockRows = reader.get<uint32_t>();
+
+	vector<StoreBlockRow> rowList(numBlockRows);
+	for (auto& row : rowList)		row.key				= reader.getString();
+	for (auto& row : rowList)		row.time.bigTime	= reader.get<double>();
+
+	int numDoubles = reader.get<uint32_t>();
+	for (int i = 0; i < numDoubles && reader.pass; i++)
+	{
+		string name = reader.getString();
+
+		for (auto& row : rowList)
+		{
+			double value = reader.get<double>();
+			if (std::isnan(value) == false)
+				row.doubleMap[name] = value;
+		}
+	}
+
+	int numStrings = reader.get<uint32_t>();
+	for (int i = 0; i < numStrings && reader.pass; i++)
+	{
+		string name = reader.getString();
+
+		for (auto& row : rowList)
+		{
+			string value = reader.getString();
+			if (value.empty() == false)
+				row.stringMap[name] = value;
+		}
+	}
+
+	if (reader.pass == false)
+	{
+		BOOST_LOG_TRIVIAL(warning)
+		<< "Warning: Corrupt block in time series store " << filename;
+
+		return;
+	}
+
+	for (auto& row : rowList)
+	{
+		insert(collection, storeKeyFields(row.key), row.time, row.doubleMap, row.stringMap);
+	}
+}
+
+/** Note which file is being read, so that it can be reloaded if it is replaced
+ */
+void TimeSeriesStore::recordFileIdentity()
+{
+	struct stat fileStat;
+	if (stat(filename.c_str(), &fileStat) != 0)
+	{
+		fileDevice	= -1;
+		fileInode	= -1;
+
+		return;
+	}
+
+	fileDevice	= fileStat.st_dev;
+	fileInode	= fileStat.st_ino;
+}
+
+/** Load any complete blocks that have been added to the file since it was last read
+ */
+void TimeSeriesStore::readBlocks()
+{
+	if (readPos == 0)
+	{
+		recordFileIdentity();
+	}
+
+	std::ifstream inputStream(filename, std::ios::binary);
+	if (!inputStream)
+	{
+		return;
+	}
+
+	inputStream.seekg(readPos);
+
+	while (true)
+	{
+		char		magic[4];
+		uint64_t	length;
+
+		inputStream.read(magic,				sizeof(magic));
+		inputStream.read((char*) &length,	sizeof(length));
+
+		if	(  !inputStream
+			|| memcmp(magic, STORE_BLOCK_MAGIC, sizeof(magic)) != 0)
+		{
+			//nothing more, or a block that is still being written
+			break;
+		}
+
+		string block(length, '\0');
+		inputStream.read(&block[0], length);
+
+		if (!inputStream)
+		{
+			break;
+		}
+
+		applyBlock(block);
+
+		readPos += sizeof(magic) + sizeof(length) + length;
+	}
+}
+
+/** Append a block to the file, as a single write so that readers never see part of a header.
+ * Must be called with the store's lock file held
+ */
+void TimeSeriesStore::appendBlock(
+	const string&	block)
+{
+	uint64_t length = block.size();
+
+	string data;
+	data.reserve(4 + sizeof(length) + length);
+	data.append(STORE_BLOCK_MAGIC, 4);
+	data.append((char*) &length, sizeof(length));
+	data.append(block);
+
+	std::ofstream outputStream(filename, std::ios::binary | std::ios::app);
+	if (!outputStream)
+	{
+		BOOST_LOG_TRIVIAL(error)
+		<< "Error: Could not write to time series store " << filename;
+
+		return;
+	}
+
+	outputStream.write(data.data(), data.size());
+	outputStream.flush();
+
+	long int endPos = outputStream.tellp();
+
+	//the block is already applied, skip over it unless the file has data that hasn't been read yet, which is then read along with it
+	if (endPos - (long int) data.size() == readPos)
+	{
+		readPos = endPos;
+	}
+
+	if (fileInode < 0)
+	{
+		recordFileIdentity();
+	}
+}
+
+/** Pick up data written to the file by other processes.
+ * A file that has been replaced, (compacted by another process) is reloaded completely
+ */
+void TimeSeriesStore::refresh()
+{
+	struct stat fileStat;
+	if (stat(filename.c_str(), &fileStat) != 0)
+	{
+		return;
+	}
+
+	bool replaced	=  fileStat.st_dev	!= fileDevice
+					|| fileStat.st_ino	!= fileInode
+					|| fileStat.st_size	<  readPos;
+
+	if	(  replaced
+		&& readPos > 0)
+	{
+		collectionMap.clear();
+		readPos		= 0;
+		numRows		= 0;
+		numCulled	= 0;
+	}
+	else if (fileStat.st_size == readPos)
+	{
+		return;
+	}
+
+	readBlocks();
+}
+
+/** Write documents to a collection, updating any rows that already exist with the same keys and time.
+ * Key fields other than the first key time identify the series, the first key time is the time of the row
+ */
+void TimeSeriesStore::write(
+	const string&		collection,
+	vector<DBEntry>&	entryList)
+{
+	vector<StoreBlockRow> rowList;
+	rowList.reserve(entryList.size());
+
+	for (auto& entry : entryList)
+	{
+		StoreBlockRow		row;
+		map<string, string>	keyFields;
+		bool				timeFound = false;
+
+		for (auto& [name, value] : entry.timeMap)
+		{
+			auto& [time, isKey] = value;
+
+			if	(  isKey
+				&& timeFound == false)
+			{
+				row.time	= time;
+				timeFound	= true;
+			}
+			else if (isKey)
+			{
+				keyFields[name] = std::to_string((double) time.bigTime);
+			}
+			else
+			{
+				row.doubleMap[name] = time.bigTime;
+			}
+		}
+
+		for (auto& [name, value] : entry.stringMap)
+		{
+			auto& [str, isKey] = value;
+
+			if (isKey)		keyFields		[name] = str;
+			else			row.stringMap	[name] = str;
+		}
+
+		for (auto& [name, value] : entry.intMap)
+		{
+			auto& [num, isKey] = value;
+
+			if (isKey)		keyFields		[name] = std::to_string(num);
+			else			row.doubleMap	[name] = num;
+		}
+
+		for (auto& [name, value] : entry.doubleMap)
+		{
+			auto& [num, isKey] = value;
+
+			if (isKey)		keyFields		[name] = std::to_string(num);
+			else			row.doubleMap	[name] = num;
+		}
+
+		//vectors and arrays are expanded into a field per element, named as mongo names vector elements
+		for (auto& [name, value] : entry.vectorMap)
+		{
+			auto& [vec, isKey] = value;
+			for (int i = 0; i < 3; i++)						row.doubleMap[name + std::to_string(i)] = vec[i];
+		}
+
+		for (auto& [name, value] : entry.doubleArrayMap)
+		{
+			auto& [vec, isKey] = value;
+			for (int i = 0; i < vec.size(); i++)			row.doubleMap[name + std::to_string(i)] = vec[i];
+		}
+
+		for (auto& [name, value] : entry.intArrayMap)
+		{
+			auto& [vec, isKey] = value;
+			for (int i = 0; i < vec.size(); i++)			row.doubleMap[name + std::to_string(i)] = vec[i];
+		}
+
+		for (auto& [name, value] : entry.boolArrayMap)
+		{
+			auto& [vec, isKey] = value;
+			for (int i = 0; i < vec.size(); i++)			row.doubleMap[name + std::to_string(i)] = vec[i];
+		}
+
+		row.key = storeKey(keyFields);
+
+		rowList.push_back(std::move(row));
+	}
+
+	if (rowList.empty())
+	{
+		return;
+	}
+
+	string block = encodeWriteBlock(collection, rowList);
+
+	std::lock_guard<std::mutex> guard(storeMutex);
+
+	StoreFileLock fileLock(filename);
+
+	refresh();
+
+	for (auto& row : rowList)
+	{
+		insert(collection, storeKeyFields(row.key), row.time, row.doubleMap, row.stringMap);
+	}
+
+	appendBlock(block);
+}
+
+/** Get the series of a collection whose key fields match all of those in a filter
+ */
+vector<StoreSeries*> TimeSeriesStore::matchingSeries(
+	const string&				collection,
+	const map<string, string>&	keyFilter)
+{
+	vector<StoreSeries*> seriesList;
+
+	auto collIt = collectionMap.find(collection);
+	if (collIt == collectionMap.end())
+	{
+		return seriesList;
+	}
+
+	auto& seriesMap = collIt->second;
+
+	//a filter with every key field goes straight to its series through the index
+	auto it = seriesMap.find(storeKey(keyFilter));
+	if	(  it != seriesMap.end()
+		&& it->second.keyFields.size() == keyFilter.size())
+	{
+		seriesList.push_back(&it->second);
+
+		return seriesList;
+	}
+
+	for (auto& [key, series] : seriesMap)
+	{
+		bool match = true;
+		for (auto& [name, value] : keyFilter)
+		{
+			auto fieldIt = series.keyFields.find(name);
+			if	(  fieldIt == series.keyFields.end()
+				|| fieldIt->second != value)
+			{
+				match = false;
+				break;
+			}
+		}
+
+		if (match)
+		{
+			seriesList.push_back(&series);
+		}
+	}
+
+	return seriesList;
+}
+
+/** Find rows of a collection with key fields matching a filter, between two times inclusive.
+ * Times that are not set leave the range open on that side.
+ * Rows are returned in time order, or reverse time order, up to the limit if one is given
+ */
+vector<StoreRow> TimeSeriesStore::find(
+	const string&				collection,
+	const map<string, string>&	keyFilter,
+	GTime						begin,
+	GTime						end,
+	int							limit,
+	bool						reverse)
+{
+	std::lock_guard<std::mutex> guard(storeMutex);
+
+	refresh();
+
+	vector<StoreRow> rowList;
+
+	for (auto series_ptr : matchingSeries(collection, keyFilter))
+	{
+		auto& series	= *series_ptr;
+		auto& indexMap	= series.timeIndexMap;
+
+		auto first	= indexMap.begin();
+		auto last	= indexMap.end();
+
+		if (begin	!= GTime::noTime())		first	= indexMap.lower_bound(begin);
+		if (end		!= GTime::noTime())		last	= indexMap.upper_bound(end);
+
+		int count = 0;
+
+		if (reverse == false)
+		{
+			for (auto it = first; it != last; it++)
+			{
+				if (limit >= 0 && count++ >= limit)
+					break;
+
+				rowList.push_back(series.getRow(it->second));
+			}
+		}
+		else
+		{
+			for (auto it = std::make_reverse_iterator(last); it != std::make_reverse_iterator(first); it++)
+			{
+				if (limit >= 0 && count++ >= limit)
+					break;
+
+				rowList.push_back(series.getRow(it->second));
+			}
+		}
+	}
+
+	std::stable_sort(rowList.begin(), rowList.end(), [reverse](const StoreRow& a, const StoreRow& b)
+	{
+		if (reverse)	return a.time > b.time;
+		else			return a.time < b.time;
+	});
+
+	if	(  limit >= 0
+		&& rowList.size() > limit)
+	{
+		rowList.resize(limit);
+	}
+
+	return rowList;
+}
+
+/** Find the most recent row of each series of a collection with key fields matching a filter
+ */
+vector<StoreRow> TimeSeriesStore::findLatest(
+	const string&				collection,
+	const map<string, string>&	keyFilter)
+{
+	std::lock_guard<std::mutex> guard(storeMutex);
+
+	refresh();
+
+	vector<StoreRow> rowList;
+
+	for (auto series_ptr : matchingSeries(collection, keyFilter))
+	{
+		auto& series = *series_ptr;
+
+		if (series.timeIndexMap.empty())
+			continue;
+
+		rowList.push_back(series.getRow(series.timeIndexMap.rbegin()->second));
+	}
+
+	return rowList;
+}
+
+/** Remove the rows of a collection from before a time, from memory only
+ */
+void TimeSeriesStore::removeBefore(
+	const string&	collection,
+	GTime			time)
+{
+	auto collIt = collectionMap.find(collection);
+	if (collIt == collectionMap.end())
+	{
+		return;
+	}
+
+	auto& seriesMap = collIt->second;
+
+	for (auto it = seriesMap.begin(); it != seriesMap.end(); )
+	{
+		auto& series = it->second;
+
+		vector<int> keepList;
+		for (int row = 0; row < series.timeList.size(); row++)
+		{
+			if (series.timeList[row] >= time)
+				keepList.push_back(row);
+		}
+
+		int numRemoved = series.timeList.size() - keepList.size();
+
+		numRows		-= numRemoved;
+		numCulled	+= numRemoved;
+
+		if (keepList.empty())
+		{
+			it = seriesMap.erase(it);
+			continue;
+		}
+
+		if (numRemoved > 0)
+		{
+			StoreSeries kept;
+			kept.keyFields = series.keyFields;
+
+			for (int row : keepList)
+			{
+				kept.timeIndexMap[series.timeList[row]] = kept.timeList.size();
+				kept.timeList.push_back(series.timeList[row]);
+			}
+
+			for (auto& [name, column] : series.doubleColumns)		for (int row : keepList)	kept.doubleColumns[name].push_back(column[row]);
+			for (auto& [name, column] : series.stringColumns)		for (int row : keepList)	kept.stringColumns[name].push_back(column[row]);
+
+			series = std::move(kept);
+		}
+
+		it++;
+	}
+}
+
+/** Rewrite the file with only the rows that are currently held, once more has been culled than is held.
+ * The file is replaced rather than rewritten in place, so that readers in other processes see a new file and reload it.
+ * Must be called with the store's lock file held
+ */
+void TimeSeriesStore::compact()
+{
+	string tempFilename = filename + ".tmp";
+	{
+		std::ofstream outputStream(tempFilename, std::ios::binary | std::ios::trunc);
+		if (!outputStream)
+		{
+			return;
+		}
+
+		for (auto& [collection, seriesMap] : collectionMap)
+		{
+			vector<StoreBlockRow> rowList;
+
+			for (auto& [key, series] : seriesMap)
+			for (int row = 0; row < series.timeList.size(); row++)
+			{
+				StoreRow storeRow = series.getRow(row);
+
+				StoreBlockRow blockRow;
+				blockRow.key		= key;
+				blockRow.time		= storeRow.time;
+				blockRow.doubleMap	= std::move(storeRow.doubleMap);
+
+				for (auto& [name, value] : storeRow.stringMap)
+				{
+					if (series.keyFields.count(name) == 0)
+						blockRow.stringMap[name] = value;
+				}
+
+				rowList.push_back(std::move(blockRow));
+			}
+
+			string		block	= encodeWriteBlock(collection, rowList);
+			uint64_t	length	= block.size();
+
+			outputStream.write(STORE_BLOCK_MAGIC,	4);
+			outputStream.write((char*) &length,		sizeof(length));
+			outputStream.write(block.data(),		block.size());
+		}
+	}
+
+	std::rename(tempFilename.c_str(), filename.c_str());
+
+	std::ifstream inputStream(filename, std::ios::binary | std::ios::ate);
+
+	readPos		= inputStream.tellg();
+	numCulled	= 0;
+
+	recordFileIdentity();
+}
+
+/** Remove the rows of a collection from before a time, to limit the size of long running stores
+ */
+void TimeSeriesStore::cull(
+	const string&	collection,
+	GTime			time)
+{
+	std::lock_guard<std::mutex> guard(storeMutex);
+
+	StoreFileLock fileLock(filename);
+
+	refresh();
+
+	removeBefore(collection, time);
+
+	if (numCulled > numRows)
+	{
+		compact();
+		return;
+	}
+
+	string block;
+	block += STORE_BLOCK_CULL;
+	putString(block, collection);
+	putDouble(block, time.bigTime);
+
+	appendBlock(block);
+}
+
+/** Get the store for a file, opening it if it is not already open, so that all users of a file share one store
+ */
+TimeSeriesStore* openTimeSeriesStore(
+	string	filename,
+	bool	deleteHistory)
+{
+	static std::mutex								storeListMutex;
+	static map<string, TimeSeriesStore*>			storeMap;
+
+	std::lock_guard<std::mutex> guard(storeListMutex);
+
+	auto& store_ptr = storeMap[filename];
+
+	if (store_ptr == nullptr)
+	{
+		store_ptr = new TimeSeriesStore(filename, deleteHistory);
+	}
+
+	return store_ptr;
+}
@@ -0,0 +1,156 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <tuple>
+#include <mutex>
+#include <map>
+
+using std::string;
+using std::vector;
+using std::deque;
+using std::tuple;
+using std::map;
+
+#include "eigenIncluder.hpp"
+#include "gTime.hpp"
+
+
+/** Document to be written to a database.
+ * Fields flagged true are keys that identify the document, the others are values that are updated
+ */
+struct DBEntry
+{
+	map<string, tuple<string,			bool>>		stringMap;
+	map<string, tuple<GTime,			bool>>		timeMap;
+	map<string, tuple<double,			bool>>		doubleMap;
+	map<string, tuple<int,				bool>>		intMap;
+	map<string, tuple<Vector3d,			bool>>		vectorMap;
+	map<string, tuple<vector<double>,	bool>>		doubleArrayMap;
+	map<string, tuple<vector<int>,		bool>>		intArrayMap;
+	map<string, tuple<deque<bool>,		bool>>		boolArrayMap;
+};
+
+/** Row of a time series as returned from a query, with its key fields included alongside its values
+ */
+struct StoreRow
+{
+	GTime					time;				///< Time of the row (key time field)
+	map<string, double>		doubleMap;			///< Numeric fields, including integers, times, and expanded vectors and arrays
+	map<string, string>		stringMap;			///< Text fields, including the key fields of the series
+
+	double	getDouble(
+		const string&	name,
+		double			defaultValue = 0)
+	const;
+
+	int		getInt(
+		const string&	name,
+		int				defaultValue = 0)
+	const;
+
+	string	getString(
+		const string&	name)
+	const;
+
+	GTime	getTime(
+		const string&	name)
+	const;
+};
+
+/** Single time series of a collection, identified by the values of its key fields.
+ * Rows are stored column-wise, with an index from time to row
+ */
+struct StoreSeries
+{
+	map<string, string>				keyFields;			///< Values of the key fields that identify this series
+	vector<GTime>					timeList;			///< Time of each row
+	map<GTime, int>					timeIndexMap;		///< Index from time to row
+	map<string, vector<double>>		doubleColumns;		///< Numeric fields, NaN where not set for a row
+	map<string, vector<string>>		stringColumns;		///< Text fields, empty where not set for a row
+
+	int		row(
+		GTime	time);
+
+	StoreRow getRow(
+		int		row)
+	const;
+};
+
+/** Embedded, file-backed time series store, as an alternative to a mongo database.
+ * Data is indexed by collection, key, and time, and written to file as columnar blocks, one per batch of writes.
+ * The file is append only, so that other processes (eg ssr generation) may open the same file and follow it as it is written.
+ * Writers in any process are serialised by a lock file alongside the store
+ */
+struct TimeSeriesStore
+{
+	string											filename;
+	std::mutex										storeMutex;
+	map<string, map<string, StoreSeries>>			collectionMap;		///< Series of each collection, by their key
+	long int										readPos		= 0;	///< Position in the file that has been loaded up to
+	long int										numCulled	= 0;	///< Number of rows removed since the file was last compacted
+	long int										numRows		= 0;	///< Number of rows currently held
+	long int										fileDevice	= -1;	///< Device of the file that has been loaded, to detect it being replaced by a compaction
+	long int										fileInode	= -1;	///< Inode of the file that has been loaded, to detect it being replaced by a compaction
+
+	TimeSeriesStore(
+		string	filename,
+		bool	deleteHistory);
+
+	void write(
+		const string&		collection,
+		vector<DBEntry>&	entryList);
+
+	vector<StoreRow> find(
+		const string&				collection,
+		const map<string, string>&	keyFilter,
+		GTime						begin		= GTime::noTime(),
+		GTime						end			= GTime::noTime(),
+		int							limit		= -1,
+		bool						reverse		= false);
+
+	vector<StoreRow> findLatest(
+		const string&				collection,
+		const map<string, string>&	keyFilter);
+
+	void cull(
+		const string&	collection,
+		GTime			time);
+
+	void refresh();
+
+private:
+
+	void readBlocks();
+
+	void recordFileIdentity();
+
+	void applyBlock(
+		const string&	block);
+
+	void appendBlock(
+		const string&	block);
+
+	void compact();
+
+	void insert(
+		const string&				collection,
+		const map<string, string>&	keyFields,
+		GTime						time,
+		const map<string, double>&	doubleMap,
+		const map<string, string>&	stringMap);
+
+	void removeBefore(
+		const string&	collection,
+		GTime			time);
+
+	vector<StoreSeries*> matchingSeries(
+		const string&				collection,
+		const map<string, string>&	keyFilter);
+};
+
+TimeSeriesStore* openTimeSeriesStore(
+	string	filename,
+	bool	deleteHistory = false);
@@ -54,23 +54,127 @@ void tracepdeex(int level, Trace& stream, string const& fmt, Arguments&&... args
 }
 
 
-template<typename T>
-std::ofstream getTraceFile(
-	T& thing)
+#define TRACE_BLOCK_SIZE	4096		///< Size of the in-memory block that trace output is collected in before being submitted
+
+/** Stream buffer that collects trace output in memory and hands it to the background trace writer.
+ * Output is submitted whenever the stream is flushed, or when the block is full
+ */
+struct TraceBuffer : std::streambuf
 {
-	if (thing.traceFilename.empty())
+	const string*	filename_ptr = nullptr;		///< Interned name of the file this buffer writes to
+	vector<char>	block;						///< Output that has not yet been submitted
+
+	TraceBuffer() = default;
+
+	TraceBuffer(
+		const string*	filename_ptr)
+	:	filename_ptr	(filename_ptr),
+		block			(TRACE_BLOCK_SIZE)
+	{
+		setp(block.data(), block.data() + block.size());
+	}
+
+	TraceBuffer(
+		TraceBuffer&&	other)
+	:	std::streambuf	(other),
+		filename_ptr	(other.filename_ptr),
+		block			(std::move(other.block))
+	{
+		other.filename_ptr = nullptr;
+		other.setp(nullptr, nullptr);
+	}
+
+	TraceBuffer& operator=(
+		TraceBuffer&&	other)
+	{
+		submit();
+
+		std::streambuf::operator=(other);
+		filename_ptr	= other.filename_ptr;
+		block			= std::move(other.block);
+
+		other.filename_ptr = nullptr;
+		other.setp(nullptr, nullptr);
+
+		return *this;
+	}
+
+	~TraceBuffer()
+	{
+		submit();
+	}
+
+	void submit();
+
+protected:
+	int overflow(
+		int c)
+	override;
+
+	int sync()
+	override;
+};
+
+/** Output stream for trace files, which are written asynchronously by a background thread.
+ * Default constructed streams have no buffer, and silently discard all output
+ */
+struct TraceStream : std::ostream
+{
+	TraceBuffer	buffer;
+
+	TraceStream()
+	:	std::ostream(nullptr)
+	{
+
+	}
+
+	TraceStream(
+		const string&	filename);
+
+	TraceStream(
+		TraceStream&&	other)
+	:	std::ostream	(std::move(other)),
+		buffer			(std::move(other.buffer))
 	{
-		return std::ofstream();
+		if (buffer.filename_ptr)
+			set_rdbuf(&buffer);
 	}
 
-	std::ofstream trace(thing.traceFilename, std::ios::app);
-	if (!trace)
+	TraceStream& operator=(
+		TraceStream&&	other)
+	{
+		buffer.submit();
+
+		std::ostream::operator=(std::move(other));
+		buffer = std::move(other.buffer);
+
+		if (buffer.filename_ptr)	set_rdbuf(&buffer);
+		else						set_rdbuf(nullptr);
+
+		return *this;
+	}
+};
+
+void submitTraceRecord(
+	const string*	filename_ptr,
+	const string&	data);
+
+void submitTraceRecord(
+	const string&	filename,
+	const string&	data);
+
+void flushTraceWriter();
+
+template<typename T>
+TraceStream getTraceFile(
+	T& thing)
+{
+	if (thing.traceFilename.empty())
 	{
-		BOOST_LOG_TRIVIAL(error)
-		<< "Error: Could not open trace file for " << thing.id << " at " << thing.traceFilename;
+		return TraceStream();
 	}
 
-	return trace;
+	return TraceStream(thing.traceFilename);
 }
 
 void printHex(
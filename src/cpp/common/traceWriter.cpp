@@ -0,0 +1,733 @@
+
+// #pragma GCC optimize ("O0")
+
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+#include <exception>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using std::unordered_map;
+using std::unordered_set;
+using std::unique_ptr;
+
+#include "instrument.hpp"
+#include "trace.hpp"
+
+
+#define TRACE_PENDING_BYTES		(64 * 1024 * 1024)	///< Maximum number of bytes waiting to be written before producers are held back
+#define TRACE_WAIT_MS			1000				///< Longest time a producer is held back before its output is dropped
+#define TRACE_IDLE_SECONDS		30					///< Time after the last write that a file's handle is closed, so that rotated files are released
+#define TRACE_MAX_SIGNAL_BUFFERS	256					///< Most thread buffers that are written in order from a fatal signal handler, any others are written after them
+
+
+/** Trace output collected by a single thread.
+ * The data of all records is kept in one block, so that submitting output does not allocate once the block has grown
+ */
+struct TraceRecords
+{
+	struct Entry
+	{
+		long int		seq;				///< Order that the record was submitted in, across all threads
+		const string*	filename_ptr;		///< Interned name of the file to write to
+		size_t			offset;				///< Start of the record's data in the block
+		size_t			length;				///< Length of the record's data
+	};
+
+	vector<Entry>	entryList;
+	string			data;
+
+	void clear()
+	{
+		entryList	.clear();
+		data		.clear();
+	}
+};
+
+/** Buffer of trace output belonging to one thread, shared only between that thread and the writer
+ */
+struct ThreadTraceBuffer
+{
+	std::mutex			mutex;
+	TraceRecords		records;
+	std::atomic<bool>	finished	= false;	///< The owning thread has exited, the buffer may be released once drained
+};
+
+/** Handle of a file being written by the trace writer
+ */
+struct TraceFile
+{
+	std::ofstream							stream;
+	std::chrono::steady_clock::time_point	lastWrite;		///< Time of the most recent write, used to close idle files
+};
+
+/** Background writer for trace files.
+ * Each thread collects records in its own buffer, which a single writer thread swaps out and writes in submission order, keeping each file open.
+ * The writer thread sleeps until a producer adds to an empty queue, or until idle files are due to be closed.
+ * Everything pending is written at exit and on std::terminate, after which records are written synchronously.
+ * SIGINT and SIGTERM are taken by a dedicated thread that writes everything pending before the program is stopped,
+ * fatal signals write what they can of the queued records with plain system calls before the program is taken down.
+ * The writer is never destroyed, so that records submitted during static destruction are not lost
+ */
+struct TraceWriter
+{
+	std::atomic<long int>						sequence		= 0;
+	std::atomic<long int>						pendingBytes	= 0;
+	std::atomic<long int>						droppedBytes	= 0;	///< Output discarded while the writer could not keep up, reported by the writer
+	std::atomic<bool>							running			= true;
+
+	std::mutex									bufferListMutex;
+	vector<unique_ptr<ThreadTraceBuffer>>		bufferList;		///< Buffers of all threads that have submitted records
+
+	std::mutex									writeMutex;		///< Held while records are written, so that a final drain does not race the writer thread
+	unordered_map<const string*, TraceFile>		fileMap;		///< Long-lived handles of files being written
+	vector<TraceRecords>						drainList;		///< Records taken from the threads, kept between drains to be swapped back as empty blocks
+
+	std::mutex									drainedMutex;
+	std::condition_variable						drainedCondition;	///< Notified after each drain, for producers that are held back
+
+	std::mutex									pendingMutex;
+	std::condition_variable						pendingCondition;	///< Notified when records are added to an empty queue, or when the writer is stopped
+
+	std::mutex									filenameMutex;
+	unordered_set<string>						filenameSet;	///< Interned filenames, never removed so that records may refer to them by pointer
+
+	std::thread									thread;
+	std::thread									signalThread;
+
+	TraceWriter();
+
+	void stop();
+
+	void notify();
+
+	const string* internFilename(
+		const string&	filename);
+
+	ThreadTraceBuffer& threadBuffer();
+
+	void push(
+		const string*	filename_ptr,
+		const char*		data,
+		size_t			length);
+
+	void write(
+		const string*	filename_ptr,
+		const char*		data,
+		size_t			length);
+
+	bool drain();
+
+	void run();
+
+	void waitSignals();
+};
+
+TraceWriter& getTraceWriter();
+
+std::terminate_handler previousTerminateHandler = nullptr;
+
+/** Write everything pending before an unhandled exception takes the program down, then defer to the previous handler
+ */
+void traceTerminateHandler()
+{
+	auto& writer = getTraceWriter();
+
+	if (writer.writeMutex.try_lock())
+	{
+		writer.drain();
+		writer.writeMutex.unlock();
+	}
+
+	if (previousTerminateHandler)	previousTerminateHandler();
+	else							std::abort();
+}
+
+/** Stop the writer thread and write everything pending when the program exits
+ */
+void stopTraceWriter()
+{
+	getTraceWriter().stop();
+}
+
+volatile sig_atomic_t traceFatalSignalRaised = 0;
+
+/** Write a block of data to a file using only async-signal-safe calls
+ */
+void writeTraceSignalSafe(
+	const string*	filename_ptr,
+	const char*		data,
+	size_t			length)
+{
+	int fd = open(filename_ptr->c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+	if (fd < 0)
+		return;
+
+	while (length > 0)
+	{
+		ssize_t bytes = ::write(fd, data, length);
+		if (bytes <= 0)
+			break;
+
+		data	+= bytes;
+		length	-= bytes;
+	}
+
+	close(fd);
+}
+
+/** Write what can be written of the queued records before a fatal signal takes the program down, then re-raise it.
+ * No locks can be taken here, so this is best effort: records that another thread is adding, or that the writer thread has already taken, may be lost
+ */
+void traceFatalSignalHandler(
+	int	signal)
+{
+	if (traceFatalSignalRaised == 0)
+	{
+		traceFatalSignalRaised = 1;
+
+		auto& bufferList = getTraceWriter().bufferList;
+
+		//merge the buffers by sequence number, using only stack memory
+		size_t	cursorList[TRACE_MAX_SIGNAL_BUFFERS] = {};
+		size_t	numBuffers = std::min(bufferList.size(), (size_t) TRACE_MAX_SIGNAL_BUFFERS);
+
+		while (true)
+		{
+			int		next	= -1;
+			long int	nextSeq	= 0;
+
+			for (int i = 0; i < numBuffers; i++)
+			{
+				auto& records = bufferList[i]->records;
+
+				if (cursorList[i] >= records.entryList.size())
+					continue;
+
+				long int seq = records.entryList[cursorList[i]].seq;
+				if	(  next < 0
+					|| seq < nextSeq)
+				{
+					next	= i;
+					nextSeq	= seq;
+				}
+			}
+
+			if (next < 0)
+				break;
+
+			auto& records	= bufferList[next]->records;
+			auto& entry		= records.entryList[cursorList[next]];
+
+			writeTraceSignalSafe(entry.filename_ptr, records.data.data() + entry.offset, entry.length);
+
+			cursorList[next]++;
+		}
+
+		for (size_t i = numBuffers; i < bufferList.size(); i++)
+		{
+			auto& records = bufferList[i]->records;
+
+			for (auto& entry : records.entryList)
+			{
+				writeTraceSignalSafe(entry.filename_ptr, records.data.data() + entry.offset, entry.length);
+			}
+		}
+	}
+
+	::signal(signal, SIG_DFL);
+	raise(signal);
+}
+
+TraceWriter::TraceWriter()
+{
+	previousTerminateHandler = std::set_terminate(traceTerminateHandler);
+
+	std::atexit(stopTraceWriter);
+
+	//interrupts are blocked in every thread created from here on and taken by the signal thread instead,
+	//the writer is created during static initialisation so that this precedes any worker threads
+	sigset_t signalSet;
+	sigemptyset(&signalSet);
+	sigaddset(&signalSet, SIGINT);
+	sigaddset(&signalSet, SIGTERM);
+
+	pthread_sigmask(SIG_BLOCK, &signalSet, nullptr);
+
+	for (int signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT})
+	{
+		struct sigaction action = {};
+		action.sa_handler = traceFatalSignalHandler;
+		sigemptyset(&action.sa_mask);
+
+		sigaction(signal, &action, nullptr);
+	}
+
+	thread			= std::thread(&TraceWriter::run,			this);
+	signalThread	= std::thread(&TraceWriter::waitSignals,	this);
+
+	signalThread.detach();
+}
+
+/** Join the writer thread and write out everything pending, later records are written synchronously
+ */
+void TraceWriter::stop()
+{
+	running = false;
+
+	notify();
+
+	if (thread.joinable())
+		thread.join();
+
+	std::lock_guard<std::mutex> guard(writeMutex);
+
+	drain();
+
+	fileMap.clear();
+}
+
+/** Wake the writer thread
+ */
+void TraceWriter::notify()
+{
+	//taking the mutex orders this with the writer's check of its wait condition, so that the notification cannot be missed
+	{
+		std::lock_guard<std::mutex> guard(pendingMutex);
+	}
+
+	pendingCondition.notify_one();
+}
+
+/** Get a pointer to a shared copy of a filename, which remains valid for the life of the program
+ */
+const string* TraceWriter::internFilename(
+	const string&	filename)
+{
+	std::lock_guard<std::mutex> guard(filenameMutex);
+
+	auto [it, inserted] = filenameSet.insert(filename);
+
+	return &*it;
+}
+
+thread_local ThreadTraceBuffer*	threadTraceBuffer_ptr	= nullptr;	///< Trivially destructible, so that it remains usable while the thread is exiting
+thread_local bool				threadTraceExited		= false;
+
+/** Marks a thread's buffer as finished when the thread exits, so that the writer can release it
+ */
+struct ThreadTraceHandle
+{
+	~ThreadTraceHandle()
+	{
+		if (threadTraceBuffer_ptr)
+			threadTraceBuffer_ptr->finished = true;
+
+		threadTraceBuffer_ptr	= nullptr;
+		threadTraceExited		= true;
+	}
+};
+
+/** Get the buffer of the calling thread, registering a new one with the writer on first use
+ */
+ThreadTraceBuffer& TraceWriter::threadBuffer()
+{
+	if (threadTraceBuffer_ptr)
+		return *threadTraceBuffer_ptr;
+
+	threadTraceBuffer_ptr = new ThreadTraceBuffer;
+	{
+		std::lock_guard<std::mutex> guard(bufferListMutex);
+
+		bufferList.push_back(unique_ptr<ThreadTraceBuffer>(threadTraceBuffer_ptr));
+	}
+
+	if (threadTraceExited == false)
+	{
+		thread_local ThreadTraceHandle handle;
+		(void) handle;
+	}
+
+	return *threadTraceBuffer_ptr;
+}
+
+/** Add a record to the calling thread's buffer.
+ * If too much output is already pending, waits a bounded time for the writer to catch up before dropping the record
+ */
+void TraceWriter::push(
+	const string*	filename_ptr,
+	const char*		data,
+	size_t			length)
+{
+	if (running == false)
+	{
+		write(filename_ptr, data, length);
+
+		return;
+	}
+
+	//the writer thread must never wait on itself
+	if	(  pendingBytes + (long int) length > TRACE_PENDING_BYTES
+		&& std::this_thread::get_id() != thread.get_id())
+	{
+		std::unique_lock<std::mutex> lock(drainedMutex);
+
+		bool fits = drainedCondition.wait_for(lock, std::chrono::milliseconds(TRACE_WAIT_MS), [&]
+		{
+			return pendingBytes + (long int) length <= TRACE_PENDING_BYTES
+				|| running == false;
+		});
+
+		if (fits == false)
+		{
+			droppedBytes += length;
+
+			return;
+		}
+	}
+
+	long int previousBytes;
+
+	auto& buffer = threadBuffer();
+	{
+		std::lock_guard<std::mutex> guard(buffer.mutex);
+
+		auto& records = buffer.records;
+
+		records.entryList.push_back({sequence++, filename_ptr, records.data.size(), length});
+		records.data.append(data, length);
+
+		previousBytes = pendingBytes.fetch_add(length);
+	}
+
+	//the writer only sleeps once everything pending is written, so only the first record after that needs to wake it
+	if (previousBytes == 0)
+	{
+		notify();
+	}
+
+	//the writer may have stopped while this record was being added, make sure it is not left behind
+	if (running == false)
+	{
+		std::lock_guard<std::mutex> guard(writeMutex);
+
+		drain();
+	}
+}
+
+/** Append a record to its file directly, for records submitted after the writer has stopped
+ */
+void TraceWriter::write(
+	const string*	filename_ptr,
+	const char*		data,
+	size_t			length)
+{
+	std::lock_guard<std::mutex> guard(writeMutex);
+
+	std::ofstream file(*filename_ptr, std::ios::app);
+
+	file.write(data, length);
+}
+
+/** Write all records collected by the threads to their files, returns true if anything was written.
+ * Must be called with the writeMutex held.
+ * Errors are reported directly to stderr, as logging from here would feed back into the writer
+ */
+bool TraceWriter::drain()
+{
+	vector<ThreadTraceBuffer*> bufferPtrList;
+	{
+		std::lock_guard<std::mutex> guard(bufferListMutex);
+
+		for (auto& buffer_ptr : bufferList)
+		{
+			bufferPtrList.push_back(buffer_ptr.get());
+		}
+	}
+
+	drainList.resize(std::max(drainList.size(), bufferPtrList.size()));
+
+	//swap each thread's records for an emptied block from the previous drain
+	for (int i = 0; i < bufferPtrList.size(); i++)
+	{
+		auto& buffer = *bufferPtrList[i];
+
+		std::lock_guard<std::mutex> guard(buffer.mutex);
+
+		std::swap(buffer.records, drainList[i]);
+	}
+
+	//restore the order that records were submitted in, as a file may be written by different threads across epochs
+	struct Position
+	{
+		long int	seq;
+		int			list;
+		int			entry;
+	};
+
+	vector<Position> positionList;
+	for (int i = 0; i < bufferPtrList.size(); i++)
+	for (int j = 0; j < drainList[i].entryList.size(); j++)
+	{
+		positionList.push_back({drainList[i].entryList[j].seq, i, j});
+	}
+
+	std::sort(positionList.begin(), positionList.end(), [](const Position& a, const Position& b)
+	{
+		return a.seq < b.seq;
+	});
+
+	auto now = std::chrono::steady_clock::now();
+
+	long int written = 0;
+
+	for (auto& position : positionList)
+	{
+		auto& records	= drainList[position.list];
+		auto& entry		= records.entryList[position.entry];
+
+		auto& traceFile = fileMap[entry.filename_ptr];
+		auto& file		= traceFile.stream;
+
+		if (file.is_open() == false)
+		{
+			file.open(*entry.filename_ptr, std::ios::app);
+
+			if (!file)
+			{
+				std::cerr << "Error: Could not open trace file at " << *entry.filename_ptr << std::endl;
+			}
+		}
+
+		file.write(records.data.data() + entry.offset, entry.length);
+
+		traceFile.lastWrite = now;
+
+		written += entry.length;
+	}
+
+	for (auto& records : drainList)
+	{
+		records.clear();
+	}
+
+	bool wrote = (positionList.empty() == false);
+
+	if (wrote)
+	{
+		for (auto& [filename_ptr, traceFile] : fileMap)
+		{
+			traceFile.stream.flush();
+		}
+
+		pendingBytes -= written;
+
+		std::lock_guard<std::mutex> guard(drainedMutex);
+
+		drainedCondition.notify_all();
+	}
+
+	long int dropped = droppedBytes.exchange(0);
+	if (dropped)
+	{
+		std::cerr << "Warning: " << dropped << " bytes of trace output were dropped while the trace writer was behind" << std::endl;
+	}
+
+	//release buffers of threads that have exited, their records have all been taken above
+	{
+		std::lock_guard<std::mutex> guard(bufferListMutex);
+
+		bufferList.erase(std::remove_if(bufferList.begin(), bufferList.end(), [](const unique_ptr<ThreadTraceBuffer>& buffer_ptr)
+		{
+			return buffer_ptr->finished
+				&& buffer_ptr->records.entryList.empty();
+		}), bufferList.end());
+	}
+
+	//release handles of files that are no longer being written to
+	for (auto it = fileMap.begin(); it != fileMap.end(); )
+	{
+		auto& traceFile = it->second;
+
+		if (now - traceFile.lastWrite > std::chrono::seconds(TRACE_IDLE_SECONDS))
+		{
+			it = fileMap.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	return wrote;
+}
+
+/** Main loop of the writer thread
+ */
+void TraceWriter::run()
+{
+	while (running)
+	{
+		{
+			std::lock_guard<std::mutex> guard(writeMutex);
+
+			drain();
+		}
+
+		//wake periodically even when nothing is written, so that idle files are closed
+		std::unique_lock<std::mutex> lock(pendingMutex);
+
+		pendingCondition.wait_for(lock, std::chrono::seconds(TRACE_IDLE_SECONDS), [&]
+		{
+			return pendingBytes > 0
+				|| running == false;
+		});
+	}
+}
+
+/** Main loop of the signal thread.
+ * Waits for an interrupt or termination request, writes everything pending, and then lets the signal stop the program as it would have
+ */
+void TraceWriter::waitSignals()
+{
+	sigset_t signalSet;
+	sigemptyset(&signalSet);
+	sigaddset(&signalSet, SIGINT);
+	sigaddset(&signalSet, SIGTERM);
+
+	int signal = 0;
+	if (sigwait(&signalSet, &signal) != 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(writeMutex);
+
+		drain();
+
+		fileMap.clear();
+	}
+
+	::signal(signal, SIG_DFL);
+
+	pthread_sigmask(SIG_UNBLOCK, &signalSet, nullptr);
+
+	raise(signal);
+}
+
+/** Get the trace writer, which is created on first use and intentionally never destroyed
+ */
+TraceWriter& getTraceWriter()
+{
+	static TraceWriter* traceWriter_ptr = new TraceWriter;
+
+	return *traceWriter_ptr;
+}
+
+TraceWriter& startupTraceWriter = getTraceWriter();		///< Created during static initialisation, so that interrupts are blocked before any other threads are started
+
+/** Queue output to be appended to a file by the background writer
+ */
+void submitTraceRecord(
+	const string*	filename_ptr,	///< Interned name of the file to write to
+	const string&	data)			///< Output to write
+{
+	if	(  filename_ptr == nullptr
+		|| data.empty())
+	{
+		return;
+	}
+
+	Instrument::count("bytes written", data.size());
+
+	getTraceWriter().push(filename_ptr, data.data(), data.size());
+}
+
+/** Queue output to be appended to a file by the background writer
+ */
+void submitTraceRecord(
+	const string&	filename,		///< Name of the file to write to
+	const string&	data)			///< Output to write
+{
+	if (filename.empty())
+		return;
+
+	submitTraceRecord(getTraceWriter().internFilename(filename), data);
+}
+
+/** Block until everything that has been submitted so far is written to file
+ */
+void flushTraceWriter()
+{
+	auto& writer = getTraceWriter();
+
+	std::lock_guard<std::mutex> guard(writer.writeMutex);
+
+	writer.drain();
+}
+
+/** Stream that writes to a trace file, or that discards all output if no filename is given
+ */
+TraceStream::TraceStream(
+	const string&	filename)
+:	std::ostream	(nullptr)
+{
+	if (filename.empty())
+		return;
+
+	buffer = TraceBuffer(getTraceWriter().internFilename(filename));
+
+	rdbuf(&buffer);
+}
+
+/** Hand the collected output to the writer and start a new block
+ */
+void TraceBuffer::submit()
+{
+	if	(  filename_ptr == nullptr
+		|| pptr() == pbase())
+	{
+		return;
+	}
+
+	Instrument::count("bytes written", pptr() - pbase());
+
+	getTraceWriter().push(filename_ptr, pbase(), pptr() - pbase());
+
+	setp(block.data(), block.data() + block.size());
+}
+
+int TraceBuffer::overflow(
+	int c)
+{
+	if (filename_ptr == nullptr)
+		return traits_type::eof();
+
+	submit();
+
+	if (c != traits_type::eof())
+	{
+		*pptr() = c;
+		pbump(1);
+	}
+
+	return traits_type::not_eof(c);
+}
+
+int TraceBuffer::sync()
+{
+	submit();
+
+	return 0;
+}
@@ -26,22 +26,6 @@ map<string, long> endLinePos;
 
 static int ionexMapIndex = 0;
 
-double ionVtec(
-	GTime		time,
-	VectorPos&	ionPP,
-	int			layer,
-	double&		vtecstd,
-	KFState&	kfState)
-{
-	switch (acsConfig.ionModelOpts.model)
-	{
-		case E_IonoModel::SPHERICAL_HARMONICS:		return ionVtecSphhar(time, ionPP, layer, vtecstd, kfState);
-		case E_IonoModel::SPHERICAL_CAPS:			return ionVtecSphcap(time, ionPP, layer, vtecstd, kfState);
-		case E_IonoModel::BSPLINE:					return ionVtecBsplin(time, ionPP, layer, vtecstd, kfState);
-		default:									return 0;
-	}
-}
-
 bool writeIonexHead(
 	Trace& ionex)
 {
@@ -82,6 +66,45 @@ bool writeIonexHead(
 	return true;
 }
 
+/** Writes the values of each layer's map in ionex layout.
+ * Each latitude row is formatted into a single buffer before being written
+ */
+void writeIonexMap(
+	Trace&					ionex,			///< Stream to write to
+	vector<IonoMapGrid>&	gridList,		///< Grids of each layer
+	vector<MatrixXd>&		valueList)		///< Values to write for each layer, in ionex units
+{
+	for (int ihgt = 0; ihgt < gridList.size();	ihgt++)
+	for (int ilat = 0; ilat < ionex_latres;		ilat++)
+	{
+		auto& grid		= gridList	[ihgt];
+		auto& values	= valueList	[ihgt];
+
+		tracepdeex(0, ionex, "  %6.1f%6.1f%6.1f%6.1f%6.1f%28sLAT/LON1/LON2/DLON/H",
+				grid.latList[ilat],
+				ionex_lonmin,
+				ionex_lonmin + (ionex_lonres - 1) * ionex_loninc,
+				ionex_loninc,
+				acsConfig.ionModelOpts.layer_heights[ihgt] / 1000, " ");
+
+		string	line;
+		char	buff[16];
+
+		for (int ilon = 0; ilon < ionex_lonres; ilon++)
+		{
+			if (ilon % 16 == 0)
+				line += "\n";
+
+			snprintf(buff, sizeof(buff), "%5.0f", values(ilat, ilon));
+			line += buff;
+		}
+
+		line += "\n";
+
+		ionex << line;
+	}
+}
+
 int writeIonexEpoch(
 	Trace&		ionex,
 	GTime		time,
@@ -101,98 +124,63 @@ int writeIonexEpoch(
 	GEpoch ep = time;
 	tracepdeex(4, std::cout, "  ..Writing IONEX epoch:%6.0f%6.0f%6.0f%6.0f%6.0f%6.0f \n", ep[0], ep[1], ep[2], ep[3], ep[4], ep[5]);
 
-	tracepdeex(0, ionex, "%6d%54sSTART OF TEC MAP\n", ionexMapIndex, " ");
-	tracepdeex(0, ionex, "%6.0f%6.0f%6.0f%6.0f%6.0f%6.0f%24sEPOCH OF CURRENT MAP\n", ep[0], ep[1], ep[2], ep[3], ep[4], ep[5], " ");
+	int numLayers = acsConfig.ionModelOpts.layer_heights.size();
 
-	vector<double> tecrmsList;
+	//evaluate all nodes of each layer's map at once, then convert to ionex units
+	vector<IonoMapGrid>	gridList(numLayers);
+	vector<MatrixXd>	tecList	(numLayers);
+	vector<MatrixXd>	rmsList	(numLayers);
 
-	for (int ihgt = 0; ihgt < acsConfig.ionModelOpts.layer_heights.size();	ihgt++)
-	for (int ilat = 0; ilat < ionex_latres;									ilat++)
+	for (int ihgt = 0; ihgt < numLayers; ihgt++)
 	{
-		VectorPos ipp;
-		ipp[0] = ionex_latmin + (ionex_latres - ilat - 1) * ionex_latinc;
-
-		tracepdeex(0, ionex, "  %6.1f%6.1f%6.1f%6.1f%6.1f%28sLAT/LON1/LON2/DLON/H",
-				ipp[0],
-				ionex_lonmin,
-				ionex_lonmin + (ionex_lonres - 1) * ionex_loninc,
-				ionex_loninc,
-				acsConfig.ionModelOpts.layer_heights[ihgt] / 1000, " ");
+		auto& grid = gridList[ihgt];
+		grid.layer = ihgt;
 
-		ipp[0] *= D2R;
+		for (int ilat = 0; ilat < ionex_latres; ilat++)		grid.latList.push_back(ionex_latmin + (ionex_latres - ilat - 1)	* ionex_latinc);
+		for (int ilon = 0; ilon < ionex_lonres; ilon++)		grid.lonList.push_back(ionex_lonmin + ilon						* ionex_loninc);
 
-		for (int ilon = 0; ilon < ionex_lonres; ilon++)
-		{
-			if (ilon % 16 == 0)
-				tracepdeex(0, ionex, "\n");
+		evaluateIonoMap(time, kfState, grid);
 
-			ipp[1] = (ionex_lonmin + ilon * ionex_loninc) * D2R;
+		auto& tec		= tecList[ihgt];
+		auto& tecrms	= rmsList[ihgt];
 
-			double vari;
-			double iono = ionVtec(time, ipp, ihgt, vari, kfState) / pow(10, IONEX_NEXP);
+		tec		= grid.vtec / pow(10, IONEX_NEXP);
+		tecrms	= grid.variance;
 
-			tracepdeex(5, std::cout, "IPP: %8.4f,%9.4f; layr: %1d; delay: %12.6f; var: %.4e\n",
-					ipp[0]*R2D,
-					ipp[1]*R2D,
-					ihgt,
-					iono,
-					vari);
+		if (numLayers == 1)
+			tecrms.array() += SINGL_LAY_ERR;
 
-			if (acsConfig.ionModelOpts.layer_heights.size() == 1) 
-				vari += SINGL_LAY_ERR;
+		tecrms /= pow(10, 2 * IONEX_NEXP);
 
-			double tecrms = vari / pow(10, 2 * IONEX_NEXP);
-
-			if	(  tecrms >  9999
-				|| tecrms <= 0 )
+		for (int ilat = 0; ilat < ionex_latres; ilat++)
+		for (int ilon = 0; ilon < ionex_lonres; ilon++)
+		{
+			if	(  tecrms(ilat, ilon) >  9999
+				|| tecrms(ilat, ilon) <= 0 )
 			{
-				tecrms = 9999;
+				tecrms(ilat, ilon) = 9999;
 			}
 
-			if	(  iono > +9999
-				|| iono < -9999)
+			if	(  tec(ilat, ilon) > +9999
+				|| tec(ilat, ilon) < -9999)
 			{
-				iono	= 9999;
-				tecrms	= 9999;
+				tec		(ilat, ilon) = 9999;
+				tecrms	(ilat, ilon) = 9999;
 			}
-
-			tracepdeex(0, ionex, "%5.0f", iono);
-			tecrmsList.push_back(tecrms);
 		}
-
-		tracepdeex(0, ionex, "\n");
 	}
 
-	tracepdeex(0, ionex, "%6d%54sEND OF TEC MAP\n",		ionexMapIndex, " ");
-	tracepdeex(0, ionex, "%6d%54sSTART OF RMS MAP\n",	ionexMapIndex, " ");
-
+	tracepdeex(0, ionex, "%6d%54sSTART OF TEC MAP\n", ionexMapIndex, " ");
 	tracepdeex(0, ionex, "%6.0f%6.0f%6.0f%6.0f%6.0f%6.0f%24sEPOCH OF CURRENT MAP\n", ep[0], ep[1], ep[2], ep[3], ep[4], ep[5], " ");
 
-	auto it = tecrmsList.begin();
-	
-	for (int ihgt = 0; ihgt < acsConfig.ionModelOpts.layer_heights.size();	ihgt++)
-	for (int ilat = 0; ilat < ionex_latres;									ilat++)
-	{
-		tracepdeex(0, ionex, "  %6.1f%6.1f%6.1f%6.1f%6.1f%28sLAT/LON1/LON2/DLON/H",
-				ionex_latmin + (ionex_latres - ilat - 1)	* ionex_latinc,
-				ionex_lonmin,
-				ionex_lonmin + (ionex_lonres - 1)			* ionex_loninc,
-				ionex_loninc,
-				acsConfig.ionModelOpts.layer_heights[ihgt] / 1000, "");
+	writeIonexMap(ionex, gridList, tecList);
 
-		for (int ilon = 0; ilon < ionex_lonres; ilon++)
-		{
-			if (ilon % 16 == 0)
-				tracepdeex(0, ionex, "\n");
+	tracepdeex(0, ionex, "%6d%54sEND OF TEC MAP\n",		ionexMapIndex, " ");
+	tracepdeex(0, ionex, "%6d%54sSTART OF RMS MAP\n",	ionexMapIndex, " ");
 
-			double tecrms = *it;
-			it++;
-			
-			tracepdeex(0, ionex, "%5.0f", tecrms);
-		}
+	tracepdeex(0, ionex, "%6.0f%6.0f%6.0f%6.0f%6.0f%6.0f%24sEPOCH OF CURRENT MAP\n", ep[0], ep[1], ep[2], ep[3], ep[4], ep[5], " ");
 
-		tracepdeex(0, ionex, "\n");
-	}
+	writeIonexMap(ionex, gridList, rmsList);
 
 	tracepdeex(0, ionex, "%6d%54sEND OF RMS MAP\n", ionexMapIndex, "");
 
@@ -173,6 +173,18 @@ double ionCoefBsplin(int ind, IonoObs& obs, bool slant)
 	return out;
 }
 
+/** Returns the layer of a B-splines basis function, or -1 if it is not defined
+ */
+int ionLayerBsplin(
+	int			ind)			///< Basis function number
+{
+	auto it = Bsp_Basis_list.find(ind);
+	if (it == Bsp_Basis_list.end())
+		return -1;
+
+	return it->second.hind;
+}
+
 /** Estimate Ionosphere VTEC using Ionospheric gridmaps
 	Ion_pp				I		Ionosphere Piercing Point
 	layer				I 		Layer number
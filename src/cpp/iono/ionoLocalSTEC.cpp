@@ -262,13 +262,18 @@ int ippCheckLocal(
 ----------------------------------------------------------------------------*/
 double ionCoefLocal(int ind, IonoObs& obs)
 {
-	if (localBasisMap.find(ind) == localBasisMap.end())		return 0;
+	//called for many observations at once, look up without inserting
+	auto basis_it = localBasisMap.find(ind);
+	if (basis_it == localBasisMap.end())					return 0;
 	
-	LocalBasis& basis = localBasisMap[ind];
+	LocalBasis& basis = basis_it->second;
 	
 	if (obs.ionoSat != basis.Sat)							return 0;
 	
-	auto& atmReg = nav.ssrAtm.atmosRegionsMap[basis.regionID];
+	auto region_it = nav.ssrAtm.atmosRegionsMap.find(basis.regionID);
+	if (region_it == nav.ssrAtm.atmosRegionsMap.end())		return 0;
+	
+	auto& atmReg = region_it->second;
 	double recLat = obs.ippMap[0].lat;
 	double recLon = obs.ippMap[0].lon;
 	
@@ -314,8 +319,8 @@ double ionCoefLocal(int ind, IonoObs& obs)
 }
 
 void ionOutputLocal(
-	Trace&		trace, 
-	KFState&	kfState)
+	Trace&			trace, 
+	const KFState&	kfState)
 {
 	for (auto [key, index] : kfState.kfIndexMap)
 	{
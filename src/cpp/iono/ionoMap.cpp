@@ -0,0 +1,176 @@
+
+// #pragma GCC optimize ("O0")
+
+#include <mutex>
+
+#include "ionoModel.hpp"
+#include "acsConfig.hpp"
+#include "constants.hpp"
+#include "algebra.hpp"
+
+/** Basis values of a map grid, kept between epochs while they remain valid
+ */
+struct IonoMapBasisCache
+{
+	GTime			time;				///< Time the basis values were evaluated at
+	int				numBasis = 0;		///< Number of basis functions in the model when evaluated
+	vector<double>	latList;			///< Latitudes of the grid rows (deg)
+	vector<double>	lonList;			///< Longitudes of the grid columns (deg)
+	MatrixXd		basis;				///< Basis values, one row per node and one column per basis function
+};
+
+map<int, IonoMapBasisCache>	ionMapBasisCacheMap;
+std::mutex					ionMapBasisCacheMutex;
+
+/** Evaluates the model basis functions at every node of a map grid.
+ * Returns a matrix with a row for each node (latitude major) and a column for each basis function.
+ * Columns of basis functions from other layers, and rows of nodes outside the model's coverage, are zero
+ */
+MatrixXd ionMapBasis(
+	GTime			time,		///< Time of the map
+	IonoMapGrid&	grid)		///< Grid to evaluate basis functions for
+{
+	int numBasis	= acsConfig.ionModelOpts.numBasis;
+	int numLat		= grid.latList.size();
+	int numLon		= grid.lonList.size();
+	int numNodes	= numLat * numLon;
+
+	MatrixXd basis = MatrixXd::Zero(numNodes, numBasis);
+
+	switch (acsConfig.ionModelOpts.model)
+	{
+		case E_IonoModel::SPHERICAL_HARMONICS:	break;
+		case E_IonoModel::SPHERICAL_CAPS:		break;
+		case E_IonoModel::BSPLINE:				break;
+		default:								return basis;
+	}
+
+	//pierce points are mapped into the model's frame serially, the basis functions are then evaluated in parallel
+	vector<IonoObs>		nodeList(numNodes);
+	vector<IonoObs*>	nodePtrList;
+	vector<int>			nodeIndexList;
+
+	for (int ilat = 0; ilat < numLat; ilat++)
+	for (int ilon = 0; ilon < numLon; ilon++)
+	{
+		int n = ilat * numLon + ilon;
+
+		VectorPos ipp;
+		ipp.lat() = grid.latList[ilat] * D2R;
+		ipp.lon() = grid.lonList[ilon] * D2R;
+		ipp.hgt() = acsConfig.ionModelOpts.layer_heights[grid.layer];
+
+		bool pass = ippInRange(time, ipp);
+		if (pass == false)
+			continue;
+
+		auto& node = nodeList[n];
+
+		for (int layer = 0; layer < acsConfig.ionModelOpts.layer_heights.size(); layer++)
+		{
+			node.ippMap[layer].lat			= ipp.lat();
+			node.ippMap[layer].lon			= ipp.lon();
+			node.ippMap[layer].slantFactor	= 1;
+		}
+
+		nodePtrList		.push_back(&node);
+		nodeIndexList	.push_back(n);
+	}
+
+	MatrixXd nodeBasis = ionModelCoefs(nodePtrList, false);
+
+	for (int i = 0; i < nodeIndexList.size(); i++)
+	{
+		basis.row(nodeIndexList[i]) = nodeBasis.row(i);
+	}
+
+	for (int j = 0; j < numBasis; j++)
+	{
+		if (ionModelLayer(j) != grid.layer)
+			basis.col(j).setZero();
+	}
+
+	return basis;
+}
+
+/** Evaluates the vertical TEC and its variance at every node of a map grid.
+ * The map is computed as a single product of the basis values with the model states, and the variance from the full covariance of those states.
+ * Basis values are reused between epochs when the model's basis functions are not time dependent
+ */
+void evaluateIonoMap(
+	GTime			time,		///< Time of the map
+	KFState&		kfState,	///< Filter containing the ionosphere model states
+	IonoMapGrid&	grid)		///< Grid to evaluate, with the layer and node coordinates set
+{
+	int numBasis	= acsConfig.ionModelOpts.numBasis;
+	int numLat		= grid.latList.size();
+	int numLon		= grid.lonList.size();
+
+	MatrixXd basis;
+	{
+		std::lock_guard<std::mutex> guard(ionMapBasisCacheMutex);
+
+		auto& cache = ionMapBasisCacheMap[grid.layer];
+
+		//spherical harmonics pierce points are rotated to follow the sun, so their basis values only hold for one time
+		bool timeDependent = (acsConfig.ionModelOpts.model == +E_IonoModel::SPHERICAL_HARMONICS);
+
+		if	(  cache.numBasis	!= numBasis
+			|| cache.latList	!= grid.latList
+			|| cache.lonList	!= grid.lonList
+			|| (timeDependent && cache.time != time))
+		{
+			cache.time		= time;
+			cache.numBasis	= numBasis;
+			cache.latList	= grid.latList;
+			cache.lonList	= grid.lonList;
+			cache.basis		= ionMapBasis(time, grid);
+		}
+
+		basis = cache.basis;
+	}
+
+	//gather the model states and their covariance in basis function order
+	vector<int> indexList(numBasis, -1);
+
+	for (int j = 0; j < numBasis; j++)
+	{
+		KFKey key;
+		key.type	= KF::IONOSPHERIC;
+		key.num		= j;
+
+		int index = kfState.kfIndexMap.index(key);
+		if	(  index < 0
+			|| index >= kfState.x.rows())
+		{
+			continue;
+		}
+
+		indexList[j] = index;
+	}
+
+	VectorXd x = VectorXd::Zero(numBasis);
+	MatrixXd P = MatrixXd::Zero(numBasis, numBasis);
+
+	for (int j = 0; j < numBasis; j++)
+	{
+		if (indexList[j] < 0)
+			continue;
+
+		x(j) = kfState.x(indexList[j]);
+
+		for (int k = 0; k < numBasis; k++)
+		{
+			if (indexList[k] < 0)
+				continue;
+
+			P(j, k) = kfState.P(indexList[j], indexList[k]);
+		}
+	}
+
+	VectorXd vtec		= basis * x;
+	VectorXd variance	= (basis * P).cwiseProduct(basis).rowwise().sum();
+
+	grid.vtec		= vtec		.reshaped(numLon, numLat).transpose();
+	grid.variance	= variance	.reshaped(numLon, numLat).transpose();
+}
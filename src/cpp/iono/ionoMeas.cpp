@@ -258,7 +258,7 @@ void writeReceiverMeasurements(
 int  ginan2IonoMeas(
 	Trace&			trace,			///< debug trace
 	StationMap&		stationMap, ///< List of stations containing observations for this epoch
-	KFState&		measKFstate)	///< Kalman filter object containing the ionosphere estimates
+	const KFState&	measKFstate)	///< Kalman filter object containing the ionosphere estimates
 {
 	tracepdeex(3,trace,"\n Ginan 2.0 Ionosphere Function %s\n", measKFstate.time.to_string().c_str());
 	
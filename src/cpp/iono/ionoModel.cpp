@@ -12,6 +12,7 @@ using std::map;
 #include "common.hpp"
 #include "testUtils.hpp"
 #include "acsConfig.hpp"
+#include "instrument.hpp"
 #include "enums.h"
 
 
@@ -42,8 +43,8 @@ bool overwriteIonoKF (
 }
 
 void ionosphereSsrUpdate(
-	Trace&		trace,
-	KFState&	kfState)
+	Trace&			trace,
+	const KFState&	kfState)
 {
 	switch (acsConfig.ionModelOpts.model)
 	{
@@ -92,6 +93,62 @@ double ionModelCoef(
 	}
 }
 
+/** Returns the layer that an ionosphere basis function belongs to, or -1 if it is not defined
+ */
+int ionModelLayer(
+	int			ind)
+{
+	switch (acsConfig.ionModelOpts.model)
+	{
+		case E_IonoModel::SPHERICAL_HARMONICS:	return ionLayerSphhar(ind);
+		case E_IonoModel::SPHERICAL_CAPS:		return ionLayerSphcap(ind);
+		case E_IonoModel::BSPLINE:				return ionLayerBsplin(ind);
+		default:								return -1;
+	}
+}
+
+/** Evaluates the ionosphere basis functions at the pierce points of a batch of observations.
+ * Returns the design row block, with a row for each observation and a column for each basis function
+ */
+MatrixXd ionModelCoefs(
+	vector<IonoObs*>&	obsList,	///< Observations to evaluate basis functions for
+	bool				slant)		///< apply slant factor, false: coefficient for VTEC, true: coefficient for STEC
+{
+	int numBasis = acsConfig.ionModelOpts.numBasis;
+	
+	MatrixXd coefs = MatrixXd::Zero(obsList.size(), numBasis);
+	
+#	ifdef ENABLE_PARALLELISATION
+#	ifndef ENABLE_UNIT_TESTS
+	Eigen::setNbThreads(1);
+#	pragma omp parallel for
+#	endif
+#	endif
+	for (int i = 0; i < obsList.size(); i++)
+	{
+		auto& obs = *obsList[i];
+		
+		if (acsConfig.ionModelOpts.model == +E_IonoModel::SPHERICAL_HARMONICS)
+		{
+			VectorXd rowCoefs;
+			ionCoefsSphhar(obs, rowCoefs, slant);
+			
+			coefs.row(i) = rowCoefs.transpose();
+			
+			continue;
+		}
+		
+		for (int j = 0; j < numBasis; j++)
+		{
+			coefs(i, j) = ionModelCoef(j, obs, slant);
+		}
+	}
+	
+	Eigen::setNbThreads(0);
+	
+	return coefs;
+}
+
 /** Updating the ionosphere model parameters     
  * The ionosphere model should be initialized by calling 'config_ionosph_model'        
  * Ionosphere measurments from stations should be loaded using 'update_station_measr' 
@@ -103,6 +160,8 @@ void updateIonosphereModel(
 	StationMap&		stations,			///< List of pointers to stations to use
 	GTime 			time)				///< Time of this epoch
 {
+	Instrument	instrument(__FUNCTION__);
+	
 	if (acsConfig.ionModelOpts.model== +E_IonoModel::NONE) 
 		return;
 	
@@ -188,8 +247,9 @@ void updateIonosphereModel(
 		tracepdeex(4, trace,"#IONO_MOD REF STATION for %s: %s\n", sys._to_string(), maxCountSta[sys]);
 	} 
 	
-	//add measurements and create design matrix entries
-	KFMeasEntryList kfMeasEntryList;
+	//collect the usable measurements and evaluate the model basis at all of their pierce points at once
+	vector<pair<Station*, GObs*>>	usedObsList;
+	vector<IonoObs*>				ionoObsList;
 
 	for (auto& [id, rec]	: stations)
 	for (auto& obs			: only<GObs>(rec.obsList))
@@ -198,6 +258,25 @@ void updateIonosphereModel(
 		
 		if (obs.ionExclude)								{	continue;	}
 		if (stationlist[rec.id][sys] < MIN_NSAT_STA)	{	continue;	}
+		
+		usedObsList.push_back({&rec, &obs});
+		ionoObsList.push_back(&obs);
+	}
+	
+	MatrixXd ionModelCoefMatrix = ionModelCoefs(ionoObsList, true);
+	
+	InitialState ionModelInit = initialStateFromConfig(acsConfig.ionModelOpts.ion);
+	
+	//add measurements and create design matrix entries
+	KFMeasEntryList kfMeasEntryList;
+
+	for (int o = 0; o < usedObsList.size(); o++)
+	{
+		auto& rec	= *usedObsList[o].first;
+		auto& obs	= *usedObsList[o].second;
+		auto& id	= rec.id;
+		
+		E_Sys sys = obs.Sat.sys;
 	
 		auto& recOpts = acsConfig.getRecOpts(id);
 		auto& satOpts = acsConfig.getSatOpts(obs.Sat);
@@ -250,7 +329,7 @@ void updateIonosphereModel(
 		
 		for (int i = 0; i < acsConfig.ionModelOpts.numBasis; i++)
 		{
-			double coef = ionModelCoef(i, obs, true);
+			double coef = ionModelCoefMatrix(o, i);
 			
 			if (coef == 0)
 				continue;
@@ -259,8 +338,6 @@ void updateIonosphereModel(
 			ionModelKey.type	= KF::IONOSPHERIC;
 			ionModelKey.num		= i;
 
-			InitialState ionModelInit = initialStateFromConfig(acsConfig.ionModelOpts.ion);
-			
 			meas.addDsgnEntry(ionModelKey, coef, ionModelInit);
 			
 			tracepdeex(5, trace,"#IONO_MOD %s %4d %9.5f %10.5f %8.5f %8.5f %12.5e %9.5f %12.5e\n",
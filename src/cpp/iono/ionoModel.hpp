@@ -21,10 +21,10 @@ int  configIonModel();
 
 double getSSRIono(GTime time, Vector3d& rRec, Vector3d& rSat, double& variance, SatSys& Sat);
 void  update_receivr_measr (Trace& trace, Station& rec);
-int  ginan2IonoMeas (Trace& trace, StationMap& stationMap, KFState& measKFstate);
+int  ginan2IonoMeas (Trace& trace, StationMap& stationMap, const KFState& measKFstate);
 
 void updateIonosphereModel (Trace& trace, string ionstecFilename, string ionexFilename, StationMap& stationMap, GTime time);
-void ionosphereSsrUpdate(Trace& trace, KFState& kfState);
+void ionosphereSsrUpdate(Trace& trace, const KFState& kfState);
 bool overwriteIonoKF(KFState& kfState);
 bool queryBiasDCB (Trace& trace, SatSys Sat, string Rec, E_FType freq, double& bias, double& vari);
 bool ionexFileWrite(
@@ -50,12 +50,36 @@ double ionCoefSphcap(int ind, IonoObs& obs, bool slant = true);
 double ionCoefBsplin(int ind, IonoObs& obs, bool slant = true);
 double ionCoefLocal (int ind, IonoObs& obs);
 
+MatrixXd	ionModelCoefs (vector<IonoObs*>& obsList, bool slant = true);
+void		ionCoefsSphhar(IonoObs& obs, VectorXd& coefs, bool slant = true);
+
+int ionModelLayer (int ind);
+int ionLayerSphhar(int ind);
+int ionLayerSphcap(int ind);
+int ionLayerBsplin(int ind);
+
+bool ippInRange(GTime time, VectorPos& Ion_pp);
+
 double ionVtecSphhar(GTime time, VectorPos& ionPP, int layer, double& vari, KFState& kfState);
 double ionVtecSphcap(GTime time, VectorPos& ionPP, int layer, double& vari, KFState& kfState);
 double ionVtecBsplin(GTime time, VectorPos& ionPP, int layer, double& vari, KFState& kfState);
 
-void ionOutputSphcal(Trace& trace, KFState& kfState);
-void ionOutputLocal (Trace& trace, KFState& kfState);
+/** Ionosphere map of one layer, evaluated on a regular latitude/longitude grid
+ */
+struct IonoMapGrid
+{
+	int				layer = 0;		///< Ionosphere layer of the map
+	vector<double>	latList;		///< Latitudes of the grid rows (deg)
+	vector<double>	lonList;		///< Longitudes of the grid columns (deg)
+	MatrixXd		vtec;			///< Vertical TEC at each node, one row per latitude and one column per longitude
+	MatrixXd		variance;		///< Variance of the vertical TEC at each node, from the full covariance of the model states
+};
+
+MatrixXd	ionMapBasis		(GTime time, IonoMapGrid& grid);
+void		evaluateIonoMap	(GTime time, KFState& kfState, IonoMapGrid& grid);
+
+void ionOutputSphcal(Trace& trace, const KFState& kfState);
+void ionOutputLocal (Trace& trace, const KFState& kfState);
 
 bool getIGSSSRIono(GTime time, SSRAtm& ssrAtm, Vector3d& rSat, Vector3d&	rRec, double& 	iono, double& var);
 bool getCmpSSRIono(GTime time, SSRAtm& ssrAtm, Vector3d& rRec,						double& iono, double& var, SatSys Sat);
@@ -10,9 +10,6 @@
 #include "common.hpp"
 
 
-Legendre ionLeg;                              		
-double ionSPHLastColatitude = -100;
-
 struct SphBasis
 {
 	int layer	= 0;					
@@ -48,8 +45,6 @@ int configIonModelSphhar()
 		nlay = 1;
 	}
 	
-	ionLeg.setNmax(Nmax);
-
 	int ind = 0;
 	for (int layer	= 0;		layer	< nlay;										layer++)
 	for (int order	= 0;		order	< acsConfig.ionModelOpts.function_order;	order++)
@@ -149,6 +144,32 @@ bool ippCheckSphhar(
 	return true;
 }
 
+/** Legendre functions at the colatitude of a pierce point.
+ * Each thread keeps its own evaluation, which is only recalculated when the pierce point changes
+ */
+const Legendre& ippLegendre(
+	double		colat)			///< Colatitude of the pierce point
+{
+	thread_local Legendre	leg;
+	thread_local double		lastColat = -100;
+	
+	int nmax = acsConfig.ionModelOpts.function_degree + 1;
+	
+	if (leg.nmax != nmax)
+	{
+		leg.setNmax(nmax);
+		lastColat = -100;
+	}
+	
+	if (colat != lastColat)
+	{
+		leg.calculate(cos(colat));
+		lastColat = colat;
+	}
+	
+	return leg;
+}
+
 /** Evaluates spherical harmonics basis functions
 	int ind			I		
 	obs				I		Ionosphere measurement struct
@@ -173,26 +194,100 @@ double ionCoefSphhar(
 	if (basis.degree	> acsConfig.ionModelOpts.function_degree)
 		return 0;
 
-	double colat = obs.ippMap[basis.layer].lat;
+	auto& ipp = obs.ippMap[basis.layer];
 	
-	if (fabs(ionSPHLastColatitude - colat) > 0.01)
-		ionLeg.calculate(cos(colat));
+	auto& leg = ippLegendre(ipp.lat);
 
-	double coeff = pow(-1, basis.order) * ionLeg.Pnm(basis.degree, basis.order);
+	double coeff = pow(-1, basis.order) * leg.Pnm(basis.degree, basis.order);
 	
-	double angle = basis.order * obs.ippMap[basis.layer].lon;
+	double angle = basis.order * ipp.lon;
 	
 	if		(basis.trigType == +E_TrigType::SIN)		coeff *= sin(angle);
 	else if (basis.trigType == +E_TrigType::COS)		coeff *= cos(angle);
 
 	if (slant)
 	{
-		coeff *= obs.ippMap[basis.layer].slantFactor;
+		coeff *= ipp.slantFactor;
 	}
 
 	return coeff;
 }
 
+/** Returns the layer of a spherical harmonics basis function, or -1 if it is not defined
+ */
+int ionLayerSphhar(
+	int			ind)			///< Basis function number
+{
+	auto it = sphBasisMap.find(ind);
+	if (it == sphBasisMap.end())
+		return -1;
+
+	return it->second.layer;
+}
+
+/** Evaluates all spherical harmonics basis functions at the pierce points of one observation.
+ * The Legendre functions and trigonometric terms are computed once per layer and shared by all basis functions of that layer
+ */
+void ionCoefsSphhar(
+	IonoObs&	obs,			///< Ionospheric observation metadata
+	VectorXd&	coefs,			///< Coefficients of each basis function
+	bool		slant)			///< apply slant factor, false: coefficient for VTEC, true: coefficient for STEC
+{
+	coefs = VectorXd::Zero(acsConfig.ionModelOpts.numBasis);
+	
+	int				lastLayer	= -1;
+	const Legendre*	leg_ptr		= nullptr;
+	IonoPP*			ipp_ptr		= nullptr;
+	VectorXd		cosml;
+	VectorXd		sinml;
+	
+	for (auto& [ind, basis] : sphBasisMap)
+	{
+		if (ind >= coefs.rows())
+			break;
+		
+		if (basis.order		> acsConfig.ionModelOpts.function_order)
+			continue;
+
+		if (basis.degree	> acsConfig.ionModelOpts.function_degree)
+			continue;
+		
+		if (basis.layer != lastLayer)
+		{
+			lastLayer	= basis.layer;
+			ipp_ptr		= &obs.ippMap[basis.layer];
+			leg_ptr		= &ippLegendre(ipp_ptr->lat);
+			
+			int numOrders = acsConfig.ionModelOpts.function_order + 1;
+			cosml.resize(numOrders);
+			sinml.resize(numOrders);
+			
+			for (int order = 0; order < numOrders; order++)
+			{
+				double angle = order * ipp_ptr->lon;
+				
+				cosml(order) = cos(angle);
+				sinml(order) = sin(angle);
+			}
+		}
+		
+		double coeff = leg_ptr->Pnm(basis.degree, basis.order);
+		
+		if (basis.order % 2)
+			coeff = -coeff;
+		
+		if		(basis.trigType == +E_TrigType::SIN)		coeff *= sinml(basis.order);
+		else if (basis.trigType == +E_TrigType::COS)		coeff *= cosml(basis.order);
+		
+		if (slant)
+		{
+			coeff *= ipp_ptr->slantFactor;
+		}
+		
+		coefs(ind) = coeff;
+	}
+}
+
 /** Estimate Ionosphere VTEC using Spherical Cap Harmonic models
 	gtime_t  time		I		time of solutions (not useful for this one
 	Ion_pp				I		Ionosphere Piercing Point
@@ -249,8 +344,8 @@ double ionVtecSphhar(
 }
 
 void ionOutputSphcal(
-	Trace&		trace, 
-	KFState&	kfState)
+	Trace&			trace, 
+	const KFState&	kfState)
 {
 	SSRAtmGlobal atmGlob;
 	atmGlob.numberLayers = acsConfig.ionModelOpts.layer_heights.size();
@@ -247,6 +247,18 @@ double ionCoefSphcap(
 	return out;
 }
 
+/** Returns the layer of a spherical cap harmonics basis function, or -1 if it is not defined
+ */
+int ionLayerSphcap(
+	int			ind)			///< Basis function number
+{
+	auto it = Scp_Basis_list.find(ind);
+	if (it == Scp_Basis_list.end())
+		return -1;
+
+	return it->second.hind;
+}
+
 /** Estimate Ionosphere VTEC using Spherical Cap Harmonic models
 	gtime_t  time		I		time of solutions (not useful for this one
 	Ion_pp				I		Ionosphere Piercing Point
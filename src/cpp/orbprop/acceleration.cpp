@@ -127,15 +127,31 @@ Vector3d accelJ2(
 }
 
 /** Compute the acceleration of due to a spherical harmonic field acting on the satellite
+ * The field is the sum of static coefficients and (smaller) time varying corrections to their low degree terms.
+ * Legendre recursion coefficients and working arrays are kept per thread, so they are only prepared once for each degree
  * @note This function does not contain the degree 0 acceleration need to be done via "accelCentralForce"
  */
 Vector3d accelSPH(
 	const Vector3d	r,			///< Vector of the position of the satelite (ECEF)
-	const MatrixXd	C, 			///< Matrix of the "C" spherical harmonic coefficient
-	const MatrixXd	S,			///< Matrix of the "S" spherical harmonic coefficient
+	const MatrixXd&	C, 			///< Matrix of the "C" spherical harmonic coefficient
+	const MatrixXd&	S,			///< Matrix of the "S" spherical harmonic coefficient
+	const MatrixXd&	dC, 		///< Time varying corrections to low degree "C" coefficients
+	const MatrixXd&	dS,			///< Time varying corrections to low degree "S" coefficients
 	const int		max_deg, 	///< Maximum degree use for the summation of the harmonics
 	const double	GM)			///< Value of GM constant of the body in question. 
 {
+	thread_local Legendre	leg;
+	thread_local VectorXd	cosphi;
+	thread_local VectorXd	sinphi;
+	
+	if (leg.nmax != max_deg)
+	{
+		leg.setNmax(max_deg);
+		
+		cosphi.resize(max_deg+1);
+		sinphi.resize(max_deg+1);
+	}
+	
 	double R		= r.norm();
 	double sin_lat	= r.z() / R; // Is Cos colat too.
 	
@@ -143,9 +159,6 @@ Vector3d accelSPH(
 	double cos_lon	= r.x() / Rxy;
 	double sin_lon	= r.y() / Rxy;
 
-	VectorXd cosphi(max_deg+1);
-	VectorXd sinphi(max_deg+1);
-
 	cosphi(0) = 1;
 	sinphi(0) = 0;
 
@@ -158,7 +171,6 @@ Vector3d accelSPH(
 		sinphi(i) =  sinphi(i-1) * cos_lon + cosphi(i-1) * sin_lon;
 	}
 	
-	Legendre leg(max_deg);
 	leg.calculate(sin_lat);
 
 	double dVr		= 0;
@@ -173,11 +185,22 @@ Vector3d accelSPH(
 		double dVtheta_n	= 0;
 		double dVlambda_n	= 0;
 		
+		bool corrected = i < dC.rows();
+		
 		for (int j = 0; j <= i; j++)
 		{
-			dVr_n		+=		leg.Pnm(i,j)  * (C(i,j) * cosphi(j) + S(i,j) * sinphi(j));
-			dVtheta_n	+= 		leg.dPnm(i,j) * (C(i,j) * cosphi(j) + S(i,j) * sinphi(j)); // lat
-			dVlambda_n 	+= j *	leg.Pnm(i,j)  * (S(i,j) * cosphi(j) - C(i,j) * sinphi(j)); // lon
+			double Cij = C(i,j);
+			double Sij = S(i,j);
+			
+			if (corrected)
+			{
+				Cij += dC(i,j);
+				Sij += dS(i,j);
+			}
+			
+			dVr_n		+=		leg.Pnm(i,j)  * (Cij * cosphi(j) + Sij * sinphi(j));
+			dVtheta_n	+= 		leg.dPnm(i,j) * (Cij * cosphi(j) + Sij * sinphi(j)); // lat
+			dVlambda_n 	+= j *	leg.Pnm(i,j)  * (Sij * cosphi(j) - Cij * sinphi(j)); // lon
 		}
 		dVr 		+= -1*(i+1) * 	const_Radius * dVr_n;
 		dVtheta 	+= 				const_Radius * dVtheta_n;
@@ -33,7 +33,14 @@ Vector3d accelCentralForce(
 	const	double		GM,
 			Matrix3d*	dAdPos_ptr = nullptr);
 
-Vector3d accelSPH(const Vector3d r, const MatrixXd C, const MatrixXd S, const int n, const double GM);
+Vector3d accelSPH(
+	const Vector3d	r,
+	const MatrixXd&	C,
+	const MatrixXd&	S,
+	const MatrixXd&	dC,
+	const MatrixXd&	dS,
+	const int		n,
+	const double	GM);
 
 Vector3d accelJ2(
 	const	double		C20,
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -75,8 +76,26 @@ void OceanTide::readocetide()
 				TidalWaves.back().SnmP(n_, m_) = snmp_;
 				TidalWaves.back().SnmM(n_, m_) = snmm_;
 			}
+			
+			degUsed = std::max(degUsed, n_);
 		}
 	}
+	
+	//only keep the degrees that have values, and prepare the combinations used when evaluating the tides
+	int size = degUsed + 1;
+	
+	for (auto& wave : TidalWaves)
+	{
+		wave.CnmP		= wave.CnmP.topLeftCorner(size, size).eval();
+		wave.CnmM		= wave.CnmM.topLeftCorner(size, size).eval();
+		wave.SnmP		= wave.SnmP.topLeftCorner(size, size).eval();
+		wave.SnmM		= wave.SnmM.topLeftCorner(size, size).eval();
+		
+		wave.CnmSum		= wave.CnmP + wave.CnmM;
+		wave.CnmDiff	= wave.CnmP - wave.CnmM;
+		wave.SnmSum		= wave.SnmP + wave.SnmM;
+		wave.SnmDiff	= wave.SnmP - wave.SnmM;
+	}
 }
 
 TidalWave::TidalWave(
@@ -129,8 +148,8 @@ void OceanTide::getSPH(
 	for (auto& wave : TidalWaves)
 	{
 		double thetaf = (dood * wave.Doodson).sum();
-		Cnm += ((wave.CnmP + wave.CnmM) * cos(thetaf) + (wave.SnmP + wave.SnmM) * sin(thetaf)) * 1e-11;
-		Snm += ((wave.SnmP - wave.SnmM) * cos(thetaf) - (wave.CnmP - wave.CnmM) * sin(thetaf)) * 1e-11;
+		Cnm += (wave.CnmSum		* cos(thetaf) + wave.SnmSum		* sin(thetaf)) * 1e-11;
+		Snm += (wave.SnmDiff	* cos(thetaf) - wave.CnmDiff	* sin(thetaf)) * 1e-11;
 	}
 	Snm.col(0).setZero();
 	Snm.row(0).setZero();
@@ -24,6 +24,10 @@ struct TidalWave
 	MatrixXd	CnmM;
 	MatrixXd	SnmP;
 	MatrixXd	SnmM;
+	MatrixXd	CnmSum;		///< Precomputed CnmP + CnmM
+	MatrixXd	CnmDiff;	///< Precomputed CnmP - CnmM
+	MatrixXd	SnmSum;		///< Precomputed SnmP + SnmM
+	MatrixXd	SnmDiff;	///< Precomputed SnmP - SnmM
 	ArrayXd		coeff;
 	Array6d		Doodson;
 };
@@ -32,6 +36,7 @@ struct OceanTide
 {
 	string				filename;
 	int					degMax;
+	int					degUsed	= 0;	///< Highest degree with coefficients in the tide file (up to degMax)
 	
 	vector<TidalWave>	TidalWaves;
 	Vector6d			Beta;
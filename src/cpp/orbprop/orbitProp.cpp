@@ -3,6 +3,7 @@
 // #pragma GCC optimize ("O0")
 
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <deque>
 #include <map>
 
@@ -31,6 +32,16 @@ using bsoncxx::builder::stream::document;
 void OrbitIntegrator::computeCommon(
 	const double dt)
 {
+	auto cache_it = commonCache.find(dt);
+	if (cache_it != commonCache.end())
+	{
+		OrbitCommon& common = *this;
+		
+		common = cache_it->second;
+		
+		return;
+	}
+	
 	GTime		time = timeInit	+ dt;
 
 	ERPValues	erpv = getErp(nav.erp, time);
@@ -42,7 +53,7 @@ void OrbitIntegrator::computeCommon(
 		jplEphPos(nav.jplEph_ptr, time, body, planetsPosMap[body], &planetsVelMap[body]);
 	}
 
-	//Spherical Harmonics
+	//Spherical Harmonics - the static field is used directly, only the low degree terms affected by tides are computed here
 	if (propagationOptions.egm_field)
 	for (auto& once : {1})
 	{
@@ -53,8 +64,15 @@ void OrbitIntegrator::computeCommon(
 			break;
 		}
 		
-		Cnm = egm.gfctC;
-		Snm = egm.gfctS;
+		int size = 5;
+		if (propagationOptions.ocean_tide)
+		{
+			size = std::max(size, tide.degUsed + 1);
+		}
+		size = std::min(size, (int) egm.gfctC.rows());
+		
+		dCnm = MatrixXd::Zero(size, size);
+		dSnm = MatrixXd::Zero(size, size);
 
 		if (propagationOptions.solid_earth_tide)
 		{
@@ -69,50 +87,68 @@ void OrbitIntegrator::computeCommon(
 			
 			IERS2010::solidEarthTide2(time, erpv.ut1Utc, Cnm_solid, Snm_solid);
 
-			Cnm.topLeftCorner(5, 5) += Cnm_solid;
-			Snm.topLeftCorner(5, 5) += Snm_solid;
+			dCnm.topLeftCorner(5, 5) += Cnm_solid;
+			dSnm.topLeftCorner(5, 5) += Snm_solid;
 		}
 
 		if (propagationOptions.pole_tide_ocean)
 		{
-			IERS2010::poleOceanTide(time, erpv.xp, erpv.yp, Cnm, Snm);
+			IERS2010::poleOceanTide(time, erpv.xp, erpv.yp, dCnm, dSnm);
 		}
 
 		if (propagationOptions.pole_tide_solid)
 		{
-			IERS2010::poleSolidEarthTide(time, erpv.xp, erpv.yp, Cnm, Snm);
+			IERS2010::poleSolidEarthTide(time, erpv.xp, erpv.yp, dCnm, dSnm);
 		}
 
 		if (propagationOptions.ocean_tide)
 		{
 			Vector6d dood_arr = IERS2010::doodson(time, erpv.ut1Utc);
 
-			MatrixXd Cnm_ocean = MatrixXd::Zero(Cnm.rows(), Cnm.cols());
-			MatrixXd Snm_ocean = MatrixXd::Zero(Snm.rows(), Snm.cols());
+			int tideSize = std::min(tide.degUsed + 1, size);
+			
+			MatrixXd Cnm_ocean = MatrixXd::Zero(tide.degUsed + 1, tide.degUsed + 1);
+			MatrixXd Snm_ocean = MatrixXd::Zero(tide.degUsed + 1, tide.degUsed + 1);
 
 			tide.getSPH(dood_arr, Cnm_ocean, Snm_ocean);
 
-			Cnm += Cnm_ocean;
-			Snm += Snm_ocean;
+			dCnm.topLeftCorner(tideSize, tideSize) += Cnm_ocean.topLeftCorner(tideSize, tideSize);
+			dSnm.topLeftCorner(tideSize, tideSize) += Snm_ocean.topLeftCorner(tideSize, tideSize);
 		}
 	}
+	
+	//keep a few recent evaluations - the rk78 stages repeat some times, and each step starts where the last one ended
+	if (commonCache.size() > 16)
+	{
+		auto far_it = commonCache.begin();
+		if (fabs(commonCache.rbegin()->first - dt) > fabs(far_it->first - dt))
+		{
+			far_it = std::prev(commonCache.end());
+		}
+		
+		commonCache.erase(far_it);
+	}
+	
+	commonCache[dt] = *this;
 }
 
 
 void OrbitIntegrator::computeAcceleration(
-	const	OrbitState&	orbInit,
+	const	OrbitState&	orbit,
+	const	Vector3d&	pos,
+	const	Vector3d&	vel,
 			Vector3d&	acc,
 			Matrix3d&	dAdPos,
 			Matrix3d&	dAdVel,
 			MatrixXd&	dAdParam)
 {
-	Vector3d rsat = orbInit.pos;
-	Vector3d vsat = orbInit.vel;
+	Vector3d rsat = pos;
+	Vector3d vsat = vel;
 	
 	const double posOffset = 1e-3;
 	const double velOffset = 1e-6;
 
- 	const	Vector3d satToSun	= planetsPosMap[E_ThirdBody::SUN] - rsat;
+ 	const	Vector3d satToSun	= planetsPosMap.at(E_ThirdBody::SUN) - rsat;
  	const	Vector3d ed 		= satToSun		.normalized();
  	const	Vector3d er 		= rsat			.normalized();
  	const	Vector3d ey 		= (ed.cross(er)).normalized();
@@ -120,9 +156,9 @@ void OrbitIntegrator::computeAcceleration(
 
 	if (propagationOptions.central_force)
 	{
-		Vector3d accCF = accelCentralForce(rsat, GM_values[E_ThirdBody::EARTH], &dAdPos);
+		Vector3d accCF = accelCentralForce(rsat, GM_values.at(E_ThirdBody::EARTH), &dAdPos);
 	
-// 		orbInit.componentsMap[E_Component::CENTRAL_FORCE] = accCF.norm();
+// 		orbit.componentsMap[E_Component::CENTRAL_FORCE] = accCF.norm();
 		
 		acc += accCF;
 	}
@@ -135,9 +171,9 @@ void OrbitIntegrator::computeAcceleration(
 			continue;
 		}
 		
-		Vector3d accPlanet = accelSourcePoint(rsat, planetPos, GM_values[planet], &dAdPos);
+		Vector3d accPlanet = accelSourcePoint(rsat, planetPos, GM_values.at(planet), &dAdPos);
 	
-// 		orbInit.componentsMap[E_Component::PLANETARY_PERTURBATION] = accPlanet.norm();
+// 		orbit.componentsMap[E_Component::PLANETARY_PERTURBATION] = accPlanet.norm();
 		
 		acc += accPlanet;
 	}
@@ -145,7 +181,7 @@ void OrbitIntegrator::computeAcceleration(
 	if (propagationOptions.egm_field)
 	{
 		Vector3d rsatE	= eci2ecf * rsat;
-		Vector3d accSPH	= accelSPH(rsatE, Cnm, Snm, propagationOptions.degree_max, egm.earthGravityConstant);
+		Vector3d accSPH	= accelSPH(rsatE,			egm.gfctC, egm.gfctS, dCnm, dSnm, propagationOptions.degree_max, egm.earthGravityConstant);
 		
 		for (int i = 0; i < 3; i++)
 		{
@@ -153,12 +189,12 @@ void OrbitIntegrator::computeAcceleration(
 			offset(i) = posOffset;
 			
 			Vector3d posPerturbed = rsatE + offset;
-			Vector3d accPerturbed = accelSPH(posPerturbed, Cnm, Snm, propagationOptions.degree_max, egm.earthGravityConstant);
+			Vector3d accPerturbed = accelSPH(posPerturbed,	egm.gfctC, egm.gfctS, dCnm, dSnm, propagationOptions.degree_max, egm.earthGravityConstant);
 			
 			dAdPos.col(i) += eci2ecf.transpose() * (accPerturbed - accSPH) / posOffset;
 		}
 	
-// 		orbInit.componentsMap[E_Component::EGM] = accSPH.norm();
+// 		orbit.componentsMap[E_Component::EGM] = accSPH.norm();
 		
 		acc += eci2ecf.transpose() * accSPH;
 	}
@@ -166,9 +202,15 @@ void OrbitIntegrator::computeAcceleration(
 	if (propagationOptions.indirect_J2)
 	for (const auto body : {E_ThirdBody::SUN, E_ThirdBody::MOON})
 	{
-		Vector3d accJ2 = accelJ2(Cnm(2,0), eci2ecf, planetsPosMap[body], GM_values[body]);
+		double C20 = egm.gfctC(2,0);
+		if (dCnm.rows() > 2)
+		{
+			C20 += dCnm(2,0);
+		}
+		
+		Vector3d accJ2 = accelJ2(C20, eci2ecf, planetsPosMap.at(body), GM_values.at(body));
 	
-// 		orbInit.componentsMap[E_Component::INDIRECT_J2] = accJ2.norm();
+// 		orbit.componentsMap[E_Component::INDIRECT_J2] = accJ2.norm();
 		
 		acc += eci2ecf.transpose() * accJ2;
 	}
@@ -177,8 +219,8 @@ void OrbitIntegrator::computeAcceleration(
 	{
 		Vector3d accRel = IERS2010::relativity(		rsat,
 													vsat,
-													planetsPosMap[E_ThirdBody::SUN],
-													planetsVelMap[E_ThirdBody::SUN],
+													planetsPosMap.at(E_ThirdBody::SUN),
+													planetsVelMap.at(E_ThirdBody::SUN),
 													eci2ecf,
 													deci2ecf);
 
@@ -190,8 +232,8 @@ void OrbitIntegrator::computeAcceleration(
 			offset(i) = posOffset;
 			acc_rel_part = IERS2010::relativity(	rsat + offset,
 													vsat,
-													planetsPosMap[E_ThirdBody::SUN],
-													planetsVelMap[E_ThirdBody::SUN],
+													planetsPosMap.at(E_ThirdBody::SUN),
+													planetsVelMap.at(E_ThirdBody::SUN),
 													eci2ecf,
 													deci2ecf);
 
@@ -200,34 +242,34 @@ void OrbitIntegrator::computeAcceleration(
 			offset(i) = velOffset;
 			acc_rel_part = IERS2010::relativity(	rsat,
 													vsat + offset,
-													planetsPosMap[E_ThirdBody::SUN],
-													planetsVelMap[E_ThirdBody::SUN],
+													planetsPosMap.at(E_ThirdBody::SUN),
+													planetsVelMap.at(E_ThirdBody::SUN),
 													eci2ecf,
 													deci2ecf);
 
 			dAdVel.col(i) += (acc_rel_part - accRel) / velOffset;
 		}
 	
-// 		orbInit.componentsMap[E_Component::GENERAL_RELATIVITY] = accRel.norm();
+// 		orbit.componentsMap[E_Component::GENERAL_RELATIVITY] = accRel.norm();
 
 		acc += accRel;
 	};
 
 	if (propagationOptions.antenna_thrust)
 	{
-		Vector3d accAnt = orbInit.satPower / (orbInit.satMass * CLIGHT) * rsat.normalized();
+		Vector3d accAnt = orbit.satPower / (orbit.satMass * CLIGHT) * rsat.normalized();
 
 		for (int i = 0; i < 3; i++)
 		{
 			Vector3d offset = Vector3d::Zero();
 			offset(i) = posOffset;
 
-			Vector3d acc_pert = orbInit.satPower / (orbInit.satMass * CLIGHT) * (rsat + offset).normalized();
+			Vector3d acc_pert = orbit.satPower / (orbit.satMass * CLIGHT) * (rsat + offset).normalized();
 
 			dAdPos.col(i) += (acc_pert - accAnt) / posOffset;
 		}
 	
-// 		orbInit.componentsMap[E_Component::ANTENNA_THRUST] = accAnt.norm();
+// 		orbit.componentsMap[E_Component::ANTENNA_THRUST] = accAnt.norm();
 
 		acc += accAnt;
 	}
@@ -237,9 +279,9 @@ void OrbitIntegrator::computeAcceleration(
 		double P0			= 4.56e-6;
 		double Cr			= propagationOptions.srp_cr;
 		double A			= propagationOptions.sat_area;
-		double m			= orbInit.satMass;
+		double m			= orbit.satMass;
 
-		double eclipseFrac	= sunVisibility(rsat, planetsPosMap[E_ThirdBody::SUN], planetsPosMap[E_ThirdBody::MOON]);
+		double eclipseFrac	= sunVisibility(rsat, planetsPosMap.at(E_ThirdBody::SUN), planetsPosMap.at(E_ThirdBody::MOON));
 		double scalar		= P0 * Cr * A / m * SQR(AU) * eclipseFrac / satToSun.squaredNorm();
 		double R			= satToSun.norm();
 
@@ -247,7 +289,7 @@ void OrbitIntegrator::computeAcceleration(
 
 		Vector3d accSrp = -1 * scalar * ed;
 	
-// 		orbInit.componentsMap[E_Component::SRP] = accSrp.norm();
+// 		orbit.componentsMap[E_Component::SRP] = accSrp.norm();
 
 		acc += accSrp;
 	}
@@ -255,12 +297,12 @@ void OrbitIntegrator::computeAcceleration(
 	if (propagationOptions.albedo)
 	{
 		double A			= propagationOptions.sat_area;
-		double m			= orbInit.satMass;
+		double m			= orbit.satMass;
 		double E 			= 1367;
 		double cBall		= 0.8;
 		double alpha		= 0.3;
 		double Ae			= M_PI * SQR(RE_WGS84);
-		Vector3d rSun		= planetsPosMap[E_ThirdBody::SUN];
+		Vector3d rSun		= planetsPosMap.at(E_ThirdBody::SUN);
 
 		double E_IR 		= (1 - alpha) / (4 * PI) * Ae * E / rsat.squaredNorm();
 
@@ -271,7 +313,7 @@ void OrbitIntegrator::computeAcceleration(
 	
 		Vector3d accAlbedo = A / m * (E_Vis + E_IR)  / CLIGHT * cBall * rsat.normalized();
 		
-// 		orbInit.componentsMap[E_Component::ALBEDO] = accAlbedo.norm();
+// 		orbit.componentsMap[E_Component::ALBEDO] = accAlbedo.norm();
 		
 		acc += accAlbedo;
 	}
@@ -279,13 +321,13 @@ void OrbitIntegrator::computeAcceleration(
 	if (propagationOptions.empirical_dyb)
 	{
 		double scalef		= SQR(AU) / satToSun.squaredNorm();
-		double eclipseFrac	= sunVisibility(rsat, planetsPosMap[E_ThirdBody::SUN], planetsPosMap[E_ThirdBody::MOON]);
+		double eclipseFrac	= sunVisibility(rsat, planetsPosMap.at(E_ThirdBody::SUN), planetsPosMap.at(E_ThirdBody::MOON));
 
 		double srpScalar	= eclipseFrac * scalef;
 		
 		vector<Vector3d> axis = {ed, ey, eb};
 
-		Vector3d& rSun = planetsPosMap[E_ThirdBody::SUN];
+		const Vector3d& rSun = planetsPosMap.at(E_ThirdBody::SUN);
 		Vector3d z = (rsat	.cross(vsat))	.normalized();
 		Vector3d y = (z		.cross(rSun))	.normalized();
 		Vector3d x = (y		.cross(z))		.normalized();
@@ -294,9 +336,9 @@ void OrbitIntegrator::computeAcceleration(
 
 		Vector3d accEmp = Vector3d::Zero();
 	
-		for (int i = 0; i < orbInit.empInput.size(); i++)
+		for (int i = 0; i < orbit.empInput.size(); i++)
 		{
-			auto& empdata = orbInit.empInput[i];
+			auto& empdata = orbit.empInput[i];
 			
 			double scalar = 1;
 			
@@ -313,48 +355,120 @@ void OrbitIntegrator::computeAcceleration(
 			accEmp += empdata.value * dAdParam.col(i);
 		}
 		
-// 		orbInit.componentsMap[E_Component::EMPIRICAL] = accEmp.norm();
+// 		orbit.componentsMap[E_Component::EMPIRICAL] = accEmp.norm();
 
  		acc += accEmp;
  	}
 }
 
 void OrbitIntegrator::operator()(
-	const	Orbits&	orbInits,
-			Orbits&	orbUpdates,
-	const	double	timeOffset)
+	const	OrbitStateVector&	orbInits,
+			OrbitStateVector&	orbUpdates,
+	const	double				timeOffset)
 {
 	computeCommon(timeOffset);
-
-	for (int i = 0; i < orbInits.size(); i++)
+	
+	auto& orbits = *orbits_ptr;
+	
+	//each orbit only depends on the common values computed above and its own block of the state, so they may be evaluated in any order
+#	ifdef ENABLE_PARALLELISATION
+#	ifndef ENABLE_UNIT_TESTS
+		int eigenThreads = Eigen::nbThreads();
+		Eigen::setNbThreads(1);
+#		pragma omp parallel for schedule(dynamic)
+#	endif
+#	endif
+	for (int i = 0; i < orbits.size(); i++)
 	{
 		Matrix6d A			= Matrix6d::Zero();
 		A.block<3,3>(0,3)	= Matrix3d::Identity();
 	
-		auto& orbInit	= orbInits	[i];
-		auto& orbUpdate	= orbUpdates[i];
+		auto& orbit		= orbits[i];
+		
+		int nparam	= orbit.empnum;
+		int ncols	= orbit.posVelSTM.cols();
 		
-		int nparam = orbInit.empnum;
+		//views into this orbit's block of the contiguous states
+		Eigen::Map<const Vector3d>	posInit		(orbInits	.data() + orbit.offset);
+		Eigen::Map<const Vector3d>	velInit		(orbInits	.data() + orbit.offset + 3);
+		Eigen::Map<const MatrixXd>	stmInit		(orbInits	.data() + orbit.offset + 6,	6, ncols);
+		
+		Eigen::Map<Vector3d>		posUpdate	(orbUpdates	.data() + orbit.offset);
+		Eigen::Map<Vector3d>		velUpdate	(orbUpdates	.data() + orbit.offset + 3);
+		Eigen::Map<MatrixXd>		stmUpdate	(orbUpdates	.data() + orbit.offset + 6,	6, ncols);
 
 		Vector3d acc		= Vector3d::Zero();
 		Matrix3d dAdPos		= Matrix3d::Zero();
 		Matrix3d dAdVel		= Matrix3d::Zero();
  		MatrixXd dAdParam	= MatrixXd::Zero(3, nparam);
 
-		computeAcceleration(orbInit, acc, dAdPos, dAdVel, dAdParam);
+		computeAcceleration(orbit, posInit, velInit, acc, dAdPos, dAdVel, dAdParam);
 		
 		A.block<3,3>(3,0) = dAdPos;
 		A.block<3,3>(3,3) = dAdVel;
 		
-// 		orbUpdate.componentsMap	= orbInit.componentsMap;
-		orbUpdate.pos			= orbInit.vel;
-		orbUpdate.vel			= acc;
-		orbUpdate.posVelSTM		= A * orbInit.posVelSTM;
+		posUpdate			= velInit;
+		velUpdate			= acc;
+		stmUpdate.noalias()	= A * stmInit;
 		
-      	orbUpdate.posVelSTM.bottomRightCorner(3, nparam) += dAdParam;
+      	stmUpdate.bottomRightCorner(3, nparam) += dAdParam;
 	}
+	
+#	ifdef ENABLE_PARALLELISATION
+#	ifndef ENABLE_UNIT_TESTS
+		Eigen::setNbThreads(eigenThreads);
+#	endif
+#	endif
 };
 
+/** Record the position of each orbit's block in a contiguous state vector, returning the size of the vector
+*/
+int setOrbitOffsets(
+	Orbits&		orbits)
+{
+	int size = 0;
+	for (auto& orbit : orbits)
+	{
+		orbit.offset = size;
+		
+		size += orbit.blockSize();
+	}
+	
+	return size;
+}
+
+/** Copy the propagated values of a set of orbits into a contiguous state vector, recording the position of each orbit's block
+*/
+OrbitStateVector packOrbits(
+	Orbits&		orbits)
+{
+	int size = setOrbitOffsets(orbits);
+	
+	OrbitStateVector orbitStates(size);
+	
+	for (auto& orbit : orbits)
+	{
+		orbitStates.segment(orbit.offset,		3)						= orbit.pos;
+		orbitStates.segment(orbit.offset + 3,	3)						= orbit.vel;
+		orbitStates.segment(orbit.offset + 6,	orbit.posVelSTM.size())	= orbit.posVelSTM.reshaped();
+	}
+	
+	return orbitStates;
+}
+
+/** Copy the propagated values of a set of orbits back out of a contiguous state vector
+*/
+void unpackOrbits(
+	const OrbitStateVector&		orbitStates,
+	Orbits&						orbits)
+{
+	for (auto& orbit : orbits)
+	{
+		orbit.pos		= orbitStates.segment(orbit.offset,		3);
+		orbit.vel		= orbitStates.segment(orbit.offset + 3,	3);
+		orbit.posVelSTM	= orbitStates.segment(orbit.offset + 6,	orbit.posVelSTM.size()).reshaped(6, orbit.posVelSTM.cols());
+	}
+}
 
 void integrateOrbits(
 	OrbitIntegrator&	orbitPropagator,
@@ -383,22 +497,240 @@ void integrateOrbits(
 		dt = newDt;
 	}
 	
+	orbitPropagator.orbits_ptr = &orbits;
+	
+	OrbitStateVector orbitStates = packOrbits(orbits);
+	OrbitStateVector errors;
+	
 	for (int i = 0; i < steps; i++)
 	{
 		double initTime	= i * dt;
 		
-		Orbits errors;
-		orbitPropagator.odeIntegrator.do_step(boost::ref(orbitPropagator), orbits, initTime, dt, errors);
+		orbitPropagator.odeIntegrator.do_step(boost::ref(orbitPropagator), orbitStates, initTime, dt, errors);
 		
-		for (auto error : errors)
+		for (auto& orbit : orbits)
 		{
-			double errorMag = error.pos.norm();
+			double errorMag = errors.segment(orbit.offset, 3).norm();
 			if (errorMag > 0.001)
 			{
-				BOOST_LOG_TRIVIAL(warning) << " Integrator error " << errorMag << " greater than 1mm for " << error.Sat << " " << error.str;
+				BOOST_LOG_TRIVIAL(warning) << " Integrator error " << errorMag << " greater than 1mm for " << orbit.Sat << " " << orbit.str;
 			}
 		}
 	}
+	
+	unpackOrbits(orbitStates, orbits);
+}
+
+/** Integrate orbits using an error controlled step size.
+* Each satellite's position error estimate is compared with the tolerance from its satellite options, the step size is limited to suit all satellites.
+* The accepted steps may be recorded to allow interpolation of the orbits at intermediate times
+*/
+void integrateOrbitsAdaptive(
+	OrbitIntegrator&	orbitPropagator,	///< Integrator to use
+	Orbits&				orbits,				///< Orbits to integrate
+	double				integrationPeriod,	///< Time to integrate over (s), may be negative
+	OrbitTrajectory*	trajectory_ptr)		///< Optional trajectory to record accepted steps in
+{
+	Instrument instrument(__FUNCTION__);
+	
+	if	( orbits.empty()
+		||integrationPeriod == 0)
+	{
+		return;
+	}
+	
+	double sign = integrationPeriod > 0 ? +1 : -1;
+	
+	vector<double>	toleranceList;
+	double			minStep	= 0;
+	double			maxStep	= fabs(integrationPeriod);
+	
+	for (auto& orbit : orbits)
+	{
+		auto& satOpts = acsConfig.getSatOpts(orbit.Sat);
+		
+		toleranceList.push_back(satOpts.sat_integrator.tolerance);
+		
+		minStep = std::max(minStep, satOpts.sat_integrator.min_step);
+		maxStep = std::min(maxStep, satOpts.sat_integrator.max_step);
+	}
+	
+	if (minStep > maxStep)
+	{
+		minStep = maxStep;
+	}
+	
+	orbitPropagator.orbits_ptr = &orbits;
+	
+	OrbitStateVector orbitStates = packOrbits(orbits);
+	OrbitStateVector orbitStatesNew;
+	OrbitStateVector derivatives;
+	OrbitStateVector errors;
+	
+	double t	= 0;
+	double dt	= sign * std::clamp(orbitPropagator.propagationOptions.integrator_time_step, minStep, maxStep);
+	
+	orbitPropagator(orbitStates, derivatives, t);
+	
+	if (trajectory_ptr)
+	{
+		trajectory_ptr->nodeList.clear();
+		trajectory_ptr->nodeList.push_back({t, orbitStates, derivatives});
+	}
+	
+	while (sign * (integrationPeriod - t) > 0)
+	{
+		bool lastStep = false;
+		if (sign * (t + dt - integrationPeriod) >= 0)
+		{
+			dt			= integrationPeriod - t;
+			lastStep	= true;
+		}
+		
+		orbitStatesNew = orbitStates;
+		orbitPropagator.odeIntegrator.do_step(boost::ref(orbitPropagator), orbitStatesNew, derivatives, t, dt, errors);
+		
+		//find the worst error relative to each satellite's tolerance
+		double errorRatio = 0;
+		for (int i = 0; i < orbits.size(); i++)
+		{
+			auto& orbit = orbits[i];
+			
+			double errorMag = errors.segment(orbit.offset, 3).norm();
+			
+			errorRatio = std::max(errorRatio, errorMag / toleranceList[i]);
+		}
+		
+		//standard step size controller for an 8th order error estimate
+		double scale = 5;
+		if (errorRatio > 0)
+		{
+			scale = std::clamp(0.9 * pow(errorRatio, -1.0 / 8), 0.2, 5.0);
+		}
+		
+		if	( errorRatio > 1
+			&&fabs(dt) > minStep)
+		{
+			//reject and retry with a smaller step
+			dt = sign * std::clamp(fabs(dt) * scale, minStep, maxStep);
+			
+			continue;
+		}
+		
+		if (errorRatio > 1)
+		{
+			BOOST_LOG_TRIVIAL(warning) << "Warning: Integrator error exceeds tolerance at minimum step size " << minStep;
+		}
+		
+		if (lastStep)	t = integrationPeriod;
+		else			t += dt;
+		
+		std::swap(orbitStates, orbitStatesNew);
+		
+		orbitPropagator(orbitStates, derivatives, t);
+		
+		if (trajectory_ptr)
+		{
+			trajectory_ptr->nodeList.push_back({t, orbitStates, derivatives});
+		}
+		
+		dt = sign * std::clamp(fabs(dt) * scale, minStep, maxStep);
+	}
+	
+	unpackOrbits(orbitStates, orbits);
+}
+
+/** Find orbits at a time within an adaptive integration, using the recorded steps.
+* Positions use quintic hermite interpolation of the positions, velocities and accelerations at the ends of the step,
+* other elements use cubic hermite interpolation of their values and derivatives
+*/
+bool interpolateOrbits(
+	const OrbitTrajectory&	trajectory,		///< Recorded steps of an integration
+	double					t,				///< Time offset from the start of the integration to interpolate to
+	Orbits&					orbits)			///< Orbits to output, as used for the integration
+{
+	auto& nodeList = trajectory.nodeList;
+	
+	if (nodeList.empty())
+	{
+		return false;
+	}
+	
+	int size = setOrbitOffsets(orbits);
+	if (size != nodeList.front().x.size())
+	{
+		return false;
+	}
+	
+	double sign = 1;
+	if (nodeList.back().t < nodeList.front().t)
+	{
+		sign = -1;
+	}
+	
+	if	( sign * (t - nodeList.front().t)	< 0
+		||sign * (t - nodeList.back().t)	> 0)
+	{
+		return false;
+	}
+	
+	//find the step containing the time
+	auto node_it = std::lower_bound(nodeList.begin(), nodeList.end(), t, [sign](const OrbitNode& node, double t)
+	{
+		return sign * (node.t - t) < 0;
+	});
+	
+	if (node_it == nodeList.begin())
+	{
+		unpackOrbits(node_it->x, orbits);
+		
+		return true;
+	}
+	
+	auto& node1 = *node_it;
+	auto& node0 = *std::prev(node_it);
+	
+	double h	= node1.t - node0.t;
+	double s	= (t - node0.t) / h;
+	double s2	= s		* s;
+	double s3	= s2	* s;
+	double s4	= s3	* s;
+	double s5	= s4	* s;
+	
+	//cubic hermite basis
+	double h00	=  2 * s3 - 3 * s2 + 1;
+	double h10	=      s3 - 2 * s2 + s;
+	double h01	= -2 * s3 + 3 * s2;
+	double h11	=      s3 -     s2;
+	
+	OrbitStateVector orbitStates	= h00 * node0.x
+									+ h10 * h * node0.dxdt
+									+ h01 * node1.x
+									+ h11 * h * node1.dxdt;
+	
+	//quintic hermite basis
+	double H0	= 1			- 10 * s3	+ 15 * s4	- 6 * s5;
+	double H1	= s			- 6 * s3	+ 8 * s4	- 3 * s5;
+	double H2	= 0.5 * s2	- 1.5 * s3	+ 1.5 * s4	- 0.5 * s5;
+	double H3	=			  0.5 * s3	- 1 * s4	+ 0.5 * s5;
+	double H4	=			- 4 * s3	+ 7 * s4	- 3 * s5;
+	double H5	=			  10 * s3	- 15 * s4	+ 6 * s5;
+	
+	for (auto& orbit : orbits)
+	{
+		int o = orbit.offset;
+		
+		orbitStates.segment(o, 3)	= H0		* node0.x	.segment(o,		3)
+									+ H1 * h	* node0.x	.segment(o + 3,	3)
+									+ H2 * h * h* node0.dxdt.segment(o + 3,	3)
+									+ H3 * h * h* node1.dxdt.segment(o + 3,	3)
+									+ H4 * h	* node1.x	.segment(o + 3,	3)
+									+ H5		* node1.x	.segment(o,		3);
+	}
+	
+	unpackOrbits(orbitStates, orbits);
+	
+	return true;
 }
 
 /** Get the estimated elements for a single satellite's orbit
@@ -615,7 +947,9 @@ void predictOrbits(
 	integrator.timeInit				= kfState.time;
 	integrator.propagationOptions	= acsConfig.orbitPropagation;
 
-	integrateOrbits(integrator, orbits, tgap, acsConfig.orbitPropagation.integrator_time_step);
+	//only the orbits at the end of the gap are used for the transition, so no trajectory is recorded for interpolation
+	if (acsConfig.orbitPropagation.adaptive_integrator)		integrateOrbitsAdaptive	(integrator, orbits, tgap);
+	else													integrateOrbits			(integrator, orbits, tgap, acsConfig.orbitPropagation.integrator_time_step);
 
 	applyOrbits(trace, orbits, kfState, time, tgap);
 };
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <boost/numeric/odeint.hpp>
+#include <boost/numeric/odeint/external/eigen/eigen.hpp>
 
 #include <fstream>
 #include <vector>
@@ -31,6 +32,9 @@ struct EMP
 	double		value		= 0;
 };
 
+/** Per-satellite data for orbit propagation.
+* The propagated values themselves are held in a contiguous OrbitStateVector during integration, and are unpacked here afterwards
+*/
 struct OrbitState
 {
 	SatSys	Sat;
@@ -49,121 +53,71 @@ struct OrbitState
 	Vector3d	pos;
 	Vector3d	vel;
 	MatrixXd	posVelSTM;
-
-	OrbitState& operator+=(double rhs)
-	{
-		pos			= (pos		.array() + rhs).matrix();
-		vel			= (vel		.array() + rhs).matrix();
-		posVelSTM	= (posVelSTM.array() + rhs).matrix();
-		return *this;
-	}
-	
-	OrbitState& operator*=(double rhs)
-	{
-		pos			*= rhs;
-		vel			*= rhs;
-		posVelSTM	*= rhs;
-		return *this;
-	}
 	
-	OrbitState operator+(double rhs) const
-	{
-		OrbitState newState = *this;
-		newState += rhs;
-		return newState;
-	}
-	
-	OrbitState operator+(const OrbitState& rhs) const
-	{
-		OrbitState newState = *this;
-		newState.pos		+= rhs.pos;
-		newState.vel		+= rhs.vel;
-		newState.posVelSTM	+= rhs.posVelSTM;
-		return newState;
-	}
+	int			offset		= 0;	///< Position of this orbit's block in an OrbitStateVector
 	
-	OrbitState operator*(double rhs) const
+	/** Number of elements in this orbit's block of an OrbitStateVector
+	*/
+	int blockSize() const
 	{
-		OrbitState newState = *this;
-		newState *= rhs;
-		return newState;
+		return 6 + posVelSTM.size();
 	}
 };
 
 
 typedef vector<OrbitState> Orbits;
 
-inline OrbitState operator*(
-	const	double		lhs, 
-	const	OrbitState&	rhs)
-{
-	return rhs * lhs;
-};
+/** Contiguous integration state for a set of orbits.
+* Each orbit occupies a block containing its position, velocity, and column-major 6xN variational matrix, starting at its OrbitState::offset.
+* Eigen's expression templates allow the integrator's vector space operations to be evaluated in place without allocation
+*/
+typedef VectorXd OrbitStateVector;
 
-inline Orbits operator+(
-	const Orbits& lhs,
-	const Orbits& rhs)
-{
-	Orbits newState = lhs;
-	for (int i = 0; i < lhs.size(); i++)
-	{
-		newState[i] = lhs[i] + rhs[i];
-	}
-	return newState;
-}
+OrbitStateVector packOrbits(
+	Orbits&						orbits);
 
-inline Orbits operator*(
-	const Orbits&	lhs, 
-	const double	rhs)
-{
-	Orbits newState = lhs;
-	for (int i = 0; i < lhs.size(); i++)
-	{
-		newState[i] *= rhs;
-	}
-	return newState;
-}
-
-inline Orbits operator*(
-	const double rhs, 
-	const Orbits& lhs)
-{
-	Orbits newState = lhs;
-	for (int i = 0; i < lhs.size(); i++)
-	{
-		newState[i] *= rhs;
-	}
-	return newState;
-}
+void unpackOrbits(
+	const OrbitStateVector&		orbitStates,
+	Orbits&						orbits);
 
 
-struct OrbitIntegrator
+/** Values that are common to all orbits at a single time
+*/
+struct OrbitCommon
 {
-	GTime						timeInit;
-	OrbitPropagation  			propagationOptions;
-
-	//Common parameter for all integrators.
 	Matrix3d eci2ecf;
 	Matrix3d deci2ecf;
 	
 	map<E_ThirdBody, Vector3dInit> planetsPosMap;
 	map<E_ThirdBody, Vector3dInit> planetsVelMap;
 	
-	MatrixXd Cnm;
-	MatrixXd Snm;
+	MatrixXd dCnm;		///< Time varying (tidal) corrections to the low degree terms of the static gravity field
+	MatrixXd dSnm;		///< Time varying (tidal) corrections to the low degree terms of the static gravity field
+};
+
+struct OrbitIntegrator : OrbitCommon
+{
+	GTime						timeInit;
+	OrbitPropagation  			propagationOptions;
+	
+	map<double, OrbitCommon>	commonCache;	///< Common values by time offset, reused by integrator stages and steps that share evaluation times
+
+	const Orbits*	orbits_ptr	= nullptr;	///< Per-satellite data for the orbits being integrated
 
-	runge_kutta_fehlberg78<Orbits, double, Orbits, double, vector_space_algebra> odeIntegrator;
+	runge_kutta_fehlberg78<OrbitStateVector, double, OrbitStateVector, double, vector_space_algebra> odeIntegrator;
 	
 	void operator()(
-		const	Orbits&	orbInit, 
-				Orbits&	orbUpdate, 
-		const	double	mjdSec);
+		const	OrbitStateVector&	orbInits, 
+				OrbitStateVector&	orbUpdates, 
+		const	double				mjdSec);
 
 	void computeCommon(
 		const	double	mjdinsec);
 	
 	void computeAcceleration(
-		const	OrbitState&	orbInit,
+		const	OrbitState&	orbit,
+		const	Vector3d&	pos,
+		const	Vector3d&	vel,
 				Vector3d&	acc,
 				Matrix3d&	dAdPos,
 				Matrix3d&	dAdVel,
@@ -190,6 +144,33 @@ void integrateOrbits(
 	double				integrationPeriod,
 	double 				dt);
 
+/** Accepted step of an adaptive orbit integration
+*/
+struct OrbitNode
+{
+	double				t;			///< Time offset of the node from the start of the integration
+	OrbitStateVector	x;			///< Orbit states at the node
+	OrbitStateVector	dxdt;		///< Derivatives of the orbit states at the node
+};
+
+/** Dense output of an adaptive orbit integration, so that orbits may be found at any time within the integrated period without re-integrating
+*/
+struct OrbitTrajectory
+{
+	vector<OrbitNode>	nodeList;	///< Accepted steps, in order of integration
+};
+
+void integrateOrbitsAdaptive(
+	OrbitIntegrator&	orbitPropagator,
+	Orbits&				orbits,
+	double				integrationPeriod,
+	OrbitTrajectory*	trajectory_ptr = nullptr);
+
+bool interpolateOrbits(
+	const OrbitTrajectory&	trajectory,
+	double					t,
+	Orbits&					orbits);
+
 void addKFSatEMPStates( 
 			KalmanModel&	model, 
 	const	KFState&		kfState,
@@ -497,26 +497,59 @@ void reloadInputFiles()
 
 	static bool once = true;
 	removeInvalidFiles(acsConfig.snx_files);
+	
+	//load a few files at a time concurrently, then parse them in order, releasing each buffer once it is read
+	vector<string> snxFileList;
 	for (auto& snxfile : acsConfig.snx_files)
 	{
 		if (fileChanged(snxfile) == false)
 		{
 			continue;
 		}
+		
+		snxFileList.push_back(snxfile);
+	}
+	
+	const int maxLoadedSnx = 4;
+	
+	for (int batchStart = 0; batchStart < snxFileList.size(); batchStart += maxLoadedSnx)
+	{
+		int batchStop = std::min((int) snxFileList.size(), batchStart + maxLoadedSnx);
+		
+		vector<string> batchFileList(snxFileList.begin() + batchStart, snxFileList.begin() + batchStop);
+		
+		vector<char> snxLoadedList;
+		auto snxBufferList = loadSinexFiles(batchFileList, snxLoadedList);
+		
+		for (int i = 0; i < batchFileList.size(); i++)
+		{
+			auto& snxfile = batchFileList[i];
 
-		BOOST_LOG_TRIVIAL(info)
-		<< "Loading SNX file " <<  snxfile;
+			BOOST_LOG_TRIVIAL(info)
+			<< "Loading SNX file " <<  snxfile;
 
-		bool fail = readSinex(snxfile, once);
-		if (fail)
-		{
-			BOOST_LOG_TRIVIAL(error)
-			<< "Error: Unable to load SINEX file " << snxfile;
+			if (snxLoadedList[i] == false)
+			{
+				BOOST_LOG_TRIVIAL(error)
+				<< "Error: Unable to read SINEX file " << snxfile;
 
-			continue;
-		}
+				continue;
+			}
+
+			bool fail = readSinex(snxfile, once, &snxBufferList[i]);
+			
+			string().swap(snxBufferList[i]);
+			
+			if (fail)
+			{
+				BOOST_LOG_TRIVIAL(error)
+				<< "Error: Unable to load SINEX file " << snxfile;
 
-		once = false;
+				continue;
+			}
+
+			once = false;
+		}
 	}
 	
 	removeInvalidFiles(acsConfig.vmf_files);
@@ -863,6 +896,7 @@ void createDirectories(
 								acsConfig.trop_sinex_directory,
 								acsConfig.bias_sinex_directory,
 								acsConfig.persistance_directory,
+								acsConfig.profile_directory,
 								acsConfig.pppOpts.rts_directory,
 								acsConfig.decoded_rtcm_json_directory,
 								acsConfig.encoded_rtcm_json_directory,
@@ -916,6 +950,8 @@ void createTracefiles(
 			if	( acsConfig.process_network
 				||acsConfig.process_ppp)
 			{
+				string oldBasename = net.kfState.rts_basename;
+				
 				bool newTraceFile = createNewTraceFile(net.id,		boost::posix_time::not_a_date_time,	acsConfig.pppOpts.rts_filename,		net.kfState.rts_basename);
 			
 				if (newTraceFile)
@@ -924,12 +960,30 @@ void createTracefiles(
 					std::remove((net.kfState.rts_basename					).c_str());
 					std::remove((net.kfState.rts_basename + FORWARD_SUFFIX	).c_str());
 					std::remove((net.kfState.rts_basename + BACKWARD_SUFFIX	).c_str());
+					
+					removeSerialRecordBuffer	(oldBasename + FORWARD_SUFFIX);
+					removeFilterArchive			(oldBasename + FORWARD_SUFFIX);
+					removeFilterArchive			(oldBasename + BACKWARD_SUFFIX);
+					
+					if	( acsConfig.pppOpts.rts_in_memory
+						&&acsConfig.pppOpts.rts_lag > 0)
+					{
+						enableSerialRecordBuffer(net.kfState.rts_basename + FORWARD_SUFFIX, acsConfig.retain_rts_files);
+					}
+					
+					if (acsConfig.pppOpts.rts_compact_archive)
+					{
+						enableFilterArchive(net.kfState.rts_basename + FORWARD_SUFFIX);
+						enableFilterArchive(net.kfState.rts_basename + BACKWARD_SUFFIX);
+					}
 				}
 			}
 			
 			if (acsConfig.process_user)
 			for (auto& [id, rec] : stationMap)
 			{
+				string oldBasename = rec.pppState.rts_basename;
+				
 				bool newTraceFile = createNewTraceFile(id,			boost::posix_time::not_a_date_time,	acsConfig.pppOpts.rts_filename,		rec.pppState.rts_basename);
 				
 				if (newTraceFile)
@@ -938,6 +992,22 @@ void createTracefiles(
 					std::remove((rec.pppState.rts_basename					).c_str());
 					std::remove((rec.pppState.rts_basename + FORWARD_SUFFIX	).c_str());
 					std::remove((rec.pppState.rts_basename + BACKWARD_SUFFIX).c_str());
+					
+					removeSerialRecordBuffer	(oldBasename + FORWARD_SUFFIX);
+					removeFilterArchive			(oldBasename + FORWARD_SUFFIX);
+					removeFilterArchive			(oldBasename + BACKWARD_SUFFIX);
+					
+					if	( acsConfig.pppOpts.rts_in_memory
+						&&acsConfig.pppOpts.rts_lag > 0)
+					{
+						enableSerialRecordBuffer(rec.pppState.rts_basename + FORWARD_SUFFIX, acsConfig.retain_rts_files);
+					}
+					
+					if (acsConfig.pppOpts.rts_compact_archive)
+					{
+						enableFilterArchive(rec.pppState.rts_basename + FORWARD_SUFFIX);
+						enableFilterArchive(rec.pppState.rts_basename + BACKWARD_SUFFIX);
+					}
 				}
 			}
 		}
@@ -1117,6 +1187,12 @@ void createTracefiles(
 		createNewTraceFile("",			logptime,	acsConfig.log_filename,								FileLog::path_log);
 	}
 	
+	if (acsConfig.output_profile)
+	{
+		createNewTraceFile("",			logptime,	acsConfig.profile_filename,							Instrument::profileFilename);
+		createNewTraceFile("",			logptime,	acsConfig.profile_summary_filename,					Instrument::summaryFilename);
+	}
+	
 	if (acsConfig.output_ntrip_log)
 	{
 		for (auto& [id, stream_ptr] : ntripBroadcaster.ntripUploadStreams)
@@ -1438,15 +1514,41 @@ void outputPredictedStates(
 		GTime orbitsTime	= tsync;
 		GTime stopTime		= tsync + sign * duration;
 		
-		for (GTime time = tsync; sign * (time - stopTime).to_double() <= 0; time += sign * mongoOptions.prediction_interval)
+		//with an adaptive integrator, integrate once over the whole period and interpolate the intermediate epochs
+		OrbitTrajectory trajectory;
+		if (acsConfig.orbitPropagation.adaptive_integrator)
 		{
 			OrbitIntegrator integrator;
-			integrator.timeInit				= orbitsTime;
+			integrator.timeInit				= tsync;
 			integrator.propagationOptions	= acsConfig.orbitPropagation;
-
-			double tgap = (time - orbitsTime).to_double();
 			
-			integrateOrbits(integrator, orbits, tgap, acsConfig.orbitPropagation.integrator_time_step);
+			Orbits finalOrbits = orbits;
+			
+			integrateOrbitsAdaptive(integrator, finalOrbits, sign * duration, &trajectory);
+		}
+		
+		for (GTime time = tsync; sign * (time - stopTime).to_double() <= 0; time += sign * mongoOptions.prediction_interval)
+		{
+			if (acsConfig.orbitPropagation.adaptive_integrator)
+			{
+				bool pass = interpolateOrbits(trajectory, (time - tsync).to_double(), orbits);
+				if (pass == false)
+				{
+					BOOST_LOG_TRIVIAL(warning) << "Warning: Orbits could not be interpolated to " << time.to_string() << ", predictions not output";
+					
+					continue;
+				}
+			}
+			else
+			{
+				OrbitIntegrator integrator;
+				integrator.timeInit				= orbitsTime;
+				integrator.propagationOptions	= acsConfig.orbitPropagation;
+
+				double tgap = (time - orbitsTime).to_double();
+				
+				integrateOrbits(integrator, orbits, tgap, acsConfig.orbitPropagation.integrator_time_step);
+			}
 			
 			orbitsTime = time;
 			
@@ -1518,28 +1620,29 @@ void mainPerEpochPostProcessingAndOutputs(
 	}
 	
 	
-	KFState tempAugmentedKF = net.kfState;
-	
-	tempAugmentedKF.rts_basename = "";
+	//outputs share the filter state rather than copying it, a private copy is only made if it needs to be modified
+	auto tempAugmentedKF = KFStateSnapshot::borrow(net.kfState);
 	
 	if (acsConfig.process_network)
 	{
-		tempAugmentedKF.outputStates(netTrace);
-		
-		KFState KF_ARcopy = net.kfState;
+		tempAugmentedKF.view().outputStates(netTrace);
 		
-		KF_ARcopy.outputMongoMeasurements = false;
+		auto KF_ARcopy = KFStateSnapshot::borrow(net.kfState);
 		
 		if (acsConfig.ambrOpts.mode != +E_ARmode::OFF)
 		{
-			networkAmbigResl(netTrace, stationMap, KF_ARcopy);
+			auto& fixedKF = KF_ARcopy.edit();
+			
+			fixedKF.outputMongoMeasurements = false;
+			
+			networkAmbigResl(netTrace, stationMap, fixedKF);
 			
 			if (ARsol_ready())
 			{
-				KF_ARcopy.outputStates(netTrace, "/AR");
+				fixedKF.outputStates(netTrace, "/AR");
 			}
 
-			mongoStates(KF_ARcopy, "_AR");
+			mongoStates(fixedKF, "_AR");
 		}
 		
 		if (acsConfig.output_clocks)
@@ -1547,11 +1650,11 @@ void mainPerEpochPostProcessingAndOutputs(
 			if	( acsConfig.output_ar_clocks == false
 				|| ARsol_ready() == false)
 			{
-				outputClocks(acsConfig.clocks_filename, acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, tsync, tempAugmentedKF,	&stationMap);
+				outputClocks(acsConfig.clocks_filename, acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, tsync, tempAugmentedKF	.view(),	&stationMap);
 			}
 			else
 			{
-				outputClocks(acsConfig.clocks_filename, acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, tsync, KF_ARcopy,		&stationMap);
+				outputClocks(acsConfig.clocks_filename, acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, tsync, KF_ARcopy		.view(),	&stationMap);
 			}
 		}
 		
@@ -1567,9 +1670,9 @@ void mainPerEpochPostProcessingAndOutputs(
 				rec.minconApriori = rec.aprioriPos;
 			}
 			
-			mincon(netTrace, tempAugmentedKF);
+			mincon(netTrace, tempAugmentedKF.edit());
 	
-			mongoStates(tempAugmentedKF, "_mincon");
+			mongoStates(tempAugmentedKF.view(), "_mincon");
 		}
 		
 		if (acsConfig.output_erp)
@@ -1581,18 +1684,23 @@ void mainPerEpochPostProcessingAndOutputs(
 			&& acsConfig.pppOpts.rts_lag > 0)
 		{
 			RTS_Process(net.kfState,	false, &stationMap);
-			RTS_Process(KF_ARcopy,		false, &stationMap);
+			
+			//the borrowed state has the filter's rts files, only a resolved copy is smoothed separately
+			if (acsConfig.ambrOpts.mode != +E_ARmode::OFF)
+			{
+				RTS_Process(KF_ARcopy.edit(),	false, &stationMap);
+			}
 
 			if (ARsol_ready())
 			{
-				outputClocks(acsConfig.clocks_filename, acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, tsync, KF_ARcopy, &stationMap);
+				outputClocks(acsConfig.clocks_filename, acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, tsync, KF_ARcopy.view(), &stationMap);
 			}
 		}
 	}
 	
 	if (acsConfig.process_ppp)
 	{
-		KFState KF_ARcopy;
+		KFStateSnapshot KF_ARcopy;
 		
 		/* select ambiguity resolved KF */
 		if (acsConfig.ambrOpts.mode != +E_ARmode::OFF)
@@ -1602,7 +1710,7 @@ void mainPerEpochPostProcessingAndOutputs(
 				tempAugmentedKF = KF_ARcopy;
 			}
 			
-			mongoStates(tempAugmentedKF, "_AR");
+			mongoStates(tempAugmentedKF.view(), "_AR");
 		}	
 			
 		
@@ -1619,9 +1727,9 @@ void mainPerEpochPostProcessingAndOutputs(
 				rec.minconApriori = rec.aprioriPos;
 			}
 			
-			mincon(netTrace, tempAugmentedKF);
+			mincon(netTrace, tempAugmentedKF.edit());
 	
-			mongoStates(tempAugmentedKF, "_mincon");
+			mongoStates(tempAugmentedKF.view(), "_mincon");
 		}
 		
 		if (acsConfig.output_erp)
@@ -1631,7 +1739,7 @@ void mainPerEpochPostProcessingAndOutputs(
 		
 		if (acsConfig.output_clocks)
 		{
-			outputClocks(acsConfig.clocks_filename, acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, tsync, tempAugmentedKF, &stationMap);
+			outputClocks(acsConfig.clocks_filename, acsConfig.clocks_receiver_sources, acsConfig.clocks_satellite_sources, tsync, tempAugmentedKF.view(), &stationMap);
 		}
 		
 		if	(  acsConfig.process_rts
@@ -1647,18 +1755,18 @@ void mainPerEpochPostProcessingAndOutputs(
 		if	(  ARsol_ready() 
 			&& acsConfig.output_ar_clocks)
 		{
-			KFState KF_ARcopy = retrieve_last_ARcopy();
-			prepareSsrStates(netTrace, KF_ARcopy,		tsync);
+			KFStateSnapshot KF_ARcopy = retrieve_last_ARcopy();
+			prepareSsrStates(netTrace, KF_ARcopy		.view(),	tsync);
 		}
 		else
 		{
-			prepareSsrStates(netTrace, tempAugmentedKF,	tsync);
+			prepareSsrStates(netTrace, tempAugmentedKF	.view(),	tsync);
 		}
 	}
 	
 	if (acsConfig.output_sp3)
 	{
-		outputSp3(acsConfig.sp3_filename, tsync, acsConfig.sp3_orbit_sources, acsConfig.sp3_clock_sources, &tempAugmentedKF);
+		outputSp3(acsConfig.sp3_filename, tsync, acsConfig.sp3_orbit_sources, acsConfig.sp3_clock_sources, &tempAugmentedKF.view());
 	}
 	
 	if (acsConfig.output_orbex)
@@ -1695,7 +1803,11 @@ void mainPerEpochPostProcessingAndOutputs(
 	mongoCull(tsync);
 }
 
-void mainOncePerEpochPerSatellite(
+/** Prepare a satellite for the epoch.
+ * Finding svns and block types may reinitialise the satellite's options, so this is done sequentially.
+ * Returns false if the satellite is excluded
+*/
+bool mainOncePerEpochPerSatellite(
 	Trace&	trace,
 	GTime	time,
 	SatSys	Sat)
@@ -1705,7 +1817,7 @@ void mainOncePerEpochPerSatellite(
 	
 	if (satOpts.exclude)
 	{
-		return;
+		return false;
 	}
 	
 	//get svn and block type if possible
@@ -1747,6 +1859,23 @@ void mainOncePerEpochPerSatellite(
 	
 	satOpts = acsConfig.getSatOpts(Sat);
 	
+	satNav.antBoresight	= satOpts.antenna_boresight;
+	satNav.antAzimuth	= satOpts.antenna_azimuth;
+	
+	return true;
+}
+
+/** Position and attitude of a satellite at the epoch.
+ * These are shared by all stations, so they are computed once per epoch, in parallel across satellites
+*/
+void updateSatelliteEpochState(
+	GTime				time,				///< Time of epoch
+	SatSys				Sat,				///< Satellite to update
+	SatelliteOptions&	satOpts,			///< Options of the satellite
+	FrameSwapper&		frameSwapper)		///< Frame conversions for the epoch
+{
+	auto& satNav = nav.satNavMap.at(Sat);
+	
 	GObs obs;
 	obs.Sat			= Sat;
 	obs.time		= time;
@@ -1758,15 +1887,9 @@ void mainOncePerEpochPerSatellite(
 		BOOST_LOG_TRIVIAL(warning) << "Warning: No sat pos found for " << obs.Sat.id() << ".";
 	}
 	
-	ERPValues erpv = getErp(nav.erp, tsync);
-	
-	FrameSwapper frameSwapper(time, erpv);
-	
 	obs.rSatEci0 = frameSwapper(obs.rSat);
 	
 	satNav.aprioriPos	= obs.rSatEci0;
-	satNav.antBoresight	= satOpts.antenna_boresight;
-	satNav.antAzimuth	= satOpts.antenna_azimuth;
 	
 	updateSatAtts(obs);
 }
@@ -1780,6 +1903,11 @@ void mainOncePerEpoch(
 	//load any changes from the config
 	bool newConfig = acsConfig.parse();
 	
+	//switch profiling on or off as configured
+	Instrument::enabled = acsConfig.output_profile;
+	
+	Instrument instrument(__FUNCTION__);
+	
 	avoidCollisions(stationMap);
 	
 	//reload any new or modified files
@@ -1801,28 +1929,61 @@ void mainOncePerEpoch(
 	mongoooo();
 
 	//try to get svns & block types of all used satellites
+	vector<pair<SatSys, SatelliteOptions*>> satList;
 	for (auto& [Sat, satNav] : nav.satNavMap)
 	{
 		if (acsConfig.process_sys[Sat.sys] == false)
 			continue;
 	
-		mainOncePerEpochPerSatellite(netTrace, time, Sat);
+		bool used = mainOncePerEpochPerSatellite(netTrace, time, Sat);
+		if (used)
+		{
+			satList.push_back({Sat, &acsConfig.getSatOpts(Sat)});
+		}
+	}
+	
+	//svns and block types are known now, publish the options resolved so far so stations can read them without locking
+	acsConfig.publishOptsSnapshot();
+	
+	//get positions and attitudes of all used satellites, for all stations to share
+	{
+		ERPValues erpv = getErp(nav.erp, tsync);
+		
+		FrameSwapper frameSwapper(time, erpv);
+		
+#		ifdef ENABLE_PARALLELISATION
+#		ifndef ENABLE_UNIT_TESTS
+			Eigen::setNbThreads(1);
+#			pragma omp parallel for
+#		endif
+#		endif
+		for (int i = 0; i < satList.size(); i++)
+		{
+			auto& [Sat, satOpts_ptr] = satList[i];
+			
+			updateSatelliteEpochState(time, Sat, *satOpts_ptr, frameSwapper);
+		}
+		Eigen::setNbThreads(0);
 	}
 
 	//do per-station pre processing
+	vector<Station*> stationList;
+	stationList.reserve(stationMap.size());
+	for (auto& [id, rec] : stationMap)
+	{
+		stationList.push_back(&rec);
+	}
+	
 	bool emptyEpoch = true;
 #	ifdef ENABLE_PARALLELISATION
 #	ifndef ENABLE_UNIT_TESTS
 		Eigen::setNbThreads(1);
-#		pragma omp parallel for
+#		pragma omp parallel for schedule(dynamic)
 #	endif
 #	endif
-	for (int i = 0; i < stationMap.size(); i++)
+	for (int i = 0; i < stationList.size(); i++)
 	{
-		auto rec_ptr_iterator = stationMap.begin();
-		std::advance(rec_ptr_iterator, i);
-
-		auto& [id, rec] = *rec_ptr_iterator;
+		auto& rec = *stationList[i];
 		mainOncePerEpochPerStation(rec, net, emptyEpoch);
 	}
 	Eigen::setNbThreads(0);
@@ -1992,6 +2153,8 @@ void mainPostProcessing(
 	outputSummaries(netTrace, stationMap);
 	
 	outputStatistics(netTrace, net.kfState.statisticsMapSum, net.kfState.statisticsMapSum);
+	
+	Instrument::epochMark(epoch, "post processing");
 }
 
 int ginan(
@@ -2432,6 +2595,8 @@ int ginan(
 			mainOncePerEpoch(net, stationMap, tsync);
 		}
 		GTime epochStopTime		= timeGet();
+		
+		Instrument::epochMark(epoch, tsync.to_string());
 
 		
 		
@@ -404,7 +404,7 @@ void mincon(
 		KFMeas pseudoMeas;
 		int rows = kfStateTrans.x.rows() - 1;
 		pseudoMeas.V = - kfStateTrans.x.bottomRows(rows);
-		pseudoMeas.H = Tdash;
+		pseudoMeas.H = Tdash.sparseView();
 		pseudoMeas.R = MatrixXd::Zero	(rows, rows);
 		pseudoMeas.obsKeys.resize		(rows);
 
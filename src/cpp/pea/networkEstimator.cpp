@@ -361,20 +361,7 @@ void networkEstimator(
 	KFMeasEntryList		kfMeasEntryList;
 	static Station*	refRec = nullptr;
 
-	for (auto& [Sat, satNav] : nav.satNavMap)
-	{
-		if (acsConfig.process_sys[Sat.sys] == false)
-		{
-			continue;
-		}
-		
-		auto& satOpts = acsConfig.getSatOpts(Sat);
-		
-		InitialState init = initialStateFromConfig(satOpts.orb);
-			
-		if (init.estimate)
-			orbPartials(trace, tsync, Sat, satNav.satPartialMat);	
-	}
+	updateOrbitPartials(trace, tsync);
 
 	for (auto& [id, rec]	: stations)
 	for (auto& obs 			: only<GObs>(rec.obsList))
@@ -226,11 +226,11 @@ bool satQuat(
 	bool				origGal	= false);
 
 int PPP_AR(
-	Trace&		trace,		
-	KFState&	kfState);
+	Trace&				trace,		
+	KFStateSnapshot&	snapshot);
 
 bool copyFixedKF(
-	KFState& fixed);
+	KFStateSnapshot& fixed);
 
 void overwriteFixedKF(
 	KFState& kfState);
@@ -22,7 +22,7 @@
 #include "common.hpp"
 #include "trace.hpp"
 
-KFState kfState_forAR;
+KFStateSnapshot kfState_forAR = KFStateSnapshot(KFState());
 
 bool	fixKFReady = false;
 
@@ -90,14 +90,16 @@ void applyUCAmbiguities(
 }
 
 int PPP_AR(
-	Trace&		trace,		///< Debug trace
-	KFState&	kfState)	///< Filter state
+	Trace&				trace,		///< Debug trace
+	KFStateSnapshot&	snapshot)	///< Filter state, which is shared as the fixed filter afterwards
 {
 	Instrument	instrument(__FUNCTION__);
+	
+	const KFState& kfState = *snapshot;
 		
 	tracepdeex(3,trace,"Ginan 2.0 AR: %s\n",kfState.time.to_string(2));
 	fixKFReady=false;
-	kfState_forAR = kfState;
+	kfState_forAR = snapshot;
 	
 	if (acsConfig.ambrOpts.mode == +E_ARmode::OFF)
 	{
@@ -142,17 +144,19 @@ int PPP_AR(
 	int nfix = GNSS_AR (trace, ARmtx, ARopt);
 	if (nfix>0)
 	{
-		applyUCAmbiguities (trace, kfState, ARmtx);
+		//release the fixed filter's reference first, so that the ambiguities are applied without duplicating the state
+		kfState_forAR = KFStateSnapshot();
+		
+		applyUCAmbiguities (trace, snapshot.edit(), ARmtx);
 		fixKFReady = true;
 	}
 	
-	kfState_forAR = kfState;
-	kfState_forAR.rts_basename = kfState.rts_basename + "_AR";
+	kfState_forAR = snapshot;
 	
 	return nfix;
 }
 
-bool copyFixedKF(KFState& fixed)
+bool copyFixedKF(KFStateSnapshot& fixed)
 {
 	fixed = kfState_forAR;
 	
@@ -164,7 +168,7 @@ bool copyFixedKF(KFState& fixed)
 void overwriteFixedKF(
 	KFState& kfState)
 {
-	kfState_forAR = kfState;
+	kfState_forAR = KFStateSnapshot(kfState);
 }
 
 bool queryBiasUC(
@@ -206,7 +210,7 @@ bool queryBiasUC(
 			
 			kfKey.type	= KF::CODE_BIAS;
 			
-			return kfState_forAR.getKFValue(kfKey,bias, &var);
+			return kfState_forAR->getKFValue(kfKey,bias, &var);
 		}
 		
 		if (type == PHAS)
@@ -223,7 +227,7 @@ bool queryBiasUC(
 			
 			kfKey.type	= KF::PHASE_BIAS;
 			
-			return kfState_forAR.getKFValue(kfKey, bias, &var);
+			return kfState_forAR->getKFValue(kfKey, bias, &var);
 		}
 	}
 	else if (rec.empty())
@@ -244,7 +248,7 @@ bool queryBiasUC(
 			
 			kfKey.type	= KF::CODE_BIAS;
 			string keyStr = kfKey;
-			bool pass = kfState_forAR.getKFValue(kfKey, bias, &var);
+			bool pass = kfState_forAR->getKFValue(kfKey, bias, &var);
 			tracepdeex(5,trace,"\n Searching UC %s - %s", keyStr.c_str(), pass?"found":"not found");
 			
 			return pass;
@@ -264,7 +268,7 @@ bool queryBiasUC(
 			
 			kfKey.type	= KF::PHASE_BIAS;
 			string keyStr = kfKey;
-			bool pass = kfState_forAR.getKFValue(kfKey, bias, &var);
+			bool pass = kfState_forAR->getKFValue(kfKey, bias, &var);
 			tracepdeex(5,trace,"\n Searching UC %s - %s", keyStr.c_str(), pass?"found":"not found");
 			
 			return pass;
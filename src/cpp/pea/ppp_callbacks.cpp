@@ -47,7 +47,7 @@ bool pseudoMeasTest(
 	
 	for (auto& [key, state] : kfState.kfIndexMap)
 	{
-		if	( kfMeas.H(index, state)
+		if	( kfMeas.H.coeff(index, state)
 			&&key.type == KF::ORBIT)
 		{
 			orbitGlitchReaction(trace, kfState, kfMeas, key);
@@ -243,7 +243,7 @@ bool rejectByState(
 	
 	for (int meas = 0; meas < kfMeas.H.rows(); meas++)
 	{
-		if (kfMeas.H(meas, stateIndex))
+		if (kfMeas.H.coeff(meas, stateIndex))
 		{
 			kfState.doMeasRejectCallbacks(trace, kfMeas, meas);
 		}
@@ -1110,27 +1110,13 @@ void stationPPP(
 		
 		auto& satOpts = acsConfig.getSatOpts(obs.Sat);
 		
-		satPosClk(trace, time, obs, nav, satOpts.sat_pos.ephemeris_sources, satOpts.sat_clock.ephemeris_sources, &kfState, E_OffsetType::COM, E_Relativity::OFF);
+		satPosClkCached(trace, time, obs, nav, satOpts.sat_pos.ephemeris_sources, satOpts.sat_clock.ephemeris_sources, &kfState, E_OffsetType::COM, E_Relativity::OFF);
 	}
 	
 	ERPValues erpv = getErp(nav.erp, time);
 	
 	FrameSwapper frameSwapper(time, erpv);
 	
-	for (auto& [Sat, satNav] : nav.satNavMap)
-	{
-		if (acsConfig.process_sys[Sat.sys] == false)
-		{
-			continue;
-		}
-		
-		auto& satOpts = acsConfig.getSatOpts(Sat);
-		
-		InitialState init	= initialStateFromConfig(satOpts.orb);
-		if (init.estimate)
-			orbPartials(trace, time, Sat, satNav.satPartialMat);	
-	}
-	
 	for (auto&	obs				: only<GObs>(rec.obsList))
 	for (auto&	[ft, sigList]	: obs.SigsLists)
 	for (auto&	sig				: sigList)
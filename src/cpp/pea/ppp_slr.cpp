@@ -205,9 +205,10 @@ inline void recTimeBias(COMMON_PPP_ARGS)
 
 /** Satellite orbit adjustments
  */
-inline void satOrbitAdjustment(COMMON_PPP_ARGS)
+inline void satOrbitAdjustment(COMMON_PPP_ARGS,
+	MatrixXd&	satPartialMat)		///< Orbit partials of the satellite at the time of this station's observations
 {
-	if (satNav.satOrbit.numUnknowns != satNav.satPartialMat.rows())
+	if (satNav.satOrbit.numUnknowns != satPartialMat.rows())
 	{
 		return;
 	}
@@ -226,7 +227,7 @@ inline void satOrbitAdjustment(COMMON_PPP_ARGS)
 			double adjustment = 0;
 			kfState.getKFValue(kfKey, adjustment);
 		
-			VectorXd orbitPartials = satNav.satPartialMat * satStat.e;
+			VectorXd orbitPartials = satPartialMat * satStat.e;
 			measEntry.addDsgnEntry(kfKey, orbitPartials(i) * 2, init);
 			
 			double computed = adjustment * orbitPartials(i);
@@ -322,6 +323,9 @@ void stationSlr(
 	
 	FrameSwapper frameSwapper(time, erpv);
 	
+	//partials are at this station's observation time, so they are kept here rather than in the satNavs that other stations share
+	map<SatSys, MatrixXd> satPartialMatMap;
+	
 	for (auto& [Sat, satNav] : nav.satNavMap)
 	{
 		if (acsConfig.process_sys[Sat.sys] == false)
@@ -332,7 +336,7 @@ void stationSlr(
 		auto& satOpts = acsConfig.getSatOpts(Sat);
 		
 		if (satOpts.orb.estimate[0])
-			orbPartials(trace, time, Sat, satNav.satPartialMat);	
+			orbPartials(trace, time, Sat, satPartialMatMap[Sat]);	
 	}
 
 	
@@ -529,7 +533,7 @@ void stationSlr(
 		slrTroposphere		(COMMON_PPP_ARGS);
 		recRangeBias		(COMMON_PPP_ARGS);
 		recTimeBias			(COMMON_PPP_ARGS);
-		satOrbitAdjustment	(COMMON_PPP_ARGS);
+		satOrbitAdjustment	(COMMON_PPP_ARGS, satPartialMatMap[Sat]);
 		slrEops				(COMMON_PPP_ARGS);
 
 		//Calculate residuals and form up the measurement
@@ -19,9 +19,11 @@ using std::map;
 #include "eigenIncluder.hpp"
 #include "observations.hpp"
 #include "corrections.hpp"
+#include "ephemeris.hpp"
 #include "instrument.hpp"
 #include "mongoWrite.hpp"
 #include "navigation.hpp"
+#include "orbits.hpp"
 #include "orbitProp.hpp"
 #include "ionoModel.hpp"
 #include "acsConfig.hpp"
@@ -36,8 +38,8 @@ using std::map;
 	
 struct Duo
 {
-	map<KFKey, short int>*	indexMap_ptr;
-	MatrixXd*				designMatrix_ptr;
+	KFIndexMap*				indexMap_ptr;
+	RowSparseMatrix*		designMatrix_ptr;
 };
 
 void explainMeasurements(
@@ -59,9 +61,10 @@ void explainMeasurements(
 		trace << std::endl << "Explaining " << obsKey << " : " << obsKey.comment;
 		
 		
-		for (int col = 0; col < meas.H.cols(); col++)
+		for (RowSparseMatrix::InnerIterator it(meas.H, i); it; ++it)
 		{
-			double entry = meas.H(i, col);
+			int		col		= it.col();
+			double	entry	= it.value();
 			
 			if (entry == 0)
 			{
@@ -81,6 +84,25 @@ void explainMeasurements(
 	}
 }
 
+/** Non-zero entries of each column of a row-major design matrix, in row order, so that measurements sharing a state can be paired without searching rows
+ */
+vector<vector<tuple<int, double>>> designColumns(
+	RowSparseMatrix&	H)
+{
+	vector<vector<tuple<int, double>>> columnList(H.cols());
+	
+	for (int row = 0; row < H.outerSize(); row++)
+	for (RowSparseMatrix::InnerIterator it(H, row); it; ++it)
+	{
+		if (it.value() == 0)
+			continue;
+		
+		columnList[it.col()].push_back({row, it.value()});
+	}
+	
+	return columnList;
+}
+
 /** Replace individual measurements with linear combinations
  */
 KFMeas makeIFLCs(
@@ -100,10 +122,10 @@ KFMeas makeIFLCs(
 		{&kfState.noiseIndexMap,	&combinedMeas.H_star}
 	};
 	
-	for (auto duo : duos)
-	for (auto& [kfKey, index] : *duo.indexMap_ptr)						{																if (kfKey.type != KF::IONO_STEC)	continue;
-	for (int i_2 = 0; i_2 < combinedMeas.obsKeys.size();	i_2++)		{	double coeff_2 = (*duo.designMatrix_ptr)(i_2, index);		if (coeff_2 == 0)					continue;	
-	for (int i_1 = 0; i_1 < i_2;							i_1++)		{	double coeff_1 = (*duo.designMatrix_ptr)(i_1, index);		if (coeff_1 == 0)					continue;
+	for (auto duo : duos)												{	auto columnList = designColumns(*duo.designMatrix_ptr);
+	for (auto& [kfKey, index] : *duo.indexMap_ptr)						{																if (kfKey.type != KF::IONO_STEC)	continue;		auto& column = columnList[index];
+	for (int j_2 = 0; j_2 < column.size();					j_2++)		{	auto [i_2, coeff_2] = column[j_2];
+	for (int j_1 = 0; j_1 < j_2;							j_1++)		{	auto [i_1, coeff_1] = column[j_1];
 	{
 		if (coeff_1 * coeff_2 < 0)								{	continue;	}	//only combine similarly signed (code/phase) components
 		if (coeff_1	== coeff_2)									{	continue;	}	//dont combine if it will eliminate the entire measurement
@@ -147,7 +169,7 @@ KFMeas makeIFLCs(
 		
 		combinedMeas.metaDataMaps[i_1]["IFLCcombined"] = (void*) true;
 		combinedMeas.metaDataMaps[i_2]["IFLCcombined"] = (void*) true;
-	}}}}
+	}}}}}
 	
 	if (meas == 0)
 	{
@@ -203,10 +225,10 @@ KFMeas makeGFLCs(
 		{&kfState.noiseIndexMap,	&combinedMeas.H_star}
 	};
 	
-	for (auto duo : duos)
-	for (auto& [kfKey, index] : *duo.indexMap_ptr)						{																if (kfKey.type != KF::IONO_STEC)	continue;
-	for (int i_2 = 0; i_2 < combinedMeas.obsKeys.size();	i_2++)		{	double coeff_2 = (*duo.designMatrix_ptr)(i_2, index);		if (coeff_2 == 0)					continue;	
-	for (int i_1 = 0; i_1 < i_2;							i_1++)		{	double coeff_1 = (*duo.designMatrix_ptr)(i_1, index);		if (coeff_1 == 0)					continue;
+	for (auto duo : duos)												{	auto columnList = designColumns(*duo.designMatrix_ptr);
+	for (auto& [kfKey, index] : *duo.indexMap_ptr)						{																if (kfKey.type != KF::IONO_STEC)	continue;		auto& column = columnList[index];
+	for (int j_2 = 0; j_2 < column.size();					j_2++)		{	auto [i_2, coeff_2] = column[j_2];
+	for (int j_1 = 0; j_1 < j_2;							j_1++)		{	auto [i_1, coeff_1] = column[j_1];
 	{
 		if (coeff_1 * coeff_2 < 0)								{	continue;	}
 		if (coeff_1	== coeff_2)									{	continue;	}	//dont combine if it will eliminate the entire measurement
@@ -251,7 +273,7 @@ KFMeas makeGFLCs(
 		
 		combinedMeas.metaDataMaps[i_1]["GFLCcombined"] = (void*) true;
 		combinedMeas.metaDataMaps[i_2]["GFLCcombined"] = (void*) true;
-	}}}}
+	}}}}}
 	
 	if (meas == 0)
 	{
@@ -310,10 +332,10 @@ KFMeas makeRTKLCs(
 		{&kfState.noiseIndexMap,	&combinedMeas.H_star}
 	};
 	
-	for (auto duo : duos)
-	for (auto& [kfKey, index] : *duo.indexMap_ptr)						{																if (kfKey.type != KF::SAT_CLOCK)	continue;
-	for (int i_2 = 0; i_2 < combinedMeas.obsKeys.size();	i_2++)		{	double coeff_2 = (*duo.designMatrix_ptr)(i_2, index);		if (coeff_2 == 0)					continue;	
-	for (int i_1 = 0; i_1 < i_2;							i_1++)		{	double coeff_1 = (*duo.designMatrix_ptr)(i_1, index);		if (coeff_1 == 0)					continue;
+	for (auto duo : duos)												{	auto columnList = designColumns(*duo.designMatrix_ptr);
+	for (auto& [kfKey, index] : *duo.indexMap_ptr)						{																if (kfKey.type != KF::SAT_CLOCK)	continue;		auto& column = columnList[index];
+	for (int j_2 = 0; j_2 < column.size();					j_2++)		{	auto [i_2, coeff_2] = column[j_2];
+	for (int j_1 = 0; j_1 < j_2;							j_1++)		{	auto [i_1, coeff_1] = column[j_1];
 	{
 		if (combinedMeas.metaDataMaps[i_1]["RTKcombined"])		{	continue;	}
 		if (combinedMeas.metaDataMaps[i_2]["RTKcombined"])		{	continue;	}
@@ -351,7 +373,7 @@ KFMeas makeRTKLCs(
 		
 		combinedMeas.metaDataMaps[i_1]["RTKcombined"] = (void*) true;
 		combinedMeas.metaDataMaps[i_2]["RTKcombined"] = (void*) true;
-	}}}}
+	}}}}}
 	
 	
 	for (int i = 0; i < combinedMeas.obsKeys.size(); i++)
@@ -626,10 +648,12 @@ KFState propagateUncertainty(
 		kfKey.type	= KF::CALC;
 		kfKey.str	= obsKey.str;
 		
-		propagatedState.kfIndexMap[kfKey] = i;
+		propagatedState.kfIndexMap.set(kfKey, i);
 		i++;
 	}
 	
+	propagatedState.kfIndexMap.reindex();
+	
 	return propagatedState;
 }
 
@@ -639,7 +663,7 @@ void chunkFilter(
 	KFMeas&						combinedMeas,
 	StationMap&					stationMap,
 	vector<FilterChunk>&		filterChunkList,
-	map<string, std::ofstream>&	traceList)	
+	map<string, TraceStream>&	traceList)	
 {	
 	if (acsConfig.pppOpts.station_chunking == false)
 	{
@@ -833,34 +857,67 @@ void PPP(
 	map<SatSys,int> activeSatMap;
 	{	
 		Instrument instrument("PPP obsOMC");
+		
+		//satellite states are shared between stations, start afresh for this epoch's states before any station reads them
+		clearSatPosClkCache();
+		updateOrbitPartials(trace, kfState.time);
 	
-		//calculate the measurements for each station
+		//prepare a list of the stations with observations this epoch, with somewhere to record any new states they require
+		struct StationWork
+		{
+			Station*			rec_ptr;
+			KFMeasEntryList*	kfMeasEntryList_ptr;
+			KFStateUpdateBuffer	updateBuffer;
+		};
+		
+		vector<StationWork> stationWorkList;
+		stationWorkList.reserve(stationMap.size());
+		
+		for (auto& [id, rec] : stationMap)
+		{
+			if (rec.obsList.empty())
+			{
+				continue;
+			}
+			
+			StationWork stationWork;
+			stationWork.rec_ptr								= &rec;
+			stationWork.kfMeasEntryList_ptr					= &stationKFEntryListMap[rec.id];
+			stationWork.updateBuffer.kfState_ptr			= &kfState;
+			stationWork.updateBuffer.kfMeasEntryList_ptr	= stationWork.kfMeasEntryList_ptr;
+			
+			stationWorkList.push_back(std::move(stationWork));
+		}
+		
+		//calculate the measurements for each station, stations have very different numbers of observations so schedule dynamically
 #		ifdef ENABLE_PARALLELISATION
 #		ifndef ENABLE_UNIT_TESTS
 			Eigen::setNbThreads(1);
-#			pragma omp parallel for
+#			pragma omp parallel for schedule(dynamic)
 #		endif
 #		endif
-		for (int i = 0; i < stationMap.size(); i++)
+		for (int i = 0; i < stationWorkList.size(); i++)
 		{
-			auto rec_iterator = stationMap.begin();
-			std::advance(rec_iterator, i);
+			auto& stationWork		= stationWorkList[i];
+			auto& rec				= *stationWork.rec_ptr;
+			auto& kfMeasEntryList	= *stationWork.kfMeasEntryList_ptr;
 			
-			auto& [id, rec] = *rec_iterator;
-			
-			if (rec.obsList.empty())
-			{
-				continue;
-			}
-			
-			auto& kfMeasEntryList = stationKFEntryListMap[rec.id];
+			KFState::updateBuffer_ptr = &stationWork.updateBuffer;
 			
 			orbitPseudoObs	(trace,		rec, kfState, kfMeasEntryList);
 			stationPPP		(std::cout,	rec, kfState, kfMeasEntryList);
 			stationSlr		(std::cout, rec, kfState, kfMeasEntryList);
 			stationPseudoObs(std::cout,	rec, kfState, kfMeasEntryList, stationMap, R_ptr);
+			
+			KFState::updateBuffer_ptr = nullptr;
 		}
 		Eigen::setNbThreads(0);
+		
+		//add any new states in station order, resolving which station created each new state
+		for (auto& stationWork : stationWorkList)
+		{
+			stationWork.updateBuffer.apply(kfState);
+		}
 	}
 	
 	
@@ -916,7 +973,7 @@ void PPP(
 	}
 	
 	vector<FilterChunk>	filterChunkList;
-	map<string, std::ofstream>	traceList;	//keep in large scope as we're using pointers
+	map<string, TraceStream>	traceList;	//keep in large scope as we're using pointers
 	
 	chunkFilter(trace, kfState, combinedMeas, stationMap, filterChunkList, traceList);
 	
@@ -944,27 +1001,28 @@ void PPP(
 	
 // 	lambdacalcs(kfState);
 	
-	KFState kfStatefixed = kfState;
+	//the fixed filter is copied once here, and then shared with the ambiguity resolution outputs rather than copied again
+	KFStateSnapshot kfStatefixed(kfState);
 	
-	kfStatefixed.suffix = "AR";
+	kfStatefixed.edit().suffix = "AR";
 	
 	PPP_AR(trace, kfStatefixed);
 	
 	for (auto& [recId, rec] : stationMap)
 	{
 		double trop = 0;
-		kfStatefixed.getKFValue({KF::TROP, {}, recId,	0}, trop);	//todo aaron, needs to iterate
+		kfStatefixed->getKFValue({KF::TROP, {}, recId,	0}, trop);	//todo aaron, needs to iterate
 				
 		for (short i = 0; i < 3; i++)
 		{
-			kfStatefixed.getKFValue({KF::REC_POS, 		{}, recId,	i},		rec.sol.pppRRec[i]);
-			kfStatefixed.getKFValue({KF::REC_POS_RATE,	{}, recId,	i},		rec.sol.pppVRec[i]);
+			kfStatefixed->getKFValue({KF::REC_POS, 		{}, recId,	i},		rec.sol.pppRRec[i]);
+			kfStatefixed->getKFValue({KF::REC_POS_RATE,	{}, recId,	i},		rec.sol.pppVRec[i]);
 		}
 		
 		for (short i = 0; i < 3; i++)
 		{
-			kfStatefixed.getKFValue({KF::ORBIT, 		{}, recId,	i},		rec.sol.pppRRec[i]);		//todo aaron, this is eci
-			kfStatefixed.getKFValue({KF::ORBIT,			{}, recId,	i + 3},	rec.sol.pppVRec[i]);
+			kfStatefixed->getKFValue({KF::ORBIT, 		{}, recId,	i},		rec.sol.pppRRec[i]);		//todo aaron, this is eci
+			kfStatefixed->getKFValue({KF::ORBIT,			{}, recId,	i + 3},	rec.sol.pppVRec[i]);
 		}
 
 		GWeek	week	= kfState.time;
@@ -981,12 +1039,12 @@ void PPP(
 	if	(  acsConfig.model.ionospheric_model
 		&& acsConfig.ssrOpts.ionosphere_sources.front() == +E_Source::KALMAN)
 	{
-		ionosphereSsrUpdate(trace, kfStatefixed);
+		ionosphereSsrUpdate(trace, kfStatefixed.view());
 	}
 	
 	if (acsConfig.process_ionosphere)
 	{
-		ginan2IonoMeas(trace, stationMap, kfStatefixed);
+		ginan2IonoMeas(trace, stationMap, kfStatefixed.view());
 	}
 	
 	if (1)
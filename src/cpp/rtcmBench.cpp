@@ -0,0 +1,75 @@
+
+#include <iostream>
+#include <chrono>
+
+#include "streamRtcm.hpp"
+#include "streamFile.hpp"
+
+/** Measures the throughput of the rtcm frame scanner and decoder over recorded rtcm files
+ */
+int main(
+	int		argc,
+	char**	argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: rtcm_bench <file.rtcm> [<file.rtcm> ...]" << std::endl;
+		return 1;
+	}
+
+	long int	totalBytes		= 0;
+	double		totalSeconds	= 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string path = argv[i];
+
+		FileStream	stream(path);
+		RtcmParser	parser;
+		parser.rtcmMountpoint = path;
+
+		auto start = std::chrono::steady_clock::now();
+
+		while (true)
+		{
+			long int lastPos = stream.filePos;
+			{
+				auto iStream_ptr = stream.getIStream_ptr();
+				if (!*iStream_ptr)
+				{
+					break;
+				}
+
+				parser.parse(*iStream_ptr);
+			}
+
+			//observations are not consumed here, discard them to keep memory flat
+			parser.obsListList.clear();
+
+			if (stream.filePos <= lastPos)
+			{
+				break;
+			}
+		}
+
+		auto stop = std::chrono::steady_clock::now();
+
+		long int	bytes	= std::max(stream.filePos, 0L);
+		double		seconds	= std::chrono::duration<double>(stop - start).count();
+
+		totalBytes		+= bytes;
+		totalSeconds	+= seconds;
+
+		printf("\n%s\n", path.c_str());
+		printf("  Bytes         : %ld\n",		bytes);
+		printf("  Frames passed : %ld\n",		parser.numFramesPassCRC);
+		printf("  Frames failed : %ld\n",		parser.numFramesFailedCRC);
+		printf("  Seconds       : %.3f\n",		seconds);
+		printf("  MB/s          : %.2f\n",		bytes / 1e6 / seconds);
+		printf("  Frames/s      : %.0f\n",		parser.numFramesPassCRC / seconds);
+	}
+
+	printf("\nTotal MB/s      : %.2f\n", totalBytes / 1e6 / totalSeconds);
+
+	return 0;
+}
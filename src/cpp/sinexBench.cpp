@@ -0,0 +1,100 @@
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+
+#include "sinex.hpp"
+
+/** Measures the throughput of the sinex reader, including the solution matrix blocks, over sinex files
+ */
+int main(
+	int		argc,
+	char**	argv)
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: sinex_bench <file.snx> [<file.snx> ...]" << std::endl;
+		return 1;
+	}
+
+	vector<string> fileList;
+	for (int i = 1; i < argc; i++)
+	{
+		fileList.push_back(argv[i]);
+	}
+
+	const int maxLoaded = 4;
+
+	long int	totalBytes		= 0;
+	double		totalSeconds	= 0;
+	double		loadSeconds		= 0;
+
+	vector<char>	loadedList;
+	vector<string>	bufferList;
+
+	for (int i = 0; i < fileList.size(); i++)
+	{
+		//load a few files at a time, as the pea does
+		if (i % maxLoaded == 0)
+		{
+			vector<string> batchFileList(fileList.begin() + i, fileList.begin() + std::min((int) fileList.size(), i + maxLoaded));
+
+			auto loadStart = std::chrono::steady_clock::now();
+
+			bufferList = loadSinexFiles(batchFileList, loadedList);
+
+			auto loadStop = std::chrono::steady_clock::now();
+
+			loadSeconds += std::chrono::duration<double>(loadStop - loadStart).count();
+		}
+
+		auto& path		= fileList[i];
+		auto& buffer	= bufferList[i % maxLoaded];
+
+		if (loadedList[i % maxLoaded] == false)
+		{
+			printf("\n%s\n  Result        : unreadable\n", path.c_str());
+			continue;
+		}
+
+		long int	bytes	= buffer.size();
+		long int	lines	= std::count(buffer.begin(), buffer.end(), '\n');
+
+		auto start = std::chrono::steady_clock::now();
+
+		bool fail = readSinex(path, i == 0, &buffer);
+
+		auto stop = std::chrono::steady_clock::now();
+
+		double seconds = std::chrono::duration<double>(stop - start).count();
+
+		string().swap(buffer);
+
+		totalBytes		+= bytes;
+		totalSeconds	+= seconds;
+
+		printf("\n%s\n", path.c_str());
+		printf("  Result        : %s\n",		fail ? "failed" : "ok");
+		printf("  Bytes         : %ld\n",		bytes);
+		printf("  Lines         : %ld\n",		lines);
+		printf("  Seconds       : %.3f\n",		seconds);
+		printf("  MB/s          : %.2f\n",		bytes / 1e6 / seconds);
+		printf("  Lines/s       : %.0f\n",		lines / seconds);
+	}
+
+	printf("\n");
+	for (int type = 0; type < MAX_MATRIX_TYPE; type++)
+	for (auto& [value, fileMatrixMap]	: theSinex.matrix_map[type])
+	for (auto& [path, matrix]			: fileMatrixMap)
+	{
+		printf("Matrix %d/%d     : %d x %d  %s\n", type, value, matrix.dim, matrix.dim, path.c_str());
+	}
+
+	printf("\nLoad seconds    : %.3f\n", loadSeconds);
+	printf("Total MB/s      : %.2f\n", totalBytes / 1e6 / totalSeconds);
+
+	return 0;
+}